@@ -22,10 +22,15 @@ static void printUsage() {
       << "  unmute           Unmute audio\n"
       << "  status           Show daemon status (add --json for raw JSON)\n"
       << "  list-monitors    List available monitors\n"
+      << "  query <expr>     Search the library, e.g.\n"
+      << "                   type:video tag:dark rating>=3 sort:used limit:10\n"
+      << "                   width>=3840 duration<30 fps>=60 codec:vp9\n"
+      << "  duplicates       List wallpapers whose files have identical contents\n"
+      << "                   --near [--radius <bits>] groups similar-looking ones\n"
       << "  version          Show daemon version\n\n"
       << "Options:\n"
       << "  --monitor <name> Target a specific monitor (e.g. DP-1)\n"
-      << "  --json           Output status as raw JSON\n"
+      << "  --json           Output status, query or duplicate results as JSON\n"
       << "  --help, -h       Show this help message\n"
       << "  --version, -v    Show version information\n"
       << std::endl;
@@ -101,15 +106,34 @@ int main(int argc, char **argv) {
   // Parse arguments
   std::string monitor;
   std::string path;
+  std::string expression;
   bool jsonOutput = false;
+  bool nearDuplicates = false;
+  int radius = 6;
   for (int i = 2; i < argc; ++i) {
     std::string arg = argv[i];
     if (arg == "--monitor" && i + 1 < argc) {
       monitor = argv[++i];
     } else if (arg == "--json") {
       jsonOutput = true;
+    } else if (command == "duplicates" && arg == "--near") {
+      nearDuplicates = true;
+    } else if (command == "duplicates" && arg == "--radius" && i + 1 < argc) {
+      try {
+        radius = std::stoi(argv[++i]);
+      } catch (...) {
+        std::cerr << "Error: Invalid radius: " << argv[i] << std::endl;
+        return 1;
+      }
     } else if (path.empty() && (command == "set" || command == "volume")) {
       path = arg;
+    } else if (command == "query") {
+      // The shell already split and unquoted the terms; quote any that
+      // carry spaces so the daemon sees the same phrase.
+      if (!expression.empty())
+        expression += ' ';
+      expression += arg.find(' ') == std::string::npos ? arg
+                                                       : '"' + arg + '"';
     }
   }
 
@@ -219,6 +243,59 @@ int main(int argc, char **argv) {
       std::cerr << "Error parsing monitor list: " << e.what() << std::endl;
       return 1;
     }
+  } else if (command == "query") {
+    std::string resultJson = client->query(expression);
+    if (jsonOutput) {
+      std::cout << resultJson << std::endl;
+      return 0;
+    }
+    try {
+      auto j = nlohmann::json::parse(resultJson);
+      if (j.contains("error")) {
+        std::cerr << "Error: " << j["error"].get<std::string>() << std::endl;
+        return 1;
+      }
+      for (const auto &wp : j.value("wallpapers", nlohmann::json::array())) {
+        std::cout << wp.value("id", "") << "\t" << wp.value("title", "")
+                  << "\t" << wp.value("path", "") << "\n";
+      }
+    } catch (const nlohmann::json::exception &e) {
+      std::cerr << "Error parsing query result: " << e.what() << std::endl;
+      return 1;
+    }
+  } else if (command == "duplicates") {
+    std::string resultJson = nearDuplicates ? client->findNearDuplicates(radius)
+                                            : client->findDuplicates();
+    if (jsonOutput) {
+      std::cout << resultJson << std::endl;
+      return 0;
+    }
+    try {
+      auto j = nlohmann::json::parse(resultJson);
+      if (j.contains("error")) {
+        std::cerr << "Error: " << j["error"].get<std::string>() << std::endl;
+        return 1;
+      }
+      auto groups = j.value("groups", nlohmann::json::array());
+      if (groups.empty()) {
+        std::cout << "No duplicates found" << std::endl;
+      }
+      for (const auto &group : groups) {
+        if (nearDuplicates) {
+          std::cout << "Similar:\n";
+        } else {
+          std::cout << group.value("hash", "") << "  "
+                    << group.value("size", uint64_t{0}) << " bytes\n";
+        }
+        for (const auto &wp : group.value("wallpapers", nlohmann::json::array())) {
+          std::cout << "  " << wp.value("id", "") << "\t"
+                    << wp.value("path", "") << "\n";
+        }
+      }
+    } catch (const nlohmann::json::exception &e) {
+      std::cerr << "Error parsing duplicate list: " << e.what() << std::endl;
+      return 1;
+    }
   } else if (command == "version") {
     std::cout << "bwp (CLI) " << BWP_VERSION << "\n"
               << "daemon    " << client->getDaemonVersion() << std::endl;
@@ -17,6 +17,10 @@ const char *const DUPLICATE_HANDLING =
     "library.duplicate_handling";  
 const char *const AUTO_REMOVE_MISSING = "library.auto_remove_missing";
 const char *const THUMBNAIL_SIZE = "library.thumbnail_size";
+const char *const SCAN_WORKERS = "library.scan_workers";  // 0 = auto
+const char *const THUMBNAIL_MEMORY_MB = "library.thumbnail_memory_mb";
+const char *const THUMBNAIL_CODEC = "library.thumbnail_codec";  // qoi | png
+const char *const THUMBNAIL_SHARED_CACHE = "library.thumbnail_shared_cache";
 const char *const DEFAULT_SCALING = "defaults.scaling_mode";
 const char *const DEFAULT_AUDIO_ENABLED = "defaults.audio_enabled";
 const char *const DEFAULT_VOLUME = "defaults.audio_volume";
@@ -63,7 +67,11 @@ public:
               {"scan_recursive", true},
               {"duplicate_handling", "ask"},
               {"auto_remove_missing", true},
-              {"thumbnail_size", 256}}},
+              {"thumbnail_size", 256},
+              {"scan_workers", 0},
+              {"thumbnail_memory_mb", 64},
+              {"thumbnail_codec", "qoi"},
+              {"thumbnail_shared_cache", true}}},
             {"defaults",
              {{"scaling_mode", "fill"},
               {"audio_enabled", false},
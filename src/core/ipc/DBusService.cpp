@@ -2,6 +2,7 @@
 #include "../utils/Logger.hpp"
 #include <gio/gio.h>
 #include <iostream>
+#include <thread>
 namespace bwp::ipc {
 static const char *introspection_xml = R"(
 <node>
@@ -44,6 +45,17 @@ static const char *introspection_xml = R"(
     <method name="GetMonitors">
       <arg name="monitors" type="s" direction="out"/>
     </method>
+    <method name="Query">
+      <arg name="query" type="s" direction="in"/>
+      <arg name="result" type="s" direction="out"/>
+    </method>
+    <method name="FindDuplicates">
+      <arg name="groups" type="s" direction="out"/>
+    </method>
+    <method name="FindNearDuplicates">
+      <arg name="radius" type="i" direction="in"/>
+      <arg name="clusters" type="s" direction="out"/>
+    </method>
     <property name="DaemonVersion" type="s" access="read"/>
     <signal name="WallpaperChanged">
       <arg name="monitor" type="s"/>
@@ -175,6 +187,39 @@ void DBusService::handle_method_call(GDBusConnection *  ,
     }
     g_dbus_method_invocation_return_value(invocation,
                                           g_variant_new("(s)", monitors.c_str()));
+  } else if (method == "Query") {
+    const char *expression;
+    g_variant_get(parameters, "(&s)", &expression);
+    std::string result;
+    if (self->m_queryHandler) {
+      result = self->m_queryHandler(expression);
+    }
+    g_dbus_method_invocation_return_value(invocation,
+                                          g_variant_new("(s)", result.c_str()));
+  } else if (method == "FindDuplicates") {
+    // May read every file in the library; answered from a worker so the
+    // main loop keeps serving other calls meanwhile.
+    std::thread([handler = self->m_findDuplicatesHandler, invocation]() {
+      std::string groups;
+      if (handler) {
+        groups = handler();
+      }
+      g_dbus_method_invocation_return_value(
+          invocation, g_variant_new("(s)", groups.c_str()));
+    }).detach();
+  } else if (method == "FindNearDuplicates") {
+    int radius;
+    g_variant_get(parameters, "(i)", &radius);
+    // Backfilling hashes decodes thumbnails; off the main loop as above.
+    std::thread([handler = self->m_findNearDuplicatesHandler, radius,
+                 invocation]() {
+      std::string clusters;
+      if (handler) {
+        clusters = handler(radius);
+      }
+      g_dbus_method_invocation_return_value(
+          invocation, g_variant_new("(s)", clusters.c_str()));
+    }).detach();
   } else {
     g_dbus_method_invocation_return_error(invocation, G_DBUS_ERROR,
                                           G_DBUS_ERROR_UNKNOWN_METHOD,
@@ -225,6 +270,17 @@ void DBusService::setGetStatusHandler(IIPCService::NoArgStringHandler handler) {
 void DBusService::setGetMonitorsHandler(IIPCService::NoArgStringHandler handler) {
   m_getMonitorsHandler = handler;
 }
+void DBusService::setQueryHandler(IIPCService::GetStringHandler handler) {
+  m_queryHandler = handler;
+}
+void DBusService::setFindDuplicatesHandler(
+    IIPCService::NoArgStringHandler handler) {
+  m_findDuplicatesHandler = handler;
+}
+void DBusService::setFindNearDuplicatesHandler(
+    IIPCService::IntStringHandler handler) {
+  m_findNearDuplicatesHandler = handler;
+}
 
 void DBusService::stop() {
   if (m_ownerId > 0) {
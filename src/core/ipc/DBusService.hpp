@@ -39,6 +39,9 @@ public:
   void setSetMutedHandler(MuteHandler handler) override;
   void setGetStatusHandler(NoArgStringHandler handler) override;
   void setGetMonitorsHandler(NoArgStringHandler handler) override;
+  void setQueryHandler(GetStringHandler handler) override;
+  void setFindDuplicatesHandler(NoArgStringHandler handler) override;
+  void setFindNearDuplicatesHandler(IntStringHandler handler) override;
 private:
   static void onBusAcquired(GDBusConnection *connection, const char *name,
                             void *user_data);
@@ -72,5 +75,8 @@ private:
   MuteHandler m_muteHandler;
   NoArgStringHandler m_getStatusHandler;
   NoArgStringHandler m_getMonitorsHandler;
+  GetStringHandler m_queryHandler;
+  NoArgStringHandler m_findDuplicatesHandler;
+  IntStringHandler m_findNearDuplicatesHandler;
 };
 }  
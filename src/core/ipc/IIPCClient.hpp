@@ -17,5 +17,8 @@ public:
     virtual std::string getDaemonVersion() = 0;
     virtual std::string getStatus() = 0;
     virtual std::string getMonitors() = 0;
+    virtual std::string query(const std::string &expression) = 0;
+    virtual std::string findDuplicates() = 0;
+    virtual std::string findNearDuplicates(int radius) = 0;
 };
 }  
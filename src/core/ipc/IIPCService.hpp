@@ -14,6 +14,7 @@ public:
     using MuteHandler = std::function<void(const std::string&, bool)>;
     using GetStringHandler = std::function<std::string(const std::string&)>;
     using NoArgStringHandler = std::function<std::string()>;
+    using IntStringHandler = std::function<std::string(int)>;
     virtual void setSetWallpaperHandler(BoolHandler handler) = 0;
     virtual void setGetWallpaperHandler(GetStringHandler handler) = 0;
     virtual void setNextHandler(VoidHandler handler) = 0;
@@ -25,5 +26,12 @@ public:
     virtual void setSetMutedHandler(MuteHandler handler) = 0;
     virtual void setGetStatusHandler(NoArgStringHandler handler) = 0;
     virtual void setGetMonitorsHandler(NoArgStringHandler handler) = 0;
+    // Library query-language expression in, JSON result out.
+    virtual void setQueryHandler(GetStringHandler handler) = 0;
+    // Runs on a worker thread, not the main loop.
+    virtual void setFindDuplicatesHandler(NoArgStringHandler handler) = 0;
+    // Hamming radius in, JSON clusters of similar-looking wallpapers out.
+    // Also runs on a worker thread.
+    virtual void setFindNearDuplicatesHandler(IntStringHandler handler) = 0;
 };
 }  
@@ -124,6 +124,69 @@ std::string LinuxIPCClient::getMonitors() {
   g_variant_unref(result);
   return m;
 }
+std::string LinuxIPCClient::query(const std::string &expression) {
+  if (!m_connection)
+    return R"({"error":"not connected"})";
+  GError *error = nullptr;
+  GVariant *result = g_dbus_connection_call_sync(
+      m_connection, "com.github.BetterWallpaper", "/com/github/BetterWallpaper",
+      "com.github.BetterWallpaper", "Query",
+      g_variant_new("(s)", expression.c_str()), G_VARIANT_TYPE("(s)"),
+      G_DBUS_CALL_FLAGS_NONE, 5000, nullptr, &error);
+  if (!result) {
+    if (error)
+      g_error_free(error);
+    return R"({"error":"daemon did not answer"})";
+  }
+  const char *json;
+  g_variant_get(result, "(&s)", &json);
+  std::string q = json ? json : "{}";
+  g_variant_unref(result);
+  return q;
+}
+std::string LinuxIPCClient::findDuplicates() {
+  if (!m_connection)
+    return R"({"error":"not connected"})";
+  GError *error = nullptr;
+  // A first run hashes the whole library, far past the D-Bus default.
+  GVariant *result = g_dbus_connection_call_sync(
+      m_connection, "com.github.BetterWallpaper", "/com/github/BetterWallpaper",
+      "com.github.BetterWallpaper", "FindDuplicates", nullptr,
+      G_VARIANT_TYPE("(s)"), G_DBUS_CALL_FLAGS_NONE, G_MAXINT, nullptr,
+      &error);
+  if (!result) {
+    if (error)
+      g_error_free(error);
+    return R"({"error":"daemon did not answer"})";
+  }
+  const char *json;
+  g_variant_get(result, "(&s)", &json);
+  std::string groups = json ? json : "{}";
+  g_variant_unref(result);
+  return groups;
+}
+std::string LinuxIPCClient::findNearDuplicates(int radius) {
+  if (!m_connection)
+    return R"({"error":"not connected"})";
+  GError *error = nullptr;
+  // Missing perceptual hashes are computed before the reply, video frame
+  // grabs included.
+  GVariant *result = g_dbus_connection_call_sync(
+      m_connection, "com.github.BetterWallpaper", "/com/github/BetterWallpaper",
+      "com.github.BetterWallpaper", "FindNearDuplicates",
+      g_variant_new("(i)", radius), G_VARIANT_TYPE("(s)"),
+      G_DBUS_CALL_FLAGS_NONE, G_MAXINT, nullptr, &error);
+  if (!result) {
+    if (error)
+      g_error_free(error);
+    return R"({"error":"daemon did not answer"})";
+  }
+  const char *json;
+  g_variant_get(result, "(&s)", &json);
+  std::string clusters = json ? json : "{}";
+  g_variant_unref(result);
+  return clusters;
+}
 void LinuxIPCClient::callAction(const char *method, GVariant *parameters) {
   if (!m_connection)
     return;
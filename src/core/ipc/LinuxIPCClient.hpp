@@ -14,6 +14,9 @@ public:
   std::string getDaemonVersion() override;
   std::string getStatus() override;
   std::string getMonitors() override;
+  std::string query(const std::string &expression) override;
+  std::string findDuplicates() override;
+  std::string findNearDuplicates(int radius) override;
   void nextWallpaper(const std::string &monitor) override;
   void previousWallpaper(const std::string &monitor) override;
   void pauseWallpaper(const std::string &monitor) override;
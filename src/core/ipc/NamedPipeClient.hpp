@@ -49,5 +49,12 @@ public:
     std::string getDaemonVersion() override { return "0.2.0-win"; }
     std::string getStatus() override { return "{}"; }
     std::string getMonitors() override { return "[]"; }
+    std::string query(const std::string &) override {
+        return R"({"error":"query is not supported over the named pipe"})";
+    }
+    std::string findDuplicates() override {
+        return R"({"error":"duplicates are not supported over the named pipe"})";
+    }
+    std::string findNearDuplicates(int) override { return findDuplicates(); }
 };
 }  
@@ -32,6 +32,9 @@ public:
     void setSetMutedHandler(MuteHandler h) override { m_muteHandler = h; }
     void setGetStatusHandler(NoArgStringHandler h) override { m_getStatusHandler = h; }
     void setGetMonitorsHandler(NoArgStringHandler h) override { m_getMonitorsHandler = h; }
+    void setQueryHandler(GetStringHandler h) override { m_queryHandler = h; }
+    void setFindDuplicatesHandler(NoArgStringHandler h) override { m_findDuplicatesHandler = h; }
+    void setFindNearDuplicatesHandler(IntStringHandler h) override { m_findNearDuplicatesHandler = h; }
 private:
     std::atomic<bool> m_running{false};
     std::thread m_thread;
@@ -46,6 +49,9 @@ private:
     MuteHandler m_muteHandler;
     NoArgStringHandler m_getStatusHandler;
     NoArgStringHandler m_getMonitorsHandler;
+    GetStringHandler m_queryHandler;
+    NoArgStringHandler m_findDuplicatesHandler;
+    IntStringHandler m_findNearDuplicatesHandler;
 #ifdef _WIN32
     void listenLoop();
 #endif
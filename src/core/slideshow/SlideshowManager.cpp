@@ -58,29 +58,20 @@ void SlideshowManager::start(const std::vector<std::string> &wallpaperIds,
 void SlideshowManager::startFromFolder(const std::string &folderPath,
                                        int intervalSeconds) {
   auto &library = bwp::wallpaper::WallpaperLibrary::getInstance();
-  auto wallpapers = library.getAllWallpapers();
   std::vector<std::string> ids;
-  for (const auto &wp : wallpapers) {
-    if (wp.path.find(folderPath) != std::string::npos) {
-      ids.push_back(wp.id);
+  library.snapshot()->forEach([&](const auto &wp) {
+    if (wp.path().find(folderPath) != std::string::npos) {
+      ids.emplace_back(wp.id());
     }
-  }
+  });
   start(ids, intervalSeconds);
 }
 void SlideshowManager::startFromTag(const std::string &tag,
                                     int intervalSeconds) {
   auto &library = bwp::wallpaper::WallpaperLibrary::getInstance();
-  auto wallpapers = library.getAllWallpapers();
-  std::vector<std::string> ids;
-  for (const auto &wp : wallpapers) {
-    for (const auto &t : wp.tags) {
-      if (t == tag) {
-        ids.push_back(wp.id);
-        break;
-      }
-    }
-  }
-  start(ids, intervalSeconds);
+  bwp::wallpaper::TagQuery query;
+  query.all.push_back(tag);
+  start(library.queryTags(query), intervalSeconds);
 }
 void SlideshowManager::stop() {
   std::lock_guard<std::recursive_mutex> lock(m_mutex);
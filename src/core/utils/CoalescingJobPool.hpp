@@ -0,0 +1,222 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+namespace bwp::utils {
+// Fixed set of worker threads serving keyed jobs from two FIFO queues, high
+// priority first. Submitting a key that is already queued or running adds
+// a waiter to that job instead of running it twice, and a high-priority
+// waiter promotes a queued low-priority job. Each waiter gets a Ticket;
+// cancelling the last waiter of a job that has not started drops the job.
+// Callbacks run on the worker thread that produced the result.
+template <typename Result> class CoalescingJobPool {
+public:
+  enum class Priority { Low, High };
+  using Work = std::function<Result()>;
+  using Done = std::function<void(const Result &)>;
+  struct Metrics {
+    size_t queued = 0;      // jobs waiting for a worker
+    size_t running = 0;
+    uint64_t completed = 0;
+    uint64_t cancelled = 0; // jobs dropped before they started
+    uint64_t coalesced = 0; // submissions that joined an existing job
+    double avgWaitMs = 0.0; // submit to start
+    double avgRunMs = 0.0;  // start to finish
+    double maxRunMs = 0.0;
+  };
+
+private:
+  enum class State { Queued, Running };
+  struct Job {
+    std::string key;
+    Work work;
+    Priority priority = Priority::Low;
+    State state = State::Queued;
+    std::vector<std::pair<uint64_t, Done>> waiters;
+    std::chrono::steady_clock::time_point submitted;
+  };
+  struct Shared {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::unordered_map<std::string, std::shared_ptr<Job>> jobs;
+    // May hold stale entries (promoted or cancelled jobs); skipped on pop.
+    std::deque<std::shared_ptr<Job>> high;
+    std::deque<std::shared_ptr<Job>> low;
+    size_t queued = 0;
+    size_t running = 0;
+    uint64_t nextWaiter = 1;
+    uint64_t completed = 0;
+    uint64_t cancelled = 0;
+    uint64_t coalesced = 0;
+    double totalWaitMs = 0.0;
+    double totalRunMs = 0.0;
+    double maxRunMs = 0.0;
+    bool stopping = false;
+  };
+
+public:
+  class Ticket {
+  public:
+    Ticket() = default;
+    // The callback will not run unless it already started. Idempotent.
+    void cancel() {
+      auto shared = m_shared.lock();
+      auto job = m_job.lock();
+      if (!shared || !job)
+        return;
+      std::lock_guard<std::mutex> lock(shared->mutex);
+      auto &waiters = job->waiters;
+      waiters.erase(std::remove_if(waiters.begin(), waiters.end(),
+                                   [this](const auto &w) {
+                                     return w.first == m_waiter;
+                                   }),
+                    waiters.end());
+      if (waiters.empty() && job->state == State::Queued) {
+        auto it = shared->jobs.find(job->key);
+        if (it != shared->jobs.end() && it->second == job) {
+          shared->jobs.erase(it);
+          shared->queued--;
+          shared->cancelled++;
+        }
+      }
+      m_job.reset();
+    }
+    explicit operator bool() const { return !m_job.expired(); }
+
+  private:
+    friend class CoalescingJobPool;
+    std::weak_ptr<Shared> m_shared;
+    std::weak_ptr<Job> m_job;
+    uint64_t m_waiter = 0;
+  };
+  explicit CoalescingJobPool(unsigned workers)
+      : m_shared(std::make_shared<Shared>()) {
+    for (unsigned i = 0; i < std::max(1u, workers); ++i)
+      m_threads.emplace_back([this]() { workerLoop(); });
+  }
+  ~CoalescingJobPool() {
+    {
+      std::lock_guard<std::mutex> lock(m_shared->mutex);
+      m_shared->stopping = true;
+    }
+    m_shared->wake.notify_all();
+    for (auto &thread : m_threads)
+      thread.join();
+  }
+  CoalescingJobPool(const CoalescingJobPool &) = delete;
+  CoalescingJobPool &operator=(const CoalescingJobPool &) = delete;
+  unsigned workers() const { return static_cast<unsigned>(m_threads.size()); }
+  // `work` is ignored when the key is already queued or running. `done`
+  // may be empty to only warm whatever the work fills.
+  Ticket submit(const std::string &key, Priority priority, Work work,
+                Done done) {
+    Ticket ticket;
+    ticket.m_shared = m_shared;
+    {
+      std::lock_guard<std::mutex> lock(m_shared->mutex);
+      std::shared_ptr<Job> &job = m_shared->jobs[key];
+      if (job) {
+        m_shared->coalesced++;
+        if (priority == Priority::High && job->priority == Priority::Low &&
+            job->state == State::Queued) {
+          job->priority = Priority::High;
+          m_shared->high.push_back(job);
+        }
+      } else {
+        job = std::make_shared<Job>();
+        job->key = key;
+        job->work = std::move(work);
+        job->priority = priority;
+        job->submitted = std::chrono::steady_clock::now();
+        (priority == Priority::High ? m_shared->high : m_shared->low)
+            .push_back(job);
+        m_shared->queued++;
+      }
+      ticket.m_job = job;
+      ticket.m_waiter = m_shared->nextWaiter++;
+      job->waiters.emplace_back(ticket.m_waiter, std::move(done));
+    }
+    m_shared->wake.notify_one();
+    return ticket;
+  }
+  Metrics metrics() const {
+    std::lock_guard<std::mutex> lock(m_shared->mutex);
+    Metrics m;
+    m.queued = m_shared->queued;
+    m.running = m_shared->running;
+    m.completed = m_shared->completed;
+    m.cancelled = m_shared->cancelled;
+    m.coalesced = m_shared->coalesced;
+    if (m_shared->completed > 0) {
+      m.avgWaitMs = m_shared->totalWaitMs / m_shared->completed;
+      m.avgRunMs = m_shared->totalRunMs / m_shared->completed;
+    }
+    m.maxRunMs = m_shared->maxRunMs;
+    return m;
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+  static double ms(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+  }
+  // Pops the next live queued job; caller holds the mutex.
+  std::shared_ptr<Job> nextJob() {
+    for (auto *queue : {&m_shared->high, &m_shared->low}) {
+      while (!queue->empty()) {
+        auto job = std::move(queue->front());
+        queue->pop_front();
+        auto it = m_shared->jobs.find(job->key);
+        if (job->state == State::Queued && it != m_shared->jobs.end() &&
+            it->second == job)
+          return job;
+      }
+    }
+    return nullptr;
+  }
+  void workerLoop() {
+    std::unique_lock<std::mutex> lock(m_shared->mutex);
+    for (;;) {
+      std::shared_ptr<Job> job;
+      m_shared->wake.wait(lock, [&]() {
+        return m_shared->stopping || (job = nextJob()) != nullptr;
+      });
+      if (!job)
+        return;
+      job->state = State::Running;
+      m_shared->queued--;
+      m_shared->running++;
+      const auto started = Clock::now();
+      m_shared->totalWaitMs += ms(started - job->submitted);
+      Work work = std::move(job->work);
+      lock.unlock();
+      Result result = work();
+      const double runMs = ms(Clock::now() - started);
+      lock.lock();
+      m_shared->jobs.erase(job->key);
+      auto waiters = std::move(job->waiters);
+      m_shared->running--;
+      m_shared->completed++;
+      m_shared->totalRunMs += runMs;
+      m_shared->maxRunMs = std::max(m_shared->maxRunMs, runMs);
+      lock.unlock();
+      for (auto &waiter : waiters) {
+        if (waiter.second)
+          waiter.second(result);
+      }
+      lock.lock();
+    }
+  }
+  std::shared_ptr<Shared> m_shared;
+  std::vector<std::thread> m_threads;
+};
+} // namespace bwp::utils
@@ -0,0 +1,151 @@
+#include "ContentHash.hpp"
+#include "MappedFile.hpp"
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <vector>
+namespace bwp::utils {
+namespace {
+constexpr uint64_t kP1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kP2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kP3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kP4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kP5 = 0x27D4EB2F165667C5ULL;
+uint64_t read64(const uint8_t *p) {
+  uint64_t v;
+  std::memcpy(&v, p, 8);
+  return v; // little-endian hosts only, like the binary library file
+}
+uint32_t read32(const uint8_t *p) {
+  uint32_t v;
+  std::memcpy(&v, p, 4);
+  return v;
+}
+uint64_t round(uint64_t acc, uint64_t input) {
+  acc += input * kP2;
+  return std::rotl(acc, 31) * kP1;
+}
+uint64_t mergeRound(uint64_t acc, uint64_t value) {
+  acc ^= round(0, value);
+  return acc * kP1 + kP4;
+}
+} // namespace
+Xxh64::Xxh64(uint64_t seed)
+    : m_acc{seed + kP1 + kP2, seed + kP2, seed, seed - kP1}, m_seed(seed) {}
+void Xxh64::update(const void *data, size_t length) {
+  const auto *p = static_cast<const uint8_t *>(data);
+  const uint8_t *end = p + length;
+  m_total += length;
+  if (m_buffered + length < 32) {
+    std::memcpy(m_buffer + m_buffered, p, length);
+    m_buffered += length;
+    return;
+  }
+  if (m_buffered > 0) {
+    size_t fill = 32 - m_buffered;
+    std::memcpy(m_buffer + m_buffered, p, fill);
+    p += fill;
+    for (int i = 0; i < 4; ++i)
+      m_acc[i] = round(m_acc[i], read64(m_buffer + i * 8));
+    m_buffered = 0;
+  }
+  uint64_t v1 = m_acc[0], v2 = m_acc[1], v3 = m_acc[2], v4 = m_acc[3];
+  while (end - p >= 32) {
+    v1 = round(v1, read64(p));
+    v2 = round(v2, read64(p + 8));
+    v3 = round(v3, read64(p + 16));
+    v4 = round(v4, read64(p + 24));
+    p += 32;
+  }
+  m_acc[0] = v1, m_acc[1] = v2, m_acc[2] = v3, m_acc[3] = v4;
+  m_buffered = static_cast<size_t>(end - p);
+  std::memcpy(m_buffer, p, m_buffered);
+}
+uint64_t Xxh64::digest() const {
+  uint64_t h;
+  if (m_total >= 32) {
+    h = std::rotl(m_acc[0], 1) + std::rotl(m_acc[1], 7) +
+        std::rotl(m_acc[2], 12) + std::rotl(m_acc[3], 18);
+    for (uint64_t acc : m_acc)
+      h = mergeRound(h, acc);
+  } else {
+    h = m_seed + kP5;
+  }
+  h += m_total;
+  const uint8_t *p = m_buffer;
+  const uint8_t *end = m_buffer + m_buffered;
+  for (; end - p >= 8; p += 8) {
+    h ^= round(0, read64(p));
+    h = std::rotl(h, 27) * kP1 + kP4;
+  }
+  if (end - p >= 4) {
+    h ^= uint64_t{read32(p)} * kP1;
+    h = std::rotl(h, 23) * kP2 + kP3;
+    p += 4;
+  }
+  for (; p < end; ++p) {
+    h ^= *p * kP5;
+    h = std::rotl(h, 11) * kP1;
+  }
+  h ^= h >> 33;
+  h *= kP2;
+  h ^= h >> 29;
+  h *= kP3;
+  h ^= h >> 32;
+  return h;
+}
+uint64_t Xxh64::of(const void *data, size_t length, uint64_t seed) {
+  Xxh64 hasher(seed);
+  hasher.update(data, length);
+  return hasher.digest();
+}
+std::optional<uint64_t> ContentHash::file(const std::filesystem::path &path) {
+  std::error_code ec;
+  auto size = std::filesystem::file_size(path, ec);
+  if (ec)
+    return std::nullopt;
+  if (size == 0)
+    return Xxh64::of(nullptr, 0);
+  auto mapped = MappedFile::open(path);
+  if (mapped)
+    return Xxh64::of(mapped->data(), mapped->size());
+  // Mapping can fail on special filesystems; stream instead.
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open())
+    return std::nullopt;
+  Xxh64 hasher;
+  std::vector<char> buffer(1 << 20);
+  while (in) {
+    in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    hasher.update(buffer.data(), static_cast<size_t>(in.gcount()));
+  }
+  if (in.bad())
+    return std::nullopt;
+  return hasher.digest();
+}
+std::optional<uint64_t> ContentHash::partial(const std::filesystem::path &path,
+                                             uint64_t size) {
+  if (size <= 2 * kPartialBytes)
+    return file(path);
+  std::ifstream in(path, std::ios::binary);
+  if (!in.is_open())
+    return std::nullopt;
+  std::vector<char> buffer(kPartialBytes);
+  Xxh64 hasher;
+  hasher.update(&size, sizeof(size));
+  for (uint64_t offset : {uint64_t{0}, size - kPartialBytes}) {
+    in.seekg(static_cast<std::streamoff>(offset));
+    if (!in.read(buffer.data(), static_cast<std::streamsize>(buffer.size())))
+      return std::nullopt;
+    hasher.update(buffer.data(), buffer.size());
+  }
+  return hasher.digest();
+}
+std::string ContentHash::toHex(uint64_t hash) {
+  static const char digits[] = "0123456789abcdef";
+  std::string out(16, '0');
+  for (int i = 15; i >= 0; --i, hash >>= 4)
+    out[i] = digits[hash & 0xf];
+  return out;
+}
+} // namespace bwp::utils
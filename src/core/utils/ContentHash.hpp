@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+namespace bwp::utils {
+// Streaming XXH64: a fast non-cryptographic 64-bit hash, good enough to
+// tell files apart (collisions are only a concern against an adversary).
+class Xxh64 {
+public:
+  explicit Xxh64(uint64_t seed = 0);
+  void update(const void *data, size_t length);
+  uint64_t digest() const;
+  static uint64_t of(const void *data, size_t length, uint64_t seed = 0);
+
+private:
+  uint64_t m_acc[4];
+  uint64_t m_seed;
+  uint64_t m_total = 0;
+  uint8_t m_buffer[32];
+  size_t m_buffered = 0;
+};
+class ContentHash {
+public:
+  // Bytes read from each end of the file for the partial hash.
+  static constexpr size_t kPartialBytes = 64 * 1024;
+  // Whole-file hash; the file is mapped rather than read when possible.
+  static std::optional<uint64_t> file(const std::filesystem::path &path);
+  // Hash of the size plus the first and last kPartialBytes. For files of at
+  // most 2 * kPartialBytes this covers every byte and equals file().
+  static std::optional<uint64_t> partial(const std::filesystem::path &path,
+                                         uint64_t size);
+  static std::string toHex(uint64_t hash);
+};
+} // namespace bwp::utils
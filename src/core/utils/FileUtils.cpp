@@ -1,5 +1,6 @@
 #include "FileUtils.hpp"
-#include <array>
+#include "ContentHash.hpp"
+#include <cstdio>
 #include <cstdlib>
 #include <fstream>
 #include <iostream>
@@ -60,6 +61,34 @@ bool FileUtils::writeFile(const std::filesystem::path &path,
   if (f.fail()) return false;
   return true;
 }
+bool FileUtils::writeFileAtomic(const std::filesystem::path &path,
+                                const std::string &content) {
+  if (path.has_parent_path()) {
+    createDirectories(path.parent_path());
+  }
+  // Write next to the target and rename over it so readers (and a crash
+  // mid-write) never observe a truncated file.
+  std::filesystem::path tmpPath = path;
+  tmpPath += ".tmp";
+  FILE *f = std::fopen(tmpPath.string().c_str(), "wb");
+  if (!f)
+    return false;
+  bool ok = std::fwrite(content.data(), 1, content.size(), f) == content.size();
+  ok = ok && std::fflush(f) == 0;
+#ifndef _WIN32
+  ok = ok && ::fsync(fileno(f)) == 0;
+#endif
+  ok = (std::fclose(f) == 0) && ok;
+  std::error_code ec;
+  if (ok) {
+    std::filesystem::rename(tmpPath, path, ec);
+    ok = !ec;
+  }
+  if (!ok) {
+    std::filesystem::remove(tmpPath, ec);
+  }
+  return ok;
+}
 std::filesystem::path FileUtils::expandPath(const std::string &pathVal) {
   if (pathVal.empty())
     return "";
@@ -109,25 +138,8 @@ std::string FileUtils::getMimeType(const std::filesystem::path &path) {
   return "application/octet-stream";
 }
 std::string FileUtils::calculateHash(const std::filesystem::path &path) {
-#ifdef _WIN32
-    return ""; 
-#else
-  std::string cmd = "sha256sum \"" + path.string() + "\" 2>/dev/null";
-  std::array<char, 128> buffer;
-  std::string result;
-  std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd.c_str(), "r"),
-                                                pclose);
-  if (!pipe) {
-    return "";
-  }
-  while (fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr) {
-    result += buffer.data();
-  }
-  std::istringstream iss(result);
-  std::string hash;
-  iss >> hash;
-  return hash;
-#endif
+  auto hash = ContentHash::file(path);
+  return hash ? ContentHash::toHex(*hash) : "";
 }
 std::string FileUtils::getExtension(const std::filesystem::path &path) {
   if (!path.has_extension())
@@ -11,10 +11,13 @@ public:
   static std::string readFile(const std::filesystem::path &path);
   static bool writeFile(const std::filesystem::path &path,
                         const std::string &content);
+  static bool writeFileAtomic(const std::filesystem::path &path,
+                              const std::string &content);
   static std::filesystem::path expandPath(const std::string &pathVal);
   static std::filesystem::path getUserHomeDir();
   static std::string getMimeType(const std::filesystem::path &path);
-  static std::string calculateHash(const std::filesystem::path &path);  
+  // Hex XXH64 of the file contents, or empty if it cannot be read.
+  static std::string calculateHash(const std::filesystem::path &path);
   static std::string getExtension(const std::filesystem::path &path);
 };
 }  
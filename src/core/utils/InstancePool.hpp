@@ -0,0 +1,83 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+namespace bwp::utils {
+// Up to `maxLive` expensive objects, created on demand and handed out one
+// caller at a time. Returned objects are kept idle for the next caller;
+// callers beyond the limit wait for one to come back. An object returned as
+// not reusable is destroyed and its slot freed. Once the factory fails it
+// is not called again, and every waiting or later acquire() gets nullptr.
+// Thread-safe; the factory and destructors run outside the lock.
+template <typename T> class InstancePool {
+public:
+  using Factory = std::function<std::unique_ptr<T>()>;
+  InstancePool(size_t maxLive, Factory create)
+      : m_maxLive(std::max<size_t>(maxLive, 1)), m_create(std::move(create)) {}
+  InstancePool(const InstancePool &) = delete;
+  InstancePool &operator=(const InstancePool &) = delete;
+  std::unique_ptr<T> acquire() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_available.wait(lock, [this] {
+      return m_unavailable || !m_idle.empty() || m_live < m_maxLive;
+    });
+    if (m_unavailable)
+      return nullptr;
+    if (!m_idle.empty()) {
+      auto instance = std::move(m_idle.back());
+      m_idle.pop_back();
+      return instance;
+    }
+    m_live++;
+    lock.unlock();
+    auto instance = m_create();
+    if (!instance) {
+      lock.lock();
+      m_live--;
+      m_unavailable = true;
+      m_available.notify_all();
+    }
+    return instance;
+  }
+  void release(std::unique_ptr<T> instance, bool reusable) {
+    if (!instance)
+      return;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (reusable) {
+        m_idle.push_back(std::move(instance));
+      } else {
+        m_live--;
+      }
+      m_available.notify_one();
+    }
+    instance.reset();
+  }
+  size_t live() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_live;
+  }
+  size_t idle() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_idle.size();
+  }
+  bool unavailable() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_unavailable;
+  }
+
+private:
+  const size_t m_maxLive;
+  Factory m_create;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_available;
+  std::vector<std::unique_ptr<T>> m_idle;
+  size_t m_live = 0; // handed out plus idle
+  bool m_unavailable = false;
+};
+} // namespace bwp::utils
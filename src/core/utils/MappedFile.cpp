@@ -0,0 +1,58 @@
+#include "MappedFile.hpp"
+#include <fstream>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+namespace bwp::utils {
+std::unique_ptr<MappedFile> MappedFile::open(const std::filesystem::path &path) {
+#ifndef _WIN32
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return nullptr;
+  auto file = map(fd);
+  ::close(fd);
+  return file;
+#else
+  std::unique_ptr<MappedFile> file(new MappedFile());
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in.is_open())
+    return nullptr;
+  auto size = static_cast<size_t>(in.tellg());
+  if (size == 0)
+    return nullptr;
+  file->m_buffer.resize(size);
+  in.seekg(0);
+  if (!in.read(reinterpret_cast<char *>(file->m_buffer.data()), size))
+    return nullptr;
+  file->m_data = file->m_buffer.data();
+  file->m_size = size;
+  return file;
+#endif
+}
+#ifndef _WIN32
+std::unique_ptr<MappedFile> MappedFile::map(int fd) {
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 || st.st_size <= 0)
+    return nullptr;
+  void *addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                      MAP_PRIVATE, fd, 0);
+  if (addr == MAP_FAILED)
+    return nullptr;
+  std::unique_ptr<MappedFile> file(new MappedFile());
+  file->m_data = static_cast<const uint8_t *>(addr);
+  file->m_size = static_cast<size_t>(st.st_size);
+  file->m_mapped = true;
+  return file;
+}
+#endif
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+  if (m_mapped && m_data) {
+    ::munmap(const_cast<uint8_t *>(m_data), m_size);
+  }
+#endif
+}
+} // namespace bwp::utils
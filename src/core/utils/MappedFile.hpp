@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+namespace bwp::utils {
+// Read-only view of a whole file. Uses mmap where available and falls back
+// to reading the file into memory elsewhere.
+class MappedFile {
+public:
+  static std::unique_ptr<MappedFile> open(const std::filesystem::path &path);
+#ifndef _WIN32
+  // Maps whatever `fd` currently holds; the descriptor stays open.
+  static std::unique_ptr<MappedFile> map(int fd);
+#endif
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  const uint8_t *data() const { return m_data; }
+  size_t size() const { return m_size; }
+
+private:
+  MappedFile() = default;
+  const uint8_t *m_data = nullptr;
+  size_t m_size = 0;
+  bool m_mapped = false;
+  std::vector<uint8_t> m_buffer;
+};
+} // namespace bwp::utils
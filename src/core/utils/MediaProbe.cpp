@@ -0,0 +1,586 @@
+#include "MediaProbe.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <vector>
+namespace bwp::utils {
+namespace {
+// Boxes and elements larger than this are never read into memory; a moov
+// box for a multi-hour video with a full sample table stays well below it.
+constexpr uint64_t kMaxHeaderBytes = 16 * 1024 * 1024;
+class Source {
+public:
+  explicit Source(const std::filesystem::path &path)
+      : m_in(path, std::ios::binary) {
+    std::error_code ec;
+    m_size = std::filesystem::file_size(path, ec);
+    if (ec)
+      m_size = 0;
+  }
+  bool ok() const { return m_in.good() && m_size > 0; }
+  uint64_t size() const { return m_size; }
+  bool read(uint64_t offset, void *out, size_t n) {
+    if (offset > m_size || n > m_size - offset)
+      return false;
+    m_in.clear();
+    m_in.seekg(static_cast<std::streamoff>(offset));
+    m_in.read(static_cast<char *>(out), static_cast<std::streamsize>(n));
+    return m_in.gcount() == static_cast<std::streamsize>(n);
+  }
+  bool read(uint64_t offset, std::vector<uint8_t> &out, size_t n) {
+    out.resize(n);
+    return read(offset, out.data(), n);
+  }
+
+private:
+  std::ifstream m_in;
+  uint64_t m_size = 0;
+};
+uint16_t be16(const uint8_t *p) { return uint16_t(p[0] << 8 | p[1]); }
+uint32_t be32(const uint8_t *p) {
+  return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 |
+         p[3];
+}
+uint64_t be64(const uint8_t *p) { return uint64_t(be32(p)) << 32 | be32(p + 4); }
+uint16_t le16(const uint8_t *p) { return uint16_t(p[0] | p[1] << 8); }
+uint32_t le32(const uint8_t *p) {
+  return p[0] | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 |
+         uint32_t(p[3]) << 24;
+}
+bool tag(const uint8_t *p, const char *fourcc) {
+  return std::memcmp(p, fourcc, 4) == 0;
+}
+std::string fourccName(const uint8_t *p) {
+  std::string name;
+  for (int i = 0; i < 4; ++i) {
+    if (p[i] == ' ' || p[i] == 0)
+      break;
+    name += static_cast<char>(std::tolower(p[i]));
+  }
+  return name;
+}
+// --- Still images -------------------------------------------------------
+std::optional<MediaInfo> probeJpeg(Source &src) {
+  uint64_t pos = 2;
+  uint8_t hdr[9];
+  while (src.read(pos, hdr, 4)) {
+    if (hdr[0] != 0xFF)
+      return std::nullopt;
+    uint8_t marker = hdr[1];
+    if (marker == 0xFF) { // fill byte
+      pos++;
+      continue;
+    }
+    if (marker == 0xD8 || (marker >= 0xD0 && marker <= 0xD7) || marker == 0x01) {
+      pos += 2;
+      continue;
+    }
+    if (marker == 0xD9 || marker == 0xDA)
+      return std::nullopt; // no frame header before the scan data
+    uint16_t length = be16(hdr + 2);
+    // SOF0..SOF15, excluding DHT (C4), JPG (C8) and DAC (CC).
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+        marker != 0xC8 && marker != 0xCC) {
+      if (!src.read(pos + 4, hdr, 5))
+        return std::nullopt;
+      MediaInfo info;
+      info.height = be16(hdr + 1);
+      info.width = be16(hdr + 3);
+      info.codec = "jpeg";
+      return info;
+    }
+    pos += 2 + length;
+  }
+  return std::nullopt;
+}
+std::optional<MediaInfo> probePng(Source &src) {
+  uint8_t ihdr[16];
+  if (!src.read(8, ihdr, sizeof(ihdr)) || !tag(ihdr + 4, "IHDR"))
+    return std::nullopt;
+  MediaInfo info;
+  info.width = static_cast<int>(be32(ihdr + 8));
+  info.height = static_cast<int>(be32(ihdr + 12));
+  info.codec = "png";
+  // APNG declares acTL before the first IDAT; walk the chunk headers.
+  uint64_t pos = 8;
+  uint8_t chunk[8];
+  while (src.read(pos, chunk, sizeof(chunk))) {
+    if (tag(chunk + 4, "IDAT") || tag(chunk + 4, "IEND"))
+      break;
+    if (tag(chunk + 4, "acTL")) {
+      info.codec = "apng";
+      break;
+    }
+    pos += 12 + uint64_t(be32(chunk));
+  }
+  return info;
+}
+std::optional<MediaInfo> probeGif(Source &src) {
+  uint8_t hdr[10];
+  if (!src.read(0, hdr, sizeof(hdr)))
+    return std::nullopt;
+  MediaInfo info;
+  info.width = le16(hdr + 6);
+  info.height = le16(hdr + 8);
+  info.codec = "gif";
+  return info;
+}
+std::optional<MediaInfo> probeBmp(Source &src) {
+  uint8_t hdr[26];
+  if (!src.read(0, hdr, sizeof(hdr)))
+    return std::nullopt;
+  MediaInfo info;
+  if (le32(hdr + 14) == 12) { // BITMAPCOREHEADER
+    info.width = le16(hdr + 18);
+    info.height = le16(hdr + 20);
+  } else {
+    info.width = static_cast<int32_t>(le32(hdr + 18));
+    info.height = std::abs(static_cast<int32_t>(le32(hdr + 22)));
+  }
+  info.codec = "bmp";
+  return info;
+}
+std::optional<MediaInfo> probeWebp(Source &src) {
+  uint8_t hdr[30];
+  if (!src.read(0, hdr, sizeof(hdr)))
+    return std::nullopt;
+  MediaInfo info;
+  info.codec = "webp";
+  const uint8_t *chunk = hdr + 12;
+  const uint8_t *data = hdr + 20;
+  if (tag(chunk, "VP8X")) {
+    info.width = 1 + int(data[4] | data[5] << 8 | data[6] << 16);
+    info.height = 1 + int(data[7] | data[8] << 8 | data[9] << 16);
+  } else if (tag(chunk, "VP8L")) {
+    uint32_t bits = le32(data + 1);
+    info.width = 1 + int(bits & 0x3FFF);
+    info.height = 1 + int((bits >> 14) & 0x3FFF);
+  } else if (tag(chunk, "VP8 ")) {
+    info.width = le16(data + 6) & 0x3FFF;
+    info.height = le16(data + 8) & 0x3FFF;
+  } else {
+    return std::nullopt;
+  }
+  return info;
+}
+// --- ISO BMFF (MP4 / MOV) -----------------------------------------------
+struct Box {
+  const uint8_t *type;
+  const uint8_t *data;
+  size_t size;
+};
+// Iterates the child boxes of a buffer held in memory.
+template <typename Fn> void eachBox(const uint8_t *p, size_t n, Fn &&fn) {
+  size_t pos = 0;
+  while (pos + 8 <= n) {
+    uint64_t size = be32(p + pos);
+    size_t header = 8;
+    if (size == 1) {
+      if (pos + 16 > n)
+        return;
+      size = be64(p + pos + 8);
+      header = 16;
+    } else if (size == 0) {
+      size = n - pos;
+    }
+    if (size < header || size > n - pos)
+      return;
+    fn(Box{p + pos + 4, p + pos + header, size_t(size - header)});
+    pos += size;
+  }
+}
+std::string isoCodecName(const uint8_t *fourcc) {
+  if (tag(fourcc, "avc1") || tag(fourcc, "avc3"))
+    return "h264";
+  if (tag(fourcc, "hvc1") || tag(fourcc, "hev1"))
+    return "hevc";
+  if (tag(fourcc, "av01"))
+    return "av1";
+  if (tag(fourcc, "vp09"))
+    return "vp9";
+  if (tag(fourcc, "vp08"))
+    return "vp8";
+  if (tag(fourcc, "mp4v"))
+    return "mpeg4";
+  return fourccName(fourcc);
+}
+struct IsoTrack {
+  bool video = false;
+  uint32_t timescale = 0;
+  uint64_t duration = 0;
+  uint64_t samples = 0;
+  uint64_t sampleTime = 0;
+  int width = 0;
+  int height = 0;
+  std::string codec;
+};
+void parseStbl(const Box &stbl, IsoTrack &track) {
+  eachBox(stbl.data, stbl.size, [&](const Box &box) {
+    if (tag(box.type, "stsd") && box.size >= 8 + 36) {
+      const uint8_t *entry = box.data + 8;
+      track.codec = isoCodecName(entry + 4);
+      track.width = be16(entry + 32);
+      track.height = be16(entry + 34);
+    } else if (tag(box.type, "stts") && box.size >= 8) {
+      uint32_t count = be32(box.data + 4);
+      count = std::min<uint64_t>(count, (box.size - 8) / 8);
+      for (uint32_t i = 0; i < count; ++i) {
+        uint64_t samples = be32(box.data + 8 + i * 8);
+        track.samples += samples;
+        track.sampleTime += samples * be32(box.data + 12 + i * 8);
+      }
+    }
+  });
+}
+void parseTrak(const Box &trak, IsoTrack &track) {
+  eachBox(trak.data, trak.size, [&](const Box &box) {
+    if (tag(box.type, "tkhd") && box.size >= 84) {
+      // Display size, 16.16 fixed point, in the last 8 bytes.
+      if (!track.width) {
+        track.width = int(be32(box.data + box.size - 8) >> 16);
+        track.height = int(be32(box.data + box.size - 4) >> 16);
+      }
+    } else if (tag(box.type, "mdia")) {
+      eachBox(box.data, box.size, [&](const Box &child) {
+        if (tag(child.type, "mdhd") && child.size >= 24) {
+          if (child.data[0] == 1 && child.size >= 36) {
+            track.timescale = be32(child.data + 20);
+            track.duration = be64(child.data + 24);
+          } else {
+            track.timescale = be32(child.data + 12);
+            track.duration = be32(child.data + 16);
+          }
+        } else if (tag(child.type, "hdlr") && child.size >= 12) {
+          track.video = tag(child.data + 8, "vide");
+        } else if (tag(child.type, "minf")) {
+          eachBox(child.data, child.size, [&](const Box &minf) {
+            if (tag(minf.type, "stbl"))
+              parseStbl(minf, track);
+          });
+        }
+      });
+    }
+  });
+}
+std::optional<MediaInfo> probeIso(Source &src) {
+  // Walk top-level box headers only, seeking past mdat wherever it sits.
+  uint64_t pos = 0;
+  uint8_t hdr[16];
+  std::vector<uint8_t> moov;
+  while (pos + 8 <= src.size() && src.read(pos, hdr, 8)) {
+    uint64_t size = be32(hdr);
+    uint64_t header = 8;
+    if (size == 1) {
+      if (!src.read(pos + 8, hdr + 8, 8))
+        break;
+      size = be64(hdr + 8);
+      header = 16;
+    } else if (size == 0) {
+      size = src.size() - pos;
+    }
+    if (size < header)
+      break;
+    if (tag(hdr + 4, "moov")) {
+      if (size - header > kMaxHeaderBytes ||
+          !src.read(pos + header, moov, size_t(size - header)))
+        return std::nullopt;
+      break;
+    }
+    pos += size;
+  }
+  if (moov.empty())
+    return std::nullopt;
+  MediaInfo info;
+  uint32_t movieTimescale = 0;
+  uint64_t movieDuration = 0;
+  std::optional<IsoTrack> video;
+  eachBox(moov.data(), moov.size(), [&](const Box &box) {
+    if (tag(box.type, "mvhd") && box.size >= 20) {
+      if (box.data[0] == 1 && box.size >= 32) {
+        movieTimescale = be32(box.data + 20);
+        movieDuration = be64(box.data + 24);
+      } else {
+        movieTimescale = be32(box.data + 12);
+        movieDuration = be32(box.data + 16);
+      }
+    } else if (tag(box.type, "trak") && !video) {
+      IsoTrack track;
+      parseTrak(box, track);
+      if (track.video)
+        video = track;
+    }
+  });
+  if (movieTimescale)
+    info.duration = double(movieDuration) / movieTimescale;
+  if (video) {
+    info.width = video->width;
+    info.height = video->height;
+    info.codec = video->codec;
+    if (video->timescale) {
+      if (info.duration <= 0)
+        info.duration = double(video->duration) / video->timescale;
+      if (video->sampleTime)
+        info.frameRate =
+            double(video->samples) * video->timescale / video->sampleTime;
+    }
+  }
+  return info;
+}
+// --- Matroska / WebM ----------------------------------------------------
+constexpr uint32_t kEbmlSegment = 0x18538067;
+constexpr uint32_t kEbmlInfo = 0x1549A966;
+constexpr uint32_t kEbmlTracks = 0x1654AE6B;
+constexpr uint32_t kEbmlCluster = 0x1F43B675;
+constexpr uint32_t kEbmlTimecodeScale = 0x2AD7B1;
+constexpr uint32_t kEbmlDuration = 0x4489;
+constexpr uint32_t kEbmlTrackEntry = 0xAE;
+constexpr uint32_t kEbmlTrackType = 0x83;
+constexpr uint32_t kEbmlCodecId = 0x86;
+constexpr uint32_t kEbmlDefaultDuration = 0x23E383;
+constexpr uint32_t kEbmlVideo = 0xE0;
+constexpr uint32_t kEbmlPixelWidth = 0xB0;
+constexpr uint32_t kEbmlPixelHeight = 0xBA;
+constexpr uint64_t kEbmlUnknownSize = ~uint64_t(0);
+struct Element {
+  uint32_t id = 0;
+  uint64_t size = 0; // kEbmlUnknownSize when open-ended
+  size_t header = 0;
+};
+// Decodes an element ID and size from at most 12 bytes.
+bool readElement(const uint8_t *p, size_t n, Element &el) {
+  if (n < 2 || p[0] == 0)
+    return false;
+  int idLen = 1;
+  while (idLen <= 4 && !(p[0] & (0x80 >> (idLen - 1))))
+    ++idLen;
+  if (idLen > 4 || size_t(idLen) >= n || p[idLen] == 0)
+    return false;
+  el.id = 0;
+  for (int i = 0; i < idLen; ++i)
+    el.id = el.id << 8 | p[i];
+  const uint8_t *s = p + idLen;
+  int sizeLen = 1;
+  while (!(s[0] & (0x80 >> (sizeLen - 1))))
+    ++sizeLen;
+  if (size_t(idLen + sizeLen) > n)
+    return false;
+  uint64_t size = s[0] & (0xFF >> sizeLen);
+  bool allOnes = size == uint64_t(0xFF >> sizeLen);
+  for (int i = 1; i < sizeLen; ++i) {
+    size = size << 8 | s[i];
+    allOnes = allOnes && s[i] == 0xFF;
+  }
+  el.size = allOnes ? kEbmlUnknownSize : size;
+  el.header = size_t(idLen + sizeLen);
+  return true;
+}
+template <typename Fn> void eachElement(const uint8_t *p, size_t n, Fn &&fn) {
+  size_t pos = 0;
+  Element el;
+  while (pos < n && readElement(p + pos, n - pos, el)) {
+    if (el.size == kEbmlUnknownSize || el.size > n - pos - el.header)
+      return;
+    fn(el.id, p + pos + el.header, size_t(el.size));
+    pos += el.header + el.size;
+  }
+}
+uint64_t ebmlUint(const uint8_t *p, size_t n) {
+  uint64_t v = 0;
+  for (size_t i = 0; i < n && i < 8; ++i)
+    v = v << 8 | p[i];
+  return v;
+}
+double ebmlFloat(const uint8_t *p, size_t n) {
+  if (n == 4) {
+    uint32_t bits = be32(p);
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+  }
+  if (n == 8) {
+    uint64_t bits = be64(p);
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+  }
+  return 0.0;
+}
+std::string matroskaCodecName(std::string id) {
+  if (id == "V_VP9")
+    return "vp9";
+  if (id == "V_VP8")
+    return "vp8";
+  if (id == "V_AV1")
+    return "av1";
+  if (id == "V_MPEG4/ISO/AVC")
+    return "h264";
+  if (id == "V_MPEGH/ISO/HEVC")
+    return "hevc";
+  if (id.rfind("V_", 0) == 0)
+    id.erase(0, 2);
+  std::transform(id.begin(), id.end(), id.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return id;
+}
+std::optional<MediaInfo> probeMatroska(Source &src) {
+  uint8_t hdr[12];
+  Element el;
+  // EBML header, then the Segment whose children are walked by header.
+  if (!src.read(0, hdr, sizeof(hdr)) || !readElement(hdr, sizeof(hdr), el))
+    return std::nullopt;
+  uint64_t pos = el.header + el.size;
+  if (!src.read(pos, hdr, std::min<uint64_t>(12, src.size() - pos)) ||
+      !readElement(hdr, sizeof(hdr), el) || el.id != kEbmlSegment)
+    return std::nullopt;
+  pos += el.header;
+  uint64_t end = el.size == kEbmlUnknownSize
+                     ? src.size()
+                     : std::min(src.size(), pos + el.size);
+  MediaInfo info;
+  uint64_t timecodeScale = 1000000;
+  double rawDuration = 0.0;
+  bool haveInfo = false;
+  bool haveTracks = false;
+  std::vector<uint8_t> body;
+  while (pos < end && !(haveInfo && haveTracks)) {
+    size_t avail = size_t(std::min<uint64_t>(12, end - pos));
+    if (!src.read(pos, hdr, avail) || !readElement(hdr, avail, el))
+      break;
+    // Clusters carry the media; metadata normally precedes them, and an
+    // open-ended one cannot be skipped anyway.
+    if (el.id == kEbmlCluster || el.size == kEbmlUnknownSize)
+      break;
+    if ((el.id == kEbmlInfo || el.id == kEbmlTracks) &&
+        el.size <= kMaxHeaderBytes &&
+        src.read(pos + el.header, body, size_t(el.size))) {
+      if (el.id == kEbmlInfo) {
+        haveInfo = true;
+        eachElement(body.data(), body.size(),
+                    [&](uint32_t id, const uint8_t *p, size_t n) {
+                      if (id == kEbmlTimecodeScale)
+                        timecodeScale = ebmlUint(p, n);
+                      else if (id == kEbmlDuration)
+                        rawDuration = ebmlFloat(p, n);
+                    });
+      } else {
+        haveTracks = true;
+        bool found = false;
+        eachElement(
+            body.data(), body.size(),
+            [&](uint32_t id, const uint8_t *p, size_t n) {
+              if (id != kEbmlTrackEntry || found)
+                return;
+              uint64_t type = 0;
+              uint64_t frameNs = 0;
+              MediaInfo track;
+              eachElement(p, n, [&](uint32_t tid, const uint8_t *tp,
+                                    size_t tn) {
+                if (tid == kEbmlTrackType)
+                  type = ebmlUint(tp, tn);
+                else if (tid == kEbmlCodecId)
+                  track.codec = matroskaCodecName(
+                      std::string(reinterpret_cast<const char *>(tp), tn));
+                else if (tid == kEbmlDefaultDuration)
+                  frameNs = ebmlUint(tp, tn);
+                else if (tid == kEbmlVideo)
+                  eachElement(tp, tn, [&](uint32_t vid, const uint8_t *vp,
+                                          size_t vn) {
+                    if (vid == kEbmlPixelWidth)
+                      track.width = int(ebmlUint(vp, vn));
+                    else if (vid == kEbmlPixelHeight)
+                      track.height = int(ebmlUint(vp, vn));
+                  });
+              });
+              if (type != 1) // video
+                return;
+              found = true;
+              info.width = track.width;
+              info.height = track.height;
+              info.codec = track.codec;
+              if (frameNs)
+                info.frameRate = 1e9 / double(frameNs);
+            });
+      }
+    }
+    pos += el.header + el.size;
+  }
+  if (!haveInfo && !haveTracks)
+    return std::nullopt;
+  info.duration = rawDuration * double(timecodeScale) / 1e9;
+  return info;
+}
+// --- AVI ----------------------------------------------------------------
+std::optional<MediaInfo> probeAvi(Source &src) {
+  uint8_t hdr[12];
+  if (!src.read(12, hdr, sizeof(hdr)) || !tag(hdr, "LIST") ||
+      !tag(hdr + 8, "hdrl"))
+    return std::nullopt;
+  uint32_t size = le32(hdr + 4);
+  std::vector<uint8_t> hdrl;
+  if (size < 4 || size > kMaxHeaderBytes || !src.read(24, hdrl, size - 4))
+    return std::nullopt;
+  MediaInfo info;
+  auto chunks = [](const std::vector<uint8_t> &buf, size_t begin, size_t end,
+                   auto &&fn) {
+    for (size_t pos = begin; pos + 8 <= end;) {
+      uint32_t n = le32(buf.data() + pos + 4);
+      if (n > end - pos - 8)
+        return;
+      fn(buf.data() + pos, buf.data() + pos + 8, n);
+      pos += 8 + n + (n & 1);
+    }
+  };
+  chunks(hdrl, 0, hdrl.size(),
+         [&](const uint8_t *id, const uint8_t *data, uint32_t n) {
+           if (tag(id, "avih") && n >= 40) {
+             uint32_t usPerFrame = le32(data);
+             uint32_t frames = le32(data + 16);
+             info.width = int(le32(data + 32));
+             info.height = int(le32(data + 36));
+             if (usPerFrame) {
+               info.frameRate = 1e6 / usPerFrame;
+               info.duration = double(frames) * usPerFrame / 1e6;
+             }
+           } else if (tag(id, "LIST") && n >= 4 && tag(data, "strl") &&
+                      info.codec.empty()) {
+             const size_t begin = size_t(data - hdrl.data()) + 4;
+             chunks(hdrl, begin, begin + n - 4,
+                    [&](const uint8_t *sid, const uint8_t *sdata, uint32_t sn) {
+                      if (tag(sid, "strh") && sn >= 8 && tag(sdata, "vids"))
+                        info.codec = fourccName(sdata + 4);
+                    });
+           }
+         });
+  return info;
+}
+} // namespace
+std::optional<MediaInfo> MediaProbe::probe(const std::filesystem::path &path) {
+  Source src(path);
+  uint8_t magic[12] = {};
+  if (!src.ok() || !src.read(0, magic, std::min<uint64_t>(12, src.size())))
+    return std::nullopt;
+  std::optional<MediaInfo> info;
+  if (magic[0] == 0xFF && magic[1] == 0xD8)
+    info = probeJpeg(src);
+  else if (std::memcmp(magic, "\x89PNG\r\n\x1a\n", 8) == 0)
+    info = probePng(src);
+  else if (std::memcmp(magic, "GIF8", 4) == 0)
+    info = probeGif(src);
+  else if (magic[0] == 'B' && magic[1] == 'M')
+    info = probeBmp(src);
+  else if (tag(magic, "RIFF") && tag(magic + 8, "WEBP"))
+    info = probeWebp(src);
+  else if (tag(magic, "RIFF") && tag(magic + 8, "AVI "))
+    info = probeAvi(src);
+  else if (be32(magic) == 0x1A45DFA3)
+    info = probeMatroska(src);
+  else if (tag(magic + 4, "ftyp") || tag(magic + 4, "moov") ||
+           tag(magic + 4, "wide") || tag(magic + 4, "mdat") ||
+           tag(magic + 4, "free"))
+    info = probeIso(src);
+  if (info && (info->width < 0 || info->height < 0))
+    return std::nullopt;
+  return info;
+}
+} // namespace bwp::utils
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+namespace bwp::utils {
+struct MediaInfo {
+  int width = 0;
+  int height = 0;
+  double duration = 0.0;  // seconds; 0 when unknown or a still image
+  double frameRate = 0.0; // 0 when unknown
+  std::string codec;      // "jpeg", "png", "gif", "webp", "h264", "vp9", ...
+};
+// Reads dimensions, duration, frame rate and codec from container and
+// image headers only: JPEG SOF, PNG IHDR (acTL for APNG), GIF and BMP
+// headers, WebP VP8/VP8L/VP8X, ISO BMFF (MP4/MOV) moov boxes, Matroska/WebM
+// Info and Tracks, and AVI avih/strh. Payload data is seeked over, never
+// read. The format is detected from the file's magic bytes.
+class MediaProbe {
+public:
+  static std::optional<MediaInfo> probe(const std::filesystem::path &path);
+};
+} // namespace bwp::utils
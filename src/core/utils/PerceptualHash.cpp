@@ -0,0 +1,42 @@
+#include "PerceptualHash.hpp"
+#include <algorithm>
+namespace bwp::utils {
+namespace phash {
+uint64_t dhash(const uint8_t *pixels, int width, int height, int rowstride,
+               int channels) {
+  constexpr int kCols = 9;
+  constexpr int kRows = 8;
+  if (!pixels || width <= 0 || height <= 0 || channels < 3)
+    return 0;
+  double grid[kRows][kCols];
+  for (int gy = 0; gy < kRows; ++gy) {
+    int y0 = gy * height / kRows;
+    int y1 = std::max(y0 + 1, (gy + 1) * height / kRows);
+    for (int gx = 0; gx < kCols; ++gx) {
+      int x0 = gx * width / kCols;
+      int x1 = std::max(x0 + 1, (gx + 1) * width / kCols);
+      uint64_t sum = 0;
+      for (int y = y0; y < std::min(y1, height); ++y) {
+        const uint8_t *row = pixels + static_cast<size_t>(y) * rowstride;
+        for (int x = x0; x < std::min(x1, width); ++x) {
+          const uint8_t *p = row + static_cast<size_t>(x) * channels;
+          // Rec. 601 luma in fixed point.
+          sum += 299u * p[0] + 587u * p[1] + 114u * p[2];
+        }
+      }
+      int count = (std::min(y1, height) - y0) * (std::min(x1, width) - x0);
+      grid[gy][gx] = static_cast<double>(sum) / count;
+    }
+  }
+  uint64_t hash = 0;
+  for (int gy = 0; gy < kRows; ++gy) {
+    for (int gx = 0; gx < kCols - 1; ++gx) {
+      hash <<= 1;
+      if (grid[gy][gx] > grid[gy][gx + 1])
+        hash |= 1;
+    }
+  }
+  return hash == 0 ? 1 : hash;
+}
+}  
+}  
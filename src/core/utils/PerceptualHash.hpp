@@ -0,0 +1,16 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+namespace bwp::utils {
+namespace phash {
+// 64-bit difference hash (dHash): the image is box-filtered down to a 9x8
+// luma grid and each bit records whether a cell is brighter than its right
+// neighbour. Resizing, re-encoding and mild colour changes flip few bits, so
+// the Hamming distance between two hashes measures visual similarity.
+// `channels` is 3 (RGB) or 4 (RGBA). Never returns 0, which callers use as
+// "not computed"; a flat image (all bits clear) hashes to 1 instead.
+uint64_t dhash(const uint8_t *pixels, int width, int height, int rowstride,
+               int channels);
+inline int distance(uint64_t a, uint64_t b) { return std::popcount(a ^ b); }
+}  
+}  
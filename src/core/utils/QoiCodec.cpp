@@ -0,0 +1,198 @@
+#include "QoiCodec.hpp"
+#include <cstring>
+namespace bwp::utils {
+namespace qoi {
+namespace {
+constexpr uint8_t kOpIndex = 0x00;
+constexpr uint8_t kOpDiff = 0x40;
+constexpr uint8_t kOpLuma = 0x80;
+constexpr uint8_t kOpRun = 0xc0;
+constexpr uint8_t kOpRgb = 0xfe;
+constexpr uint8_t kOpRgba = 0xff;
+constexpr uint8_t kMask = 0xc0;
+constexpr size_t kHeaderSize = 14;
+constexpr uint8_t kPadding[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+// Keeps a malformed header from claiming a multi-gigabyte image.
+constexpr uint64_t kMaxPixels = 64ull << 20;
+struct Pixel {
+  uint8_t r = 0, g = 0, b = 0, a = 255;
+  bool operator==(const Pixel &o) const {
+    return r == o.r && g == o.g && b == o.b && a == o.a;
+  }
+};
+inline unsigned hash(const Pixel &p) {
+  return (p.r * 3u + p.g * 5u + p.b * 7u + p.a * 11u) % 64u;
+}
+void putU32BE(std::string &out, uint32_t v) {
+  out.push_back(static_cast<char>(v >> 24));
+  out.push_back(static_cast<char>(v >> 16));
+  out.push_back(static_cast<char>(v >> 8));
+  out.push_back(static_cast<char>(v));
+}
+uint32_t readU32BE(const uint8_t *p) {
+  return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 |
+         static_cast<uint32_t>(p[2]) << 8 | p[3];
+}
+// Every chunk is at most 5 bytes and `end` stops before the padding, which
+// is never a chunk.
+template <int Channels>
+bool decodePixels(const Header &header, const uint8_t *p, const uint8_t *end,
+                  uint8_t *out, size_t rowstride) {
+  Pixel index[64] = {};
+  for (auto &slot : index)
+    slot.a = 0;
+  Pixel px;
+  int run = 0;
+  for (uint32_t y = 0; y < header.height; ++y) {
+    uint8_t *d = out + y * rowstride;
+    for (uint32_t x = 0; x < header.width; ++x, d += Channels) {
+      if (run > 0) {
+        run--;
+      } else {
+        if (p >= end)
+          return false;
+        uint8_t b1 = *p++;
+        if (b1 == kOpRgb) {
+          if (end - p < 3)
+            return false;
+          px.r = p[0];
+          px.g = p[1];
+          px.b = p[2];
+          p += 3;
+        } else if (b1 == kOpRgba) {
+          if (end - p < 4)
+            return false;
+          px.r = p[0];
+          px.g = p[1];
+          px.b = p[2];
+          px.a = p[3];
+          p += 4;
+        } else if ((b1 & kMask) == kOpIndex) {
+          px = index[b1];
+        } else if ((b1 & kMask) == kOpDiff) {
+          px.r = static_cast<uint8_t>(px.r + ((b1 >> 4) & 3) - 2);
+          px.g = static_cast<uint8_t>(px.g + ((b1 >> 2) & 3) - 2);
+          px.b = static_cast<uint8_t>(px.b + (b1 & 3) - 2);
+        } else if ((b1 & kMask) == kOpLuma) {
+          if (p >= end)
+            return false;
+          uint8_t b2 = *p++;
+          int vg = (b1 & 0x3f) - 32;
+          px.r = static_cast<uint8_t>(px.r + vg - 8 + ((b2 >> 4) & 0x0f));
+          px.g = static_cast<uint8_t>(px.g + vg);
+          px.b = static_cast<uint8_t>(px.b + vg - 8 + (b2 & 0x0f));
+        } else {
+          run = b1 & 0x3f;
+        }
+        index[hash(px)] = px;
+      }
+      d[0] = px.r;
+      d[1] = px.g;
+      d[2] = px.b;
+      if constexpr (Channels == 4)
+        d[3] = px.a;
+    }
+  }
+  return true;
+}
+} // namespace
+std::string encode(const uint8_t *pixels, int width, int height,
+                   int rowstride, int channels) {
+  if (!pixels || width <= 0 || height <= 0 || (channels != 3 && channels != 4))
+    return {};
+  std::string out;
+  out.reserve(kHeaderSize + static_cast<size_t>(width) * height * 2 +
+              sizeof(kPadding));
+  out += "qoif";
+  putU32BE(out, static_cast<uint32_t>(width));
+  putU32BE(out, static_cast<uint32_t>(height));
+  out.push_back(static_cast<char>(channels));
+  out.push_back(0); // sRGB with linear alpha
+  Pixel index[64] = {};
+  for (auto &slot : index)
+    slot.a = 0;
+  Pixel prev;
+  int run = 0;
+  for (int y = 0; y < height; ++y) {
+    const uint8_t *row = pixels + static_cast<size_t>(y) * rowstride;
+    for (int x = 0; x < width; ++x) {
+      const uint8_t *s = row + static_cast<size_t>(x) * channels;
+      Pixel px{s[0], s[1], s[2], channels == 4 ? s[3] : uint8_t(255)};
+      if (px == prev) {
+        if (++run == 62) {
+          out.push_back(static_cast<char>(kOpRun | (run - 1)));
+          run = 0;
+        }
+        continue;
+      }
+      if (run > 0) {
+        out.push_back(static_cast<char>(kOpRun | (run - 1)));
+        run = 0;
+      }
+      unsigned slot = hash(px);
+      if (index[slot] == px) {
+        out.push_back(static_cast<char>(kOpIndex | slot));
+      } else {
+        index[slot] = px;
+        if (px.a == prev.a) {
+          int8_t vr = static_cast<int8_t>(px.r - prev.r);
+          int8_t vg = static_cast<int8_t>(px.g - prev.g);
+          int8_t vb = static_cast<int8_t>(px.b - prev.b);
+          int8_t vgr = static_cast<int8_t>(vr - vg);
+          int8_t vgb = static_cast<int8_t>(vb - vg);
+          if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+            out.push_back(static_cast<char>(kOpDiff | (vr + 2) << 4 |
+                                            (vg + 2) << 2 | (vb + 2)));
+          } else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 &&
+                     vgb < 8) {
+            out.push_back(static_cast<char>(kOpLuma | (vg + 32)));
+            out.push_back(static_cast<char>((vgr + 8) << 4 | (vgb + 8)));
+          } else {
+            out.push_back(static_cast<char>(kOpRgb));
+            out.push_back(static_cast<char>(px.r));
+            out.push_back(static_cast<char>(px.g));
+            out.push_back(static_cast<char>(px.b));
+          }
+        } else {
+          out.push_back(static_cast<char>(kOpRgba));
+          out.push_back(static_cast<char>(px.r));
+          out.push_back(static_cast<char>(px.g));
+          out.push_back(static_cast<char>(px.b));
+          out.push_back(static_cast<char>(px.a));
+        }
+      }
+      prev = px;
+    }
+  }
+  if (run > 0)
+    out.push_back(static_cast<char>(kOpRun | (run - 1)));
+  out.append(reinterpret_cast<const char *>(kPadding), sizeof(kPadding));
+  return out;
+}
+std::optional<Header> readHeader(const uint8_t *data, size_t size) {
+  if (!data || size < kHeaderSize + sizeof(kPadding) ||
+      std::memcmp(data, "qoif", 4) != 0)
+    return std::nullopt;
+  Header header;
+  header.width = readU32BE(data + 4);
+  header.height = readU32BE(data + 8);
+  header.channels = data[12];
+  if (header.width == 0 || header.height == 0 ||
+      (header.channels != 3 && header.channels != 4) ||
+      static_cast<uint64_t>(header.width) * header.height > kMaxPixels)
+    return std::nullopt;
+  return header;
+}
+bool decode(const uint8_t *data, size_t size, uint8_t *out,
+            size_t rowstride) {
+  auto header = readHeader(data, size);
+  if (!header || !out)
+    return false;
+  return header->channels == 4
+             ? decodePixels<4>(*header, data + kHeaderSize,
+                               data + size - sizeof(kPadding), out, rowstride)
+             : decodePixels<3>(*header, data + kHeaderSize,
+                               data + size - sizeof(kPadding), out, rowstride);
+}
+}  
+}  
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+namespace bwp::utils {
+namespace qoi {
+// "Quite OK Image" format (qoiformat.org): lossless, byte-oriented and
+// decodable in one pass without tables beyond a 64-entry colour cache, so
+// a 256 px thumbnail decodes several times faster than a PNG inflate.
+// Pixels are 8-bit RGB or straight-alpha RGBA, the same layout GdkPixbuf
+// and GDK_MEMORY_R8G8B8(A8) textures use, so decoded rows need no
+// conversion.
+struct Header {
+  uint32_t width = 0;
+  uint32_t height = 0;
+  int channels = 0; // 3 or 4
+};
+// `channels` is 3 (RGB) or 4 (RGBA); empty on invalid input.
+std::string encode(const uint8_t *pixels, int width, int height,
+                   int rowstride, int channels);
+std::optional<Header> readHeader(const uint8_t *data, size_t size);
+// Writes header.channels bytes per pixel into `out`, rows `rowstride`
+// apart. False if the stream is truncated or malformed.
+bool decode(const uint8_t *data, size_t size, uint8_t *out, size_t rowstride);
+}  
+}  
@@ -0,0 +1,184 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+namespace bwp::utils {
+// Least-recently-used cache budgeted in bytes. Keys hash to one of several
+// shards, each with its own lock, budget (an equal share of the total) and
+// recency list threaded through the map nodes, so lookups, touches and
+// evictions are O(1) and concurrent callers rarely contend. Evicted values
+// are destroyed after the shard lock is released.
+template <typename Value> class ShardedLruCache {
+public:
+  struct Stats {
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t budgetBytes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+  };
+  explicit ShardedLruCache(size_t budgetBytes, unsigned shards = 8)
+      : m_shards(std::max(1u, shards)) {
+    setBudget(budgetBytes);
+  }
+  std::optional<Value> get(const std::string &key) {
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end()) {
+      m_misses.fetch_add(1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+    m_hits.fetch_add(1, std::memory_order_relaxed);
+    shard.unlink(&it->second);
+    shard.pushFront(&it->second);
+    return it->second.value;
+  }
+  // Replaces an existing entry. Values larger than a shard's budget are not
+  // cached at all.
+  void put(const std::string &key, Value value, size_t bytes) {
+    std::vector<Value> evicted;
+    {
+      Shard &shard = shardFor(key);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      if (bytes > shard.budget)
+        return;
+      auto [it, inserted] = shard.map.try_emplace(key);
+      Node &node = it->second;
+      if (!inserted) {
+        shard.unlink(&node);
+        shard.bytes -= node.bytes;
+        evicted.push_back(std::move(node.value));
+      } else {
+        node.key = &it->first;
+      }
+      node.value = std::move(value);
+      node.bytes = bytes;
+      shard.bytes += bytes;
+      shard.pushFront(&node);
+      trim(shard, evicted);
+    }
+  }
+  bool erase(const std::string &key) {
+    std::optional<Value> removed;
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end())
+      return false;
+    shard.unlink(&it->second);
+    shard.bytes -= it->second.bytes;
+    removed = std::move(it->second.value);
+    shard.map.erase(it);
+    return true;
+  }
+  // Removes every entry whose key satisfies pred; returns how many.
+  size_t eraseIf(const std::function<bool(const std::string &)> &pred) {
+    size_t count = 0;
+    for (auto &shard : m_shards) {
+      std::vector<Value> removed;
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      for (auto it = shard.map.begin(); it != shard.map.end();) {
+        if (pred(it->first)) {
+          shard.unlink(&it->second);
+          shard.bytes -= it->second.bytes;
+          removed.push_back(std::move(it->second.value));
+          it = shard.map.erase(it);
+          ++count;
+        } else {
+          ++it;
+        }
+      }
+    }
+    return count;
+  }
+  void clear() {
+    for (auto &shard : m_shards) {
+      std::unordered_map<std::string, Node> removed;
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      removed.swap(shard.map);
+      shard.head = shard.tail = nullptr;
+      shard.bytes = 0;
+    }
+  }
+  // Shrinking evicts immediately.
+  void setBudget(size_t budgetBytes) {
+    m_budget = budgetBytes;
+    for (auto &shard : m_shards) {
+      std::vector<Value> evicted;
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      shard.budget = budgetBytes / m_shards.size();
+      trim(shard, evicted);
+    }
+  }
+  Stats stats() const {
+    Stats stats;
+    for (auto &shard : m_shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      stats.entries += shard.map.size();
+      stats.bytes += shard.bytes;
+    }
+    stats.budgetBytes = m_budget;
+    stats.hits = m_hits.load(std::memory_order_relaxed);
+    stats.misses = m_misses.load(std::memory_order_relaxed);
+    stats.evictions = m_evictions.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+private:
+  struct Node {
+    const std::string *key = nullptr;
+    Value value{};
+    size_t bytes = 0;
+    Node *prev = nullptr; // towards most recently used
+    Node *next = nullptr;
+  };
+  struct Shard {
+    mutable std::mutex mutex;
+    // Node addresses are stable in unordered_map, so the recency list can
+    // link them directly.
+    std::unordered_map<std::string, Node> map;
+    Node *head = nullptr; // most recently used
+    Node *tail = nullptr;
+    size_t bytes = 0;
+    size_t budget = 0;
+    void unlink(Node *node) {
+      (node->prev ? node->prev->next : head) = node->next;
+      (node->next ? node->next->prev : tail) = node->prev;
+      node->prev = node->next = nullptr;
+    }
+    void pushFront(Node *node) {
+      node->prev = nullptr;
+      node->next = head;
+      (head ? head->prev : tail) = node;
+      head = node;
+    }
+  };
+  Shard &shardFor(const std::string &key) {
+    return m_shards[std::hash<std::string>{}(key) % m_shards.size()];
+  }
+  void trim(Shard &shard, std::vector<Value> &evicted) {
+    while (shard.bytes > shard.budget && shard.tail) {
+      Node *victim = shard.tail;
+      shard.unlink(victim);
+      shard.bytes -= victim->bytes;
+      evicted.push_back(std::move(victim->value));
+      shard.map.erase(shard.map.find(*victim->key));
+      m_evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  std::vector<Shard> m_shards;
+  std::atomic<size_t> m_budget{0};
+  std::atomic<uint64_t> m_hits{0};
+  std::atomic<uint64_t> m_misses{0};
+  std::atomic<uint64_t> m_evictions{0};
+};
+} // namespace bwp::utils
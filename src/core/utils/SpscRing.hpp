@@ -0,0 +1,45 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+namespace bwp::utils {
+// Fixed-capacity lock-free queue for exactly one producer thread and one
+// consumer thread. Elements are moved in and out of preallocated slots, so
+// neither side allocates. push() fails instead of blocking when full.
+template <typename T, size_t Capacity> class SpscRing {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "capacity must be a power of two");
+
+public:
+  bool push(T &&value) {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) == Capacity)
+      return false;
+    m_slots[head & (Capacity - 1)] = std::move(value);
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+  // Hands up to `max` queued elements to fn, oldest first. Consumer only.
+  template <typename Fn> size_t drain(Fn &&fn, size_t max = Capacity) {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    size_t count = m_head.load(std::memory_order_acquire) - tail;
+    if (count > max)
+      count = max;
+    for (size_t i = 0; i < count; ++i)
+      fn(std::move(m_slots[(tail + i) & (Capacity - 1)]));
+    m_tail.store(tail + count, std::memory_order_release);
+    return count;
+  }
+  [[nodiscard]] bool empty() const {
+    return m_head.load(std::memory_order_acquire) ==
+           m_tail.load(std::memory_order_acquire);
+  }
+  static constexpr size_t capacity() { return Capacity; }
+
+private:
+  alignas(64) std::atomic<size_t> m_head{0};
+  alignas(64) std::atomic<size_t> m_tail{0};
+  std::array<T, Capacity> m_slots{};
+};
+} // namespace bwp::utils
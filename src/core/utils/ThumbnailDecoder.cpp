@@ -0,0 +1,261 @@
+#include "ThumbnailDecoder.hpp"
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <memory>
+#ifdef BWP_HAVE_LIBJPEG
+#include <jpeglib.h>
+#endif
+#ifdef BWP_HAVE_LIBPNG
+#include <png.h>
+#endif
+namespace bwp::utils {
+RowDownscaler::RowDownscaler(int srcWidth, int srcHeight, int dstWidth,
+                             int dstHeight, int channels)
+    : m_srcWidth(srcWidth), m_srcHeight(srcHeight), m_channels(channels) {
+  dstWidth = std::clamp(dstWidth, 1, std::max(srcWidth, 1));
+  dstHeight = std::clamp(dstHeight, 1, std::max(srcHeight, 1));
+  m_column.resize(static_cast<size_t>(srcWidth));
+  m_binWidth.assign(static_cast<size_t>(dstWidth), 0);
+  for (int x = 0; x < srcWidth; ++x) {
+    m_column[x] =
+        static_cast<int>(static_cast<int64_t>(x) * dstWidth / srcWidth);
+    m_binWidth[m_column[x]]++;
+  }
+  m_sums.assign(static_cast<size_t>(dstWidth) * channels, 0);
+  m_out.width = dstWidth;
+  m_out.height = dstHeight;
+  m_out.channels = channels;
+  m_out.pixels.resize(static_cast<size_t>(dstWidth) * dstHeight * channels);
+}
+void RowDownscaler::push(const uint8_t *row) {
+  if (complete())
+    return;
+  if (m_channels == 4) {
+    for (int x = 0; x < m_srcWidth; ++x, row += 4) {
+      uint64_t *sum = &m_sums[static_cast<size_t>(m_column[x]) * 4];
+      const uint32_t alpha = row[3];
+      sum[0] += row[0] * alpha;
+      sum[1] += row[1] * alpha;
+      sum[2] += row[2] * alpha;
+      sum[3] += alpha;
+    }
+  } else {
+    for (int x = 0; x < m_srcWidth; ++x) {
+      uint64_t *sum = &m_sums[static_cast<size_t>(m_column[x]) * m_channels];
+      for (int c = 0; c < m_channels; ++c)
+        sum[c] += *row++;
+    }
+  }
+  m_binRows++;
+  m_srcY++;
+  if (m_srcY == m_srcHeight ||
+      static_cast<int64_t>(m_srcY) * m_out.height / m_srcHeight != m_dstY)
+    flushRow();
+}
+void RowDownscaler::flushRow() {
+  uint8_t *out = m_out.pixels.data() +
+                 static_cast<size_t>(m_dstY) * m_out.width * m_channels;
+  for (int x = 0; x < m_out.width; ++x, out += m_channels) {
+    const uint64_t *sum = &m_sums[static_cast<size_t>(x) * m_channels];
+    const uint64_t count = static_cast<uint64_t>(m_binWidth[x]) * m_binRows;
+    if (m_channels == 4) {
+      const uint64_t alpha = sum[3];
+      for (int c = 0; c < 3; ++c)
+        out[c] = alpha ? static_cast<uint8_t>((sum[c] + alpha / 2) / alpha) : 0;
+      out[3] = static_cast<uint8_t>((alpha + count / 2) / count);
+    } else {
+      for (int c = 0; c < m_channels; ++c)
+        out[c] = static_cast<uint8_t>((sum[c] + count / 2) / count);
+    }
+  }
+  std::fill(m_sums.begin(), m_sums.end(), 0);
+  m_binRows = 0;
+  m_dstY++;
+}
+DecodedImage RowDownscaler::take() { return std::move(m_out); }
+namespace {
+#ifdef BWP_HAVE_LIBJPEG
+struct JpegError {
+  jpeg_error_mgr mgr;
+  std::jmp_buf jump;
+};
+// The 1/8 IDCT only reads each block's DC coefficient. A progressive file
+// sends those in its first scan(s), so the AC scans that make up most of
+// the file need not be decoded at all. The usual scripts send DC a bit
+// short and refine it near the end; one missing bit is at most a couple of
+// levels of error in the block average, so that is where reading stops.
+void consumeDcScans(jpeg_decompress_struct &cinfo) {
+  auto dcComplete = [&cinfo] {
+    for (int c = 0; c < cinfo.num_components; ++c) {
+      const int missingBits = cinfo.coef_bits[c][0];
+      if (missingBits < 0 || missingBits > 1)
+        return false;
+    }
+    return true;
+  };
+  while (!jpeg_input_complete(&cinfo)) {
+    int status = jpeg_consume_input(&cinfo);
+    if (status == JPEG_SUSPENDED || status == JPEG_REACHED_EOI)
+      break;
+    if (status == JPEG_SCAN_COMPLETED && dcComplete())
+      break;
+  }
+}
+std::optional<DecodedImage> decodeJpeg(FILE *file, int maxSize) {
+  jpeg_decompress_struct cinfo{};
+  JpegError error;
+  std::vector<uint8_t> row;
+  std::optional<RowDownscaler> scaler;
+  cinfo.err = jpeg_std_error(&error.mgr);
+  error.mgr.error_exit = [](j_common_ptr info) {
+    std::longjmp(reinterpret_cast<JpegError *>(info->err)->jump, 1);
+  };
+  error.mgr.output_message = [](j_common_ptr) {};
+  if (setjmp(error.jump)) {
+    jpeg_destroy_decompress(&cinfo);
+    return std::nullopt;
+  }
+  jpeg_create_decompress(&cinfo);
+  jpeg_stdio_src(&cinfo, file);
+  jpeg_read_header(&cinfo, TRUE);
+  const auto [width, height] =
+      ThumbnailDecoder::fit(static_cast<int>(cinfo.image_width),
+                            static_cast<int>(cinfo.image_height), maxSize);
+  if (cinfo.jpeg_color_space == JCS_CMYK ||
+      cinfo.jpeg_color_space == JCS_YCCK ||
+      (static_cast<JDIMENSION>(width) >= cinfo.image_width &&
+       static_cast<JDIMENSION>(height) >= cinfo.image_height)) {
+    jpeg_destroy_decompress(&cinfo);
+    return std::nullopt;
+  }
+  // Largest DCT reduction that still leaves at least the thumbnail size;
+  // the box filter takes it the rest of the way.
+  cinfo.scale_num = 1;
+  cinfo.scale_denom = 1;
+  for (unsigned denom : {8u, 4u, 2u}) {
+    if ((cinfo.image_width + denom - 1) / denom >=
+            static_cast<JDIMENSION>(width) &&
+        (cinfo.image_height + denom - 1) / denom >=
+            static_cast<JDIMENSION>(height)) {
+      cinfo.scale_denom = denom;
+      break;
+    }
+  }
+  cinfo.out_color_space = JCS_RGB;
+  cinfo.dct_method = JDCT_IFAST;
+  cinfo.do_fancy_upsampling = FALSE;
+  cinfo.do_block_smoothing = FALSE;
+  const bool dcOnly = cinfo.progressive_mode && cinfo.scale_denom == 8;
+  cinfo.buffered_image = dcOnly;
+  jpeg_start_decompress(&cinfo);
+  if (dcOnly) {
+    consumeDcScans(cinfo);
+    jpeg_start_output(&cinfo, cinfo.input_scan_number);
+  }
+  scaler.emplace(static_cast<int>(cinfo.output_width),
+                 static_cast<int>(cinfo.output_height), width, height, 3);
+  row.resize(static_cast<size_t>(cinfo.output_width) *
+             cinfo.output_components);
+  while (cinfo.output_scanline < cinfo.output_height) {
+    JSAMPROW rows[] = {row.data()};
+    if (jpeg_read_scanlines(&cinfo, rows, 1) != 1)
+      break;
+    scaler->push(row.data());
+  }
+  // Anything after the last scanline (or the DC scans) is not needed.
+  jpeg_destroy_decompress(&cinfo);
+  if (!scaler->complete())
+    return std::nullopt;
+  return scaler->take();
+}
+#endif
+#ifdef BWP_HAVE_LIBPNG
+std::optional<DecodedImage> decodePng(FILE *file, int maxSize) {
+  png_structp png = png_create_read_struct(
+      PNG_LIBPNG_VER_STRING, nullptr,
+      [](png_structp p, png_const_charp) { png_longjmp(p, 1); },
+      [](png_structp, png_const_charp) {});
+  if (!png)
+    return std::nullopt;
+  png_infop info = png_create_info_struct(png);
+  std::vector<uint8_t> row;
+  std::optional<RowDownscaler> scaler;
+  if (!info || setjmp(png_jmpbuf(png))) {
+    png_destroy_read_struct(&png, &info, nullptr);
+    return std::nullopt;
+  }
+  png_init_io(png, file);
+  png_read_info(png, info);
+  const int srcWidth = static_cast<int>(png_get_image_width(png, info));
+  const int srcHeight = static_cast<int>(png_get_image_height(png, info));
+  const auto [width, height] =
+      ThumbnailDecoder::fit(srcWidth, srcHeight, maxSize);
+  // Adam7's first pass is every 8th pixel of every 8th row: a ready-made
+  // 1/8 preview. Without interlace handling libpng hands the passes over
+  // one after another, so reading stops after the first.
+  const bool interlaced =
+      png_get_interlace_type(png, info) != PNG_INTERLACE_NONE;
+  const int rows = interlaced ? static_cast<int>(PNG_PASS_ROWS(srcHeight, 0))
+                              : srcHeight;
+  const int columns = interlaced
+                          ? static_cast<int>(PNG_PASS_COLS(srcWidth, 0))
+                          : srcWidth;
+  if ((width >= srcWidth && height >= srcHeight) || columns < width ||
+      rows < height) {
+    png_destroy_read_struct(&png, &info, nullptr);
+    return std::nullopt;
+  }
+  png_set_expand(png);
+  png_set_strip_16(png);
+  png_set_gray_to_rgb(png);
+  png_read_update_info(png, info);
+  const int channels = png_get_channels(png, info);
+  scaler.emplace(columns, rows, width, height, channels);
+  row.resize(static_cast<size_t>(png_get_rowbytes(png, info)));
+  for (int y = 0; y < rows; ++y) {
+    png_read_row(png, row.data(), nullptr);
+    scaler->push(row.data());
+  }
+  png_destroy_read_struct(&png, &info, nullptr);
+  return scaler->take();
+}
+#endif
+} // namespace
+std::pair<int, int> ThumbnailDecoder::fit(int width, int height, int maxSize) {
+  // Rounds like gdk_pixbuf_new_from_file_at_scale so either path gives the
+  // same size.
+  if (width <= 0 || height <= 0)
+    return {0, 0};
+  if (height > width) {
+    return {std::max(1, static_cast<int>(0.5 + static_cast<double>(width) *
+                                                   maxSize / height)),
+            maxSize};
+  }
+  return {maxSize, std::max(1, static_cast<int>(
+                                   0.5 + static_cast<double>(height) *
+                                             maxSize / width))};
+}
+std::optional<DecodedImage>
+ThumbnailDecoder::decode(const std::filesystem::path &path, int maxSize) {
+  if (maxSize <= 0)
+    return std::nullopt;
+  std::unique_ptr<FILE, int (*)(FILE *)> file(std::fopen(path.c_str(), "rb"),
+                                              &std::fclose);
+  if (!file)
+    return std::nullopt;
+  uint8_t magic[8] = {};
+  const size_t got = std::fread(magic, 1, sizeof(magic), file.get());
+  std::rewind(file.get());
+#ifdef BWP_HAVE_LIBJPEG
+  if (got >= 3 && magic[0] == 0xFF && magic[1] == 0xD8 && magic[2] == 0xFF)
+    return decodeJpeg(file.get(), maxSize);
+#endif
+#ifdef BWP_HAVE_LIBPNG
+  if (got == sizeof(magic) && png_sig_cmp(magic, 0, sizeof(magic)) == 0)
+    return decodePng(file.get(), maxSize);
+#endif
+  (void)got;
+  return std::nullopt;
+}
+} // namespace bwp::utils
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+namespace bwp::utils {
+// Tightly packed 8-bit RGB or straight-alpha RGBA pixels.
+struct DecodedImage {
+  int width = 0;
+  int height = 0;
+  int channels = 0;
+  std::vector<uint8_t> pixels;
+};
+// Box-filters an image down while it is decoded row by row. Only one row of
+// accumulators and the output are held, so memory depends on the output
+// size alone. RGBA is averaged weighted by alpha, so fully transparent
+// pixels do not bleed their colour into the edges.
+class RowDownscaler {
+public:
+  RowDownscaler(int srcWidth, int srcHeight, int dstWidth, int dstHeight,
+                int channels);
+  // `row` holds srcWidth * channels bytes; rows arrive top to bottom.
+  void push(const uint8_t *row);
+  bool complete() const { return m_srcY == m_srcHeight; }
+  // Valid once every source row was pushed.
+  DecodedImage take();
+
+private:
+  void flushRow();
+  int m_srcWidth;
+  int m_srcHeight;
+  int m_channels;
+  int m_srcY = 0;
+  int m_dstY = 0;
+  int m_binRows = 0;
+  std::vector<int> m_column;         // source column -> output column
+  std::vector<uint32_t> m_binWidth;  // source columns per output column
+  std::vector<uint64_t> m_sums;
+  DecodedImage m_out;
+};
+// Produces a thumbnail that fits in maxSize x maxSize without decoding the
+// source at full resolution where the format allows it:
+//  - JPEG decodes through libjpeg's DCT scaling (1/2, 1/4, 1/8). For
+//    progressive files scaled by 1/8 it stops once the DC scans are in,
+//    which is all an 1/8 IDCT reads.
+//  - PNG streams rows through a RowDownscaler. For Adam7 files shrunk at
+//    least 8x it reads only the first pass, a built-in 1/8 preview.
+// Returns nullopt for anything it does not handle (other formats, images
+// that need no downscaling, builds without libjpeg/libpng), leaving the
+// caller to fall back to a general-purpose loader.
+class ThumbnailDecoder {
+public:
+  static std::optional<DecodedImage> decode(const std::filesystem::path &path,
+                                            int maxSize);
+  // Size of a w x h image scaled to fit in maxSize x maxSize.
+  static std::pair<int, int> fit(int width, int height, int maxSize);
+};
+} // namespace bwp::utils
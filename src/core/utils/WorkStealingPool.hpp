@@ -0,0 +1,126 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+namespace bwp::utils {
+// Fixed set of workers, each owning a deque of tasks. A worker pops its own
+// newest task (depth-first, cache-warm) and, when empty, steals the oldest
+// task of another worker, which tends to be a large unexplored subtree.
+// A worker that finds nothing to steal sleeps until a task is pushed.
+// Tasks may push more tasks while running; run() returns once every task
+// has finished or `stop` was raised (remaining tasks are then dropped).
+template <typename Task> class WorkStealingPool {
+public:
+  // `worker` is the index of the executing worker, for per-worker state.
+  using Fn = std::function<void(Task &task, unsigned worker)>;
+  explicit WorkStealingPool(unsigned workers) {
+    for (unsigned i = 0; i < std::max(1u, workers); ++i)
+      m_queues.push_back(std::make_unique<Queue>());
+  }
+  unsigned workers() const { return static_cast<unsigned>(m_queues.size()); }
+  // Adds a task to `worker`'s deque; call from inside the task function
+  // with its own worker index.
+  void push(unsigned worker, Task task) {
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    Queue &q = *m_queues[worker];
+    {
+      std::lock_guard<std::mutex> lock(q.mutex);
+      q.tasks.push_back(std::move(task));
+    }
+    m_queued.fetch_add(1);
+    if (m_sleepers.load() > 0) {
+      { std::lock_guard<std::mutex> lock(m_idleMutex); }
+      m_idleCv.notify_one();
+    }
+  }
+  // Worker 0 runs on the calling thread, so a pool of one is sequential.
+  void run(std::vector<Task> seeds, const Fn &fn,
+           const std::atomic<bool> *stop = nullptr) {
+    for (size_t i = 0; i < seeds.size(); ++i)
+      push(static_cast<unsigned>(i % m_queues.size()), std::move(seeds[i]));
+    auto stopped = [stop] {
+      return stop && stop->load(std::memory_order_relaxed);
+    };
+    auto work = [this, &fn, &stopped](unsigned self) {
+      Task task;
+      while (m_pending.load(std::memory_order_acquire) > 0 && !stopped()) {
+        if (!pop(self, task) && !steal(self, task)) {
+          park(stopped);
+          continue;
+        }
+        fn(task, self);
+        if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+          wakeAll();
+      }
+      // A stop is only seen between tasks; sleepers must look again.
+      wakeAll();
+    };
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < m_queues.size(); ++i)
+      threads.emplace_back(work, i);
+    work(0);
+    for (auto &thread : threads)
+      thread.join();
+    for (auto &q : m_queues)
+      q->tasks.clear();
+    m_pending = 0;
+    m_queued = 0;
+  }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+  bool pop(unsigned self, Task &out) {
+    Queue &q = *m_queues[self];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.tasks.empty())
+      return false;
+    out = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    m_queued.fetch_sub(1);
+    return true;
+  }
+  bool steal(unsigned self, Task &out) {
+    for (size_t i = 1; i < m_queues.size(); ++i) {
+      Queue &q = *m_queues[(self + i) % m_queues.size()];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (!q.tasks.empty()) {
+        out = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        m_queued.fetch_sub(1);
+        return true;
+      }
+    }
+    return false;
+  }
+  // Sleeps until a task is queued, the last task finished or `stopped`.
+  // m_queued and m_sleepers are sequentially consistent, so a push either
+  // sees the sleeper or the sleeper sees the task.
+  template <typename Stopped> void park(const Stopped &stopped) {
+    std::unique_lock<std::mutex> lock(m_idleMutex);
+    m_sleepers.fetch_add(1);
+    m_idleCv.wait(lock, [&] {
+      return m_queued.load() > 0 || m_pending.load() == 0 || stopped();
+    });
+    m_sleepers.fetch_sub(1);
+  }
+  void wakeAll() {
+    { std::lock_guard<std::mutex> lock(m_idleMutex); }
+    m_idleCv.notify_all();
+  }
+  std::vector<std::unique_ptr<Queue>> m_queues;
+  std::atomic<size_t> m_pending{0};  // queued or running
+  std::atomic<size_t> m_queued{0};   // in a deque, not yet taken
+  std::atomic<unsigned> m_sleepers{0};
+  std::mutex m_idleMutex;
+  std::condition_variable m_idleCv;
+};
+} // namespace bwp::utils
@@ -1,42 +1,92 @@
 #include "LibraryScanner.hpp"
+#include "../config/ConfigManager.hpp"
+#include "../config/SettingsSchema.hpp"
 #include "../utils/FileUtils.hpp"
 #include "../utils/Logger.hpp"
+#include "../utils/MediaProbe.hpp"
+#include "../utils/WorkStealingPool.hpp"
+#include "ThumbnailCache.hpp"
 #include "WallpaperLibrary.hpp"
 #include <algorithm>
-#include <fstream>
-#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cmath>
 namespace bwp::wallpaper {
+namespace {
+// Items handed to WallpaperLibrary::addWallpapers per transaction.
+constexpr size_t kScanBatchSize = 256;
+// Perceptual hashes committed per library transaction.
+constexpr size_t kHashBatchSize = 32;
+// Auto-sized pools stop here; the walk is bound by metadata I/O, not CPU.
+constexpr unsigned kMaxAutoScanWorkers = 8;
+// A unit of work for the scan pool. Directories are tasks, so a deep user
+// tree spreads across workers as its subdirectories are discovered.
+struct ScanTask {
+  enum class Kind { WorkshopRoot, WorkshopItem, Directory };
+  Kind kind = Kind::Directory;
+  std::filesystem::path path;
+};
+// library.scan_workers: 0 picks from the core count, 1 walks serially on
+// the scan thread.
+unsigned resolveScanWorkers() {
+  int configured = config::ConfigManager::getInstance().get<int>(
+      config::keys::SCAN_WORKERS, 0);
+  if (configured > 0)
+    return std::min(static_cast<unsigned>(configured),
+                    LibraryScanner::kMaxScanWorkers);
+  return std::clamp(std::thread::hardware_concurrency(), 2u,
+                    kMaxAutoScanWorkers);
+}
+bool isWallpaperFile(const std::filesystem::path &path) {
+  std::string ext = path.extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".gif" ||
+         ext == ".bmp" || ext == ".mp4" || ext == ".webm" || ext == ".mkv" ||
+         ext == ".avi" || ext == ".pkg" || ext == ".html" || ext == ".htm";
+}
+// Reads dimensions, duration and codec into info; false if the file has no
+// header MediaProbe understands.
+bool applyMediaProbe(const std::filesystem::path &path, WallpaperInfo &info) {
+  auto media = utils::MediaProbe::probe(path);
+  if (!media)
+    return false;
+  info.width = media->width;
+  info.height = media->height;
+  info.duration = media->duration;
+  info.frame_rate = media->frameRate;
+  info.codec = std::move(media->codec);
+  return true;
+}
+} // namespace
 #ifdef _WIN32
 #define G_SOURCE_REMOVE 0
-inline void g_idle_add(void *func, void *data) {
-  if (func) {
-    using CallbackType = int (*)(void *);
-    ((CallbackType)func)(data);
-  }
-}
+#define G_SOURCE_CONTINUE 1
+// No main loop to deliver on; getProgress() still reports.
+inline unsigned g_timeout_add(unsigned, void *, void *) { return 0; }
 #endif
-struct ProgressData {
-  ScanProgress progress;
-  LibraryScanner::ProgressCallback callback;
-};
-struct CompletionData {
-  int totalFound;
-  LibraryScanner::CompletionCallback callback;
-};
-struct FileFoundData {
-  std::string path;
-  LibraryScanner::ScanCallback callback;
-};
 LibraryScanner &LibraryScanner::getInstance() {
   static LibraryScanner instance;
   return instance;
 }
-LibraryScanner::LibraryScanner() {}
+LibraryScanner::LibraryScanner() {
+  for (auto &queue : m_found)
+    queue = std::make_unique<FoundQueue>();
+  // Constructed first so they outlive the hashing thread.
+  WallpaperLibrary::getInstance();
+  ThumbnailCache::getInstance();
+}
 LibraryScanner::~LibraryScanner() {
   cancelScan();
   if (m_scanThread.joinable()) {
     m_scanThread.join();
   }
+  {
+    std::lock_guard<std::mutex> lock(m_hashMutex);
+    m_stopHashing = true;
+  }
+  m_hashCv.notify_all();
+  if (m_hashThread.joinable()) {
+    m_hashThread.join();
+  }
 }
 void LibraryScanner::setCallback(ScanCallback callback) {
   std::lock_guard<std::mutex> lock(m_mutex);
@@ -50,10 +100,7 @@ void LibraryScanner::setCompletionCallback(CompletionCallback callback) {
   std::lock_guard<std::mutex> lock(m_mutex);
   m_completionCallback = callback;
 }
-ScanProgress LibraryScanner::getProgress() const {
-  std::lock_guard<std::mutex> lock(m_mutex);
-  return m_progress;
-}
+ScanProgress LibraryScanner::getProgress() const { return sampleProgress(); }
 void LibraryScanner::cancelScan() { m_cancelRequested = true; }
 void LibraryScanner::waitForCompletion() {
   if (m_scanThread.joinable()) {
@@ -66,56 +113,131 @@ void LibraryScanner::scan(const std::vector<std::string> &paths) {
   if (!m_scanning.compare_exchange_strong(expected, true))
     return;
   m_cancelRequested = false;
+  m_filesScanned = 0;
+  m_filesFound = 0;
+  m_dirsVisited = 0;
+  m_dirsSkipped = 0;
+  m_bytesScanned = 0;
+  m_totalEstimate = 0;
+  m_foundDropped = 0;
+  m_complete = false;
+  m_scanGeneration++;
   {
     std::lock_guard<std::mutex> lock(m_mutex);
-    m_progress = ScanProgress{};
+    m_currentPath.clear();
+    m_filesPerSecond = m_bytesPerSecond = m_dirsPerSecond = 0.0;
   }
   if (m_scanThread.joinable()) {
     m_scanThread.join();
   }
+  ensureTicker();
   m_scanThread = std::thread(&LibraryScanner::runScan, this, paths);
 }
-gboolean LibraryScanner::idleProgress(gpointer data) {
-  auto *pd = static_cast<ProgressData *>(data);
-  if (pd && pd->callback) {
-    pd->callback(pd->progress);
-  }
-  delete pd;
-  return G_SOURCE_REMOVE;
+void LibraryScanner::publishFound(unsigned producer, std::string path) {
+  // A full queue means the main loop is not keeping up; the library already
+  // has the item, so count the miss rather than stall the scan.
+  if (!m_found[producer]->push(std::move(path)))
+    m_foundDropped++;
 }
-gboolean LibraryScanner::idleCompletion(gpointer data) {
-  auto *cd = static_cast<CompletionData *>(data);
-  if (cd && cd->callback) {
-    cd->callback(cd->totalFound);
-  }
-  delete cd;
-  return G_SOURCE_REMOVE;
+void LibraryScanner::ensureTicker() {
+  if (!m_tickerActive.exchange(true))
+    g_timeout_add(kTickMs, onTick, this);
+}
+gboolean LibraryScanner::onTick(gpointer data) {
+  return static_cast<LibraryScanner *>(data)->tick() ? G_SOURCE_CONTINUE
+                                                     : G_SOURCE_REMOVE;
 }
-gboolean LibraryScanner::idleFileFound(gpointer data) {
-  auto *fd = static_cast<FileFoundData *>(data);
-  if (fd && fd->callback) {
-    fd->callback(fd->path);
+bool LibraryScanner::queuesEmpty() const {
+  return std::all_of(m_found.begin(), m_found.end(),
+                     [](const auto &queue) { return queue->empty(); });
+}
+bool LibraryScanner::tick() {
+  m_foundBatch.clear();
+  for (auto &queue : m_found)
+    queue->drain([this](std::string &&path) {
+      m_foundBatch.push_back(std::move(path));
+    });
+  ScanCallback onFound;
+  ProgressCallback onProgress;
+  CompletionCallback onComplete;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    onFound = m_callback;
+    onProgress = m_progressCallback;
+    onComplete = m_completionCallback;
+  }
+  if (onFound && !m_foundBatch.empty())
+    onFound(m_foundBatch);
+  const bool completing = m_completionPending.exchange(false);
+  if (m_scanning || completing) {
+    updateRates();
+    if (onProgress)
+      onProgress(sampleProgress());
   }
-  delete fd;
-  return G_SOURCE_REMOVE;
+  if (completing && onComplete)
+    onComplete(m_filesFound);
+  if (m_scanning || !queuesEmpty())
+    return true;
+  m_tickerActive = false;
+  // Something may have been published between the check and the store.
+  if ((!queuesEmpty() || m_completionPending) && !m_tickerActive.exchange(true))
+    return true;
+  return false;
 }
-void LibraryScanner::reportProgress() {
-  std::lock_guard<std::mutex> lock(m_mutex);
-  if (m_progressCallback) {
-    auto *data = new ProgressData{m_progress, m_progressCallback};
-    g_idle_add(idleProgress, data);
+void LibraryScanner::updateRates() {
+  const auto now = std::chrono::steady_clock::now();
+  const int files = m_filesScanned;
+  const int64_t bytes = m_bytesScanned;
+  const int dirs = m_dirsVisited + m_dirsSkipped;
+  const unsigned generation = m_scanGeneration;
+  if (generation != m_sampleGeneration) {
+    m_sampleGeneration = generation;
+    m_lastSample = now;
+    m_lastFiles = 0;
+    m_lastBytes = 0;
+    m_lastDirs = 0;
   }
+  const double dt = std::chrono::duration<double>(now - m_lastSample).count();
+  if (dt <= 0.0)
+    return;
+  // Exponential moving average with a time constant of about a second, so
+  // the 30 Hz samples do not jitter.
+  const double alpha = 1.0 - std::exp(-dt);
+  auto smooth = [alpha](double &rate, double sample) {
+    rate = rate <= 0.0 ? sample : rate + alpha * (sample - rate);
+  };
+  std::lock_guard<std::mutex> lock(m_mutex);
+  smooth(m_filesPerSecond, (files - m_lastFiles) / dt);
+  smooth(m_bytesPerSecond, double(bytes - m_lastBytes) / dt);
+  smooth(m_dirsPerSecond, (dirs - m_lastDirs) / dt);
+  m_lastSample = now;
+  m_lastFiles = files;
+  m_lastBytes = bytes;
+  m_lastDirs = dirs;
 }
-void LibraryScanner::notifyCompletion() {
+ScanProgress LibraryScanner::sampleProgress() const {
+  ScanProgress progress;
+  progress.filesScanned = m_filesScanned;
+  progress.filesFound = m_filesFound;
+  progress.totalEstimate = m_totalEstimate;
+  progress.dirsVisited = m_dirsVisited;
+  progress.dirsSkipped = m_dirsSkipped;
+  progress.bytesScanned = m_bytesScanned;
+  progress.foundDropped = m_foundDropped;
+  progress.isComplete = m_complete;
   std::lock_guard<std::mutex> lock(m_mutex);
-  if (m_completionCallback) {
-    auto *data =
-        new CompletionData{m_progress.filesFound, m_completionCallback};
-    g_idle_add(idleCompletion, data);
-  }
+  progress.currentPath = m_currentPath;
+  progress.filesPerSecond = m_filesPerSecond;
+  progress.bytesPerSecond = m_bytesPerSecond;
+  const int remaining =
+      progress.totalEstimate - progress.dirsVisited - progress.dirsSkipped;
+  if (!progress.isComplete && remaining > 0 && m_dirsPerSecond > 0.0)
+    progress.etaSeconds = static_cast<int>(remaining / m_dirsPerSecond + 0.5);
+  else if (progress.isComplete)
+    progress.etaSeconds = 0;
+  return progress;
 }
-void LibraryScanner::runScan(std::vector<std::string> paths) {
-  LOG_INFO("Starting library scan");
+std::vector<std::filesystem::path> LibraryScanner::workshopRoots() {
   const char *homeEnv = std::getenv("HOME");
   if (!homeEnv) {
     LOG_ERROR(
@@ -128,13 +250,9 @@ void LibraryScanner::runScan(std::vector<std::string> paths) {
         home + "/.local/share/Steam/steamapps/workshop/content/431960",
         home + "/.steam/steam/steamapps/workshop/content/431960"};
   }
-  int totalFound = 0;
+  std::vector<std::filesystem::path> roots;
   std::vector<std::string> scannedRoots;
   for (const auto &wsPathStr : workshopPaths) {
-    if (m_cancelRequested) {
-      LOG_INFO("Scan cancelled by user");
-      break;
-    }
     std::filesystem::path wsPath(wsPathStr);
     if (!std::filesystem::exists(wsPath) ||
         !std::filesystem::is_directory(wsPath)) {
@@ -147,103 +265,299 @@ void LibraryScanner::runScan(std::vector<std::string> paths) {
       LOG_DEBUG("Failed to canonicalize path: " + wsPathStr + " - " + e.what());
       canonicalWsPath = wsPathStr;
     }
-    bool alreadyScanned = false;
-    for (const auto &root : scannedRoots) {
-      if (root == canonicalWsPath)
-        alreadyScanned = true;
-    }
-    if (alreadyScanned) {
+    if (std::find(scannedRoots.begin(), scannedRoots.end(), canonicalWsPath) !=
+        scannedRoots.end()) {
       LOG_INFO("Skipping duplicate workshop root: " + wsPathStr);
       continue;
     }
     scannedRoots.push_back(canonicalWsPath);
+    roots.push_back(wsPath);
+  }
+  return roots;
+}
+void LibraryScanner::runScan(std::vector<std::string> paths) {
+  LOG_INFO("Starting library scan");
+  std::vector<ScanTask> seeds;
+  for (const auto &wsPath : workshopRoots()) {
     LOG_INFO("Scanning Workshop path: " + wsPath.string());
-    int folderCount = 0;
-    try {
-      for (const auto &entry : std::filesystem::directory_iterator(wsPath)) {
-        if (m_cancelRequested)
-          break;
+    seeds.push_back({ScanTask::Kind::WorkshopRoot, wsPath});
+  }
+  for (const auto &pathStr : paths) {
+    if (pathStr.find("431960") != std::string::npos)
+      continue;
+    std::filesystem::path path = utils::FileUtils::expandPath(pathStr);
+    std::error_code ec;
+    if (!std::filesystem::is_directory(path, ec))
+      continue;
+    LOG_INFO("Scanning user path: " + path.string());
+    seeds.push_back({ScanTask::Kind::Directory, path});
+  }
+  utils::WorkStealingPool<ScanTask> pool(resolveScanWorkers());
+  LOG_INFO("Scanning with " + std::to_string(pool.workers()) + " worker(s)");
+  // Results stay in a per-worker buffer until a full batch is ready, so the
+  // library write lock is taken once per kScanBatchSize items.
+  std::vector<std::vector<WallpaperInfo>> buffers(pool.workers());
+  std::atomic<int> folderCount{0};
+  // Read-only during the walk; each worker records what it saw into its own
+  // manifest and they replace this one when the scan completes.
+  auto manifestPath =
+      WallpaperLibrary::getInstance().getDataDirectory() / "scan_manifest.bin";
+  if (!m_manifestLoaded) {
+    m_manifest.load(manifestPath);
+    m_manifestLoaded = true;
+  }
+  m_totalEstimate = static_cast<int>(m_manifest.directories() +
+                                     m_manifest.items());
+  std::vector<ScanManifest> seen(pool.workers());
+  const int64_t scanStartNs =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count();
+  auto &library = WallpaperLibrary::getInstance();
+  auto collect = [&](unsigned worker, std::optional<WallpaperInfo> info) {
+    if (!info)
+      return false;
+    auto &batch = buffers[worker];
+    m_bytesScanned += static_cast<int64_t>(info->size_bytes);
+    batch.push_back(std::move(*info));
+    if (batch.size() >= kScanBatchSize)
+      flushBatch(batch, worker);
+    return true;
+  };
+  // The current path is only for display; refresh it now and then instead
+  // of taking the lock for every file.
+  auto scanned = [&](const std::filesystem::path &path) {
+    if (m_filesScanned++ % 32 == 0) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_currentPath = path.native();
+    }
+  };
+  auto workshopFound = [&]() { m_filesFound++; };
+  auto countDir = [&](bool skipped) {
+    if (skipped)
+      m_dirsSkipped++;
+    else
+      m_dirsVisited++;
+  };
+  // Lists a workshop root (children are items) or a user directory
+  // (children are directories, files are probed). An unchanged directory
+  // is not listed: its recorded children are queued and only files the
+  // library does not know yet are probed again.
+  auto walkDirectory = [&](const ScanTask &task, unsigned worker) {
+    const bool workshop = task.kind == ScanTask::Kind::WorkshopRoot;
+    const auto childKind =
+        workshop ? ScanTask::Kind::WorkshopItem : ScanTask::Kind::Directory;
+    const std::string key = task.path.string();
+    auto stamp = DirStamp::of(task.path);
+    const auto *previous = m_manifest.directory(key);
+    if (stamp && previous && previous->stamp == *stamp) {
+      countDir(true);
+      for (const auto &name : previous->subdirs)
+        pool.push(worker, {childKind, task.path / name});
+      for (const auto &name : previous->files) {
+        auto file = task.path / name;
+        if (!library.getWallpaper(file.string()))
+          collect(worker, probeFile(file));
+      }
+      seen[worker].setDirectory(key, *previous);
+      return;
+    }
+    countDir(false);
+    ScanManifest::Directory record;
+    auto options = workshop
+                       ? std::filesystem::directory_options::none
+                       : std::filesystem::directory_options::
+                             skip_permission_denied;
+    for (const auto &entry :
+         std::filesystem::directory_iterator(task.path, options)) {
+      if (m_cancelRequested)
+        return;
+      std::string name = entry.path().filename().string();
+      // Like recursive_directory_iterator, do not descend into symlinked
+      // directories in user paths.
+      if (entry.is_directory() && (workshop || !entry.is_symlink())) {
+        pool.push(worker, {childKind, entry.path()});
+        record.subdirs.push_back(std::move(name));
+      } else if (!workshop && entry.is_regular_file()) {
+        scanned(entry.path());
+        if (isWallpaperFile(entry.path()))
+          record.files.push_back(std::move(name));
+        collect(worker, probeFile(entry.path()));
+      }
+    }
+    if (stamp && ScanManifest::settled(stamp->mtimeNs, scanStartNs)) {
+      record.stamp = *stamp;
+      seen[worker].setDirectory(key, std::move(record));
+    }
+  };
+  auto probeItem = [&](const ScanTask &task, unsigned worker) {
+    const std::string key = task.path.string();
+    auto stamp = DirStamp::of(task.path);
+    auto project = DirStamp::of(task.path / "project.json");
+    int64_t projectMtimeNs = project ? project->mtimeNs : 0;
+    const auto *previous = m_manifest.item(key);
+    if (stamp && previous && previous->stamp == *stamp &&
+        previous->projectMtimeNs == projectMtimeNs &&
+        (!previous->found ||
+         library.getWallpaper(task.path.filename().string()))) {
+      countDir(true);
+      if (previous->found)
+        workshopFound();
+      seen[worker].setItem(key, *previous);
+      return;
+    }
+    countDir(false);
+    folderCount++;
+    scanned(task.path);
+    ScanManifest::Item record;
+    record.found = collect(worker, probeWorkshopItem(task.path));
+    if (record.found) {
+      workshopFound();
+      LOG_DEBUG("  ADDED: " + task.path.filename().string());
+    }
+    if (stamp && ScanManifest::settled(stamp->mtimeNs, scanStartNs) &&
+        ScanManifest::settled(projectMtimeNs, scanStartNs)) {
+      record.stamp = *stamp;
+      record.projectMtimeNs = projectMtimeNs;
+      seen[worker].setItem(key, record);
+    }
+  };
+  pool.run(
+      std::move(seeds),
+      [&](ScanTask &task, unsigned worker) {
         try {
-          if (!entry.is_directory())
-            continue;
-          folderCount++;
-          std::string folderId = entry.path().filename().string();
-          {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_progress.filesScanned++;
-            m_progress.currentPath = entry.path().string();
-          }
-          if (folderCount % 10 == 0) {
-            reportProgress();
-          }
-          bool added = scanWorkshopItem(entry.path());
-          if (added) {
-            totalFound++;
-            {
-              std::lock_guard<std::mutex> lock(m_mutex);
-              m_progress.filesFound = totalFound;
-            }
-            LOG_DEBUG("  ADDED: " + folderId);
-          }
+          if (task.kind == ScanTask::Kind::WorkshopItem)
+            probeItem(task, worker);
+          else
+            walkDirectory(task, worker);
         } catch (const std::exception &e) {
-          LOG_ERROR("Exception in folder loop: " + std::string(e.what()));
+          LOG_ERROR("Error scanning " + task.path.string() + ": " + e.what());
         }
-      }
-    } catch (const std::exception &e) {
-      LOG_ERROR("Exception iterating workshop path: " + std::string(e.what()));
+      },
+      &m_cancelRequested);
+  if (m_cancelRequested)
+    LOG_INFO("Scan cancelled by user");
+  for (unsigned worker = 0; worker < buffers.size(); ++worker)
+    flushBatch(buffers[worker], worker);
+  LOG_INFO("Processed " + std::to_string(folderCount.load()) +
+           " workshop folders, found " + std::to_string(m_filesFound.load()) +
+           " items");
+  LOG_INFO("Visited " + std::to_string(m_dirsVisited.load()) +
+           " directories, skipped " + std::to_string(m_dirsSkipped.load()) +
+           " unchanged");
+  LOG_DEBUG("project.json cache: " + std::to_string(projectCache().hits()) +
+            " hits, " + std::to_string(projectCache().misses()) + " parsed");
+  if (projectCache().dirty())
+    projectCache().save(library.getDataDirectory() / "project_meta.bin");
+  // A cancelled walk saw only part of the tree; keep the old manifest.
+  if (!m_cancelRequested) {
+    m_manifest.clear();
+    for (auto &part : seen)
+      m_manifest.merge(std::move(part));
+    if (!m_manifest.save(manifestPath))
+      LOG_WARN("Failed to save scan manifest: " + manifestPath.string());
+  }
+  // Entries from before this scan (or whose hash failed to save) too.
+  std::vector<std::pair<std::string, std::string>> unhashed;
+  library.snapshot()->forEach([&unhashed](WallpaperView view) {
+    if (view.phash() == 0)
+      unhashed.emplace_back(std::string(view.id()), view.path());
+  });
+  queuePerceptualHashes(std::move(unhashed));
+  m_complete = true;
+  m_completionPending = true;
+  m_scanning = false;
+  LOG_INFO("Scan finished. Library has " +
+           std::to_string(library.snapshot()->size()) + " wallpapers");
+  ensureTicker();
+}
+void LibraryScanner::queuePerceptualHashes(
+    std::vector<std::pair<std::string, std::string>> items) {
+  if (items.empty())
+    return;
+  {
+    std::lock_guard<std::mutex> lock(m_hashMutex);
+    for (auto &item : items) {
+      if (m_hashQueued.insert(item.first).second)
+        m_hashQueue.push_back(std::move(item));
     }
-    LOG_INFO("Processed " + std::to_string(folderCount) + " folders, found " +
-             std::to_string(totalFound) + " items");
+    if (!m_hashThread.joinable() && !m_hashQueue.empty())
+      m_hashThread = std::thread(&LibraryScanner::hashLoop, this);
   }
-  if (!m_cancelRequested) {
-    LOG_INFO("Workshop scan complete. Total: " + std::to_string(totalFound));
-    for (const auto &pathStr : paths) {
-      if (m_cancelRequested)
+  m_hashCv.notify_one();
+}
+void LibraryScanner::hashLoop() {
+  auto &library = WallpaperLibrary::getInstance();
+  auto &thumbnails = ThumbnailCache::getInstance();
+  while (true) {
+    std::vector<std::pair<std::string, std::string>> work;
+    {
+      std::unique_lock<std::mutex> lock(m_hashMutex);
+      m_hashCv.wait(lock, [this] {
+        return m_stopHashing || !m_hashQueue.empty();
+      });
+      if (m_stopHashing)
+        return;
+      while (!m_hashQueue.empty() && work.size() < kHashBatchSize) {
+        work.push_back(std::move(m_hashQueue.front()));
+        m_hashQueue.pop_front();
+      }
+    }
+    library.beginBulk();
+    for (const auto &[id, path] : work) {
+      if (m_stopHashing)
         break;
-      if (pathStr.find("431960") != std::string::npos)
-        continue;
-      std::filesystem::path path = utils::FileUtils::expandPath(pathStr);
-      if (!std::filesystem::exists(path))
+      // A FindNearDuplicates query may have hashed it first.
+      auto view = library.snapshot()->find(id);
+      if (!view || view.phash() != 0)
         continue;
-      LOG_INFO("Scanning user path: " + path.string());
-      try {
-        if (std::filesystem::is_directory(path)) {
-          for (const auto &entry :
-               std::filesystem::recursive_directory_iterator(
-                   path, std::filesystem::directory_options::
-                             skip_permission_denied)) {
-            if (m_cancelRequested)
-              break;
-            if (entry.is_regular_file()) {
-              {
-                std::lock_guard<std::mutex> lock(m_mutex);
-                m_progress.filesScanned++;
-                m_progress.currentPath = entry.path().string();
-              }
-              scanFile(entry.path());
-            }
-          }
-        }
-      } catch (const std::exception &e) {
-        LOG_ERROR("Error scanning path " + pathStr + ": " + e.what());
-      }
+      uint64_t phash = thumbnails.computePerceptualHash(
+          path, ThumbnailCache::Size::Small);
+      if (phash != 0)
+        library.updatePerceptualHash(id, phash);
     }
+    library.commit();
   }
-  {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_progress.isComplete = true;
-    m_progress.filesFound = totalFound;
+}
+ProjectMetadataCache &LibraryScanner::projectCache() {
+  std::call_once(m_projectCacheLoaded, [this]() {
+    m_projectCache.load(WallpaperLibrary::getInstance().getDataDirectory() /
+                        "project_meta.bin");
+  });
+  return m_projectCache;
+}
+void LibraryScanner::flushBatch(std::vector<WallpaperInfo> &batch,
+                                unsigned producer) {
+  if (batch.empty())
+    return;
+  WallpaperLibrary::getInstance().addWallpapers(batch);
+  std::vector<std::pair<std::string, std::string>> unhashed;
+  for (auto &info : batch) {
+    if (info.phash == 0)
+      unhashed.emplace_back(info.id, info.path);
+    publishFound(producer, std::move(info.path));
   }
-  m_scanning = false;
-  auto &library = WallpaperLibrary::getInstance();
-  library.save();
-  auto allItems = library.getAllWallpapers();
-  LOG_INFO("Scan finished. Library has " + std::to_string(allItems.size()) +
-           " wallpapers");
-  notifyCompletion();
-  reportProgress();
+  queuePerceptualHashes(std::move(unhashed));
+  batch.clear();
 }
 bool LibraryScanner::scanWorkshopItem(const std::filesystem::path &dir) {
+  auto info = probeWorkshopItem(dir);
+  if (!info)
+    return false;
+  auto &library = WallpaperLibrary::getInstance();
+  library.addWallpaper(*info);
+  auto stored = library.getWallpaper(info->id);
+  if (stored && stored->phash == 0)
+    queuePerceptualHashes({{info->id, info->path}});
+  {
+    std::lock_guard<std::mutex> lock(m_externalMutex);
+    publishFound(kExternalProducer, std::move(info->path));
+  }
+  ensureTicker();
+  return true;
+}
+std::optional<WallpaperInfo>
+LibraryScanner::probeWorkshopItem(const std::filesystem::path &dir) {
   std::filesystem::path projectJson = dir / "project.json";
   std::string folderId = dir.filename().string();
   WallpaperInfo info;
@@ -279,46 +593,32 @@ bool LibraryScanner::scanWorkshopItem(const std::filesystem::path &dir) {
     }
   } catch (const std::exception &e) {
     LOG_ERROR("Error scanning folder " + folderId + ": " + e.what());
-    return false;
+    return std::nullopt;
   }
   std::string title = folderId;
-  if (std::filesystem::exists(projectJson)) {
-    try {
-      std::ifstream f(projectJson);
-      if (f.is_open()) {
-        nlohmann::json j = nlohmann::json::parse(f);
-        title = j.value("title", folderId);
-        std::string jsonFile = j.value("file", "");
-        if (!jsonFile.empty()) {
-          std::filesystem::path fullPath = dir / jsonFile;
-          if (std::filesystem::exists(fullPath)) {
-            foundFile = fullPath.string();
-          }
-        }
-        std::string type = j.value("type", "");
-        if (type == "scene")
-          info.type = WallpaperType::WEScene;
-        else if (type == "video")
-          info.type = WallpaperType::WEVideo;
-        else if (type == "web")
-          info.type = WallpaperType::WEWeb;
-        if (j.contains("tags")) {
-          auto tagsJson = j["tags"];
-          if (tagsJson.is_array()) {
-            info.tags = tagsJson.get<std::vector<std::string>>();
-          }
-        }
+  if (auto project = projectCache().get(projectJson)) {
+    if (project->hasTitle)
+      title = project->title;
+    if (!project->file.empty()) {
+      std::filesystem::path fullPath = dir / project->file;
+      if (std::filesystem::exists(fullPath)) {
+        foundFile = fullPath.string();
       }
-    } catch (const std::exception &e) {
-      LOG_DEBUG("Failed to parse project.json metadata: " +
-                std::string(e.what()));
     }
+    if (project->type == "scene")
+      info.type = WallpaperType::WEScene;
+    else if (project->type == "video")
+      info.type = WallpaperType::WEVideo;
+    else if (project->type == "web")
+      info.type = WallpaperType::WEWeb;
+    if (project->hasTags)
+      info.tags = project->tags;
   }
   if (foundFile.empty()) {
     if (!foundPreview.empty()) {
       foundFile = foundPreview;
     } else {
-      return false;
+      return std::nullopt;
     }
   }
   info.path = foundFile;
@@ -338,34 +638,35 @@ bool LibraryScanner::scanWorkshopItem(const std::filesystem::path &dir) {
     else
       info.type = WallpaperType::StaticImage;
   }
+  if (info.type != WallpaperType::WEScene && info.type != WallpaperType::WEWeb)
+    applyMediaProbe(foundFile, info);
+  return info;
+}
+void LibraryScanner::scanFile(const std::filesystem::path &path) {
+  auto info = probeFile(path);
+  if (!info)
+    return;
   auto &library = WallpaperLibrary::getInstance();
-  library.addWallpaper(info);
+  library.addWallpaper(*info);
+  auto stored = library.getWallpaper(info->id);
+  if (stored && stored->phash == 0)
+    queuePerceptualHashes({{info->id, info->path}});
   {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_callback)
-      m_callback(info.path);
+    std::lock_guard<std::mutex> lock(m_externalMutex);
+    publishFound(kExternalProducer, path.string());
   }
-  return true;
+  ensureTicker();
 }
-void LibraryScanner::scanFile(const std::filesystem::path &path) {
-  std::string ext = path.extension().string();
-  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
-  bool isImage = (ext == ".jpg" || ext == ".jpeg" || ext == ".png" ||
-                  ext == ".gif" || ext == ".bmp");
-  bool isVideo =
-      (ext == ".mp4" || ext == ".webm" || ext == ".mkv" || ext == ".avi");
-  bool isScene = (ext == ".pkg");
-  bool isWeb = (ext == ".html" || ext == ".htm");
-  if (!isImage && !isVideo && !isScene && !isWeb)
-    return;
+std::optional<WallpaperInfo>
+LibraryScanner::probeFile(const std::filesystem::path &path) {
+  if (!isWallpaperFile(path))
+    return std::nullopt;
   std::string id = path.string();
   auto &library = WallpaperLibrary::getInstance();
   if (path.string().find("steamapps/workshop") != std::string::npos ||
       path.string().find("431960") != std::string::npos) {
-    return;
+    return std::nullopt;
   }
-  if (library.getWallpaper(id))
-    return;
   WallpaperInfo info;
   info.id = id;
   info.source = "local";
@@ -376,6 +677,20 @@ void LibraryScanner::scanFile(const std::filesystem::path &path) {
     LOG_DEBUG("Failed to get file size: " + path.string() + " - " + e.what());
     info.size_bytes = 0;
   }
+  // Known wallpapers are only revisited to backfill media details for
+  // entries added before the scanner probed headers, or when the file was
+  // rewritten in place; thumbnails of the old contents are dropped then.
+  auto known = library.getWallpaper(id);
+  const bool rewritten = known && known->size_bytes != 0 &&
+                         info.size_bytes != 0 &&
+                         known->size_bytes != info.size_bytes;
+  if (rewritten) {
+    ThumbnailCache::getInstance().invalidate(id);
+    // The merge clears its perceptual hash; let the hash thread retry it.
+    std::lock_guard<std::mutex> lock(m_hashMutex);
+    m_hashQueued.erase(id);
+  } else if (known && (known->width > 0 || !known->codec.empty()))
+    return std::nullopt;
   // Treat all as WE Video for consistent transition behavior.
   // if (isScene)
   //   info.type = WallpaperType::WEScene;
@@ -386,11 +701,8 @@ void LibraryScanner::scanFile(const std::filesystem::path &path) {
   // else
   //   info.type = WallpaperType::StaticImage;
   info.type = WallpaperType::WEVideo;
-  library.addWallpaper(info);
-  {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_callback)
-      m_callback(path.string());
-  }
+  if (!applyMediaProbe(path, info) && known)
+    return std::nullopt;
+  return info;
 }
 } // namespace bwp::wallpaper
@@ -1,5 +1,11 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <filesystem>
 #include <functional>
 #ifdef _WIN32
@@ -9,21 +15,40 @@ typedef void* gpointer;
 #include <gtk/gtk.h>
 #endif
 #include <mutex>
+#include <memory>
+#include <optional>
 #include <string>
 #include <thread>
+#include <unordered_set>
+#include <utility>
 #include <vector>
+#include "../utils/SpscRing.hpp"
+#include "WallpaperInfo.hpp"
+#include "library/ProjectMetadata.hpp"
+#include "library/ScanManifest.hpp"
 namespace bwp::wallpaper {
 struct ScanProgress {
   int filesScanned = 0;
   int filesFound = 0;
-  int totalEstimate = 0;  
+  // Directories and workshop items the previous scan recorded; 0 on a
+  // first scan.
+  int totalEstimate = 0;
+  int dirsVisited = 0;  // listed or probed this scan
+  int dirsSkipped = 0;  // unchanged since the scan manifest was recorded
+  int64_t bytesScanned = 0;  // sizes of the files probed
+  double filesPerSecond = 0.0;
+  double bytesPerSecond = 0.0;
+  int etaSeconds = -1;  // -1 while unknown
+  // Found paths that were not delivered because the main loop fell behind;
+  // listeners that mirror the library should reload it when nonzero.
+  int foundDropped = 0;
   std::string currentPath;
   bool isComplete = false;
   [[nodiscard]] float getPercentage() const {
     if (totalEstimate <= 0)
-      return -1.0f;  
-    return static_cast<float>(filesScanned) /
-           static_cast<float>(totalEstimate) * 100.0f;
+      return -1.0f;
+    return std::min(100.0f, static_cast<float>(dirsVisited + dirsSkipped) /
+                                static_cast<float>(totalEstimate) * 100.0f);
   }
 };
 class LibraryScanner {
@@ -32,32 +57,93 @@ public:
   void scan(const std::vector<std::string> &paths);
   void cancelScan();
   void waitForCompletion();
+  // Both queue the entry's perceptual hash once it is visible; callers
+  // inside a library transaction queue theirs after commit().
   void scanFile(const std::filesystem::path &path);
   bool scanWorkshopItem(const std::filesystem::path &dir);
+  // (id, path) pairs to hash in the background; each id is tried once.
+  void queuePerceptualHashes(
+      std::vector<std::pair<std::string, std::string>> items);
+  // Existing Wallpaper Engine workshop content folders, deduplicated.
+  static std::vector<std::filesystem::path> workshopRoots();
   [[nodiscard]] bool isScanning() const { return m_scanning; }
   [[nodiscard]] ScanProgress getProgress() const;
-  using ScanCallback = std::function<void(const std::string &path)>;
+  // Callbacks run on the GLib main loop. A single source drains the scan
+  // workers' queues about 30 times a second and delivers found paths in
+  // batches together with one aggregated progress update.
+  using ScanCallback = std::function<void(const std::vector<std::string> &paths)>;
   using ProgressCallback = std::function<void(const ScanProgress &progress)>;
   using CompletionCallback = std::function<void(int totalFound)>;
   void setCallback(ScanCallback callback);
   void setProgressCallback(ProgressCallback callback);
   void setCompletionCallback(CompletionCallback callback);
+  static constexpr unsigned kMaxScanWorkers = 16;
+  static constexpr unsigned kTickMs = 33;
 private:
   LibraryScanner();
   ~LibraryScanner();
   void runScan(std::vector<std::string> paths);
-  void reportProgress();
-  void notifyCompletion();
-  static gboolean idleProgress(gpointer data);
-  static gboolean idleCompletion(gpointer data);
-  static gboolean idleFileFound(gpointer data);
+  std::optional<WallpaperInfo> probeWorkshopItem(const std::filesystem::path &dir);
+  std::optional<WallpaperInfo> probeFile(const std::filesystem::path &path);
+  void flushBatch(std::vector<WallpaperInfo> &batch, unsigned producer);
+  ProjectMetadataCache &projectCache();
+  // Producer slot for paths found outside a scan (scanFile and
+  // scanWorkshopItem); pool workers use their own index.
+  static constexpr unsigned kExternalProducer = kMaxScanWorkers;
+  static constexpr size_t kFoundQueueSize = 512;
+  using FoundQueue = utils::SpscRing<std::string, kFoundQueueSize>;
+  void publishFound(unsigned producer, std::string path);
+  void ensureTicker();
+  static gboolean onTick(gpointer data);
+  bool tick();
+  bool queuesEmpty() const;
+  void updateRates();
+  ScanProgress sampleProgress() const;
   std::atomic<bool> m_scanning{false};
   std::atomic<bool> m_cancelRequested{false};
   std::thread m_scanThread;
   ScanCallback m_callback;
   ProgressCallback m_progressCallback;
   CompletionCallback m_completionCallback;
-  mutable std::mutex m_mutex;
-  ScanProgress m_progress;
+  mutable std::mutex m_mutex;  // callbacks, m_currentPath and the rates
+  // Written by the scan workers, sampled by the main-loop tick.
+  std::atomic<int> m_filesScanned{0};
+  std::atomic<int> m_filesFound{0};
+  std::atomic<int> m_dirsVisited{0};
+  std::atomic<int> m_dirsSkipped{0};
+  std::atomic<int64_t> m_bytesScanned{0};
+  std::atomic<int> m_totalEstimate{0};
+  std::atomic<int> m_foundDropped{0};
+  std::atomic<bool> m_complete{false};
+  std::atomic<bool> m_completionPending{false};
+  std::atomic<unsigned> m_scanGeneration{0};
+  std::string m_currentPath;
+  double m_filesPerSecond = 0.0;
+  double m_bytesPerSecond = 0.0;
+  double m_dirsPerSecond = 0.0;
+  std::array<std::unique_ptr<FoundQueue>, kMaxScanWorkers + 1> m_found;
+  std::mutex m_externalMutex;  // serializes producers of kExternalProducer
+  std::atomic<bool> m_tickerActive{false};
+  // Main loop only.
+  std::vector<std::string> m_foundBatch;
+  unsigned m_sampleGeneration = 0;
+  std::chrono::steady_clock::time_point m_lastSample;
+  int m_lastFiles = 0;
+  int64_t m_lastBytes = 0;
+  int m_lastDirs = 0;
+  // Perceptual hashes for findNearDuplicates, made from small thumbnails
+  // on one background thread as the scan adds entries, so a near-duplicate
+  // query rarely has to decode anything itself.
+  void hashLoop();
+  std::mutex m_hashMutex;
+  std::condition_variable m_hashCv;
+  std::deque<std::pair<std::string, std::string>> m_hashQueue;  // id, path
+  std::unordered_set<std::string> m_hashQueued;  // tried once per session
+  std::thread m_hashThread;
+  std::atomic<bool> m_stopHashing{false};
+  ScanManifest m_manifest;  // scan thread only
+  bool m_manifestLoaded = false;
+  ProjectMetadataCache m_projectCache;
+  std::once_flag m_projectCacheLoaded;
 };
 }  
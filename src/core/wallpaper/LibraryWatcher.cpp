@@ -0,0 +1,385 @@
+#include "LibraryWatcher.hpp"
+#include "../config/ConfigManager.hpp"
+#include "../config/SettingsSchema.hpp"
+#include "../utils/FileUtils.hpp"
+#include "../utils/Logger.hpp"
+#include "LibraryScanner.hpp"
+#include "ThumbnailCache.hpp"
+#include "WallpaperLibrary.hpp"
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <glib-unix.h>
+#include <glib.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+namespace bwp::wallpaper {
+namespace {
+std::vector<std::string> configuredPaths() {
+  return config::ConfigManager::getInstance().get<std::vector<std::string>>(
+      config::keys::LIBRARY_PATHS, {});
+}
+} // namespace
+LibraryWatcher &LibraryWatcher::getInstance() {
+  static LibraryWatcher instance;
+  return instance;
+}
+size_t LibraryWatcher::watchCount() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_watches.size();
+}
+#ifdef __linux__
+LibraryWatcher::~LibraryWatcher() {
+  m_stopping = true;
+  if (m_worker.joinable())
+    m_worker.join();
+  if (m_fd >= 0)
+    ::close(m_fd);
+}
+bool LibraryWatcher::start() {
+  if (isRunning())
+    return true;
+  open();
+  if (!isRunning())
+    return false;
+  if (m_configListener < 0) {
+    m_configListener = config::ConfigManager::getInstance().addListener(
+        [this](const std::string &key, const nlohmann::json &) {
+          if (key != config::keys::LIBRARY_PATHS)
+            return;
+          // Rewatch from the main loop, whichever thread changed the key.
+          g_idle_add(
+              [](gpointer data) -> gboolean {
+                auto *self = static_cast<LibraryWatcher *>(data);
+                if (self->isRunning()) {
+                  self->close();
+                  self->open();
+                }
+                return G_SOURCE_REMOVE;
+              },
+              this);
+        });
+  }
+  return true;
+}
+void LibraryWatcher::stop() {
+  close();
+  if (m_configListener >= 0) {
+    config::ConfigManager::getInstance().removeListener(m_configListener);
+    m_configListener = -1;
+  }
+}
+void LibraryWatcher::open() {
+  m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_fd < 0) {
+    LOG_WARN("inotify unavailable, library changes need a rescan: " +
+             std::string(std::strerror(errno)));
+    return;
+  }
+  m_fdSource = g_unix_fd_add(
+      m_fd, G_IO_IN,
+      [](gint, GIOCondition, gpointer data) -> gboolean {
+        static_cast<LibraryWatcher *>(data)->readEvents();
+        return G_SOURCE_CONTINUE;
+      },
+      this);
+  std::vector<std::filesystem::path> userRoots;
+  for (const auto &pathStr : configuredPaths()) {
+    // Workshop content is watched through workshopRoots(), as it is scanned.
+    if (pathStr.find("431960") != std::string::npos)
+      continue;
+    std::filesystem::path path = utils::FileUtils::expandPath(pathStr);
+    std::error_code ec;
+    if (std::filesystem::is_directory(path, ec))
+      userRoots.push_back(path);
+  }
+  // A large workshop folder means tens of thousands of watches; add them
+  // off the main loop. Events that arrive meanwhile are queued as usual.
+  m_busy = true;
+  m_worker = std::thread([this, userRoots]() {
+    for (const auto &root : LibraryScanner::workshopRoots())
+      watchTree(root, true, 0);
+    for (const auto &root : userRoots)
+      watchTree(root, false, 0);
+    LOG_INFO("Library watcher: watching " + std::to_string(watchCount()) +
+             " directories");
+    m_busy = false;
+  });
+}
+void LibraryWatcher::close() {
+  m_stopping = true;
+  if (m_worker.joinable())
+    m_worker.join();
+  m_stopping = false;
+  m_busy = false;
+  if (m_timer) {
+    g_source_remove(m_timer);
+    m_timer = 0;
+  }
+  if (m_fdSource) {
+    g_source_remove(m_fdSource);
+    m_fdSource = 0;
+  }
+  if (m_fd >= 0) {
+    ::close(m_fd);
+    m_fd = -1;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_watches.clear();
+  m_limitReached = false;
+  m_pending.clear();
+  m_overflow = false;
+}
+void LibraryWatcher::addWatch(const std::filesystem::path &dir, bool workshop,
+                              int depth) {
+  constexpr uint32_t kMask = IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO |
+                             IN_MOVED_FROM | IN_DELETE | IN_MOVE_SELF |
+                             IN_ONLYDIR;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_fd < 0 || m_limitReached)
+    return;
+  int wd = inotify_add_watch(m_fd, dir.c_str(), kMask);
+  if (wd < 0) {
+    if (errno == ENOSPC) {
+      m_limitReached = true;
+      LOG_WARN("inotify watch limit reached (fs.inotify.max_user_watches); "
+               "changes in unwatched folders appear on the next scan");
+    }
+    return;
+  }
+  m_watches[wd] = {dir, workshop, depth};
+}
+void LibraryWatcher::watchTree(const std::filesystem::path &dir, bool workshop,
+                               int depth) {
+  addWatch(dir, workshop, depth);
+  if (workshop && depth >= 1)
+    return;
+  std::error_code ec;
+  for (std::filesystem::directory_iterator
+           it(dir, std::filesystem::directory_options::skip_permission_denied,
+              ec),
+       end;
+       !ec && it != end; it.increment(ec)) {
+    if (m_stopping)
+      return;
+    std::error_code entryEc;
+    // Workshop items may be symlinked folders; user trees are walked like
+    // the scanner walks them, without following directory symlinks.
+    if (it->is_directory(entryEc) && (workshop || !it->is_symlink(entryEc)))
+      watchTree(it->path(), workshop, depth + 1);
+  }
+}
+void LibraryWatcher::readEvents() {
+  alignas(inotify_event) char buffer[16 * 1024];
+  for (;;) {
+    ssize_t n = ::read(m_fd, buffer, sizeof(buffer));
+    if (n <= 0)
+      break;
+    for (char *p = buffer; p < buffer + n;) {
+      const auto *event = reinterpret_cast<const inotify_event *>(p);
+      p += sizeof(inotify_event) + event->len;
+      if (event->mask & IN_Q_OVERFLOW) {
+        m_overflow = true;
+        continue;
+      }
+      Watch watch;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_watches.find(event->wd);
+        if (it == m_watches.end())
+          continue;
+        if (event->mask & IN_IGNORED) {
+          m_watches.erase(it);
+          continue;
+        }
+        watch = it->second;
+      }
+      if (event->mask & IN_MOVE_SELF) {
+        // The watches below still carry the old path. A move within the
+        // library also reports the new path to its parent, which watches
+        // the tree again from there.
+        unwatchTree(watch.path);
+        continue;
+      }
+      if (event->len == 0)
+        continue;
+      const bool directory = event->mask & IN_ISDIR;
+      // A created file is picked up when it is closed after writing.
+      if ((event->mask & IN_CREATE) && !directory)
+        continue;
+      Pending change;
+      change.removed = event->mask & (IN_DELETE | IN_MOVED_FROM);
+      change.directory = directory;
+      change.workshop = watch.workshop;
+      std::filesystem::path path = watch.path / event->name;
+      if (watch.workshop && watch.depth > 0) {
+        // Anything changing inside an item folder re-probes the item.
+        path = watch.path;
+        change = {false, true, true};
+      } else if (watch.workshop && !directory) {
+        continue;
+      }
+      m_pending[path.string()] = change;
+    }
+  }
+  if (m_pending.empty() && !m_overflow)
+    return;
+  auto now = std::chrono::steady_clock::now();
+  if (!m_timer) {
+    m_firstEvent = now;
+    m_timer = g_timeout_add(
+        kDebounceMs,
+        [](gpointer data) -> gboolean {
+          return static_cast<LibraryWatcher *>(data)->onDebounce()
+                     ? G_SOURCE_CONTINUE
+                     : G_SOURCE_REMOVE;
+        },
+        this);
+  }
+  m_lastEvent = now;
+}
+bool LibraryWatcher::onDebounce() {
+  auto now = std::chrono::steady_clock::now();
+  bool quiet = now - m_lastEvent >= std::chrono::milliseconds(kDebounceMs);
+  bool overdue = now - m_firstEvent >= std::chrono::milliseconds(kMaxDelayMs);
+  if ((!quiet && !overdue) || m_busy)
+    return true;
+  m_timer = 0;
+  // Not busy: the last batch is done and the thread is exiting.
+  if (m_worker.joinable())
+    m_worker.join();
+  auto batch = std::move(m_pending);
+  m_pending.clear();
+  bool overflow = m_overflow;
+  m_overflow = false;
+  m_busy = true;
+  m_worker = std::thread(&LibraryWatcher::process, this, std::move(batch),
+                         overflow);
+  return false;
+}
+void LibraryWatcher::process(std::unordered_map<std::string, Pending> batch,
+                             bool overflow) {
+  auto &scanner = LibraryScanner::getInstance();
+  auto &thumbnails = ThumbnailCache::getInstance();
+  auto &library = WallpaperLibrary::getInstance();
+  if (overflow) {
+    // Events were dropped; the manifest keeps the catch-up scan cheap.
+    LOG_WARN("inotify queue overflowed, rescanning the library");
+    scanner.scan(configuredPaths());
+  }
+  bool autoRemove = config::ConfigManager::getInstance().get<bool>(
+      config::keys::AUTO_REMOVE_MISSING, true);
+  size_t updated = 0;
+  size_t removed = 0;
+  // One transaction per batch: a folder copied in is one journal append,
+  // one snapshot and one change set rather than one per file.
+  std::vector<std::string> ingested;
+  library.beginBulk();
+  for (const auto &[key, change] : batch) {
+    if (m_stopping)
+      break;
+    std::filesystem::path path(key);
+    std::error_code ec;
+    // The last event for a path wins, but the disk has the final say.
+    if (!std::filesystem::exists(path, ec)) {
+      if (change.directory)
+        unwatchTree(path);
+      if (autoRemove)
+        removed += removeMissing(path, change);
+      continue;
+    }
+    // Written to or replaced: thumbnails of what was there are stale.
+    if (change.workshop) {
+      watchTree(path, true, 1);
+      if (auto known = library.getWallpaper(path.filename().string()))
+        thumbnails.invalidate(known->path);
+      if (scanner.scanWorkshopItem(path)) {
+        ingested.push_back(path.filename().string());
+        updated++;
+      }
+    } else if (std::filesystem::is_directory(path, ec)) {
+      // A folder moved or copied in: watch it and ingest what it holds.
+      watchTree(path, false, 1);
+      for (std::filesystem::recursive_directory_iterator
+               it(path,
+                  std::filesystem::directory_options::skip_permission_denied,
+                  ec),
+           end;
+           !ec && it != end && !m_stopping; it.increment(ec)) {
+        std::error_code entryEc;
+        if (it->is_regular_file(entryEc)) {
+          scanner.scanFile(it->path());
+          ingested.push_back(it->path().string());
+          updated++;
+        }
+      }
+    } else {
+      thumbnails.invalidate(key);
+      scanner.scanFile(path);
+      ingested.push_back(key);
+      updated++;
+    }
+  }
+  library.commit();
+  // New entries only became visible with the commit.
+  std::vector<std::pair<std::string, std::string>> unhashed;
+  for (const auto &id : ingested) {
+    auto info = library.getWallpaper(id);
+    if (info && info->phash == 0)
+      unhashed.emplace_back(id, info->path);
+  }
+  scanner.queuePerceptualHashes(std::move(unhashed));
+  LOG_DEBUG("Library watcher: processed " + std::to_string(batch.size()) +
+            " paths, " + std::to_string(updated) + " probed, " +
+            std::to_string(removed) + " removed");
+  m_busy = false;
+}
+void LibraryWatcher::unwatchTree(const std::filesystem::path &dir) {
+  const std::string prefix = dir.string() + "/";
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto it = m_watches.begin(); it != m_watches.end();) {
+    const std::string path = it->second.path.string();
+    if (path == dir.string() || path.rfind(prefix, 0) == 0) {
+      inotify_rm_watch(m_fd, it->first);
+      it = m_watches.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+size_t LibraryWatcher::removeMissing(const std::filesystem::path &path,
+                                     const Pending &change) {
+  auto &library = WallpaperLibrary::getInstance();
+  if (change.workshop) {
+    std::string id = path.filename().string();
+    auto info = library.getWallpaper(id);
+    if (!info || info->source != "workshop")
+      return 0;
+    library.removeWallpaper(id);
+    return 1;
+  }
+  // Local wallpapers are keyed by their path.
+  if (!change.directory) {
+    if (!library.getWallpaper(path.string()))
+      return 0;
+    library.removeWallpaper(path.string());
+    return 1;
+  }
+  const std::string prefix = path.string() + "/";
+  auto gone = library.filter([&](const WallpaperInfo &info) {
+    return info.source == "local" && info.path.rfind(prefix, 0) == 0;
+  });
+  for (const auto &info : gone)
+    library.removeWallpaper(info.id);
+  return gone.size();
+}
+#else
+LibraryWatcher::~LibraryWatcher() = default;
+bool LibraryWatcher::start() {
+  LOG_INFO("Library watching is not supported on this platform");
+  return false;
+}
+void LibraryWatcher::stop() {}
+#endif
+} // namespace bwp::wallpaper
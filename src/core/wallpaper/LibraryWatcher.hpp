@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+namespace bwp::wallpaper {
+// Watches library.paths and the workshop content folders with inotify and
+// hands changed paths to LibraryScanner's per-item functions, so new
+// wallpapers show up without a full rescan. Events are read on the GLib
+// main loop and debounced; the affected paths are then processed on a
+// background thread. Linux only; start() fails elsewhere.
+class LibraryWatcher {
+public:
+  static LibraryWatcher &getInstance();
+  // Call from the main thread. Also follows changes to library.paths.
+  bool start();
+  void stop();
+  [[nodiscard]] bool isRunning() const { return m_fd >= 0; }
+  [[nodiscard]] size_t watchCount() const;
+  // Quiet period after the last event before a batch is processed, and the
+  // longest a continuous burst can hold a batch back.
+  static constexpr int kDebounceMs = 250;
+  static constexpr int kMaxDelayMs = 1000;
+
+private:
+  LibraryWatcher() = default;
+  ~LibraryWatcher();
+  LibraryWatcher(const LibraryWatcher &) = delete;
+  LibraryWatcher &operator=(const LibraryWatcher &) = delete;
+  // Workshop roots are watched two levels deep (root and item folders);
+  // user roots are watched recursively.
+  struct Watch {
+    std::filesystem::path path;
+    bool workshop = false;
+    int depth = 0;
+  };
+  struct Pending {
+    bool removed = false;
+    bool directory = false;
+    bool workshop = false;
+  };
+  void open();
+  void close();
+  void addWatch(const std::filesystem::path &dir, bool workshop, int depth);
+  void watchTree(const std::filesystem::path &dir, bool workshop, int depth);
+  void unwatchTree(const std::filesystem::path &dir);
+  void readEvents();
+  bool onDebounce();
+  void process(std::unordered_map<std::string, Pending> batch, bool overflow);
+  size_t removeMissing(const std::filesystem::path &path,
+                       const Pending &change);
+  int m_fd = -1;
+  unsigned int m_fdSource = 0;
+  unsigned int m_timer = 0;
+  int m_configListener = -1;
+  mutable std::mutex m_mutex; // m_watches, m_limitReached
+  // Keyed by watch descriptor. The kernel hands out the same descriptor for
+  // a directory it already watches, which makes adding a watch idempotent
+  // and follows a directory that is moved and watched again.
+  std::unordered_map<int, Watch> m_watches;
+  bool m_limitReached = false;
+  // Main thread only.
+  std::unordered_map<std::string, Pending> m_pending;
+  bool m_overflow = false;
+  std::chrono::steady_clock::time_point m_firstEvent;
+  std::chrono::steady_clock::time_point m_lastEvent;
+  // Watches the roots on open(), then processes one batch at a time. Checks
+  // m_stopping between files, so joining it waits for one probe at most.
+  std::thread m_worker;
+  std::atomic<bool> m_busy{false};
+  std::atomic<bool> m_stopping{false};
+};
+} // namespace bwp::wallpaper
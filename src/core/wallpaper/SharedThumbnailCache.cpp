@@ -0,0 +1,173 @@
+#include "SharedThumbnailCache.hpp"
+#include "../utils/Logger.hpp"
+#include "../utils/ThumbnailDecoder.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string>
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+namespace bwp::wallpaper {
+#ifndef _WIN32
+namespace {
+struct Flavor {
+  const char *dir;
+  int size;
+};
+// Smallest first.
+constexpr Flavor kFlavors[] = {
+    {"normal", 128}, {"large", 256}, {"x-large", 512}, {"xx-large", 1024}};
+struct Source {
+  std::string uri;
+  int64_t mtime;  // whole seconds, as Thumb::MTime stores it
+  uint64_t size;
+};
+std::filesystem::path absolutePath(const std::filesystem::path &path) {
+  std::error_code ec;
+  return std::filesystem::absolute(path, ec).lexically_normal();
+}
+std::optional<Source> describe(const std::filesystem::path &path) {
+  struct stat st {};
+  if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    return std::nullopt;
+  // GIO builds the same URI, so names match what file managers write.
+  gchar *uri = g_filename_to_uri(absolutePath(path).c_str(), nullptr, nullptr);
+  if (!uri)
+    return std::nullopt;
+  Source source{uri, static_cast<int64_t>(st.st_mtime),
+                static_cast<uint64_t>(st.st_size)};
+  g_free(uri);
+  return source;
+}
+std::string thumbnailName(const std::string &uri) {
+  gchar *md5 = g_compute_checksum_for_string(G_CHECKSUM_MD5, uri.c_str(), -1);
+  std::string name = std::string(md5) + ".png";
+  g_free(md5);
+  return name;
+}
+bool describes(GdkPixbuf *pixbuf, const Source &source) {
+  const char *uri = gdk_pixbuf_get_option(pixbuf, "tEXt::Thumb::URI");
+  const char *mtime = gdk_pixbuf_get_option(pixbuf, "tEXt::Thumb::MTime");
+  if (!uri || !mtime || source.uri != uri ||
+      std::strtoll(mtime, nullptr, 10) != source.mtime)
+    return false;
+  // Optional in the spec; checked when present.
+  const char *size = gdk_pixbuf_get_option(pixbuf, "tEXt::Thumb::Size");
+  return !size || std::strtoull(size, nullptr, 10) == source.size;
+}
+} // namespace
+#endif
+SharedThumbnailCache::SharedThumbnailCache(std::filesystem::path root)
+    : m_root(std::move(root)) {}
+std::filesystem::path SharedThumbnailCache::defaultRoot() {
+  const char *cacheHome = std::getenv("XDG_CACHE_HOME");
+  if (cacheHome && std::strlen(cacheHome) > 0)
+    return std::filesystem::path(cacheHome) / "thumbnails";
+  const char *home = std::getenv("HOME");
+  if (home)
+    return std::filesystem::path(home) / ".cache" / "thumbnails";
+  return {};
+}
+#ifndef _WIN32
+GdkPixbuf *SharedThumbnailCache::load(const std::filesystem::path &source,
+                                      int size) const {
+  if (m_root.empty())
+    return nullptr;
+  auto described = describe(source);
+  if (!described)
+    return nullptr;
+  const std::string name = thumbnailName(described->uri);
+  for (const Flavor &flavor : kFlavors) {
+    if (flavor.size < size)
+      continue;
+    const std::filesystem::path path = m_root / flavor.dir / name;
+    if (::access(path.c_str(), R_OK) != 0)
+      continue;
+    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file(path.c_str(), nullptr);
+    if (!pixbuf)
+      continue;
+    if (!describes(pixbuf, *described)) {
+      g_object_unref(pixbuf);
+      continue;
+    }
+    const int width = gdk_pixbuf_get_width(pixbuf);
+    const int height = gdk_pixbuf_get_height(pixbuf);
+    if (width <= size && height <= size)
+      return pixbuf;
+    const auto [fitWidth, fitHeight] =
+        utils::ThumbnailDecoder::fit(width, height, size);
+    GdkPixbuf *scaled = gdk_pixbuf_scale_simple(pixbuf, fitWidth, fitHeight,
+                                                GDK_INTERP_BILINEAR);
+    g_object_unref(pixbuf);
+    return scaled;
+  }
+  return nullptr;
+}
+bool SharedThumbnailCache::save(const std::filesystem::path &source, int size,
+                                GdkPixbuf *pixbuf) const {
+  const Flavor *flavor = nullptr;
+  for (const Flavor &candidate : kFlavors) {
+    if (candidate.size == size)
+      flavor = &candidate;
+  }
+  if (!flavor || !pixbuf || m_root.empty())
+    return false;
+  // The spec rules out thumbnailing the thumbnail cache itself.
+  const auto inside = absolutePath(source).lexically_relative(m_root);
+  if (!inside.empty() && *inside.begin() != "..")
+    return false;
+  auto described = describe(source);
+  if (!described)
+    return false;
+  const std::filesystem::path dir = m_root / flavor->dir;
+  std::error_code ec;
+  if (std::filesystem::create_directories(dir, ec)) {
+    std::filesystem::permissions(dir, std::filesystem::perms::owner_all,
+                                 std::filesystem::perm_options::replace, ec);
+  }
+  if (ec)
+    return false;
+  const std::string name = thumbnailName(described->uri);
+  // Written aside and renamed into place so readers never see half a file.
+  const std::filesystem::path temp =
+      dir / ("." + name + "." + std::to_string(::getpid()) + ".tmp");
+  std::string mtime = std::to_string(described->mtime);
+  std::string fileSize = std::to_string(described->size);
+  char software[] = "BetterWallpaper";
+  char *keys[] = {const_cast<char *>("tEXt::Thumb::URI"),
+                  const_cast<char *>("tEXt::Thumb::MTime"),
+                  const_cast<char *>("tEXt::Thumb::Size"),
+                  const_cast<char *>("tEXt::Software"), nullptr};
+  char *values[] = {described->uri.data(), mtime.data(), fileSize.data(),
+                    software, nullptr};
+  GError *error = nullptr;
+  if (!gdk_pixbuf_savev(pixbuf, temp.c_str(), "png", keys, values, &error)) {
+    if (error) {
+      LOG_DEBUG("Failed to write shared thumbnail: " +
+                std::string(error->message));
+      g_error_free(error);
+    }
+    std::filesystem::remove(temp, ec);
+    return false;
+  }
+  ::chmod(temp.c_str(), 0600);
+  std::filesystem::rename(temp, dir / name, ec);
+  if (ec) {
+    std::filesystem::remove(temp, ec);
+    return false;
+  }
+  return true;
+}
+#else
+GdkPixbuf *SharedThumbnailCache::load(const std::filesystem::path &,
+                                      int) const {
+  return nullptr;
+}
+bool SharedThumbnailCache::save(const std::filesystem::path &, int,
+                                GdkPixbuf *) const {
+  return false;
+}
+#endif
+} // namespace bwp::wallpaper
@@ -0,0 +1,30 @@
+#pragma once
+#include <filesystem>
+#ifdef _WIN32
+typedef struct _GdkPixbuf GdkPixbuf;
+#else
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#endif
+namespace bwp::wallpaper {
+// The freedesktop.org thumbnail cache ($XDG_CACHE_HOME/thumbnails) that file
+// managers and image viewers share. Thumbnails are PNGs named after the MD5
+// of the source URI, in one directory per size (normal 128, large 256,
+// x-large 512, xx-large 1024), and record the source URI and mtime, so a
+// thumbnail of a file that has since changed is recognised and skipped.
+// Stateless apart from the root; safe to use from several threads.
+class SharedThumbnailCache {
+public:
+  explicit SharedThumbnailCache(std::filesystem::path root = defaultRoot());
+  static std::filesystem::path defaultRoot();
+  // A valid thumbnail of `source` that fits `size`, scaled down from a
+  // bigger flavor when no exact one exists. nullptr if there is none.
+  GdkPixbuf *load(const std::filesystem::path &source, int size) const;
+  // Writes `pixbuf` as the thumbnail of `source`; `size` must be one of the
+  // spec's flavors.
+  bool save(const std::filesystem::path &source, int size,
+            GdkPixbuf *pixbuf) const;
+
+private:
+  std::filesystem::path m_root;
+};
+} // namespace bwp::wallpaper
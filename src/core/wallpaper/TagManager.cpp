@@ -1,7 +1,6 @@
 #include "TagManager.hpp"
 #include <algorithm>
 #include <cctype>
-#include <set>
 namespace bwp::wallpaper {
 TagManager &TagManager::getInstance() {
   static TagManager instance;
@@ -10,14 +9,7 @@ TagManager &TagManager::getInstance() {
 TagManager::TagManager() {}
 TagManager::~TagManager() {}
 std::vector<std::string> TagManager::getAllTags() const {
-  auto wallpapers = WallpaperLibrary::getInstance().getAllWallpapers();
-  std::set<std::string> tags;
-  for (const auto &wp : wallpapers) {
-    for (const auto &tag : wp.tags) {
-      tags.insert(tag);
-    }
-  }
-  return std::vector<std::string>(tags.begin(), tags.end());
+  return WallpaperLibrary::getInstance().getAllTags();
 }
 int TagManager::levenshteinDistance(const std::string &s1,
                                     const std::string &s2) {
@@ -1,16 +1,22 @@
 #include "ThumbnailCache.hpp"
+#include "../config/ConfigManager.hpp"
+#include "../config/SettingsSchema.hpp"
 #include "../utils/Blurhash.hpp"
+#include "../utils/ContentHash.hpp"
 #include "../utils/Logger.hpp"
+#include "../utils/PerceptualHash.hpp"
+#include "../utils/QoiCodec.hpp"
+#include "../utils/ThumbnailDecoder.hpp"
+#include "library/ProjectMetadata.hpp"
 #include <algorithm>
 #include <chrono>
 #include <cstring>
 #include <fstream>
 #include <functional>
+#include <optional>
 #ifndef _WIN32
 #include <gtk/gtk.h>
 #endif
-#include <iomanip>
-#include <sstream>
 #include <thread>
 namespace bwp::wallpaper {
 ThumbnailCache &ThumbnailCache::getInstance() {
@@ -18,15 +24,140 @@ ThumbnailCache &ThumbnailCache::getInstance() {
   return instance;
 }
 #ifndef _WIN32
-ThumbnailCache::ThumbnailCache() { initCacheDir(); }
-ThumbnailCache::~ThumbnailCache() {
-  std::lock_guard<std::mutex> lock(m_mutex);
-  for (auto &[key, entry] : m_memoryCache) {
-    if (entry.pixbuf) {
-      g_object_unref(entry.pixbuf);
-    }
+namespace {
+// Decoding is CPU and memory bound; a few workers keep the grid fed without
+// starving the renderer.
+unsigned thumbnailWorkers() {
+  return std::clamp(std::thread::hardware_concurrency() / 2, 2u, 4u);
+}
+// Only thumbnails of the file itself go to the shared cache; a preview
+// standing in for a project would be shown for its project.json.
+bool isSharedSource(const std::filesystem::path &path) {
+  std::string ext = path.extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".gif" ||
+         ext == ".bmp" || ext == ".webp" || ext == ".mp4" || ext == ".webm" ||
+         ext == ".mkv" || ext == ".avi";
+}
+ThumbnailStore::Format codecFromConfig(const nlohmann::json &value) {
+  return value.is_string() && value.get<std::string>() == "png"
+             ? ThumbnailStore::Format::Png
+             : ThumbnailStore::Format::Qoi;
+}
+GdkPixbuf *decodePng(const uint8_t *data, size_t size) {
+  GdkPixbufLoader *loader = gdk_pixbuf_loader_new_with_type("png", nullptr);
+  if (!loader)
+    return nullptr;
+  GError *error = nullptr;
+  bool written = gdk_pixbuf_loader_write(loader, data, size, &error);
+  bool closed = gdk_pixbuf_loader_close(loader, written ? &error : nullptr);
+  GdkPixbuf *pixbuf =
+      written && closed ? gdk_pixbuf_loader_get_pixbuf(loader) : nullptr;
+  if (pixbuf) {
+    g_object_ref(pixbuf);
+  }
+  if (error) {
+    LOG_WARN("Failed to load cached thumbnail: " + std::string(error->message));
+    g_error_free(error);
+  }
+  g_object_unref(loader);
+  return pixbuf;
+}
+// Decodes into the buffer the pixbuf will own; no inflate, no copy.
+GdkPixbuf *decodeQoi(const uint8_t *data, size_t size) {
+  auto header = utils::qoi::readHeader(data, size);
+  if (!header)
+    return nullptr;
+  const size_t rowstride = static_cast<size_t>(header->width) * header->channels;
+  auto *pixels = static_cast<guchar *>(g_malloc(rowstride * header->height));
+  if (!utils::qoi::decode(data, size, pixels, rowstride)) {
+    LOG_WARN("Failed to load cached thumbnail: corrupt QOI data");
+    g_free(pixels);
+    return nullptr;
+  }
+  return gdk_pixbuf_new_from_data(
+      pixels, GDK_COLORSPACE_RGB, header->channels == 4, 8,
+      static_cast<int>(header->width), static_cast<int>(header->height),
+      static_cast<int>(rowstride),
+      [](guchar *p, gpointer) { g_free(p); }, nullptr);
+}
+// The video a wallpaper plays: the file itself, or the one a Wallpaper
+// Engine video project points at. Empty for anything else.
+std::filesystem::path videoSource(const std::filesystem::path &path) {
+  std::string ext = path.extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  if (ext == ".mp4" || ext == ".webm" || ext == ".mkv" || ext == ".avi")
+    return path;
+  if (ext != ".json")
+    return {};
+  std::ifstream file(path, std::ios::binary);
+  std::string json((std::istreambuf_iterator<char>(file)),
+                   std::istreambuf_iterator<char>());
+  auto project = ProjectMetadata::extract(json);
+  if (!project || project->file.empty())
+    return {};
+  std::string type = project->type;
+  std::transform(type.begin(), type.end(), type.begin(), ::tolower);
+  if (type != "video")
+    return {};
+  return path.parent_path() / project->file;
+}
+// The pixbuf takes over the decoded pixels without a copy.
+GdkPixbuf *wrapDecoded(utils::DecodedImage image) {
+  auto *pixels = new std::vector<uint8_t>(std::move(image.pixels));
+  return gdk_pixbuf_new_from_data(
+      pixels->data(), GDK_COLORSPACE_RGB, image.channels == 4, 8, image.width,
+      image.height, image.width * image.channels,
+      [](guchar *, gpointer data) {
+        delete static_cast<std::vector<uint8_t> *>(data);
+      },
+      pixels);
+}
+} // namespace
+ThumbnailCache::ThumbnailCache()
+    : m_sharedCache(std::make_unique<SharedThumbnailCache>()),
+      m_frameGrabber(std::make_unique<VideoFrameGrabber>()),
+      m_workers(std::make_unique<DecodePool>(thumbnailWorkers())) {
+  initCacheDir();
+  m_store = std::make_unique<ThumbnailStore>(m_cacheDir);
+  if (m_store->open()) {
+    m_workers->submit(
+        "#legacy", DecodePool::Priority::Low,
+        [this]() {
+          removeLegacyFiles();
+          return std::shared_ptr<GdkPixbuf>();
+        },
+        nullptr);
+    pruneCache();
   }
-  m_memoryCache.clear();
+  auto &config = config::ConfigManager::getInstance();
+  setMemoryBudget(config.get<int>(config::keys::THUMBNAIL_MEMORY_MB, 64));
+  setCodec(codecFromConfig(
+      config.get<std::string>(config::keys::THUMBNAIL_CODEC, "qoi")));
+  m_useSharedCache =
+      config.get<bool>(config::keys::THUMBNAIL_SHARED_CACHE, true);
+  m_configListener = config.addListener(
+      [this](const std::string &key, const nlohmann::json &value) {
+        if (key == config::keys::THUMBNAIL_MEMORY_MB && value.is_number())
+          setMemoryBudget(value.get<int>());
+        else if (key == config::keys::THUMBNAIL_CODEC)
+          setCodec(codecFromConfig(value));
+        else if (key == config::keys::THUMBNAIL_SHARED_CACHE &&
+                 value.is_boolean())
+          m_useSharedCache = value.get<bool>();
+      });
+}
+ThumbnailCache::~ThumbnailCache() {
+  m_workers.reset();
+  if (m_configListener >= 0)
+    config::ConfigManager::getInstance().removeListener(m_configListener);
+  m_memory.clear();
+}
+void ThumbnailCache::setMemoryBudget(size_t megabytes) {
+  m_memory.setBudget(megabytes << 20);
+}
+void ThumbnailCache::setCodec(ThumbnailStore::Format format) {
+  m_codec = format;
 }
 void ThumbnailCache::initCacheDir() {
   const char *cacheHome = std::getenv("XDG_CACHE_HOME");
@@ -53,59 +184,50 @@ void ThumbnailCache::initCacheDir() {
 }
 std::string
 ThumbnailCache::generateCacheKey(const std::string &wallpaperPath) const {
-  std::hash<std::string> hasher;
-  size_t hash = hasher(wallpaperPath);
-  std::ostringstream ss;
-  ss << std::hex << std::setfill('0') << std::setw(16) << hash;
-  return ss.str();
-}
-std::filesystem::path
-ThumbnailCache::getCachePath(const std::string &wallpaperPath,
-                             Size size) const {
-  std::string key = generateCacheKey(wallpaperPath);
-  std::string filename =
-      key + "_" + std::to_string(static_cast<int>(size)) + ".png";
-  return m_cacheDir / filename;
-}
-bool ThumbnailCache::isCached(const std::string &wallpaperPath,
-                              Size size) const {
-  auto cachePath = getCachePath(wallpaperPath, size);
-  return std::filesystem::exists(cachePath);
+  // XXH64 is fixed by its spec, so keys survive rebuilds and upgrades
+  // (std::hash makes no such promise).
+  return utils::ContentHash::toHex(
+      utils::Xxh64::of(wallpaperPath.data(), wallpaperPath.size()));
+}
+bool ThumbnailCache::isCached(const std::string &wallpaperPath, Size size) {
+  auto blob = m_store->find(memoryKey(wallpaperPath, size));
+  return blob && blob->entry.isCurrent(wallpaperPath);
+}
+std::string ThumbnailCache::memoryKey(const std::string &wallpaperPath,
+                                      Size size) const {
+  return generateCacheKey(wallpaperPath) + "_" +
+         std::to_string(static_cast<int>(size));
+}
+GdkPixbuf *ThumbnailCache::getFromMemory(const std::string &key,
+                                         const SourceStamp &source) {
+  auto cached = m_memory.get(key);
+  if (!cached || !cached->pixbuf)
+    return nullptr;
+  if (cached->source != source) {
+    m_memory.erase(key);
+    return nullptr;
+  }
+  return GDK_PIXBUF(g_object_ref(cached->pixbuf.get()));
+}
+void ThumbnailCache::remember(const std::string &key, GdkPixbuf *pixbuf,
+                              const SourceStamp &source) {
+  size_t bytes = static_cast<size_t>(gdk_pixbuf_get_rowstride(pixbuf)) *
+                 static_cast<size_t>(gdk_pixbuf_get_height(pixbuf));
+  m_memory.put(key,
+               {std::shared_ptr<GdkPixbuf>(GDK_PIXBUF(g_object_ref(pixbuf)),
+                                           g_object_unref),
+                source},
+               bytes);
 }
 GdkPixbuf *ThumbnailCache::getSync(const std::string &wallpaperPath,
                                    Size size) {
-  std::string key = generateCacheKey(wallpaperPath) + "_" +
-                    std::to_string(static_cast<int>(size));
-  {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    auto it = m_memoryCache.find(key);
-    if (it != m_memoryCache.end()) {
-      it->second.lastAccess = std::chrono::steady_clock::now();
-      return GDK_PIXBUF(g_object_ref(it->second.pixbuf));
-    }
-  }
-  auto cachePath = getCachePath(wallpaperPath, size);
-  if (std::filesystem::exists(cachePath)) {
-    GdkPixbuf *pixbuf = loadFromCache(cachePath);
-    if (pixbuf) {
-      std::lock_guard<std::mutex> lock(m_mutex);
-      if (m_memoryCache.size() >= m_maxMemoryCacheEntries) {
-        auto oldest =
-            std::min_element(m_memoryCache.begin(), m_memoryCache.end(),
-                             [](const auto &a, const auto &b) {
-                               return a.second.lastAccess < b.second.lastAccess;
-                             });
-        if (oldest != m_memoryCache.end()) {
-          if (oldest->second.pixbuf) {
-            g_object_unref(oldest->second.pixbuf);
-          }
-          m_memoryCache.erase(oldest);
-        }
-      }
-      m_memoryCache[key] = CacheEntry{GDK_PIXBUF(g_object_ref(pixbuf)),
-                                      std::chrono::steady_clock::now()};
-      return pixbuf;
-    }
+  std::string key = memoryKey(wallpaperPath, size);
+  const SourceStamp source = SourceStamp::of(wallpaperPath);
+  if (GdkPixbuf *pixbuf = getFromMemory(key, source))
+    return pixbuf;
+  if (GdkPixbuf *pixbuf = loadFromStore(key, source)) {
+    remember(key, pixbuf, source);
+    return pixbuf;
   }
   return nullptr;
 }
@@ -120,41 +242,44 @@ GdkPixbuf *ThumbnailCache::generateSync(const std::string &wallpaperPath,
   bool isImage = (ext == ".jpg" || ext == ".jpeg" || ext == ".png" ||
                   ext == ".gif" || ext == ".bmp" || ext == ".webp");
   bool isScene = (ext == ".pkg" || ext == ".json");
-  if (isVideo || isScene) {
-    pixbuf = generateFromVideo(wallpaperPath, size);
-  } else if (isImage) {
-    pixbuf = generateFromImage(wallpaperPath, size);
+  // Taken first: a file that changes while it is decoded is not current.
+  const SourceStamp source = SourceStamp::of(wallpaperPath);
+  const bool shared = m_useSharedCache && isSharedSource(path);
+  if (shared) {
+    // Made earlier by a file manager or viewer; no need to decode again.
+    pixbuf = m_sharedCache->load(path, static_cast<int>(size));
+  }
+  if (!pixbuf) {
+    // Only a thumbnail of the file itself may be published under its name.
+    bool fromSource = false;
+    if (isVideo || isScene) {
+      pixbuf = generateFromVideo(wallpaperPath, size, fromSource);
+    } else if (isImage) {
+      pixbuf = generateFromImage(wallpaperPath, size);
+      fromSource = true;
+    }
+    if (pixbuf && shared && fromSource) {
+      m_sharedCache->save(path, static_cast<int>(size), pixbuf);
+    }
   }
   if (pixbuf) {
-    auto cachePath = getCachePath(wallpaperPath, size);
-    if (saveToCache(pixbuf, cachePath)) {
+    const std::string key = memoryKey(wallpaperPath, size);
+    if (saveToStore(key, pixbuf, source)) {
       LOG_DEBUG("Cached thumbnail: " + wallpaperPath);
     }
-    std::string key = generateCacheKey(wallpaperPath) + "_" +
-                      std::to_string(static_cast<int>(size));
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_memoryCache.size() >= m_maxMemoryCacheEntries) {
-      auto oldest =
-          std::min_element(m_memoryCache.begin(), m_memoryCache.end(),
-                           [](const auto &a, const auto &b) {
-                             return a.second.lastAccess < b.second.lastAccess;
-                           });
-      if (oldest != m_memoryCache.end()) {
-        if (oldest->second.pixbuf) {
-          g_object_unref(oldest->second.pixbuf);
-        }
-        m_memoryCache.erase(oldest);
-      }
-    }
-    m_memoryCache[key] = CacheEntry{GDK_PIXBUF(g_object_ref(pixbuf)),
-                                    std::chrono::steady_clock::now()};
+    remember(key, pixbuf, source);
   }
   return pixbuf;
 }
 GdkPixbuf *ThumbnailCache::generateFromImage(const std::string &path,
                                              Size size) {
-  GError *error = nullptr;
   int targetSize = static_cast<int>(size);
+  // Large JPEG/PNG sources are decoded at close to thumbnail size instead of
+  // in full; other formats and small images go through gdk-pixbuf.
+  if (auto decoded = utils::ThumbnailDecoder::decode(path, targetSize)) {
+    return wrapDecoded(std::move(*decoded));
+  }
+  GError *error = nullptr;
   GdkPixbuf *pixbuf =
       gdk_pixbuf_new_from_file_at_scale(path.c_str(), targetSize, targetSize,
                                         TRUE,  
@@ -168,7 +293,8 @@ GdkPixbuf *ThumbnailCache::generateFromImage(const std::string &path,
   return pixbuf;
 }
 GdkPixbuf *ThumbnailCache::generateFromVideo(const std::string &path,
-                                             Size size) {
+                                             Size size, bool &fromSource) {
+  fromSource = false;
   std::filesystem::path videoPath(path);
   std::filesystem::path previewPath = videoPath.parent_path() / "preview.jpg";
   if (std::filesystem::exists(previewPath)) {
@@ -182,128 +308,207 @@ GdkPixbuf *ThumbnailCache::generateFromVideo(const std::string &path,
       return generateFromImage(previewPath.string(), size);
     }
   }
+  std::filesystem::path source = videoSource(videoPath);
+  if (!source.empty()) {
+    if (auto frame = m_frameGrabber->grab(source.string(),
+                                          static_cast<int>(size))) {
+      fromSource = source == videoPath;
+      return wrapDecoded(std::move(*frame));
+    }
+  }
   LOG_DEBUG("No preview found for video: " + path);
   return nullptr;
 }
-GdkPixbuf *
-ThumbnailCache::loadFromCache(const std::filesystem::path &cachePath) {
-  GError *error = nullptr;
-  GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file(cachePath.c_str(), &error);
-  if (error) {
-    LOG_WARN("Failed to load cached thumbnail: " + std::string(error->message));
-    g_error_free(error);
+GdkPixbuf *ThumbnailCache::loadFromStore(const std::string &key,
+                                         const SourceStamp &source) {
+  // Decoded straight out of the pack mapping: no open/read per thumbnail.
+  auto blob = m_store->find(key);
+  if (!blob || blob->entry.source() != source)
+    return nullptr;
+  switch (blob->entry.format) {
+  case ThumbnailStore::Format::Qoi:
+    return decodeQoi(blob->data, blob->entry.length);
+  case ThumbnailStore::Format::Png:
+    return decodePng(blob->data, blob->entry.length);
+  default:
     return nullptr;
   }
-  return pixbuf;
 }
-bool ThumbnailCache::saveToCache(GdkPixbuf *pixbuf,
-                                 const std::filesystem::path &cachePath) {
+bool ThumbnailCache::saveToStore(const std::string &key, GdkPixbuf *pixbuf,
+                                 const SourceStamp &source) {
   if (!pixbuf)
     return false;
-  GError *error = nullptr;
-  std::error_code ec;
-  std::filesystem::create_directories(cachePath.parent_path(), ec);
-  gboolean success =
-      gdk_pixbuf_save(pixbuf, cachePath.c_str(), "png", &error, nullptr);
-  if (error) {
-    LOG_WARN("Failed to save thumbnail: " + std::string(error->message));
-    g_error_free(error);
+  ThumbnailStore::Entry meta;
+  meta.format = m_codec;
+  meta.width = static_cast<uint32_t>(gdk_pixbuf_get_width(pixbuf));
+  meta.height = static_cast<uint32_t>(gdk_pixbuf_get_height(pixbuf));
+  meta.sourceMtime = source.mtime;
+  meta.sourceSize = source.size;
+  std::string encoded;
+  if (meta.format == ThumbnailStore::Format::Qoi) {
+    encoded = utils::qoi::encode(
+        gdk_pixbuf_get_pixels(pixbuf), gdk_pixbuf_get_width(pixbuf),
+        gdk_pixbuf_get_height(pixbuf), gdk_pixbuf_get_rowstride(pixbuf),
+        gdk_pixbuf_get_n_channels(pixbuf));
+  } else {
+    gchar *buffer = nullptr;
+    gsize size = 0;
+    GError *error = nullptr;
+    if (gdk_pixbuf_save_to_buffer(pixbuf, &buffer, &size, "png", &error,
+                                  nullptr)) {
+      encoded.assign(buffer, size);
+      g_free(buffer);
+    } else if (error) {
+      LOG_WARN("Failed to save thumbnail: " + std::string(error->message));
+      g_error_free(error);
+    }
+  }
+  if (encoded.empty())
     return false;
+  bool ok = m_store->put(key, meta,
+                         reinterpret_cast<const uint8_t *>(encoded.data()),
+                         encoded.size());
+  if (ok && m_store->wantsCompaction()) {
+    scheduleCompaction(0);
+  }
+  return ok;
+}
+void ThumbnailCache::scheduleCompaction(uint64_t budgetBytes) {
+  // Coalesces with a compaction that is already queued.
+  m_workers->submit(
+      "#compact", DecodePool::Priority::Low,
+      [this, budgetBytes]() {
+        m_store->compact(budgetBytes);
+        return std::shared_ptr<GdkPixbuf>();
+      },
+      nullptr);
+}
+void ThumbnailCache::removeLegacyFiles() {
+  // Older builds wrote one "<key>.png" per thumbnail next to the pack. Their
+  // keys came from std::hash and cannot be matched to sources any more.
+  size_t removed = 0;
+  std::error_code ec;
+  for (const auto &entry :
+       std::filesystem::directory_iterator(m_cacheDir, ec)) {
+    std::error_code removeError;
+    if (entry.path().extension() == ".png" &&
+        std::filesystem::remove(entry.path(), removeError)) {
+      removed++;
+    }
   }
-  return success == TRUE;
+  if (removed > 0) {
+    LOG_INFO("Removed " + std::to_string(removed) +
+             " thumbnails left by an older cache format");
+  }
+}
+void ThumbnailCache::Request::cancel() {
+  if (m_cancelled)
+    *m_cancelled = true;
+  m_ticket.cancel();
 }
-void ThumbnailCache::getAsync(const std::string &wallpaperPath, Size size,
-                              ThumbnailCallback callback) {
-  GdkPixbuf *cached = getSync(wallpaperPath, size);
-  if (cached) {
+ThumbnailCache::Request
+ThumbnailCache::getAsync(const std::string &wallpaperPath, Size size,
+                         ThumbnailCallback callback, Priority priority) {
+  const std::string key = memoryKey(wallpaperPath, size);
+  // Served without touching the disk: this runs on the main loop. The
+  // source is checked on a worker afterwards, and a thumbnail of what it
+  // has become is delivered to the same callback if it changed.
+  std::optional<SourceStamp> servedFrom;
+  if (auto cached = m_memory.get(key); cached && cached->pixbuf) {
     if (callback) {
-      callback(cached);
+      callback(cached->pixbuf.get());
     }
-    g_object_unref(cached);
-    return;
-  }
-  std::thread([this, wallpaperPath, size, callback]() {
-    GdkPixbuf *generated = generateSync(wallpaperPath, size);
-    struct CallbackData {
-      ThumbnailCallback callback;
-      GdkPixbuf *pixbuf;
+    servedFrom = cached->source;
+  }
+  Request request;
+  request.m_cancelled = std::make_shared<std::atomic<bool>>(false);
+  DecodePool::Done done;
+  if (callback) {
+    // One main-loop hop per finished request; the flag covers a cancel
+    // that lands after the worker already handed the result over.
+    done = [callback, cancelled = request.m_cancelled,
+            recheck = servedFrom.has_value()](
+               const std::shared_ptr<GdkPixbuf> &pixbuf) {
+      // An unchanged source needs no second delivery.
+      if (recheck && !pixbuf)
+        return;
+      struct CallbackData {
+        ThumbnailCallback callback;
+        std::shared_ptr<GdkPixbuf> pixbuf;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+      };
+      g_idle_add(
+          [](gpointer userData) -> gboolean {
+            auto *d = static_cast<CallbackData *>(userData);
+            if (!*d->cancelled) {
+              d->callback(d->pixbuf.get());
+            }
+            delete d;
+            return G_SOURCE_REMOVE;
+          },
+          new CallbackData{callback, pixbuf, cancelled});
     };
-    CallbackData *data = new CallbackData{callback, generated};
-    g_idle_add(
-        [](gpointer userData) -> gboolean {
-          CallbackData *d = static_cast<CallbackData *>(userData);
-          if (d->callback) {
-            d->callback(d->pixbuf);
-          }
-          if (d->pixbuf) {
-            g_object_unref(d->pixbuf);
-          }
-          delete d;
-          return G_SOURCE_REMOVE;
+  }
+  auto load = [this, wallpaperPath, size]() {
+    GdkPixbuf *pixbuf = getSync(wallpaperPath, size);
+    if (!pixbuf) {
+      pixbuf = generateSync(wallpaperPath, size);
+    }
+    return std::shared_ptr<GdkPixbuf>(pixbuf, [](GdkPixbuf *p) {
+      if (p) {
+        g_object_unref(p);
+      }
+    });
+  };
+  if (servedFrom) {
+    // Its own key: a request coalesced onto a recheck would get nothing
+    // back when the source is unchanged.
+    request.m_ticket = m_workers->submit(
+        key + "#recheck", DecodePool::Priority::Low,
+        [load, wallpaperPath, source = *servedFrom]() {
+          if (SourceStamp::of(wallpaperPath) == source)
+            return std::shared_ptr<GdkPixbuf>();
+          return load();
         },
-        data);
-  }).detach();
+        std::move(done));
+    return request;
+  }
+  request.m_ticket = m_workers->submit(
+      key,
+      priority == Priority::Visible ? DecodePool::Priority::High
+                                    : DecodePool::Priority::Low,
+      std::move(load), std::move(done));
+  return request;
+}
+ThumbnailCache::QueueStats ThumbnailCache::getQueueStats() const {
+  auto m = m_workers->metrics();
+  return {m.queued,    m.running,   m.completed, m.cancelled,
+          m.coalesced, m.avgWaitMs, m.avgRunMs,  m.maxRunMs};
 }
 void ThumbnailCache::invalidate(const std::string &wallpaperPath) {
-  {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    for (auto it = m_memoryCache.begin(); it != m_memoryCache.end();) {
-      if (it->first.find(generateCacheKey(wallpaperPath)) == 0) {
-        if (it->second.pixbuf) {
-          g_object_unref(it->second.pixbuf);
-        }
-        it = m_memoryCache.erase(it);
-      } else {
-        ++it;
-      }
-    }
-  }
   for (auto size : {Size::Small, Size::Medium, Size::Large}) {
-    auto cachePath = getCachePath(wallpaperPath, size);
-    std::error_code ec;
-    std::filesystem::remove(cachePath, ec);
+    const std::string key = memoryKey(wallpaperPath, size);
+    m_memory.erase(key);
+    m_store->erase(key);
   }
 }
 void ThumbnailCache::clearCache() {
-  {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    for (auto &[key, entry] : m_memoryCache) {
-      if (entry.pixbuf) {
-        g_object_unref(entry.pixbuf);
-      }
-    }
-    m_memoryCache.clear();
-  }
-  std::error_code ec;
-  for (const auto &entry :
-       std::filesystem::directory_iterator(m_cacheDir, ec)) {
-    std::filesystem::remove(entry.path(), ec);
-  }
+  m_memory.clear();
+  m_store->clear();
   LOG_INFO("Thumbnail cache cleared");
 }
 ThumbnailCache::CacheStats ThumbnailCache::getStats() const {
-  CacheStats stats{0, 0, 0};
-  std::error_code ec;
-  if (std::filesystem::exists(m_cacheDir)) {
-    for (const auto &entry :
-         std::filesystem::directory_iterator(m_cacheDir, ec)) {
-      if (entry.is_regular_file()) {
-        stats.cachedCount++;
-        stats.totalSizeBytes += entry.file_size();
-      }
-    }
-  }
-  {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    for (const auto &[key, entry] : m_memoryCache) {
-      if (entry.pixbuf) {
-        int width = gdk_pixbuf_get_width(entry.pixbuf);
-        int height = gdk_pixbuf_get_height(entry.pixbuf);
-        int channels = gdk_pixbuf_get_n_channels(entry.pixbuf);
-        stats.memoryUsageBytes += width * height * channels;
-      }
-    }
-  }
+  CacheStats stats{};
+  auto disk = m_store->stats();
+  stats.cachedCount = disk.entries;
+  stats.totalSizeBytes = disk.packBytes;
+  auto memory = m_memory.stats();
+  stats.memoryUsageBytes = memory.bytes;
+  stats.memoryBudgetBytes = memory.budgetBytes;
+  stats.memoryEntries = memory.entries;
+  stats.memoryHits = memory.hits;
+  stats.memoryMisses = memory.misses;
+  stats.memoryEvictions = memory.evictions;
   return stats;
 }
 void ThumbnailCache::setMaxCacheSize(size_t megabytes) {
@@ -311,40 +516,14 @@ void ThumbnailCache::setMaxCacheSize(size_t megabytes) {
   pruneCache();
 }
 void ThumbnailCache::pruneCache() {
-  size_t maxBytes = m_maxDiskCacheMB * 1024 * 1024;
-  struct CacheFile {
-    std::filesystem::path path;
-    size_t size;
-    std::filesystem::file_time_type lastWrite;
-  };
-  std::vector<CacheFile> files;
-  size_t totalSize = 0;
-  std::error_code ec;
-  for (const auto &entry :
-       std::filesystem::directory_iterator(m_cacheDir, ec)) {
-    if (entry.is_regular_file()) {
-      size_t fileSize = entry.file_size();
-      files.push_back({entry.path(), fileSize, entry.last_write_time()});
-      totalSize += fileSize;
-    }
+  // Dropping the oldest thumbnails and reclaiming dead records both mean
+  // rewriting the pack, which happens on a worker.
+  const uint64_t budget = static_cast<uint64_t>(m_maxDiskCacheMB) << 20;
+  if (m_store->stats().liveBytes > budget) {
+    scheduleCompaction(budget);
+  } else if (m_store->wantsCompaction()) {
+    scheduleCompaction(0);
   }
-  if (totalSize <= maxBytes) {
-    return;  
-  }
-  std::sort(files.begin(), files.end(), [](const auto &a, const auto &b) {
-    return a.lastWrite < b.lastWrite;
-  });
-  for (const auto &file : files) {
-    if (totalSize <= maxBytes)
-      break;
-    std::filesystem::remove(file.path, ec);
-    if (!ec) {
-      totalSize -= file.size;
-      LOG_DEBUG("Pruned cached thumbnail: " + file.path.string());
-    }
-  }
-  LOG_INFO("Thumbnail cache pruned to " +
-           std::to_string(totalSize / (1024 * 1024)) + " MB");
 }
 std::string ThumbnailCache::computeBlurhash(const std::string &wallpaperPath,
                                             Size size) {
@@ -378,25 +557,47 @@ std::string ThumbnailCache::computeBlurhash(const std::string &wallpaperPath,
   }
   return hash;
 }
+uint64_t ThumbnailCache::computePerceptualHash(const std::string &wallpaperPath,
+                                              Size size) {
+  GdkPixbuf *pixbuf = getSync(wallpaperPath, size);
+  if (!pixbuf) {
+    pixbuf = generateSync(wallpaperPath, size);
+  }
+  if (!pixbuf) {
+    return 0;
+  }
+  uint64_t hash = bwp::utils::phash::dhash(
+      gdk_pixbuf_get_pixels(pixbuf), gdk_pixbuf_get_width(pixbuf),
+      gdk_pixbuf_get_height(pixbuf), gdk_pixbuf_get_rowstride(pixbuf),
+      gdk_pixbuf_get_n_channels(pixbuf));
+  g_object_unref(pixbuf);
+  return hash;
+}
 #else
 ThumbnailCache::ThumbnailCache() {}
 ThumbnailCache::~ThumbnailCache() {}
+void ThumbnailCache::setMemoryBudget(size_t) {}
+void ThumbnailCache::setCodec(ThumbnailStore::Format) {}
 GdkPixbuf* ThumbnailCache::getSync(const std::string&, Size) { return nullptr; }
 GdkPixbuf* ThumbnailCache::generateSync(const std::string&, Size) { return nullptr; }
-void ThumbnailCache::getAsync(const std::string&, Size, ThumbnailCallback) {}
-bool ThumbnailCache::isCached(const std::string&, Size) const { return false; }
+void ThumbnailCache::Request::cancel() {}
+ThumbnailCache::Request ThumbnailCache::getAsync(const std::string&, Size, ThumbnailCallback, Priority) { return {}; }
+ThumbnailCache::QueueStats ThumbnailCache::getQueueStats() const { return {}; }
+bool ThumbnailCache::isCached(const std::string&, Size) { return false; }
 void ThumbnailCache::clearCache() {}
 void ThumbnailCache::setMaxCacheSize(size_t) {}
 ThumbnailCache::CacheStats ThumbnailCache::getStats() const { return {}; }
 void ThumbnailCache::invalidate(const std::string&) {}
 void ThumbnailCache::initCacheDir() {}
 void ThumbnailCache::pruneCache() {}
-std::string ThumbnailCache::generateCacheKey(const std::string& wallpaperPath) const { return ""; }
-std::filesystem::path ThumbnailCache::getCachePath(const std::string&, Size) const { return ""; }
+std::string ThumbnailCache::generateCacheKey(const std::string&) const { return ""; }
 GdkPixbuf* ThumbnailCache::generateFromImage(const std::string&, Size) { return nullptr; }
-GdkPixbuf* ThumbnailCache::generateFromVideo(const std::string&, Size) { return nullptr; }
-GdkPixbuf* ThumbnailCache::loadFromCache(const std::filesystem::path&) { return nullptr; }
-bool ThumbnailCache::saveToCache(GdkPixbuf*, const std::filesystem::path&) { return false; }
+GdkPixbuf* ThumbnailCache::generateFromVideo(const std::string&, Size, bool&) { return nullptr; }
+GdkPixbuf* ThumbnailCache::loadFromStore(const std::string&, const SourceStamp&) { return nullptr; }
+bool ThumbnailCache::saveToStore(const std::string&, GdkPixbuf*, const SourceStamp&) { return false; }
+void ThumbnailCache::scheduleCompaction(uint64_t) {}
+void ThumbnailCache::removeLegacyFiles() {}
 std::string ThumbnailCache::computeBlurhash(const std::string&, Size) { return ""; }
+uint64_t ThumbnailCache::computePerceptualHash(const std::string&, Size) { return 0; }
 #endif
 }  
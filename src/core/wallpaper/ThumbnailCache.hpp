@@ -7,9 +7,16 @@ typedef struct _GdkPixbuf GdkPixbuf;
 #else
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #endif
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include "../utils/CoalescingJobPool.hpp"
+#include "../utils/ShardedLruCache.hpp"
+#include "SharedThumbnailCache.hpp"
+#include "VideoFrameGrabber.hpp"
+#include "library/ThumbnailStore.hpp"
 namespace bwp::wallpaper {
 class ThumbnailCache {
 public:
@@ -21,42 +28,111 @@ public:
   };
   GdkPixbuf *getSync(const std::string &wallpaperPath, Size size);
   using ThumbnailCallback = std::function<void(GdkPixbuf *pixbuf)>;
-  void getAsync(const std::string &wallpaperPath, Size size,
-                ThumbnailCallback callback);
+  // Visible requests are served before prefetches; a visible request for
+  // a thumbnail that is already queued as a prefetch promotes it.
+  enum class Priority { Prefetch, Visible };
+  // Handle for an asynchronous request. cancel() (main thread) guarantees
+  // the callback will not run; a job nobody waits for any more is dropped
+  // if it has not started.
+  class Request {
+  public:
+    Request() = default;
+    void cancel();
+    explicit operator bool() const { return m_cancelled != nullptr; }
+
+  private:
+    friend class ThumbnailCache;
+    std::shared_ptr<std::atomic<bool>> m_cancelled;
+    utils::CoalescingJobPool<std::shared_ptr<GdkPixbuf>>::Ticket m_ticket;
+  };
+  // Memory hits call back synchronously without touching the disk; the
+  // returned Request then rechecks the source on the worker pool and calls
+  // back again only if it changed. Everything else (disk cache included)
+  // is loaded on the worker pool and delivered on the main loop.
+  Request getAsync(const std::string &wallpaperPath, Size size,
+                   ThumbnailCallback callback,
+                   Priority priority = Priority::Visible);
   GdkPixbuf *generateSync(const std::string &wallpaperPath, Size size);
-  bool isCached(const std::string &wallpaperPath, Size size) const;
+  // True if a thumbnail made from the file as it is now is on disk.
+  bool isCached(const std::string &wallpaperPath, Size size);
   void invalidate(const std::string &wallpaperPath);
   void clearCache();
   struct CacheStats {
     size_t cachedCount;
     size_t totalSizeBytes;
     size_t memoryUsageBytes;
+    size_t memoryBudgetBytes;
+    size_t memoryEntries;
+    uint64_t memoryHits;
+    uint64_t memoryMisses;
+    uint64_t memoryEvictions;
   };
   CacheStats getStats() const;
+  struct QueueStats {
+    size_t queued;       // requests waiting for a worker
+    size_t running;
+    uint64_t completed;
+    uint64_t cancelled;  // dropped before they started
+    uint64_t coalesced;  // joined an identical in-flight request
+    double avgWaitMs;
+    double avgDecodeMs;
+    double maxDecodeMs;
+  };
+  QueueStats getQueueStats() const;
   void setMaxCacheSize(size_t megabytes);
+  // In-memory budget; follows library.thumbnail_memory_mb by default.
+  void setMemoryBudget(size_t megabytes);
+  // Encoding for newly written thumbnails (library.thumbnail_codec);
+  // thumbnails already on disk stay readable in either format.
+  void setCodec(ThumbnailStore::Format format);
   void pruneCache();
   std::string computeBlurhash(const std::string &wallpaperPath, Size size);
+  // dHash of the thumbnail (see utils::phash); 0 if none could be made.
+  uint64_t computePerceptualHash(const std::string &wallpaperPath, Size size);
 private:
   ThumbnailCache();
   ~ThumbnailCache();
   ThumbnailCache(const ThumbnailCache &) = delete;
   ThumbnailCache &operator=(const ThumbnailCache &) = delete;
   std::string generateCacheKey(const std::string &wallpaperPath) const;
-  std::filesystem::path getCachePath(const std::string &wallpaperPath,
-                                     Size size) const;
   GdkPixbuf *generateFromImage(const std::string &path, Size size);
-  GdkPixbuf *generateFromVideo(const std::string &path, Size size);
-  GdkPixbuf *loadFromCache(const std::filesystem::path &cachePath);
-  bool saveToCache(GdkPixbuf *pixbuf, const std::filesystem::path &cachePath);
+  // `fromSource` is set when the frame came from `path` itself rather than
+  // a preview image next to it.
+  GdkPixbuf *generateFromVideo(const std::string &path, Size size,
+                               bool &fromSource);
+  using SourceStamp = ThumbnailStore::SourceStamp;
+  // Both skip thumbnails made before the source last changed; a stale
+  // memory entry is dropped on the way.
+  GdkPixbuf *loadFromStore(const std::string &key, const SourceStamp &source);
+  GdkPixbuf *getFromMemory(const std::string &key, const SourceStamp &source);
+  void remember(const std::string &key, GdkPixbuf *pixbuf,
+                const SourceStamp &source);
+  std::string memoryKey(const std::string &wallpaperPath, Size size) const;
+  bool saveToStore(const std::string &key, GdkPixbuf *pixbuf,
+                   const SourceStamp &source);
+  void scheduleCompaction(uint64_t budgetBytes);
+  void removeLegacyFiles();
   void initCacheDir();
   std::filesystem::path m_cacheDir;
-  struct CacheEntry {
-    GdkPixbuf *pixbuf;
-    std::chrono::steady_clock::time_point lastAccess;
+  std::unique_ptr<ThumbnailStore> m_store;
+  // Pixbufs are shared with callers by reference; the cache's reference is
+  // dropped when the entry is evicted.
+  struct MemoryEntry {
+    std::shared_ptr<GdkPixbuf> pixbuf;
+    SourceStamp source;
   };
-  mutable std::mutex m_mutex;
-  std::unordered_map<std::string, CacheEntry> m_memoryCache;
-  size_t m_maxMemoryCacheEntries = 100;  
+  utils::ShardedLruCache<MemoryEntry> m_memory{64u << 20};
+  int m_configListener = -1;
+  std::atomic<ThumbnailStore::Format> m_codec{ThumbnailStore::Format::Qoi};
+  // ~/.cache/thumbnails, read and written when library.thumbnail_shared_cache
+  // is on.
+  std::unique_ptr<SharedThumbnailCache> m_sharedCache;
+  std::atomic<bool> m_useSharedCache{true};
   size_t m_maxDiskCacheMB = 500;         
+  // For videos that ship no preview image.
+  std::unique_ptr<VideoFrameGrabber> m_frameGrabber;
+  // Declared last so its workers stop before the caches they fill go away.
+  using DecodePool = utils::CoalescingJobPool<std::shared_ptr<GdkPixbuf>>;
+  std::unique_ptr<DecodePool> m_workers;
 };
 }  
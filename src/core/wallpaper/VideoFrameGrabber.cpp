@@ -0,0 +1,307 @@
+#include "VideoFrameGrabber.hpp"
+#include "../utils/Logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <iterator>
+#ifndef _WIN32
+#include <mpv/client.h>
+#include <mpv/render.h>
+#endif
+namespace bwp::wallpaper {
+VideoFrameGrabber::FrameLook VideoFrameGrabber::look(const uint8_t *pixels,
+                                                    int width, int height,
+                                                    size_t stride) {
+  uint64_t sum = 0, squares = 0;
+  for (int y = 0; y < height; ++y) {
+    const uint8_t *p = pixels + y * stride;
+    for (int x = 0; x < width; ++x, p += 4) {
+      const uint32_t luma = (2 * p[0] + 5 * p[1] + p[2]) / 8;
+      sum += luma;
+      squares += luma * luma;
+    }
+  }
+  const double count = static_cast<double>(width) * height;
+  FrameLook result;
+  result.meanLuma = sum / count;
+  result.contrast = std::sqrt(
+      std::max(0.0, squares / count - result.meanLuma * result.meanLuma));
+  return result;
+}
+#ifndef _WIN32
+namespace {
+using Clock = std::chrono::steady_clock;
+// Per grab, covering load, seeks and rendering.
+constexpr auto kGrabTimeout = std::chrono::seconds(5);
+// Tried in order (percent of the duration) until a frame is not blank.
+constexpr const char *kPositions[] = {"10", "30", "50"};
+double secondsUntil(Clock::time_point deadline) {
+  return std::max(0.0, std::chrono::duration<double>(deadline - Clock::now())
+                           .count());
+}
+} // namespace
+struct VideoFrameGrabber::Instance {
+  mpv_handle *mpv = nullptr;
+  mpv_render_context *render = nullptr;
+  std::mutex mutex;
+  std::condition_variable frameCv;
+  bool frameReady = false;
+  // False after a timeout: events of the abandoned file may still be queued,
+  // so the instance is not reused.
+  bool healthy = true;
+  ~Instance() {
+    if (render)
+      mpv_render_context_free(render);
+    if (mpv)
+      mpv_terminate_destroy(mpv);
+  }
+  static std::unique_ptr<Instance> create() {
+    auto instance = std::make_unique<Instance>();
+    if (!instance->init())
+      return nullptr;
+    return instance;
+  }
+  bool init() {
+    mpv = mpv_create();
+    if (!mpv)
+      return false;
+    static const char *const options[][2] = {
+        {"terminal", "no"},
+        {"msg-level", "all=no"},
+        {"config", "no"},
+        {"load-scripts", "no"},
+        {"ytdl", "no"},
+        {"input-default-bindings", "no"},
+        {"vo", "libmpv"},
+        {"audio", "no"},
+        {"sid", "no"},
+        {"osd-level", "0"},
+        {"idle", "yes"},
+        {"pause", "yes"},
+        {"keep-open", "always"},
+        {"cache", "no"},
+        {"hwdec", "no"},
+        // Keyframe seeks: no decoding forward from the keyframe to an exact
+        // timestamp, which is most of the cost on long-GOP files.
+        {"hr-seek", "no"},
+        {"start", "10%"},
+        // Deblocking artefacts disappear at thumbnail size.
+        {"vd-lavc-skiploopfilter", "all"},
+    };
+    for (const auto &option : options)
+      mpv_set_option_string(mpv, option[0], option[1]);
+    int err = mpv_initialize(mpv);
+    if (err < 0) {
+      LOG_ERROR("Failed to initialize MPV frame grabber: " +
+                std::string(mpv_error_string(err)));
+      return false;
+    }
+    mpv_render_param params[] = {
+        {MPV_RENDER_PARAM_API_TYPE, const_cast<char *>(MPV_RENDER_API_TYPE_SW)},
+        {MPV_RENDER_PARAM_INVALID, nullptr}};
+    err = mpv_render_context_create(&render, mpv, params);
+    if (err < 0) {
+      LOG_ERROR("Failed to create MPV frame grabber render context: " +
+                std::string(mpv_error_string(err)));
+      render = nullptr;
+      return false;
+    }
+    // Runs on an mpv thread, which must not call back into mpv.
+    mpv_render_context_set_update_callback(
+        render,
+        [](void *data) {
+          auto *self = static_cast<Instance *>(data);
+          {
+            std::lock_guard<std::mutex> lock(self->mutex);
+            self->frameReady = true;
+          }
+          self->frameCv.notify_all();
+        },
+        this);
+    return true;
+  }
+  // Waits until the current file is showing a frame after a load or seek.
+  // Events from an earlier file always precede the START_FILE of the one
+  // just loaded, so those are skipped when `loading`.
+  bool waitForPlayback(bool loading, Clock::time_point deadline) {
+    bool started = !loading;
+    while (true) {
+      double timeout = secondsUntil(deadline);
+      mpv_event *event = mpv_wait_event(mpv, timeout);
+      switch (event->event_id) {
+      case MPV_EVENT_NONE:
+        if (timeout <= 0) {
+          healthy = false;
+          return false;
+        }
+        break;
+      case MPV_EVENT_SHUTDOWN:
+        healthy = false;
+        return false;
+      case MPV_EVENT_START_FILE:
+        started = true;
+        break;
+      case MPV_EVENT_END_FILE:
+        if (started)
+          return false;
+        break;
+      case MPV_EVENT_PLAYBACK_RESTART:
+        if (started)
+          return true;
+        break;
+      default:
+        break;
+      }
+    }
+  }
+  bool renderFrame(int width, int height, std::vector<uint8_t> &buffer,
+                   uint8_t *&pixels, size_t &stride,
+                   Clock::time_point deadline) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      if (!frameCv.wait_until(lock, deadline, [this] { return frameReady; })) {
+        healthy = false;
+        return false;
+      }
+      frameReady = false;
+    }
+    mpv_render_context_update(render);
+    // 64-byte aligned rows let the software renderer take its fast path.
+    stride = (static_cast<size_t>(width) * 4 + 63) & ~size_t(63);
+    buffer.resize(stride * height + 64);
+    auto address = reinterpret_cast<uintptr_t>(buffer.data());
+    pixels = buffer.data() + ((64 - address % 64) % 64);
+    int size[2] = {width, height};
+    mpv_render_param params[] = {
+        {MPV_RENDER_PARAM_SW_SIZE, size},
+        {MPV_RENDER_PARAM_SW_FORMAT, const_cast<char *>("rgb0")},
+        {MPV_RENDER_PARAM_SW_STRIDE, &stride},
+        {MPV_RENDER_PARAM_SW_POINTER, pixels},
+        {MPV_RENDER_PARAM_INVALID, nullptr}};
+    return mpv_render_context_render(render, params) >= 0;
+  }
+  std::optional<utils::DecodedImage> grab(const std::string &path,
+                                          int maxSize, uint64_t &extraSeeks) {
+    const auto deadline = Clock::now() + kGrabTimeout;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      frameReady = false;
+    }
+    const char *load[] = {"loadfile", path.c_str(), "replace", nullptr};
+    if (mpv_command(mpv, load) < 0 || !waitForPlayback(true, deadline))
+      return std::nullopt;
+    int64_t videoWidth = 0, videoHeight = 0;
+    // Display size: sample aspect ratio and rotation applied.
+    if (mpv_get_property(mpv, "dwidth", MPV_FORMAT_INT64, &videoWidth) < 0 ||
+        mpv_get_property(mpv, "dheight", MPV_FORMAT_INT64, &videoHeight) < 0 ||
+        videoWidth <= 0 || videoHeight <= 0)
+      return std::nullopt;
+    const auto [width, height] = utils::ThumbnailDecoder::fit(
+        static_cast<int>(videoWidth), static_cast<int>(videoHeight), maxSize);
+    std::vector<uint8_t> buffer, best;
+    uint8_t *pixels = nullptr;
+    uint8_t *bestPixels = nullptr;
+    size_t stride = 0;
+    double bestContrast = -1;
+    for (size_t i = 0; i < std::size(kPositions); ++i) {
+      if (i > 0) {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          frameReady = false;
+        }
+        const char *seek[] = {"seek", kPositions[i],
+                              "absolute-percent+keyframes", nullptr};
+        extraSeeks++;
+        if (mpv_command(mpv, seek) < 0 || !waitForPlayback(false, deadline))
+          break;
+      }
+      if (!renderFrame(width, height, buffer, pixels, stride, deadline))
+        break;
+      FrameLook frame = look(pixels, width, height, stride);
+      if (frame.contrast > bestContrast) {
+        bestContrast = frame.contrast;
+        best.swap(buffer);
+        bestPixels = pixels;
+      }
+      if (!frame.blank())
+        break;
+    }
+    if (!bestPixels)
+      return std::nullopt;
+    utils::DecodedImage image;
+    image.width = width;
+    image.height = height;
+    image.channels = 3;
+    image.pixels.resize(static_cast<size_t>(width) * height * 3);
+    uint8_t *out = image.pixels.data();
+    for (int y = 0; y < height; ++y) {
+      const uint8_t *p = bestPixels + y * stride;
+      for (int x = 0; x < width; ++x, p += 4, out += 3) {
+        out[0] = p[0];
+        out[1] = p[1];
+        out[2] = p[2];
+      }
+    }
+    return image;
+  }
+};
+VideoFrameGrabber::VideoFrameGrabber(size_t maxHandles)
+    : m_pool(maxHandles, &Instance::create) {}
+VideoFrameGrabber::~VideoFrameGrabber() = default;
+std::optional<utils::DecodedImage>
+VideoFrameGrabber::grab(const std::string &path, int maxSize) {
+  const auto start = Clock::now();
+  uint64_t extraSeeks = 0;
+  std::optional<utils::DecodedImage> frame;
+  auto instance = m_pool.acquire();
+  bool reusable = false;
+  if (instance) {
+    frame = instance->grab(path, maxSize, extraSeeks);
+    reusable = instance->healthy;
+    if (reusable) {
+      // Unload now so an idle instance does not hold decoder buffers.
+      const char *stop[] = {"stop", nullptr};
+      mpv_command(instance->mpv, stop);
+    } else {
+      LOG_WARN("Timed out grabbing a video frame from " + path);
+    }
+  }
+  m_pool.release(std::move(instance), reusable);
+  const double ms =
+      std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_grabs++;
+  if (!frame)
+    m_failures++;
+  m_extraSeeks += extraSeeks;
+  m_totalMs += ms;
+  return frame;
+}
+#else
+// No libmpv on Windows builds; every grab fails.
+struct VideoFrameGrabber::Instance {
+  static std::unique_ptr<Instance> create() { return nullptr; }
+};
+VideoFrameGrabber::VideoFrameGrabber(size_t maxHandles)
+    : m_pool(maxHandles, &Instance::create) {}
+VideoFrameGrabber::~VideoFrameGrabber() = default;
+std::optional<utils::DecodedImage> VideoFrameGrabber::grab(const std::string &,
+                                                           int) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_grabs++;
+  m_failures++;
+  return std::nullopt;
+}
+#endif
+VideoFrameGrabber::Stats VideoFrameGrabber::getStats() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Stats stats{};
+  stats.grabs = m_grabs;
+  stats.failures = m_failures;
+  stats.extraSeeks = m_extraSeeks;
+  stats.handles = m_pool.live();
+  stats.avgGrabMs = m_grabs ? m_totalMs / m_grabs : 0.0;
+  return stats;
+}
+} // namespace bwp::wallpaper
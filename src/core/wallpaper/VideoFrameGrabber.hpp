@@ -0,0 +1,55 @@
+#pragma once
+#include "../utils/InstancePool.hpp"
+#include "../utils/ThumbnailDecoder.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+namespace bwp::wallpaper {
+// Still frames from videos through libmpv's software render API: no window,
+// GL context or audio output, and the frame is scaled to thumbnail size as
+// it is rendered. Starting mpv costs more than a grab, so up to maxHandles
+// instances are kept and reused across jobs; callers beyond that wait for
+// one to come free. Thread-safe. libmpv needs LC_NUMERIC=C, which the
+// applications set once at startup.
+class VideoFrameGrabber {
+public:
+  explicit VideoFrameGrabber(size_t maxHandles = 2);
+  ~VideoFrameGrabber();
+  VideoFrameGrabber(const VideoFrameGrabber &) = delete;
+  VideoFrameGrabber &operator=(const VideoFrameGrabber &) = delete;
+  // The keyframe nearest 10% in, or a later one when that is (near) black,
+  // fitted in maxSize x maxSize. nullopt if mpv cannot show a frame of it.
+  std::optional<utils::DecodedImage> grab(const std::string &path,
+                                          int maxSize);
+  struct Stats {
+    uint64_t grabs;
+    uint64_t failures;
+    uint64_t extraSeeks;  // seeks past dark frames
+    size_t handles;       // mpv instances alive
+    double avgGrabMs;
+  };
+  Stats getStats() const;
+  // Luma statistics of an RGB0 frame. Fades, black intros and title cards
+  // on one colour are blank and make poor thumbnails.
+  struct FrameLook {
+    double meanLuma = 0;
+    double contrast = 0;  // standard deviation of luma
+    bool blank() const { return meanLuma < 24 || contrast < 6; }
+  };
+  static FrameLook look(const uint8_t *pixels, int width, int height,
+                        size_t stride);
+
+private:
+  struct Instance;
+  // Stops creating instances once libmpv has failed to start.
+  utils::InstancePool<Instance> m_pool;
+  mutable std::mutex m_mutex;
+  uint64_t m_grabs = 0;
+  uint64_t m_failures = 0;
+  uint64_t m_extraSeeks = 0;
+  double m_totalMs = 0;
+};
+} // namespace bwp::wallpaper
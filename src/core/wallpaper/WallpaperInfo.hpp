@@ -30,6 +30,13 @@ struct WallpaperInfo {
   uint64_t workshop_id = 0;
   uint64_t size_bytes = 0;
   std::string blurhash;
+  uint64_t phash = 0; // dHash of the small thumbnail; 0 = not computed
+  // Read from the file header at scan time; 0 / empty = unknown.
+  int width = 0;
+  int height = 0;
+  double duration = 0.0;   // seconds
+  double frame_rate = 0.0; // frames per second
+  std::string codec;       // "jpeg", "png", "h264", "vp9", ...
   struct Settings {
     int fps = -1; // -1 = use global default
     bool muted = false;
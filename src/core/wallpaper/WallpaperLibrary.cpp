@@ -3,16 +3,21 @@
 #include "../utils/FileUtils.hpp"
 #include "../utils/Logger.hpp"
 #include "../utils/StringUtils.hpp"
+#include "library/LibraryCodec.hpp"
+#include "library/PathValidator.hpp"
 #include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <iostream>
 #include <unordered_map>
-#include <unordered_set>
 namespace bwp::wallpaper {
 
 namespace {
 
+// Lower bound on journal length before a compaction is scheduled; above it
+// the threshold scales with library size (see appendJournal).
+constexpr size_t kMinCompactRecords = 512;
+
 WallpaperType detectTypeFromPath(const std::string &path) {
   std::string ext = utils::StringUtils::toLower(
       std::filesystem::path(path).extension().string());
@@ -29,17 +34,47 @@ WallpaperType detectTypeFromPath(const std::string &path) {
   return WallpaperType::Unknown;
 }
 
+bool isSteamSource(std::string_view source) {
+  return source == "workshop" || source == "steam";
+}
+
+// Of two entries sharing a path, keep the Steam one, then the shorter id.
+bool keepsOver(std::string_view id, std::string_view source,
+               std::string_view otherId, std::string_view otherSource) {
+  if (isSteamSource(source) != isSteamSource(otherSource))
+    return isSteamSource(source);
+  return id.length() < otherId.length();
+}
+
 } // namespace
 WallpaperLibrary &WallpaperLibrary::getInstance() {
   static WallpaperLibrary instance;
   return instance;
 }
-WallpaperLibrary::WallpaperLibrary() {
+WallpaperLibrary::WallpaperLibrary()
+    : m_dbPath(getDatabasePath()),
+      m_binPath(std::filesystem::path(m_dbPath).replace_extension(".bin")),
+      m_journal(std::filesystem::path(m_dbPath).replace_extension(".journal")) {
   LOG_SCOPE_AUTO();
-  m_dbPath = getDatabasePath();
+  m_snapshot.store(m_store.publish());
 }
 WallpaperLibrary::~WallpaperLibrary() {
-  if (m_dirty) {
+  if (m_hydrateThread.joinable()) {
+    m_hydrateThread.join();
+  }
+  m_stopValidation = true;
+  if (m_validateThread.joinable()) {
+    m_validateThread.join();
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_compactSignalMutex);
+    m_stopCompaction = true;
+  }
+  m_compactCv.notify_all();
+  if (m_compactThread.joinable()) {
+    m_compactThread.join();
+  }
+  if (m_dirty || m_journal.pendingRecords() > 0) {
     try {
       save();
     } catch (...) {
@@ -47,6 +82,7 @@ WallpaperLibrary::~WallpaperLibrary() {
       // singletons are already destroyed — silently ignore.
     }
   }
+  m_journal.close();
 }
 void WallpaperLibrary::initialize() {
   LOG_SCOPE_AUTO();
@@ -73,384 +109,921 @@ std::filesystem::path WallpaperLibrary::getDatabasePath() const {
 }
 void WallpaperLibrary::load() {
   LOG_SCOPE_AUTO();
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
-  if (!std::filesystem::exists(m_dbPath))
-    return;
-  try {
-    std::string content = utils::FileUtils::readFile(m_dbPath);
-    nlohmann::json j = nlohmann::json::parse(content);
-    if (!j.contains("wallpapers") || !j["wallpapers"].is_array()) {
-      LOG_WARN(
-          "Library JSON missing or invalid 'wallpapers' array - skipping load");
-      return;
+  std::unique_lock<std::recursive_mutex> lock(m_mutex);
+  m_store.clear();
+  m_pathToId.clear();
+  rebuildIndexLocked();
+  publishLocked();
+  std::shared_ptr<const BinaryLibraryFile> base;
+  // library.bin is only trusted if it was written together with the current
+  // library.json; an edited or older JSON is imported instead.
+  if (auto stamp = BinaryLibraryFile::stampOf(m_dbPath)) {
+    base = BinaryLibraryFile::open(m_binPath);
+    if (!base || base->stamp() != *stamp) {
+      LOG_INFO("Binary library snapshot missing or stale - importing " +
+               m_dbPath.string());
+      base.reset();
     }
-    m_wallpapers.clear();
-    for (const auto &item : j["wallpapers"]) {
-      WallpaperInfo info;
-      info.id = item.value("id", "");
-      info.path = item.value("path", "");
-      info.title = item.value("title", "");
-      if (info.title.empty() && !info.path.empty()) {
-        info.title = std::filesystem::path(info.path).stem().string();
-        m_dirty = true;
-      }
-      info.type = static_cast<WallpaperType>(item.value("type", 0));
-      if (info.type == WallpaperType::Unknown || info.type == WallpaperType::StaticImage) {
-        // Recompute when unknown or defaulted to StaticImage
-        info.type = detectTypeFromPath(info.path);
-      }
-      info.source = item.value("source", std::string(""));
-      info.rating = item.value("rating", 0);
-      info.favorite = item.value("favorite", false);
-      info.play_count = item.value("play_count", 0);
-      if (item.contains("added")) {
-        info.added = (long long)item["added"];
-      }
-      if (info.added == 0) {
-        info.added =
-            static_cast<long long>(std::chrono::system_clock::to_time_t(
-                std::chrono::system_clock::now()));
-        m_dirty = true;
-      }
-      if (item.contains("last_used")) {
-        info.last_used = (long long)item["last_used"];
+  }
+  m_base.store(base, std::memory_order_release);
+  if (base && m_journal.emptyOnDisk()) {
+    m_hydrated = false;
+    LOG_INFO("Mapped " + std::to_string(base->size()) +
+             " wallpapers from binary library snapshot");
+    lock.unlock();
+    m_hydrateThread = std::thread([this] { ensureHydrated(); });
+    return;
+  }
+  bool dirty = false;
+  auto wallpapers = readEntries(dirty);
+  installLocked(std::move(wallpapers), dirty);
+  bool needsSave = m_dirty;
+  lock.unlock();
+  if (needsSave) {
+    save();
+  }
+}
+void WallpaperLibrary::ensureHydrated() const {
+  if (m_hydrated.load(std::memory_order_acquire))
+    return;
+  // Decoding a large snapshot takes a while. m_mutex is only held to
+  // install the result; getWallpaper() keeps answering from m_base, and
+  // everything else that needs the entries waits here.
+  std::lock_guard<std::mutex> hydrating(m_hydrateMutex);
+  if (m_hydrated)
+    return;
+  auto *self = const_cast<WallpaperLibrary *>(this);
+  bool dirty = false;
+  auto wallpapers = self->readEntries(dirty);
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  self->installLocked(std::move(wallpapers), dirty);
+  if (m_dirty) {
+    self->requestCompaction();
+  }
+}
+std::unordered_map<std::string, WallpaperInfo>
+WallpaperLibrary::readEntries(bool &dirty) {
+  LOG_SCOPE_AUTO();
+  std::unordered_map<std::string, WallpaperInfo> wallpapers;
+  if (auto base = m_base.load(std::memory_order_acquire)) {
+    wallpapers.reserve(base->size());
+    base->forEach([&wallpapers](WallpaperInfo &&info) {
+      if (!info.id.empty()) {
+        std::string id = info.id;
+        wallpapers[std::move(id)] = std::move(info);
       }
-      if (item.contains("tags")) {
-        for (const auto &tag : item["tags"]) {
-          info.tags.push_back(tag);
+    });
+  } else if (std::filesystem::exists(m_dbPath)) {
+    try {
+      std::string content = utils::FileUtils::readFile(m_dbPath);
+      nlohmann::json j = nlohmann::json::parse(content);
+      if (!j.contains("wallpapers") || !j["wallpapers"].is_array()) {
+        LOG_WARN("Library JSON missing or invalid 'wallpapers' array - "
+                 "skipping snapshot");
+      } else {
+        for (const auto &item : j["wallpapers"]) {
+          WallpaperInfo info = LibraryCodec::fromJson(item);
+          if (!info.id.empty()) {
+            wallpapers[info.id] = std::move(info);
+          }
         }
+        // Compact after an import so the next start can map library.bin.
+        dirty = true;
       }
-      if (item.contains("settings")) {
-        const auto &s = item["settings"];
-        info.settings.fps = s.value("fps", -1);
-        info.settings.volume = s.value("volume", -1);
-        info.settings.muted = s.value("muted", false);
-        info.settings.playback_speed = s.value("playback_speed", 1.0f);
-        info.settings.scaling = static_cast<ScalingMode>(s.value("scaling", 0));
-        info.settings.noAudioProcessing = s.value("no_audio_processing", -1);
-        info.settings.disableMouse = s.value("disable_mouse", -1);
-        info.settings.noAutomute = s.value("no_automute", -1);
-      }
-      info.blurhash = item.value("blurhash", "");
-      if (!info.id.empty()) {
-        if (std::filesystem::exists(info.path)) {
-          m_wallpapers[info.id] = info;
+    } catch (const std::exception &e) {
+      LOG_ERROR(std::string("Failed to load library: ") + e.what());
+    }
+  }
+  // Mutations made after the last compaction live only in the journal.
+  size_t replayed =
+      m_journal.replay([&wallpapers](LibraryJournal::Record &&record) {
+        if (record.op == LibraryJournal::Op::Put) {
+          wallpapers[record.id] = std::move(record.info);
         } else {
-          LOG_WARN("Removed missing wallpaper from library: " + info.path);
-          m_dirty = true;
+          wallpapers.erase(record.id);
         }
-      }
+      });
+  if (replayed > 0) {
+    LOG_INFO("Replayed " + std::to_string(replayed) +
+             " library journal records");
+    dirty = true;
+  }
+  for (auto &pair : wallpapers) {
+    auto &info = pair.second;
+    if (info.title.empty() && !info.path.empty()) {
+      info.title = std::filesystem::path(info.path).stem().string();
+      dirty = true;
     }
-    LOG_INFO("Loaded " + std::to_string(m_wallpapers.size()) +
-             " wallpapers from library");
-    m_pathToId.clear();
-    std::vector<std::string> idsToRemove;
-    for (const auto &pair : m_wallpapers) {
-      const auto &info = pair.second;
-      std::string normPath = info.path;
-      try {
-        if (std::filesystem::exists(info.path)) {
-          normPath = std::filesystem::canonical(info.path).string();
-        }
-      } catch (...) {
+    if (info.type == WallpaperType::Unknown ||
+        info.type == WallpaperType::StaticImage) {
+      // Recompute when unknown or defaulted to StaticImage
+      info.type = detectTypeFromPath(info.path);
+    }
+    if (info.added == 0) {
+      info.added = static_cast<long long>(std::chrono::system_clock::to_time_t(
+          std::chrono::system_clock::now()));
+      dirty = true;
+    }
+  }
+  LOG_INFO("Loaded " + std::to_string(wallpapers.size()) +
+           " wallpapers from library");
+  return wallpapers;
+}
+void WallpaperLibrary::installLocked(
+    std::unordered_map<std::string, WallpaperInfo> wallpapers, bool dirty) {
+  LOG_SCOPE_AUTO();
+  m_dirty = m_dirty || dirty;
+  // Entries load optimistically: existence checks and canonical paths come
+  // from validateEntries() off-thread, so until then paths are indexed as
+  // stored.
+  m_pathToId.clear();
+  std::vector<std::string> idsToRemove;
+  for (const auto &pair : wallpapers) {
+    const auto &info = pair.second;
+    const std::string &normPath = info.path;
+    if (m_pathToId.count(normPath)) {
+      std::string existingId = m_pathToId[normPath];
+      const auto &existing = wallpapers[existingId];
+      if (keepsOver(info.id, info.source, existing.id, existing.source)) {
+        idsToRemove.push_back(existingId);
+        m_pathToId[normPath] = info.id;
+      } else {
+        idsToRemove.push_back(info.id);
       }
-      if (m_pathToId.count(normPath)) {
-        std::string existingId = m_pathToId[normPath];
-        const auto &existing = m_wallpapers[existingId];
-        bool keepCurrent = false;
-        if ((info.source == "workshop" || info.source == "steam") &&
-            (existing.source != "workshop" && existing.source != "steam")) {
-          keepCurrent = true;
-        } else if ((existing.source == "workshop" ||
-                    existing.source == "steam") &&
-                   (info.source != "workshop" && info.source != "steam")) {
-          keepCurrent = false;
-        } else {
-          if (info.id.length() < existing.id.length())
-            keepCurrent = true;
-        }
-        if (keepCurrent) {
-          idsToRemove.push_back(existingId);
-          m_pathToId[normPath] = info.id;
-        } else {
-          idsToRemove.push_back(info.id);
-        }
+    } else {
+      m_pathToId[normPath] = info.id;
+    }
+  }
+  if (!idsToRemove.empty()) {
+    LOG_INFO("Removing " + std::to_string(idsToRemove.size()) +
+             " duplicate wallpapers.");
+    for (const auto &id : idsToRemove) {
+      wallpapers.erase(id);
+    }
+    m_dirty = true;
+  }
+  m_store.clear();
+  m_store.reserve(wallpapers.size());
+  for (auto &pair : wallpapers) {
+    m_store.put(pair.second);
+  }
+  rebuildIndexLocked();
+  publishLocked();
+  // Readers that saw m_hydrated false may still be using the mapping; they
+  // hold their own reference.
+  m_hydrated.store(true, std::memory_order_release);
+  m_base.store(nullptr, std::memory_order_release);
+  if (!m_validateThread.joinable() && m_store.size() > 0) {
+    m_validateThread = std::thread(&WallpaperLibrary::validateEntries, this,
+                                   m_snapshot.load());
+  }
+}
+void WallpaperLibrary::validateEntries(
+    std::shared_ptr<const LibrarySnapshot> snap) {
+  LOG_SCOPE_AUTO();
+  auto start = std::chrono::steady_clock::now();
+  std::vector<PathCheck> checks;
+  checks.reserve(snap->size());
+  snap->forEach([&checks](WallpaperView view) {
+    PathCheck check;
+    check.id = std::string(view.id());
+    check.path = view.path();
+    checks.push_back(std::move(check));
+  });
+  snap.reset();
+  if (!PathValidator::run(checks, 0, &m_stopValidation))
+    return;
+  LibraryChangeSet changes;
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    std::string records;
+    auto drop = [&](const std::string &id) {
+      m_store.erase(id);
+      unindexLocked(id);
+      records += LibraryJournal::encodeRemove(id);
+      changes.removed.push_back(id);
+    };
+    std::unordered_map<std::string, std::string> canonicalById;
+    canonicalById.reserve(checks.size());
+    for (auto &check : checks) {
+      // Entries updated or removed while validating are left alone.
+      WallpaperView view = m_store.find(check.id);
+      if (!view || view.path() != check.path)
+        continue;
+      if (check.state == PathCheck::State::Missing) {
+        LOG_WARN("Removed missing wallpaper from library: " + check.path);
+        drop(check.id);
       } else {
-        m_pathToId[normPath] = info.id;
+        canonicalById.emplace(check.id, std::move(check.canonical));
       }
     }
-    if (!idsToRemove.empty()) {
-      LOG_INFO("Removing " + std::to_string(idsToRemove.size()) +
-               " duplicate wallpapers.");
-      for (const auto &id : idsToRemove) {
-        m_wallpapers.erase(id);
+    // Re-key the path index on canonical paths, which also surfaces
+    // duplicates that differ only by symlinks or relative components.
+    std::unordered_map<std::string, std::string> pathToId;
+    pathToId.reserve(m_store.size());
+    std::vector<std::string> duplicates;
+    m_store.forEach([&](WallpaperView view) {
+      std::string id(view.id());
+      auto known = canonicalById.find(id);
+      std::string key = known != canonicalById.end()
+                            ? known->second
+                            : normalizePath(view.path());
+      auto [it, inserted] = pathToId.try_emplace(std::move(key), id);
+      if (inserted)
+        return;
+      WallpaperView existing = m_store.find(it->second);
+      if (keepsOver(id, view.source(), existing.id(), existing.source())) {
+        duplicates.push_back(it->second);
+        it->second = id;
+      } else {
+        duplicates.push_back(id);
       }
-      m_dirty = true;
+    });
+    if (!duplicates.empty()) {
+      LOG_INFO("Removing " + std::to_string(duplicates.size()) +
+               " duplicate wallpapers.");
+    }
+    for (const auto &id : duplicates)
+      drop(id);
+    m_pathToId = std::move(pathToId);
+    if (!changes.removed.empty()) {
+      appendJournal(records, changes.removed.size());
+      publishLocked();
     }
-  } catch (const std::exception &e) {
-    LOG_ERROR(std::string("Failed to load library: ") + e.what());
-  }
-  if (m_dirty) {
-    save();
   }
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+  LOG_INFO("Validated " + std::to_string(checks.size()) +
+           " wallpaper paths in " + std::to_string(ms) + " ms");
+  dispatchChangeSet(changes);
+}
+void WallpaperLibrary::publishLocked() {
+  m_snapshot.store(m_store.publish(), std::memory_order_release);
+}
+std::shared_ptr<const LibrarySnapshot> WallpaperLibrary::snapshot() const {
+  ensureHydrated();
+  return m_snapshot.load(std::memory_order_acquire);
 }
 void WallpaperLibrary::save() {
   LOG_SCOPE_AUTO();
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  compact();
+}
+bool WallpaperLibrary::compact() {
+  // Serialize compactions; the library mutex is only held while copying the
+  // entries and rotating the journal, never while serializing or writing.
+  ensureHydrated();
+  std::lock_guard<std::mutex> compactLock(m_compactMutex);
+  std::shared_ptr<const LibrarySnapshot> snap;
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    if (!m_journal.rotate()) {
+      return false;
+    }
+    // Uncommitted bulk changes are not in the published snapshot, but their
+    // journal records are only written on commit, after this rotation.
+    snap = m_snapshot.load(std::memory_order_acquire);
+    m_dirty = false;
+  }
   try {
+    std::vector<WallpaperView> entries;
+    entries.reserve(snap->size());
+    snap->forEach([&entries](WallpaperView view) { entries.push_back(view); });
     nlohmann::json j;
     j["wallpapers"] = nlohmann::json::array();
-    for (const auto &pair : m_wallpapers) {
-      const auto &info = pair.second;
-      nlohmann::json item;
-      item["id"] = info.id;
-      item["path"] = info.path;
-      item["title"] = info.title;
-      item["type"] = static_cast<int>(info.type);
-      item["rating"] = info.rating;
-      item["favorite"] = info.favorite;
-      item["play_count"] = info.play_count;
-      item["added"] = info.added;
-      item["last_used"] = info.last_used;
-      item["tags"] = info.tags;
-      item["source"] = info.source;
-      nlohmann::json settings;
-      settings["fps"] = info.settings.fps;
-      settings["volume"] = info.settings.volume;
-      settings["muted"] = info.settings.muted;
-      settings["playback_speed"] = info.settings.playback_speed;
-      settings["scaling"] = static_cast<int>(info.settings.scaling);
-      settings["no_audio_processing"] = info.settings.noAudioProcessing;
-      settings["disable_mouse"] = info.settings.disableMouse;
-      settings["no_automute"] = info.settings.noAutomute;
-      item["settings"] = settings;
-      if (!info.blurhash.empty()) {
-        item["blurhash"] = info.blurhash;
-      }
-      j["wallpapers"].push_back(item);
+    for (const auto &view : entries) {
+      j["wallpapers"].push_back(LibraryCodec::toJson(view.toInfo()));
     }
-    utils::FileUtils::createDirectories(m_dbPath.parent_path());
-    utils::FileUtils::writeFile(m_dbPath, j.dump(4));
-    m_dirty = false;
+    if (!utils::FileUtils::writeFileAtomic(m_dbPath, j.dump(4))) {
+      LOG_ERROR("Failed to write library snapshot: " + m_dbPath.string());
+      std::lock_guard<std::recursive_mutex> lock(m_mutex);
+      m_dirty = true;
+      return false;
+    }
+    auto stamp = BinaryLibraryFile::stampOf(m_dbPath);
+    if (!stamp || !BinaryLibraryFile::write(m_binPath, entries, *stamp)) {
+      // library.json is authoritative; the next load simply imports it.
+      LOG_WARN("Binary library snapshot not updated");
+    }
+    // The rotated journal is now folded into the snapshot.
+    m_journal.discardRotated();
     LOG_INFO("Saved library database");
+    return true;
   } catch (const std::exception &e) {
     LOG_ERROR(std::string("Failed to save library: ") + e.what());
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    m_dirty = true;
+    return false;
+  }
+}
+void WallpaperLibrary::appendJournal(const std::string &lines,
+                                     size_t recordCount) {
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  if (!m_journal.append(lines, recordCount)) {
+    // Without a journal the only way to persist is a full snapshot.
+    m_dirty = true;
+    requestCompaction();
+    return;
+  }
+  // Compact once the journal outgrows a fraction of the library so the
+  // amortized snapshot cost per mutation stays constant.
+  size_t threshold =
+      std::max<size_t>(kMinCompactRecords, m_store.size() / 2);
+  if (m_journal.pendingRecords() >= threshold) {
+    requestCompaction();
+  }
+}
+void WallpaperLibrary::requestCompaction() {
+  std::lock_guard<std::mutex> lock(m_compactSignalMutex);
+  if (m_stopCompaction)
+    return;
+  m_compactRequested = true;
+  if (!m_compactThread.joinable()) {
+    m_compactThread = std::thread(&WallpaperLibrary::compactionLoop, this);
+  }
+  m_compactCv.notify_one();
+}
+void WallpaperLibrary::compactionLoop() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_compactSignalMutex);
+      m_compactCv.wait(lock,
+                       [this] { return m_compactRequested || m_stopCompaction; });
+      if (m_stopCompaction)
+        return;
+      m_compactRequested = false;
+    }
+    compact();
+  }
+}
+std::string WallpaperLibrary::normalizePath(const std::string &path) {
+  try {
+    if (std::filesystem::exists(path))
+      return std::filesystem::canonical(path).string();
+  } catch (...) {
+  }
+  return path;
+}
+WallpaperLibrary::AddResult
+WallpaperLibrary::addWallpaperLocked(const WallpaperInfo &info,
+                                     const std::string &normPath) {
+  auto pathIt = m_pathToId.find(normPath);
+  if (pathIt != m_pathToId.end()) {
+    const std::string existingId = pathIt->second;
+    if (existingId != info.id) {
+      LOG_INFO("Ignoring duplicate wallpaper import: " + info.path +
+               " (Existing ID: " + existingId + ")");
+      return AddResult::Ignored;
+    }
+    WallpaperView stored = m_store.find(existingId);
+    if (!stored)
+      return AddResult::Ignored;
+    const WallpaperInfo before = stored.toInfo();
+    WallpaperInfo existing = before;
+    if (!info.title.empty())
+      existing.title = info.title;
+    if (info.type != WallpaperType::Unknown)
+      existing.type = info.type;
+    else
+      existing.type = detectTypeFromPath(existing.path);
+    if (!info.source.empty())
+      existing.source = info.source;
+    if (!info.tags.empty())
+      existing.tags = info.tags;
+    // Header probes fill in media details for items scanned before them.
+    if (info.width > 0 || !info.codec.empty()) {
+      existing.width = info.width;
+      existing.height = info.height;
+      existing.duration = info.duration;
+      existing.frame_rate = info.frame_rate;
+      existing.codec = info.codec;
+    }
+    if (info.size_bytes != 0 && info.size_bytes != existing.size_bytes) {
+      // Rewritten in place; hashes of the old contents no longer apply.
+      if (existing.size_bytes != 0) {
+        existing.blurhash.clear();
+        existing.phash = 0;
+      }
+      existing.size_bytes = info.size_bytes;
+    }
+    // Rescans re-submit every known item; only journal real changes.
+    if (existing.title == before.title && existing.type == before.type &&
+        existing.source == before.source && existing.tags == before.tags &&
+        existing.size_bytes == before.size_bytes &&
+        existing.width == before.width && existing.height == before.height &&
+        existing.duration == before.duration &&
+        existing.frame_rate == before.frame_rate &&
+        existing.codec == before.codec) {
+      return AddResult::Unchanged;
+    }
+    journalLocked(LibraryJournal::encodePut(existing));
+    indexLocked(existing);
+    m_store.put(existing);
+    return AddResult::Merged;
+  }
+  WallpaperInfo newInfo = info;
+  if (newInfo.type == WallpaperType::Unknown)
+    newInfo.type = detectTypeFromPath(newInfo.path);
+  if (newInfo.added == 0) {
+    newInfo.added = static_cast<long long>(std::chrono::system_clock::to_time_t(
+        std::chrono::system_clock::now()));
   }
+  if (newInfo.title.empty()) {
+    newInfo.title = std::filesystem::path(newInfo.path).stem().string();
+  }
+  m_pathToId[normPath] = newInfo.id;
+  journalLocked(LibraryJournal::encodePut(newInfo));
+  indexLocked(newInfo);
+  m_store.put(newInfo);
+  return AddResult::Added;
 }
 void WallpaperLibrary::addWallpaper(const WallpaperInfo &info) {
   LOG_SCOPE_AUTO();
+  ensureHydrated();
+  std::string normPath = normalizePath(info.path);
+  ChangeCallback cb;
+  LibraryChangeSet changes;
   {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    std::string normPath = info.path;
-    try {
-      if (std::filesystem::exists(info.path))
-        normPath = std::filesystem::canonical(info.path).string();
-    } catch (...) {
+    AddResult result = addWallpaperLocked(info, normPath);
+    if (BulkState *bulk = currentBulkLocked()) {
+      if (result == AddResult::Added)
+        bulk->changes.added(info.id);
+      else if (result == AddResult::Merged)
+        bulk->changes.updated(info.id);
+      return;
     }
-    if (m_pathToId.count(normPath)) {
-      std::string existingId = m_pathToId[normPath];
-      if (existingId != info.id) {
-        LOG_INFO("Ignoring duplicate wallpaper import: " + info.path +
-                 " (Existing ID: " + existingId + ")");
-        return;
-      }
-      auto &existing = m_wallpapers[existingId];
-      if (!info.title.empty())
-        existing.title = info.title;
-      if (info.type != WallpaperType::Unknown)
-        existing.type = info.type;
-      else
-        existing.type = detectTypeFromPath(existing.path);
-      if (!info.source.empty())
-        existing.source = info.source;
-      if (!info.tags.empty())
-        existing.tags = info.tags;
-      m_dirty = true;
+    if (result == AddResult::Merged) {
+      publishLocked();
+      changes.updated.push_back(info.id);
+    } else if (result == AddResult::Added) {
+      publishLocked();
+      changes.added.push_back(info.id);
+      // Copy callback under lock to avoid holding mutex during invocation
+      cb = m_changeCallback;
+    } else {
       return;
     }
-    WallpaperInfo newInfo = info;
-    if (newInfo.type == WallpaperType::Unknown)
-      newInfo.type = detectTypeFromPath(newInfo.path);
-    if (newInfo.added == 0) {
-      newInfo.added =
-          static_cast<long long>(std::chrono::system_clock::to_time_t(
-              std::chrono::system_clock::now()));
+  }
+  if (cb) {
+    cb(info);
+  }
+  dispatchChangeSet(changes);
+}
+size_t WallpaperLibrary::addWallpapers(const std::vector<WallpaperInfo> &batch) {
+  LOG_SCOPE_AUTO();
+  ensureHydrated();
+  if (batch.empty())
+    return 0;
+  // Path canonicalization hits the filesystem; do it before taking the lock.
+  std::vector<std::string> normPaths;
+  normPaths.reserve(batch.size());
+  for (const auto &info : batch) {
+    normPaths.push_back(normalizePath(info.path));
+  }
+  size_t added = 0;
+  beginBulk();
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    BulkState *bulk = currentBulkLocked();
+    for (size_t i = 0; i < batch.size(); ++i) {
+      if (batch[i].id.empty())
+        continue;
+      AddResult result = addWallpaperLocked(batch[i], normPaths[i]);
+      if (result == AddResult::Added) {
+        bulk->changes.added(batch[i].id);
+        added++;
+      } else if (result == AddResult::Merged) {
+        bulk->changes.updated(batch[i].id);
+      }
+    }
+  }
+  commit();
+  return added;
+}
+void WallpaperLibrary::beginBulk() {
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  m_bulk[std::this_thread::get_id()].depth++;
+}
+void WallpaperLibrary::commit() {
+  LibraryChangeSet changes;
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    auto it = m_bulk.find(std::this_thread::get_id());
+    if (it == m_bulk.end()) {
+      LOG_WARN("WallpaperLibrary::commit() without matching beginBulk()");
+      return;
     }
-    if (newInfo.title.empty()) {
-      newInfo.title = std::filesystem::path(newInfo.path).stem().string();
+    if (--it->second.depth > 0)
+      return;
+    BulkState state = std::move(it->second);
+    m_bulk.erase(it);
+    appendJournal(state.journal, state.records);
+    publishLocked();
+    changes = state.changes.take();
+  }
+  if (!changes.empty()) {
+    LOG_DEBUG("Library bulk commit: " + std::to_string(changes.added.size()) +
+              " added, " + std::to_string(changes.updated.size()) +
+              " updated, " + std::to_string(changes.removed.size()) +
+              " removed");
+    dispatchChangeSet(changes);
+  }
+}
+WallpaperLibrary::BulkState *WallpaperLibrary::currentBulkLocked() {
+  if (m_bulk.empty())
+    return nullptr;
+  auto it = m_bulk.find(std::this_thread::get_id());
+  return it == m_bulk.end() ? nullptr : &it->second;
+}
+void WallpaperLibrary::journalLocked(std::string record) {
+  if (BulkState *bulk = currentBulkLocked()) {
+    bulk->journal += record;
+    bulk->records++;
+    return;
+  }
+  appendJournal(record, 1);
+}
+void WallpaperLibrary::indexLocked(const WallpaperInfo &info) {
+  std::unique_lock<std::shared_mutex> indexLock(m_indexMutex);
+  writeIndexEntry(info);
+}
+void WallpaperLibrary::writeIndexEntry(const WallpaperInfo &info) {
+  uint32_t slot;
+  auto it = m_slots.find(info.id);
+  if (it != m_slots.end()) {
+    slot = it->second;
+  } else {
+    if (!m_freeSlots.empty()) {
+      slot = m_freeSlots.back();
+      m_freeSlots.pop_back();
+      m_slotIds[slot] = info.id;
+    } else {
+      slot = static_cast<uint32_t>(m_slotIds.size());
+      m_slotIds.push_back(info.id);
     }
-    m_wallpapers[newInfo.id] = newInfo;
-    m_pathToId[normPath] = newInfo.id;
-    m_dirty = true;
+    m_slots.emplace(info.id, slot);
   }
-  save();
-  // Copy callback outside lock to avoid holding mutex during invocation
-  ChangeCallback cb;
+  std::string filename = std::filesystem::path(info.path).filename().string();
+  std::vector<std::string_view> fields{info.title, filename};
+  fields.insert(fields.end(), info.tags.begin(), info.tags.end());
+  m_searchIndex.set(slot, fields);
+  m_tagIndex.set(slot, info.tags);
+  m_attrIndex.set(slot, AttributeIndex::Attributes::of(info));
+  m_phashIndex.set(slot, info.phash);
+}
+void WallpaperLibrary::unindexLocked(const std::string &id) {
+  std::unique_lock<std::shared_mutex> indexLock(m_indexMutex);
+  auto it = m_slots.find(id);
+  if (it == m_slots.end())
+    return;
+  uint32_t slot = it->second;
+  m_slots.erase(it);
+  m_searchIndex.remove(slot);
+  m_tagIndex.remove(slot);
+  m_attrIndex.remove(slot);
+  m_phashIndex.remove(slot);
+  m_slotIds[slot].clear();
+  m_freeSlots.push_back(slot);
+}
+void WallpaperLibrary::rebuildIndexLocked() {
+  std::unique_lock<std::shared_mutex> indexLock(m_indexMutex);
+  m_slots.clear();
+  m_slotIds.clear();
+  m_freeSlots.clear();
+  m_searchIndex.clear();
+  m_tagIndex.clear();
+  m_attrIndex.clear();
+  m_phashIndex.clear();
+  m_slots.reserve(m_store.size());
+  m_slotIds.reserve(m_store.size());
+  m_store.forEach(
+      [this](WallpaperView view) { writeIndexEntry(view.toInfo()); });
+}
+void WallpaperLibrary::dispatchChangeSet(const LibraryChangeSet &changes) {
+  if (changes.empty())
+    return;
+  std::vector<ChangeSetCallback> cbs;
   {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    cb = m_changeCallback;
+    for (const auto &[id, cb] : m_changeSetCallbacks) {
+      cbs.push_back(cb);
+    }
   }
-  if (cb) {
-    cb(info);
+  for (const auto &cb : cbs) {
+    if (cb) {
+      cb(changes);
+    }
   }
 }
 void WallpaperLibrary::updateWallpaper(const WallpaperInfo &info) {
   LOG_SCOPE_AUTO();
-  bool needsSave = false;
+  ensureHydrated();
   ChangeCallback cb;
   std::vector<ChangeCallback> cbs;
   std::vector<ChangeCallback> idCbs;
   {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    if (m_wallpapers.count(info.id)) {
-      WallpaperInfo stored = info;
-      stored.type = WallpaperType::WEVideo;
-      m_wallpapers[info.id] = stored;
-      m_dirty = true;
-      needsSave = true;
-      cb = m_changeCallback;
-      cbs = m_changeCallbacks;
-      for (const auto &[id, icb] : m_idCallbacks) {
-        idCbs.push_back(icb);
-      }
+    if (!m_store.contains(info.id))
+      return;
+    WallpaperInfo stored = info;
+    stored.type = WallpaperType::WEVideo;
+    journalLocked(LibraryJournal::encodePut(stored));
+    indexLocked(stored);
+    m_store.put(stored);
+    if (BulkState *bulk = currentBulkLocked()) {
+      bulk->changes.updated(info.id);
+      return;
     }
-  }
-  if (needsSave) {
-    save();
-    if (cb) {
-      cb(info);
+    publishLocked();
+    cb = m_changeCallback;
+    cbs = m_changeCallbacks;
+    for (const auto &[id, icb] : m_idCallbacks) {
+      idCbs.push_back(icb);
     }
-    for (const auto &callback : cbs) {
-      if (callback) {
-        callback(info);
-      }
+  }
+  if (cb) {
+    cb(info);
+  }
+  for (const auto &callback : cbs) {
+    if (callback) {
+      callback(info);
     }
-    for (const auto &callback : idCbs) {
-      if (callback) {
-        callback(info);
-      }
+  }
+  for (const auto &callback : idCbs) {
+    if (callback) {
+      callback(info);
     }
   }
+  LibraryChangeSet changes;
+  changes.updated.push_back(info.id);
+  dispatchChangeSet(changes);
 }
 void WallpaperLibrary::updateBlurhash(const std::string &id,
                                       const std::string &hash) {
   LOG_SCOPE_AUTO();
-  bool needsSave = false;
-  {
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    auto it = m_wallpapers.find(id);
-    if (it != m_wallpapers.end()) {
-      it->second.blurhash = hash;
-      m_dirty = true;
-      needsSave = true;
-    }
+  ensureHydrated();
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  WallpaperView stored = m_store.find(id);
+  if (stored && stored.blurhash() != hash) {
+    WallpaperInfo updated = stored.toInfo();
+    updated.blurhash = hash;
+    journalLocked(LibraryJournal::encodePut(updated));
+    m_store.put(updated);
+    if (!currentBulkLocked())
+      publishLocked();
   }
-  if (needsSave) {
-    save();
+}
+void WallpaperLibrary::updatePerceptualHash(const std::string &id,
+                                            uint64_t hash) {
+  ensureHydrated();
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  WallpaperView stored = m_store.find(id);
+  if (stored && stored.phash() != hash) {
+    WallpaperInfo updated = stored.toInfo();
+    updated.phash = hash;
+    journalLocked(LibraryJournal::encodePut(updated));
+    indexLocked(updated);
+    m_store.put(updated);
+    if (!currentBulkLocked())
+      publishLocked();
   }
 }
 void WallpaperLibrary::removeWallpaper(const std::string &id) {
   LOG_SCOPE_AUTO();
-  bool needsSave = false;
+  ensureHydrated();
   {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    if (m_wallpapers.count(id)) {
-      std::string path = m_wallpapers[id].path;
-      m_wallpapers.erase(id);
-      try {
-        if (std::filesystem::exists(path)) {
-          std::string norm = std::filesystem::canonical(path).string();
-          if (m_pathToId.count(norm) && m_pathToId[norm] == id) {
-            m_pathToId.erase(norm);
-          }
-        } else {
-          for (auto it = m_pathToId.begin(); it != m_pathToId.end();) {
-            if (it->second == id)
-              it = m_pathToId.erase(it);
-            else
-              ++it;
-          }
+    WallpaperView stored = m_store.find(id);
+    if (!stored)
+      return;
+    std::string path = stored.path();
+    m_store.erase(id);
+    unindexLocked(id);
+    try {
+      if (std::filesystem::exists(path)) {
+        std::string norm = std::filesystem::canonical(path).string();
+        if (m_pathToId.count(norm) && m_pathToId[norm] == id) {
+          m_pathToId.erase(norm);
+        }
+      } else {
+        for (auto it = m_pathToId.begin(); it != m_pathToId.end();) {
+          if (it->second == id)
+            it = m_pathToId.erase(it);
+          else
+            ++it;
         }
-      } catch (...) {
       }
-      m_dirty = true;
-      needsSave = true;
+    } catch (...) {
     }
+    journalLocked(LibraryJournal::encodeRemove(id));
+    if (BulkState *bulk = currentBulkLocked()) {
+      bulk->changes.removed(id);
+      return;
+    }
+    publishLocked();
   }
-  if (needsSave) {
-    save();
-  }
+  LibraryChangeSet changes;
+  changes.removed.push_back(id);
+  dispatchChangeSet(changes);
 }
 void WallpaperLibrary::removeDuplicates() {
+  ensureHydrated();
   std::lock_guard<std::recursive_mutex> lock(m_mutex);
   std::unordered_map<std::string, std::string> pathToId; // path -> first id
   std::vector<std::string> toRemove;
-  for (const auto &[id, info] : m_wallpapers) {
-    auto [it, inserted] = pathToId.emplace(info.path, id);
+  m_store.forEach([&](WallpaperView view) {
+    auto [it, inserted] = pathToId.emplace(view.path(), view.id());
     if (!inserted) {
-      toRemove.push_back(id); // duplicate path, remove this entry
+      toRemove.emplace_back(view.id()); // duplicate path, remove this entry
     }
-  }
+  });
+  std::string records;
   for (const auto &id : toRemove) {
-    m_wallpapers.erase(id);
+    m_store.erase(id);
+    unindexLocked(id);
+    records += LibraryJournal::encodeRemove(id);
   }
   if (!toRemove.empty()) {
-    m_dirty = true;
     LOG_INFO("Removed " + std::to_string(toRemove.size()) +
              " duplicate wallpapers.");
-    save();
+    appendJournal(records, toRemove.size());
+    publishLocked();
   }
 }
 std::optional<WallpaperInfo>
 WallpaperLibrary::getWallpaper(const std::string &id) const {
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
-  auto it = m_wallpapers.find(id);
-  if (it != m_wallpapers.end()) {
-    return it->second;
+  // The mapping is only dropped after the hydrated snapshot is published,
+  // so a null m_base means the snapshot has the entry.
+  if (!m_hydrated.load(std::memory_order_acquire)) {
+    if (auto base = m_base.load(std::memory_order_acquire))
+      return base->find(id);
+  }
+  auto snap = m_snapshot.load(std::memory_order_acquire);
+  if (WallpaperView view = snap->find(id)) {
+    return view.toInfo();
   }
   return std::nullopt;
 }
 std::vector<WallpaperInfo> WallpaperLibrary::getAllWallpapers() const {
   LOG_SCOPE_AUTO();
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  return snapshot()->values();
+}
+std::vector<WallpaperInfo>
+WallpaperLibrary::search(const std::string &query) const {
+  LOG_SCOPE_AUTO();
+  ensureHydrated();
+  std::string q = utils::StringUtils::trim(query);
+  std::vector<std::string> ids;
+  {
+    std::shared_lock<std::shared_mutex> indexLock(m_indexMutex);
+    for (uint32_t slot : m_searchIndex.search(q)) {
+      ids.push_back(m_slotIds[slot]);
+    }
+  }
+  auto snap = m_snapshot.load(std::memory_order_acquire);
   std::vector<WallpaperInfo> result;
-  result.reserve(m_wallpapers.size());
-  for (const auto &pair : m_wallpapers) {
-    result.push_back(pair.second);
+  result.reserve(ids.size());
+  for (const auto &id : ids) {
+    if (WallpaperView view = snap->find(id)) {
+      result.push_back(view.toInfo());
+    }
   }
   return result;
 }
 std::vector<WallpaperInfo>
-WallpaperLibrary::search(const std::string &query) const {
+WallpaperLibrary::query(const std::string &expression,
+                        std::string *error) const {
+  auto parsed = LibraryQuery::parse(expression, error);
+  if (!parsed) {
+    LOG_DEBUG("Rejected library query '" + expression + "'");
+    return {};
+  }
+  return query(*parsed);
+}
+std::vector<WallpaperInfo>
+WallpaperLibrary::query(const LibraryQuery &q) const {
   LOG_SCOPE_AUTO();
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
-  std::vector<WallpaperInfo> result;
-  std::string q = utils::StringUtils::toLower(utils::StringUtils::trim(query));
-  for (const auto &pair : m_wallpapers) {
-    const auto &info = pair.second;
-    bool match = false;
-    std::string filename = std::filesystem::path(info.path).filename().string();
-    if (utils::StringUtils::toLower(filename).find(q) != std::string::npos)
-      match = true;
-    for (const auto &tag : info.tags) {
-      if (utils::StringUtils::toLower(tag).find(q) != std::string::npos)
-        match = true;
+  ensureHydrated();
+  auto snap = m_snapshot.load(std::memory_order_acquire);
+  std::vector<WallpaperView> hits;
+  {
+    std::shared_lock<std::shared_mutex> indexLock(m_indexMutex);
+    // Narrow with every indexed term; matches() below re-checks the rest.
+    std::vector<std::string> plan;
+    RoaringBitmap candidates;
+    bool narrowed = false;
+    auto narrow = [&](const RoaringBitmap &bitmap, const char *term) {
+      candidates = narrowed ? candidates & bitmap : bitmap;
+      narrowed = true;
+      plan.emplace_back(term);
+    };
+    if (!q.tagsAll.empty() || !q.tagsAny.empty())
+      narrow(m_tagIndex.query(q.tagsAll, q.tagsAny, {}), "tags");
+    if (!q.types.empty()) {
+      RoaringBitmap ofTypes;
+      for (WallpaperType type : q.types)
+        ofTypes = ofTypes | m_attrIndex.ofType(type);
+      narrow(ofTypes, "type");
+    }
+    if (q.favorite)
+      narrow(*q.favorite ? m_attrIndex.favorites()
+                         : m_tagIndex.live() - m_attrIndex.favorites(),
+             "favorite");
+    if (q.rating.active()) {
+      auto clampRating = [](int64_t v) {
+        return static_cast<int>(std::clamp<int64_t>(v, -1, 1 << 30));
+      };
+      narrow(m_attrIndex.ratingBetween(clampRating(q.rating.min),
+                                       clampRating(q.rating.max)),
+             "rating");
     }
-    if (match) {
-      result.push_back(info);
+    for (const auto &word : q.words) {
+      RoaringBitmap docs;
+      for (uint32_t slot : m_searchIndex.search(word))
+        docs.add(slot);
+      narrow(docs, "text");
     }
+    if (!narrowed) {
+      candidates = m_tagIndex.live();
+      plan.emplace_back("scan");
+    }
+    auto verified = [&](uint32_t slot) -> WallpaperView {
+      WallpaperView view = snap->find(m_slotIds[slot]);
+      return view && q.matches(view) ? view : WallpaperView{};
+    };
+    bool recency = q.sort == LibraryQuery::SortKey::Added ||
+                   q.sort == LibraryQuery::SortKey::LastUsed;
+    if (recency) {
+      // Walk the cached ordering and stop at the limit instead of sorting
+      // every candidate.
+      const auto &order = m_attrIndex.ordered(
+          q.sort == LibraryQuery::SortKey::Added
+              ? AttributeIndex::Order::Added
+              : AttributeIndex::Order::LastUsed);
+      auto visit = [&](uint32_t slot) {
+        if (!candidates.contains(slot))
+          return true;
+        if (WallpaperView view = verified(slot))
+          hits.push_back(view);
+        return q.limit == 0 || hits.size() < q.limit;
+      };
+      if (q.descending) {
+        for (auto it = order.rbegin(); it != order.rend() && visit(*it); ++it) {
+        }
+      } else {
+        for (auto it = order.begin(); it != order.end() && visit(*it); ++it) {
+        }
+      }
+      plan.emplace_back("ordered");
+    } else {
+      candidates.forEach([&](uint32_t slot) {
+        if (WallpaperView view = verified(slot))
+          hits.push_back(view);
+      });
+    }
+    LOG_DEBUG("Library query plan: " + utils::StringUtils::join(plan, "+") +
+              " -> " + std::to_string(hits.size()) + " hits");
   }
+  if (q.sort != LibraryQuery::SortKey::None &&
+      q.sort != LibraryQuery::SortKey::Added &&
+      q.sort != LibraryQuery::SortKey::LastUsed) {
+    auto key = [&q](const WallpaperView &v) -> int64_t {
+      switch (q.sort) {
+      case LibraryQuery::SortKey::Rating: return v.rating();
+      case LibraryQuery::SortKey::Plays: return v.playCount();
+      case LibraryQuery::SortKey::Size: return static_cast<int64_t>(v.sizeBytes());
+      default: return 0;
+      }
+    };
+    auto less = [&](const WallpaperView &a, const WallpaperView &b) {
+      if (q.sort == LibraryQuery::SortKey::Name)
+        return q.descending ? b.title() < a.title() : a.title() < b.title();
+      return q.descending ? key(b) < key(a) : key(a) < key(b);
+    };
+    if (q.limit > 0 && q.limit < hits.size()) {
+      std::partial_sort(hits.begin(), hits.begin() + q.limit, hits.end(), less);
+    } else {
+      std::stable_sort(hits.begin(), hits.end(), less);
+    }
+  }
+  if (q.limit > 0 && hits.size() > q.limit)
+    hits.resize(q.limit);
+  std::vector<WallpaperInfo> result;
+  result.reserve(hits.size());
+  for (const auto &view : hits)
+    result.push_back(view.toInfo());
   return result;
 }
 std::vector<WallpaperInfo> WallpaperLibrary::filter(
     const std::function<bool(const WallpaperInfo &)> &predicate) const {
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
   std::vector<WallpaperInfo> result;
-  for (const auto &pair : m_wallpapers) {
-    if (predicate(pair.second)) {
-      result.push_back(pair.second);
+  snapshot()->forEach([&](WallpaperView view) {
+    WallpaperInfo info = view.toInfo();
+    if (predicate(info)) {
+      result.push_back(std::move(info));
     }
-  }
+  });
   return result;
 }
 void WallpaperLibrary::setChangeCallback(ChangeCallback cb) {
@@ -471,18 +1044,91 @@ void WallpaperLibrary::removeChangeCallback(int id) {
   std::lock_guard<std::recursive_mutex> lock(m_mutex);
   m_idCallbacks.erase(id);
 }
-std::vector<std::string> WallpaperLibrary::getAllTags() const {
+int WallpaperLibrary::addChangeSetCallback(ChangeSetCallback cb) {
   std::lock_guard<std::recursive_mutex> lock(m_mutex);
-  std::unordered_set<std::string> tagSet;
-  for (const auto &pair : m_wallpapers) {
-    for (const auto &tag : pair.second.tags) {
-      tagSet.insert(tag);
-    }
+  int id = m_nextCallbackId++;
+  m_changeSetCallbacks[id] = std::move(cb);
+  return id;
+}
+void WallpaperLibrary::removeChangeSetCallback(int id) {
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  m_changeSetCallbacks.erase(id);
+}
+std::vector<std::string> WallpaperLibrary::getAllTags() const {
+  std::vector<std::string> tags;
+  for (auto &[tag, count] : getTagCounts()) {
+    tags.push_back(std::move(tag));
   }
-  std::vector<std::string> tags(tagSet.begin(), tagSet.end());
-  std::sort(tags.begin(), tags.end());
   return tags;
 }
+std::vector<std::pair<std::string, size_t>>
+WallpaperLibrary::getTagCounts() const {
+  ensureHydrated();
+  std::shared_lock<std::shared_mutex> indexLock(m_indexMutex);
+  return m_tagIndex.counts();
+}
+size_t WallpaperLibrary::countWithTag(const std::string &tag) const {
+  ensureHydrated();
+  std::shared_lock<std::shared_mutex> indexLock(m_indexMutex);
+  return m_tagIndex.count(tag);
+}
+std::vector<std::string>
+WallpaperLibrary::queryTags(const TagQuery &query) const {
+  std::vector<std::string> ids;
+  forEachTagged(query, [&ids](const std::string &id) { ids.push_back(id); });
+  return ids;
+}
+void WallpaperLibrary::forEachTagged(
+    const TagQuery &query,
+    const std::function<void(const std::string &id)> &fn) const {
+  ensureHydrated();
+  std::shared_lock<std::shared_mutex> indexLock(m_indexMutex);
+  m_tagIndex.query(query.all, query.any, query.none)
+      .forEach([this, &fn](uint32_t slot) { fn(m_slotIds[slot]); });
+}
+std::vector<DuplicateGroup> WallpaperLibrary::findDuplicates() {
+  LOG_SCOPE_AUTO();
+  std::vector<DuplicateFinder::Input> inputs;
+  snapshot()->forEach([&inputs](WallpaperView view) {
+    inputs.push_back({std::string(view.id()), view.path()});
+  });
+  std::lock_guard<std::mutex> lock(m_hashMutex);
+  auto cachePath = getDataDirectory() / "hashes.bin";
+  if (!m_hashCacheLoaded) {
+    m_hashCache.load(cachePath);
+    m_hashCacheLoaded = true;
+  }
+  auto start = std::chrono::steady_clock::now();
+  auto groups = DuplicateFinder::run(inputs, m_hashCache);
+  m_hashCache.dropUntouched();
+  if (m_hashCache.dirty() && !m_hashCache.save(cachePath)) {
+    LOG_WARN("Failed to save content hash cache: " + cachePath.string());
+  }
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+  LOG_INFO("Duplicate scan of " + std::to_string(inputs.size()) +
+           " wallpapers found " + std::to_string(groups.size()) +
+           " groups in " + std::to_string(ms) + " ms");
+  return groups;
+}
+std::vector<std::vector<std::string>>
+WallpaperLibrary::findNearDuplicates(int radius) const {
+  LOG_SCOPE_AUTO();
+  ensureHydrated();
+  std::shared_lock<std::shared_mutex> indexLock(m_indexMutex);
+  std::vector<std::vector<std::string>> result;
+  for (const auto &slots : m_phashIndex.clusters(radius)) {
+    auto &ids = result.emplace_back();
+    for (uint32_t slot : slots)
+      ids.push_back(m_slotIds[slot]);
+    std::sort(ids.begin(), ids.end());
+  }
+  LOG_DEBUG("Near-duplicate scan over " + std::to_string(m_phashIndex.size()) +
+            " hashes (radius " + std::to_string(radius) + "): " +
+            std::to_string(result.size()) + " clusters");
+  return result;
+}
 std::filesystem::path WallpaperLibrary::getDataDirectory() const {
   return m_dbPath.parent_path();
 }
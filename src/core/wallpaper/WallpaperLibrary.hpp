@@ -1,26 +1,81 @@
 #pragma once
 #include "WallpaperInfo.hpp"
+#include "library/AttributeIndex.hpp"
+#include "library/BinaryLibraryFile.hpp"
+#include "library/DuplicateFinder.hpp"
+#include "library/LibraryChangeSet.hpp"
+#include "library/LibraryJournal.hpp"
+#include "library/LibraryQuery.hpp"
+#include "library/PerceptualIndex.hpp"
+#include "library/LibrarySnapshot.hpp"
+#include "library/TagIndex.hpp"
+#include "library/TrigramIndex.hpp"
 #include <filesystem>
 #include <mutex>
 #include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <shared_mutex>
+#include <thread>
 #include <nlohmann/json.hpp>
 #include <string>
 #include <unordered_map>
 #include <vector>
 namespace bwp::wallpaper {
+// Boolean tag filter: every tag in `all`, at least one of `any` (when
+// non-empty) and none of `none`.
+struct TagQuery {
+  std::vector<std::string> all;
+  std::vector<std::string> any;
+  std::vector<std::string> none;
+};
 class WallpaperLibrary {
 public:
   static WallpaperLibrary &getInstance();
   void initialize();
   void save();
   void addWallpaper(const WallpaperInfo &info);
+  // Adds (or merges) a batch in one transaction: one journal write and one
+  // change-set notification. Returns the number of newly added entries.
+  size_t addWallpapers(const std::vector<WallpaperInfo> &batch);
+  // Per-thread bulk transaction. Mutations made by the calling thread
+  // between beginBulk() and the matching commit() are journaled together,
+  // published to readers together and reported as a single change set;
+  // per-item callbacks are skipped.
+  void beginBulk();
+  void commit();
   void updateWallpaper(const WallpaperInfo &info);
   void updateBlurhash(const std::string &id, const std::string &hash);
+  void updatePerceptualHash(const std::string &id, uint64_t hash);
   void removeWallpaper(const std::string &id);
+  // Current immutable view of the library. Never blocks on writers; hold
+  // the pointer to iterate or keep references without copying entries.
+  std::shared_ptr<const LibrarySnapshot> snapshot() const;
   std::optional<WallpaperInfo> getWallpaper(const std::string &id) const;
   std::vector<WallpaperInfo> getAllWallpapers() const;
   std::vector<std::string> getAllTags() const;
+  std::vector<std::pair<std::string, size_t>> getTagCounts() const;
+  size_t countWithTag(const std::string &tag) const;
+  std::vector<std::string> queryTags(const TagQuery &query) const;
+  // Visits matching ids without copying entries. Runs under the index read
+  // lock: `fn` may read from the library but must not mutate it.
+  void forEachTagged(const TagQuery &query,
+                     const std::function<void(const std::string &id)> &fn) const;
   std::vector<WallpaperInfo> search(const std::string &query) const;
+  // Evaluates a query-language expression (see LibraryQuery). On a parse
+  // error returns nothing and, if given, fills `error`.
+  std::vector<WallpaperInfo> query(const std::string &expression,
+                                   std::string *error = nullptr) const;
+  std::vector<WallpaperInfo> query(const LibraryQuery &query) const;
+  // Groups of entries whose files have identical contents. Hashes are
+  // cached on disk by file identity, so repeat runs only read new files.
+  std::vector<DuplicateGroup> findDuplicates();
+  // Clusters of visually similar entries: perceptual hashes within `radius`
+  // bits of each other, found through a BK-tree rather than pairwise.
+  // Entries without a hash yet (WallpaperInfo::phash == 0) are skipped.
+  static constexpr int kDefaultNearRadius = 6;
+  std::vector<std::vector<std::string>>
+  findNearDuplicates(int radius = kDefaultNearRadius) const;
   std::vector<WallpaperInfo>
   filter(const std::function<bool(const WallpaperInfo &)> &predicate) const;
   using ChangeCallback = std::function<void(const WallpaperInfo &info)>;
@@ -28,22 +83,91 @@ public:
   void addChangeCallback(ChangeCallback cb);
   int addChangeCallbackWithId(ChangeCallback cb);
   void removeChangeCallback(int id);
+  using ChangeSetCallback = std::function<void(const LibraryChangeSet &changes)>;
+  // One call per transaction, on the mutating thread. UI consumers should
+  // feed a ChangeSetQueue to get at most one diff per main-loop iteration.
+  int addChangeSetCallback(ChangeSetCallback cb);
+  void removeChangeSetCallback(int id);
   std::filesystem::path getDataDirectory() const;
 private:
+  enum class AddResult { Added, Merged, Unchanged, Ignored };
+  struct BulkState {
+    int depth = 0;
+    std::string journal;
+    size_t records = 0;
+    ChangeSetAccumulator changes;
+  };
   void removeDuplicates();
   WallpaperLibrary();
   ~WallpaperLibrary();
   void load();
+  // Entries from m_base or library.json plus the journal, normalized. Runs
+  // without m_mutex: nothing else touches the store before hydration.
+  std::unordered_map<std::string, WallpaperInfo> readEntries(bool &dirty);
+  void installLocked(std::unordered_map<std::string, WallpaperInfo> wallpapers,
+                     bool dirty);
+  void ensureHydrated() const;
+  // Background pass after hydration: prunes entries whose file is gone and
+  // re-keys m_pathToId on canonical paths, then reports one change set.
+  void validateEntries(std::shared_ptr<const LibrarySnapshot> snap);
   std::filesystem::path getDatabasePath() const;
-  std::unordered_map<std::string, WallpaperInfo> m_wallpapers;
+  static std::string normalizePath(const std::string &path);
+  AddResult addWallpaperLocked(const WallpaperInfo &info,
+                               const std::string &normPath);
+  BulkState *currentBulkLocked();
+  void journalLocked(std::string record);
+  void appendJournal(const std::string &lines, size_t recordCount);
+  void dispatchChangeSet(const LibraryChangeSet &changes);
+  void publishLocked();
+  void indexLocked(const WallpaperInfo &info);
+  void writeIndexEntry(const WallpaperInfo &info);
+  void unindexLocked(const std::string &id);
+  void rebuildIndexLocked();
+  void requestCompaction();
+  void compactionLoop();
+  bool compact();
+  LibraryStore m_store;
+  std::atomic<std::shared_ptr<const LibrarySnapshot>> m_snapshot;
   std::unordered_map<std::string, std::string> m_pathToId;
+  // Dense slot per wallpaper id for the secondary indexes; freed slots are
+  // reused so the id space stays compact. Written under both m_mutex and
+  // m_indexMutex, so readers only need the latter.
+  mutable std::shared_mutex m_indexMutex;
+  std::unordered_map<std::string, uint32_t> m_slots;
+  std::vector<std::string> m_slotIds;
+  std::vector<uint32_t> m_freeSlots;
+  TrigramIndex m_searchIndex;
+  TagIndex m_tagIndex;
+  AttributeIndex m_attrIndex;
+  PerceptualIndex m_phashIndex;
   mutable std::recursive_mutex m_mutex;
   std::filesystem::path m_dbPath;
+  std::filesystem::path m_binPath;
   bool m_dirty = false;
+  // Until hydrated, point lookups are served lock-free from the mapped
+  // binary snapshot and the published snapshot is empty.
+  std::atomic<std::shared_ptr<const BinaryLibraryFile>> m_base;
+  std::atomic<bool> m_hydrated{true};
+  mutable std::mutex m_hydrateMutex;
+  std::thread m_hydrateThread;
+  std::thread m_validateThread;
+  std::atomic<bool> m_stopValidation{false};
+  LibraryJournal m_journal;
+  std::mutex m_compactMutex;
+  std::mutex m_hashMutex;
+  HashCache m_hashCache;
+  bool m_hashCacheLoaded = false;
+  std::mutex m_compactSignalMutex;
+  std::condition_variable m_compactCv;
+  std::thread m_compactThread;
+  bool m_compactRequested = false;
+  bool m_stopCompaction = false;
   std::atomic<bool> m_initialized{false};
   ChangeCallback m_changeCallback;
   std::vector<ChangeCallback> m_changeCallbacks;
   std::unordered_map<int, ChangeCallback> m_idCallbacks;
+  std::unordered_map<int, ChangeSetCallback> m_changeSetCallbacks;
+  std::unordered_map<std::thread::id, BulkState> m_bulk;
   int m_nextCallbackId = 1;
 };
 }  
@@ -0,0 +1,86 @@
+#include "AttributeIndex.hpp"
+#include <algorithm>
+namespace bwp::wallpaper {
+AttributeIndex::Attributes
+AttributeIndex::Attributes::of(const WallpaperInfo &info) {
+  Attributes a;
+  a.type = info.type;
+  a.favorite = info.favorite;
+  a.rating = info.rating;
+  a.playCount = info.play_count;
+  a.added = info.added;
+  a.lastUsed = info.last_used;
+  a.sizeBytes = info.size_bytes;
+  return a;
+}
+int AttributeIndex::bucketOf(int rating) {
+  return std::clamp(rating, 0, kMaxRating);
+}
+void AttributeIndex::set(Slot slot, const Attributes &attributes) {
+  remove(slot);
+  if (slot >= m_columns.size()) {
+    m_columns.resize(slot + 1);
+    m_present.resize(slot + 1, false);
+  }
+  m_columns[slot] = attributes;
+  m_present[slot] = true;
+  m_types[static_cast<size_t>(attributes.type)].add(slot);
+  m_ratings[bucketOf(attributes.rating)].add(slot);
+  if (attributes.favorite)
+    m_favorites.add(slot);
+  std::lock_guard<std::mutex> lock(m_orderMutex);
+  m_orderValid.fill(false);
+}
+void AttributeIndex::remove(Slot slot) {
+  if (slot >= m_present.size() || !m_present[slot])
+    return;
+  const Attributes &old = m_columns[slot];
+  m_types[static_cast<size_t>(old.type)].remove(slot);
+  m_ratings[bucketOf(old.rating)].remove(slot);
+  m_favorites.remove(slot);
+  m_present[slot] = false;
+  std::lock_guard<std::mutex> lock(m_orderMutex);
+  m_orderValid.fill(false);
+}
+void AttributeIndex::clear() {
+  for (auto &bitmap : m_types)
+    bitmap.clear();
+  for (auto &bitmap : m_ratings)
+    bitmap.clear();
+  m_favorites.clear();
+  m_columns.clear();
+  m_present.clear();
+  std::lock_guard<std::mutex> lock(m_orderMutex);
+  m_orderValid.fill(false);
+}
+const RoaringBitmap &AttributeIndex::ofType(WallpaperType type) const {
+  return m_types[static_cast<size_t>(type)];
+}
+RoaringBitmap AttributeIndex::ratingBetween(int min, int max) const {
+  RoaringBitmap result;
+  for (int r = bucketOf(min); r <= bucketOf(max); ++r)
+    result = result | m_ratings[r];
+  return result;
+}
+const std::vector<AttributeIndex::Slot> &
+AttributeIndex::ordered(Order order) const {
+  size_t which = static_cast<size_t>(order);
+  std::lock_guard<std::mutex> lock(m_orderMutex);
+  auto &slots = m_orders[which];
+  if (!m_orderValid[which]) {
+    slots.clear();
+    for (Slot s = 0; s < m_present.size(); ++s) {
+      if (m_present[s])
+        slots.push_back(s);
+    }
+    auto key = [this, order](Slot s) {
+      return order == Order::Added ? m_columns[s].added
+                                   : m_columns[s].lastUsed;
+    };
+    std::stable_sort(slots.begin(), slots.end(),
+                     [&key](Slot a, Slot b) { return key(a) < key(b); });
+    m_orderValid[which] = true;
+  }
+  return slots;
+}
+} // namespace bwp::wallpaper
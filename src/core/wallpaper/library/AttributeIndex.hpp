@@ -0,0 +1,52 @@
+#pragma once
+#include "../WallpaperInfo.hpp"
+#include "RoaringBitmap.hpp"
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+namespace bwp::wallpaper {
+// Per-slot scalar attributes for the query planner: bitmaps for the
+// low-cardinality ones (type, favorite, rating) and dense columns for the
+// rest. Orderings by recency are built on demand and cached until the next
+// write, so repeated "sort:last_used limit:N" queries walk a ready list.
+class AttributeIndex {
+public:
+  using Slot = uint32_t;
+  enum class Order { Added, LastUsed };
+  struct Attributes {
+    WallpaperType type = WallpaperType::Unknown;
+    bool favorite = false;
+    int rating = 0;
+    int playCount = 0;
+    int64_t added = 0;
+    int64_t lastUsed = 0;
+    uint64_t sizeBytes = 0;
+    static Attributes of(const WallpaperInfo &info);
+  };
+  static constexpr int kMaxRating = 5;
+  void set(Slot slot, const Attributes &attributes);
+  void remove(Slot slot);
+  void clear();
+  const RoaringBitmap &ofType(WallpaperType type) const;
+  const RoaringBitmap &favorites() const { return m_favorites; }
+  // Slots whose rating lies in [min, max]; ratings outside 0..kMaxRating
+  // are clamped into the end buckets.
+  RoaringBitmap ratingBetween(int min, int max) const;
+  // Live slots in ascending order of the key. Not safe to call
+  // concurrently with set/remove; concurrent readers are fine.
+  const std::vector<Slot> &ordered(Order order) const;
+
+private:
+  static int bucketOf(int rating);
+  std::array<RoaringBitmap, static_cast<size_t>(WallpaperType::Unknown) + 1>
+      m_types;
+  std::array<RoaringBitmap, kMaxRating + 1> m_ratings;
+  RoaringBitmap m_favorites;
+  std::vector<Attributes> m_columns;
+  std::vector<bool> m_present;
+  mutable std::mutex m_orderMutex;
+  mutable std::array<std::vector<Slot>, 2> m_orders;
+  mutable std::array<bool, 2> m_orderValid{};
+};
+} // namespace bwp::wallpaper
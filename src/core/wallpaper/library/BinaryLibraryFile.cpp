@@ -0,0 +1,339 @@
+#include "BinaryLibraryFile.hpp"
+#include "../../utils/FileUtils.hpp"
+#include "../../utils/Logger.hpp"
+#include <cstring>
+#include <unordered_map>
+namespace bwp::wallpaper {
+namespace {
+constexpr char kMagic[8] = {'B', 'W', 'P', 'L', 'I', 'B', '\0', '\0'};
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+  uint32_t recordCount;
+  uint32_t bucketCount;
+  uint64_t jsonSize;
+  int64_t jsonMtime;
+  uint64_t recordsOffset;
+  uint64_t tagsOffset;
+  uint64_t tagCount;
+  uint64_t idIndexOffset;
+  uint64_t stringsOffset;
+  uint64_t stringsSize;
+};
+// String fields are (offset << 32 | length) references into the string table.
+struct FileRecord {
+  uint64_t id;
+  uint64_t path;
+  uint64_t title;
+  uint64_t source;
+  uint64_t blurhash;
+  uint64_t workshopId;
+  uint64_t sizeBytes;
+  uint64_t phash;
+  uint64_t codec;
+  int64_t added;
+  int64_t lastUsed;
+  double playbackSpeed;
+  uint32_t tagsBegin;
+  uint32_t tagsCount;
+  int32_t rating;
+  int32_t playCount;
+  int32_t fps;
+  int32_t volume;
+  int32_t width;
+  int32_t height;
+  double duration;
+  double frameRate;
+  uint8_t type;
+  uint8_t favorite;
+  uint8_t muted;
+  uint8_t scaling;
+  int8_t noAudioProcessing;
+  int8_t disableMouse;
+  int8_t noAutomute;
+  uint8_t reserved;
+};
+static_assert(sizeof(FileHeader) == 88, "library.bin header layout changed");
+static_assert(sizeof(FileRecord) == 152, "library.bin record layout changed");
+constexpr size_t kFieldId = 0;
+
+uint64_t fnv1a(std::string_view s) {
+  uint64_t h = 1469598103934665603ULL;
+  for (unsigned char c : s) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+uint32_t bucketCountFor(size_t records) {
+  uint32_t buckets = 16;
+  while (buckets < records * 2)
+    buckets <<= 1;
+  return buckets;
+}
+void alignTo8(std::string &buf) {
+  buf.resize((buf.size() + 7) & ~size_t{7}, '\0');
+}
+template <typename T> void appendPod(std::string &buf, const T &value) {
+  buf.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+template <typename T> T readPod(const uint8_t *base, uint64_t offset) {
+  T value;
+  std::memcpy(&value, base + offset, sizeof(T));
+  return value;
+}
+} // namespace
+
+std::optional<BinaryLibraryFile::Stamp>
+BinaryLibraryFile::stampOf(const std::filesystem::path &jsonPath) {
+  std::error_code ec;
+  auto size = std::filesystem::file_size(jsonPath, ec);
+  if (ec)
+    return std::nullopt;
+  auto mtime = std::filesystem::last_write_time(jsonPath, ec);
+  if (ec)
+    return std::nullopt;
+  Stamp stamp;
+  stamp.jsonSize = size;
+  stamp.jsonMtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+  return stamp;
+}
+bool BinaryLibraryFile::write(const std::filesystem::path &path,
+                              const std::vector<WallpaperView> &entries,
+                              const Stamp &stamp) {
+  std::string strings;
+  auto append = [&](std::string_view s) -> uint64_t {
+    uint64_t ref = (static_cast<uint64_t>(strings.size()) << 32) |
+                   static_cast<uint32_t>(s.size());
+    strings += s;
+    return ref;
+  };
+  // Keys view the entries' strings, which outlive this function. Paths are
+  // rebuilt per entry and unique anyway, so they bypass the table.
+  std::unordered_map<std::string_view, uint64_t> interned;
+  auto intern = [&](std::string_view s) -> uint64_t {
+    auto it = interned.find(s);
+    if (it != interned.end())
+      return it->second;
+    uint64_t ref = append(s);
+    interned.emplace(s, ref);
+    return ref;
+  };
+  uint32_t buckets = bucketCountFor(entries.size());
+  std::vector<uint32_t> idIndex(buckets, 0);
+  auto insert = [&](std::string_view key, uint32_t record) {
+    uint32_t mask = buckets - 1;
+    uint32_t slot = static_cast<uint32_t>(fnv1a(key)) & mask;
+    while (idIndex[slot] != 0)
+      slot = (slot + 1) & mask;
+    idIndex[slot] = record + 1;
+  };
+  std::vector<FileRecord> records;
+  std::vector<uint64_t> tagRefs;
+  records.reserve(entries.size());
+  for (const auto &view : entries) {
+    const LibraryEntry &e = *view.entry();
+    uint32_t index = static_cast<uint32_t>(records.size());
+    insert(e.id(), index);
+    FileRecord r{};
+    r.id = intern(e.id());
+    r.path = append(view.path());
+    r.title = intern(e.title());
+    r.source = intern(*e.source);
+    r.blurhash = intern(e.blurhash());
+    r.workshopId = e.workshopId;
+    r.sizeBytes = e.sizeBytes;
+    r.phash = e.phash;
+    r.codec = intern(*e.codec);
+    r.added = e.added;
+    r.lastUsed = e.lastUsed;
+    r.playbackSpeed = e.playbackSpeed;
+    r.tagsBegin = static_cast<uint32_t>(tagRefs.size());
+    r.tagsCount = static_cast<uint32_t>(e.tags.size());
+    for (const auto *tag : e.tags) {
+      tagRefs.push_back(intern(*tag));
+    }
+    r.rating = e.rating;
+    r.playCount = e.playCount;
+    r.fps = e.fps;
+    r.volume = e.volume;
+    r.width = e.width;
+    r.height = e.height;
+    r.duration = e.duration;
+    r.frameRate = e.frameRate;
+    r.type = e.type;
+    r.favorite = (e.flags & LibraryEntry::kFavorite) ? 1 : 0;
+    r.muted = (e.flags & LibraryEntry::kMuted) ? 1 : 0;
+    r.scaling = e.scaling;
+    r.noAudioProcessing = e.noAudioProcessing;
+    r.disableMouse = e.disableMouse;
+    r.noAutomute = e.noAutomute;
+    records.push_back(r);
+  }
+
+  FileHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.recordSize = sizeof(FileRecord);
+  header.recordCount = static_cast<uint32_t>(records.size());
+  header.bucketCount = buckets;
+  header.jsonSize = stamp.jsonSize;
+  header.jsonMtime = stamp.jsonMtime;
+
+  std::string buf;
+  buf.reserve(sizeof(FileHeader) + records.size() * sizeof(FileRecord) +
+              tagRefs.size() * 8 + buckets * 4 + strings.size() + 24);
+  buf.resize(sizeof(FileHeader));
+  header.recordsOffset = buf.size();
+  for (const auto &r : records)
+    appendPod(buf, r);
+  alignTo8(buf);
+  header.tagsOffset = buf.size();
+  header.tagCount = tagRefs.size();
+  for (uint64_t ref : tagRefs)
+    appendPod(buf, ref);
+  alignTo8(buf);
+  header.idIndexOffset = buf.size();
+  for (uint32_t v : idIndex)
+    appendPod(buf, v);
+  alignTo8(buf);
+  header.stringsOffset = buf.size();
+  header.stringsSize = strings.size();
+  buf += strings;
+  std::memcpy(buf.data(), &header, sizeof(header));
+  if (!utils::FileUtils::writeFileAtomic(path, buf)) {
+    LOG_ERROR("Failed to write binary library snapshot: " + path.string());
+    return false;
+  }
+  return true;
+}
+std::unique_ptr<BinaryLibraryFile>
+BinaryLibraryFile::open(const std::filesystem::path &path) {
+  auto file = utils::MappedFile::open(path);
+  if (!file)
+    return nullptr;
+  std::unique_ptr<BinaryLibraryFile> lib(new BinaryLibraryFile());
+  lib->m_file = std::move(file);
+  if (!lib->validate()) {
+    LOG_WARN("Ignoring invalid binary library snapshot: " + path.string());
+    return nullptr;
+  }
+  return lib;
+}
+bool BinaryLibraryFile::validate() {
+  const size_t fileSize = m_file->size();
+  if (fileSize < sizeof(FileHeader))
+    return false;
+  auto header = readPod<FileHeader>(m_file->data(), 0);
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion || header.recordSize != sizeof(FileRecord))
+    return false;
+  if (header.bucketCount == 0 ||
+      (header.bucketCount & (header.bucketCount - 1)) != 0 ||
+      header.bucketCount < header.recordCount)
+    return false;
+  auto within = [fileSize](uint64_t offset, uint64_t length) {
+    return offset <= fileSize && length <= fileSize - offset;
+  };
+  if (!within(header.recordsOffset,
+              uint64_t{header.recordCount} * sizeof(FileRecord)) ||
+      !within(header.tagsOffset, header.tagCount * 8) ||
+      !within(header.idIndexOffset, uint64_t{header.bucketCount} * 4) ||
+      !within(header.stringsOffset, header.stringsSize))
+    return false;
+  m_stamp.jsonSize = header.jsonSize;
+  m_stamp.jsonMtime = header.jsonMtime;
+  m_recordCount = header.recordCount;
+  m_bucketCount = header.bucketCount;
+  m_recordsOffset = header.recordsOffset;
+  m_tagsOffset = header.tagsOffset;
+  m_tagCount = header.tagCount;
+  m_idIndexOffset = header.idIndexOffset;
+  m_stringsOffset = header.stringsOffset;
+  m_stringsSize = header.stringsSize;
+  return true;
+}
+std::string_view BinaryLibraryFile::string(uint64_t ref) const {
+  uint64_t offset = ref >> 32;
+  uint64_t length = ref & 0xffffffffULL;
+  if (offset > m_stringsSize || length > m_stringsSize - offset)
+    return {};
+  return std::string_view(
+      reinterpret_cast<const char *>(m_file->data() + m_stringsOffset + offset),
+      length);
+}
+std::string_view BinaryLibraryFile::recordString(size_t index,
+                                                 size_t field) const {
+  uint64_t ref = readPod<uint64_t>(
+      m_file->data(), m_recordsOffset + index * sizeof(FileRecord) + field * 8);
+  return string(ref);
+}
+int64_t BinaryLibraryFile::lookup(std::string_view id) const {
+  uint32_t mask = m_bucketCount - 1;
+  uint32_t slot = static_cast<uint32_t>(fnv1a(id)) & mask;
+  for (uint32_t probes = 0; probes < m_bucketCount; ++probes) {
+    uint32_t value =
+        readPod<uint32_t>(m_file->data(), m_idIndexOffset + uint64_t{slot} * 4);
+    if (value == 0 || value > m_recordCount)
+      return -1;
+    if (recordString(value - 1, kFieldId) == id)
+      return value - 1;
+    slot = (slot + 1) & mask;
+  }
+  return -1;
+}
+WallpaperInfo BinaryLibraryFile::at(size_t index) const {
+  auto r = readPod<FileRecord>(m_file->data(),
+                               m_recordsOffset + index * sizeof(FileRecord));
+  WallpaperInfo info;
+  info.id = std::string(string(r.id));
+  info.path = std::string(string(r.path));
+  info.title = std::string(string(r.title));
+  info.source = std::string(string(r.source));
+  info.blurhash = std::string(string(r.blurhash));
+  info.workshop_id = r.workshopId;
+  info.size_bytes = r.sizeBytes;
+  info.phash = r.phash;
+  info.codec = std::string(string(r.codec));
+  info.width = r.width;
+  info.height = r.height;
+  info.duration = r.duration;
+  info.frame_rate = r.frameRate;
+  info.added = r.added;
+  info.last_used = r.lastUsed;
+  info.rating = r.rating;
+  info.play_count = r.playCount;
+  info.type = static_cast<WallpaperType>(r.type);
+  info.favorite = r.favorite != 0;
+  if (uint64_t{r.tagsBegin} + r.tagsCount <= m_tagCount) {
+    info.tags.reserve(r.tagsCount);
+    for (uint32_t t = 0; t < r.tagsCount; ++t) {
+      info.tags.emplace_back(string(readPod<uint64_t>(
+          m_file->data(), m_tagsOffset + (uint64_t{r.tagsBegin} + t) * 8)));
+    }
+  }
+  info.settings.fps = r.fps;
+  info.settings.volume = r.volume;
+  info.settings.muted = r.muted != 0;
+  info.settings.playback_speed = r.playbackSpeed;
+  info.settings.scaling = static_cast<ScalingMode>(r.scaling);
+  info.settings.noAudioProcessing = r.noAudioProcessing;
+  info.settings.disableMouse = r.disableMouse;
+  info.settings.noAutomute = r.noAutomute;
+  return info;
+}
+std::optional<WallpaperInfo>
+BinaryLibraryFile::find(std::string_view id) const {
+  int64_t index = lookup(id);
+  if (index < 0)
+    return std::nullopt;
+  return at(static_cast<size_t>(index));
+}
+void BinaryLibraryFile::forEach(
+    const std::function<void(WallpaperInfo &&info)> &fn) const {
+  for (size_t i = 0; i < m_recordCount; ++i) {
+    fn(at(i));
+  }
+}
+} // namespace bwp::wallpaper
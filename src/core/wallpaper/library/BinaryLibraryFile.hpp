@@ -0,0 +1,64 @@
+#pragma once
+#include "../../utils/MappedFile.hpp"
+#include "../WallpaperInfo.hpp"
+#include "LibraryEntry.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+namespace bwp::wallpaper {
+// Versioned, memory-mappable library snapshot ("library.bin").
+//
+// Layout: header | fixed-size records | tag refs | id hash index |
+// string table. Strings are deduplicated into the table and referenced by
+// (offset, length); the id index is an open-addressed table of record
+// numbers keyed by a stable FNV-1a hash, so a lookup touches a handful of
+// pages and never parses the whole file.
+//
+// The header stamps the size and mtime of the library.json written in the
+// same compaction, letting load() detect a JSON that was edited or written
+// by an older build and fall back to importing it.
+class BinaryLibraryFile {
+public:
+  static constexpr uint32_t kVersion = 4;
+  struct Stamp {
+    uint64_t jsonSize = 0;
+    int64_t jsonMtime = 0;
+    bool operator==(const Stamp &other) const {
+      return jsonSize == other.jsonSize && jsonMtime == other.jsonMtime;
+    }
+  };
+  static std::optional<Stamp> stampOf(const std::filesystem::path &jsonPath);
+  static bool write(const std::filesystem::path &path,
+                    const std::vector<WallpaperView> &entries,
+                    const Stamp &stamp);
+  static std::unique_ptr<BinaryLibraryFile>
+  open(const std::filesystem::path &path);
+  size_t size() const { return m_recordCount; }
+  const Stamp &stamp() const { return m_stamp; }
+  WallpaperInfo at(size_t index) const;
+  std::optional<WallpaperInfo> find(std::string_view id) const;
+  void forEach(const std::function<void(WallpaperInfo &&info)> &fn) const;
+
+private:
+  BinaryLibraryFile() = default;
+  bool validate();
+  std::string_view string(uint64_t ref) const;
+  std::string_view recordString(size_t index, size_t field) const;
+  int64_t lookup(std::string_view id) const;
+  std::unique_ptr<utils::MappedFile> m_file;
+  Stamp m_stamp;
+  uint32_t m_recordCount = 0;
+  uint32_t m_bucketCount = 0;
+  uint64_t m_recordsOffset = 0;
+  uint64_t m_tagsOffset = 0;
+  uint64_t m_tagCount = 0;
+  uint64_t m_idIndexOffset = 0;
+  uint64_t m_stringsOffset = 0;
+  uint64_t m_stringsSize = 0;
+};
+} // namespace bwp::wallpaper
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+namespace bwp::wallpaper {
+// Little helpers for the small length-prefixed cache files in the data
+// directory (scan manifest, project metadata). Values are host-endian.
+inline void putU32(std::string &out, uint32_t v) {
+  out.append(reinterpret_cast<const char *>(&v), 4);
+}
+inline void putU64(std::string &out, uint64_t v) {
+  out.append(reinterpret_cast<const char *>(&v), 8);
+}
+inline void putString(std::string &out, const std::string &s) {
+  putU32(out, static_cast<uint32_t>(s.size()));
+  out += s;
+}
+inline void putStrings(std::string &out, const std::vector<std::string> &v) {
+  putU32(out, static_cast<uint32_t>(v.size()));
+  for (const auto &s : v)
+    putString(out, s);
+}
+// Bounds-checked cursor; any overrun clears `ok` and reads return zeros.
+struct ByteReader {
+  const uint8_t *p;
+  const uint8_t *end;
+  bool ok = true;
+  bool need(size_t n) {
+    ok = ok && static_cast<size_t>(end - p) >= n;
+    return ok;
+  }
+  uint32_t u32() {
+    uint32_t v = 0;
+    if (need(4)) {
+      std::memcpy(&v, p, 4);
+      p += 4;
+    }
+    return v;
+  }
+  uint64_t u64() {
+    uint64_t v = 0;
+    if (need(8)) {
+      std::memcpy(&v, p, 8);
+      p += 8;
+    }
+    return v;
+  }
+  std::string str() {
+    uint32_t n = u32();
+    if (!need(n))
+      return {};
+    std::string s(reinterpret_cast<const char *>(p), n);
+    p += n;
+    return s;
+  }
+  std::vector<std::string> strings() {
+    uint32_t n = u32();
+    std::vector<std::string> out;
+    // Every string costs at least its length prefix.
+    if (!need(static_cast<size_t>(n) * 4))
+      return out;
+    out.reserve(n);
+    for (uint32_t i = 0; i < n && ok; ++i)
+      out.push_back(str());
+    return out;
+  }
+};
+} // namespace bwp::wallpaper
@@ -0,0 +1,155 @@
+#include "DuplicateFinder.hpp"
+#include "../../utils/ContentHash.hpp"
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <thread>
+namespace bwp::wallpaper {
+namespace {
+struct Candidate {
+  size_t input;
+  FileIdentity identity;
+  std::optional<uint64_t> partial;
+  std::optional<uint64_t> full;
+  std::vector<size_t> links; // other inputs naming the same file
+};
+template <typename Fn>
+bool parallelFor(size_t count, size_t batch, unsigned workers,
+                 const std::atomic<bool> *stop, Fn &&fn) {
+  size_t batches = (count + batch - 1) / batch;
+  workers = static_cast<unsigned>(std::min<size_t>(workers, batches));
+  std::atomic<size_t> next{0};
+  auto work = [&] {
+    while (!stop || !stop->load(std::memory_order_relaxed)) {
+      size_t begin = next.fetch_add(batch, std::memory_order_relaxed);
+      if (begin >= count)
+        return;
+      size_t end = std::min(begin + batch, count);
+      for (size_t i = begin; i < end; ++i)
+        fn(i);
+    }
+  };
+  std::vector<std::thread> pool;
+  for (unsigned i = 1; i < workers; ++i)
+    pool.emplace_back(work);
+  work();
+  for (auto &thread : pool)
+    thread.join();
+  return !stop || !stop->load();
+}
+// Splits each group by `key`, keeping subgroups that still describe at
+// least two entries (a candidate stands for itself plus its links).
+template <typename Key>
+std::vector<std::vector<Candidate *>>
+regroup(const std::vector<std::vector<Candidate *>> &groups, Key key) {
+  std::vector<std::vector<Candidate *>> out;
+  for (const auto &group : groups) {
+    std::map<uint64_t, std::vector<Candidate *>> byKey;
+    for (Candidate *c : group) {
+      if (auto k = key(*c))
+        byKey[*k].push_back(c);
+    }
+    for (auto &[k, members] : byKey) {
+      if (members.size() > 1 || !members[0]->links.empty())
+        out.push_back(std::move(members));
+    }
+  }
+  return out;
+}
+} // namespace
+std::vector<DuplicateGroup>
+DuplicateFinder::run(const std::vector<Input> &inputs, HashCache &cache,
+                     unsigned workers, const std::atomic<bool> *stop) {
+  if (workers == 0)
+    workers = std::clamp(std::thread::hardware_concurrency(), 1u, kMaxWorkers);
+  std::vector<std::optional<FileIdentity>> identities(inputs.size());
+  if (!parallelFor(inputs.size(), kBatchSize * 4, workers, stop, [&](size_t i) {
+        identities[i] = FileIdentity::of(inputs[i].path);
+      }))
+    return {};
+  // Stage 1: size. Links to one file are duplicates by definition, but only
+  // one of them needs hashing; the others ride along as `links`.
+  std::vector<Candidate> candidates;
+  candidates.reserve(inputs.size());
+  std::map<std::pair<uint64_t, uint64_t>, size_t> seenFiles;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    if (!identities[i])
+      continue;
+    const FileIdentity &id = *identities[i];
+    if (id.inode != 0) {
+      auto [it, inserted] = seenFiles.emplace(
+          std::make_pair(id.device, id.inode), candidates.size());
+      if (!inserted) {
+        candidates[it->second].links.push_back(i);
+        continue;
+      }
+    }
+    candidates.push_back({i, id, std::nullopt, std::nullopt, {}});
+  }
+  std::vector<std::vector<Candidate *>> groups(1);
+  for (auto &c : candidates)
+    groups[0].push_back(&c);
+  groups = regroup(groups, [](const Candidate &c) {
+    return std::optional<uint64_t>(c.identity.size);
+  });
+  // Stages 2 and 3: partial then full hashes, cached per identity.
+  auto hashStage = [&](const std::vector<std::vector<Candidate *>> &stage,
+                       bool full) {
+    std::vector<Candidate *> work;
+    for (const auto &group : stage) {
+      for (Candidate *c : group) {
+        if (!(full ? c->full : c->partial))
+          work.push_back(c);
+      }
+    }
+    return parallelFor(work.size(), kBatchSize, workers, stop, [&](size_t i) {
+      Candidate &c = *work[i];
+      auto cached = cache.lookup(c.identity);
+      const std::string &path = inputs[c.input].path;
+      if (!full) {
+        c.partial = cached.partial;
+        if (!c.partial && (c.partial = utils::ContentHash::partial(
+                               path, c.identity.size)))
+          cache.storePartial(c.identity, *c.partial);
+        return;
+      }
+      c.full = cached.full;
+      if (!c.full && (c.full = utils::ContentHash::file(path)))
+        cache.storeFull(c.identity, *c.full);
+    });
+  };
+  if (!hashStage(groups, false))
+    return {};
+  groups = regroup(groups, [](const Candidate &c) { return c.partial; });
+  // A partial hash of a small file already covers every byte.
+  for (auto &group : groups) {
+    for (Candidate *c : group) {
+      if (c->identity.size <= 2 * utils::ContentHash::kPartialBytes)
+        c->full = c->partial;
+    }
+  }
+  if (!hashStage(groups, true))
+    return {};
+  groups = regroup(groups, [](const Candidate &c) { return c.full; });
+  std::vector<DuplicateGroup> result;
+  for (const auto &group : groups) {
+    DuplicateGroup out;
+    out.size = group.front()->identity.size;
+    out.hash = group.front()->full.value_or(0);
+    std::vector<size_t> members;
+    for (Candidate *c : group) {
+      members.push_back(c->input);
+      members.insert(members.end(), c->links.begin(), c->links.end());
+    }
+    std::sort(members.begin(), members.end());
+    for (size_t input : members)
+      out.ids.push_back(inputs[input].id);
+    result.push_back(std::move(out));
+  }
+  std::sort(result.begin(), result.end(),
+            [](const DuplicateGroup &a, const DuplicateGroup &b) {
+              return a.size > b.size;
+            });
+  return result;
+}
+} // namespace bwp::wallpaper
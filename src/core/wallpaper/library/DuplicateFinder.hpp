@@ -0,0 +1,34 @@
+#pragma once
+#include "HashCache.hpp"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+namespace bwp::wallpaper {
+// Entries whose files have identical contents.
+struct DuplicateGroup {
+  uint64_t size = 0;
+  uint64_t hash = 0;
+  std::vector<std::string> ids; // in input order
+};
+// Content-based duplicate detection as a cascade: only files sharing a size
+// get a partial hash (both ends of the file), and only files sharing a
+// partial hash get a full hash. Most of a library is therefore never read
+// at all, and the cache skips re-hashing files whose identity is unchanged.
+// Hashing runs on a small worker pool claiming batches from a shared cursor.
+class DuplicateFinder {
+public:
+  struct Input {
+    std::string id;
+    std::string path;
+  };
+  static constexpr size_t kBatchSize = 16;
+  static constexpr unsigned kMaxWorkers = 8;
+  // Groups of two or more ids, largest files first. Unreadable files are
+  // skipped. Returns an empty list if `stop` is raised.
+  static std::vector<DuplicateGroup> run(const std::vector<Input> &inputs,
+                                         HashCache &cache,
+                                         unsigned workers = 0,
+                                         const std::atomic<bool> *stop = nullptr);
+};
+} // namespace bwp::wallpaper
@@ -0,0 +1,152 @@
+#include "HashCache.hpp"
+#include "../../utils/FileUtils.hpp"
+#include "../../utils/MappedFile.hpp"
+#include <chrono>
+#include <cstring>
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+namespace bwp::wallpaper {
+namespace {
+constexpr char kMagic[4] = {'B', 'W', 'P', 'H'};
+constexpr uint32_t kVersion = 1;
+constexpr uint8_t kHasPartial = 1;
+constexpr uint8_t kHasFull = 2;
+// device, inode, mtime, size, partial, full, flags (padded to 8).
+constexpr size_t kRecordSize = 7 * 8;
+void put64(std::string &out, uint64_t v) {
+  out.append(reinterpret_cast<const char *>(&v), 8);
+}
+uint64_t get64(const uint8_t *p) {
+  uint64_t v;
+  std::memcpy(&v, p, 8);
+  return v;
+}
+} // namespace
+std::optional<FileIdentity>
+FileIdentity::of(const std::filesystem::path &path) {
+  FileIdentity id;
+#ifndef _WIN32
+  struct stat st {};
+  if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    return std::nullopt;
+  id.device = static_cast<uint64_t>(st.st_dev);
+  id.inode = static_cast<uint64_t>(st.st_ino);
+  id.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+               st.st_mtim.tv_nsec;
+  id.size = static_cast<uint64_t>(st.st_size);
+#else
+  std::error_code ec;
+  if (!std::filesystem::is_regular_file(path, ec))
+    return std::nullopt;
+  id.size = std::filesystem::file_size(path, ec);
+  auto mtime = std::filesystem::last_write_time(path, ec);
+  if (ec)
+    return std::nullopt;
+  id.mtimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   mtime.time_since_epoch())
+                   .count();
+#endif
+  return id;
+}
+size_t HashCache::Key::operator()(const FileIdentity &id) const {
+  uint64_t h = id.inode * 0x9E3779B97F4A7C15ULL;
+  h ^= id.device + (h << 6) + (h >> 2);
+  h ^= static_cast<uint64_t>(id.mtimeNs) + (h << 6) + (h >> 2);
+  h ^= id.size + (h << 6) + (h >> 2);
+  return static_cast<size_t>(h);
+}
+bool HashCache::load(const std::filesystem::path &path) {
+  auto file = utils::MappedFile::open(path);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries.clear();
+  m_dirty = false;
+  if (!file || file->size() < 16 ||
+      std::memcmp(file->data(), kMagic, 4) != 0)
+    return false;
+  uint32_t version;
+  std::memcpy(&version, file->data() + 4, 4);
+  uint64_t count = get64(file->data() + 8);
+  if (version != kVersion || count > (file->size() - 16) / kRecordSize)
+    return false;
+  m_entries.reserve(count);
+  const uint8_t *p = file->data() + 16;
+  for (uint64_t i = 0; i < count; ++i, p += kRecordSize) {
+    FileIdentity id{get64(p), get64(p + 8), static_cast<int64_t>(get64(p + 16)),
+                    get64(p + 24)};
+    uint8_t flags = p[48];
+    Entry entry;
+    if (flags & kHasPartial)
+      entry.hashes.partial = get64(p + 32);
+    if (flags & kHasFull)
+      entry.hashes.full = get64(p + 40);
+    m_entries.emplace(id, entry);
+  }
+  return true;
+}
+bool HashCache::save(const std::filesystem::path &path) {
+  std::string out;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    out.reserve(16 + m_entries.size() * kRecordSize);
+    out.append(kMagic, 4);
+    out.append(reinterpret_cast<const char *>(&kVersion), 4);
+    put64(out, m_entries.size());
+    for (const auto &[id, entry] : m_entries) {
+      put64(out, id.device);
+      put64(out, id.inode);
+      put64(out, static_cast<uint64_t>(id.mtimeNs));
+      put64(out, id.size);
+      put64(out, entry.hashes.partial.value_or(0));
+      put64(out, entry.hashes.full.value_or(0));
+      uint64_t flags = (entry.hashes.partial ? kHasPartial : 0) |
+                       (entry.hashes.full ? kHasFull : 0);
+      put64(out, flags);
+    }
+    m_dirty = false;
+  }
+  return utils::FileUtils::writeFileAtomic(path, out);
+}
+HashCache::Hashes HashCache::lookup(const FileIdentity &id) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_entries.find(id);
+  if (it == m_entries.end())
+    return {};
+  it->second.touched = true;
+  return it->second.hashes;
+}
+void HashCache::storePartial(const FileIdentity &id, uint64_t hash) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Entry &entry = m_entries[id];
+  entry.hashes.partial = hash;
+  entry.touched = true;
+  m_dirty = true;
+}
+void HashCache::storeFull(const FileIdentity &id, uint64_t hash) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  Entry &entry = m_entries[id];
+  entry.hashes.full = hash;
+  entry.touched = true;
+  m_dirty = true;
+}
+void HashCache::dropUntouched() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto it = m_entries.begin(); it != m_entries.end();) {
+    if (it->second.touched) {
+      it->second.touched = false;
+      ++it;
+    } else {
+      it = m_entries.erase(it);
+      m_dirty = true;
+    }
+  }
+}
+size_t HashCache::size() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_entries.size();
+}
+bool HashCache::dirty() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_dirty;
+}
+} // namespace bwp::wallpaper
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+namespace bwp::wallpaper {
+// What a file was when it was hashed. A rewrite changes the mtime or size,
+// a replacement changes the inode, so an unchanged identity means the
+// cached hashes are still valid without reading the file.
+struct FileIdentity {
+  uint64_t device = 0;
+  uint64_t inode = 0;
+  int64_t mtimeNs = 0;
+  uint64_t size = 0;
+  static std::optional<FileIdentity> of(const std::filesystem::path &path);
+  // Same underlying file (hard link or two spellings of one path).
+  bool sameFile(const FileIdentity &other) const {
+    return inode != 0 && device == other.device && inode == other.inode;
+  }
+  bool operator==(const FileIdentity &) const = default;
+};
+// Persistent content hashes keyed by FileIdentity. Thread-safe.
+class HashCache {
+public:
+  struct Hashes {
+    std::optional<uint64_t> partial;
+    std::optional<uint64_t> full;
+  };
+  bool load(const std::filesystem::path &path);
+  bool save(const std::filesystem::path &path);
+  Hashes lookup(const FileIdentity &id);
+  void storePartial(const FileIdentity &id, uint64_t hash);
+  void storeFull(const FileIdentity &id, uint64_t hash);
+  // Drops entries not looked up or stored since the previous call (or the
+  // load), so files that left the library do not accumulate.
+  void dropUntouched();
+  size_t size() const;
+  bool dirty() const;
+
+private:
+  struct Key {
+    size_t operator()(const FileIdentity &id) const;
+  };
+  struct Entry {
+    Hashes hashes;
+    bool touched = false;
+  };
+  mutable std::mutex m_mutex;
+  std::unordered_map<FileIdentity, Entry, Key> m_entries;
+  bool m_dirty = false;
+};
+} // namespace bwp::wallpaper
@@ -0,0 +1,101 @@
+#include "LibraryChangeSet.hpp"
+namespace bwp::wallpaper {
+void ChangeSetAccumulator::record(const std::string &id, Kind kind) {
+  auto [it, inserted] = m_state.try_emplace(id, Kind::None);
+  if (inserted)
+    m_order.push_back(id);
+  Kind &state = it->second;
+  Kind before = state;
+  switch (state) {
+  case Kind::None:
+    state = kind;
+    break;
+  case Kind::Added:
+    // Never seen by the consumer: a later remove cancels the add.
+    if (kind == Kind::Removed)
+      state = Kind::None;
+    break;
+  case Kind::Updated:
+    if (kind == Kind::Removed)
+      state = Kind::Removed;
+    break;
+  case Kind::Removed:
+    // The consumer still holds the old entry, so it reappears as an update.
+    if (kind != Kind::Removed)
+      state = Kind::Updated;
+    break;
+  }
+  if (before == Kind::None && state != Kind::None)
+    m_live++;
+  else if (before != Kind::None && state == Kind::None)
+    m_live--;
+}
+void ChangeSetAccumulator::merge(const LibraryChangeSet &changes) {
+  for (const auto &id : changes.removed)
+    removed(id);
+  for (const auto &id : changes.added)
+    added(id);
+  for (const auto &id : changes.updated)
+    updated(id);
+}
+LibraryChangeSet ChangeSetAccumulator::take() {
+  LibraryChangeSet result;
+  for (auto &id : m_order) {
+    switch (m_state[id]) {
+    case Kind::Added:
+      result.added.push_back(std::move(id));
+      break;
+    case Kind::Updated:
+      result.updated.push_back(std::move(id));
+      break;
+    case Kind::Removed:
+      result.removed.push_back(std::move(id));
+      break;
+    case Kind::None:
+      break;
+    }
+  }
+  m_state.clear();
+  m_order.clear();
+  m_live = 0;
+  return result;
+}
+ChangeSetQueue::ChangeSetQueue(Schedule schedule, Sink sink)
+    : m_schedule(std::move(schedule)), m_state(std::make_shared<State>()) {
+  m_state->sink = std::move(sink);
+}
+ChangeSetQueue::~ChangeSetQueue() {
+  std::lock_guard<std::mutex> lock(m_state->mutex);
+  m_state->sink = nullptr;
+  m_state->pending.take();
+}
+void ChangeSetQueue::push(const LibraryChangeSet &changes) {
+  if (changes.empty())
+    return;
+  {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    m_state->pending.merge(changes);
+    if (m_state->scheduled)
+      return;
+    m_state->scheduled = true;
+  }
+  std::weak_ptr<State> weak = m_state;
+  m_schedule([weak] {
+    if (auto state = weak.lock())
+      flushState(state);
+  });
+}
+void ChangeSetQueue::flush() { flushState(m_state); }
+void ChangeSetQueue::flushState(const std::shared_ptr<State> &state) {
+  LibraryChangeSet changes;
+  Sink sink;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->scheduled = false;
+    changes = state->pending.take();
+    sink = state->sink;
+  }
+  if (sink && !changes.empty())
+    sink(changes);
+}
+} // namespace bwp::wallpaper
@@ -0,0 +1,66 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+namespace bwp::wallpaper {
+struct LibraryChangeSet {
+  std::vector<std::string> added;
+  std::vector<std::string> updated;
+  std::vector<std::string> removed;
+  [[nodiscard]] bool empty() const {
+    return added.empty() && updated.empty() && removed.empty();
+  }
+};
+// Folds a stream of per-id events into one net diff: add+update is an add,
+// add+remove cancels out, remove+add is an update. Each id appears at most
+// once in the result, in first-seen order.
+class ChangeSetAccumulator {
+public:
+  void added(const std::string &id) { record(id, Kind::Added); }
+  void updated(const std::string &id) { record(id, Kind::Updated); }
+  void removed(const std::string &id) { record(id, Kind::Removed); }
+  void merge(const LibraryChangeSet &changes);
+  [[nodiscard]] bool empty() const { return m_live == 0; }
+  // Returns the net diff and resets the accumulator.
+  LibraryChangeSet take();
+
+private:
+  enum class Kind { None, Added, Updated, Removed };
+  void record(const std::string &id, Kind kind);
+  std::unordered_map<std::string, Kind> m_state;
+  std::vector<std::string> m_order;
+  size_t m_live = 0;
+};
+// Thread-safe coalescing channel for change sets. push() may be called from
+// any thread; the first push after a flush asks `schedule` to run flush()
+// later (e.g. on the next main-loop iteration), and every push until then
+// folds into the same diff, so the sink sees at most one diff per scheduled
+// run however many transactions landed in between.
+class ChangeSetQueue {
+public:
+  using Schedule = std::function<void(std::function<void()> task)>;
+  using Sink = std::function<void(const LibraryChangeSet &changes)>;
+  ChangeSetQueue(Schedule schedule, Sink sink);
+  // Drops pending changes; a flush already scheduled becomes a no-op.
+  ~ChangeSetQueue();
+  ChangeSetQueue(const ChangeSetQueue &) = delete;
+  ChangeSetQueue &operator=(const ChangeSetQueue &) = delete;
+  void push(const LibraryChangeSet &changes);
+  // Delivers pending changes now, on the calling thread.
+  void flush();
+
+private:
+  struct State {
+    std::mutex mutex;
+    ChangeSetAccumulator pending;
+    bool scheduled = false;
+    Sink sink;
+  };
+  static void flushState(const std::shared_ptr<State> &state);
+  Schedule m_schedule;
+  std::shared_ptr<State> m_state;
+};
+} // namespace bwp::wallpaper
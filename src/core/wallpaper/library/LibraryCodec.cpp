@@ -0,0 +1,93 @@
+#include "LibraryCodec.hpp"
+namespace bwp::wallpaper {
+nlohmann::json LibraryCodec::toJson(const WallpaperInfo &info) {
+  nlohmann::json item;
+  item["id"] = info.id;
+  item["path"] = info.path;
+  item["title"] = info.title;
+  item["type"] = static_cast<int>(info.type);
+  item["rating"] = info.rating;
+  item["favorite"] = info.favorite;
+  item["play_count"] = info.play_count;
+  item["added"] = info.added;
+  item["last_used"] = info.last_used;
+  item["tags"] = info.tags;
+  item["source"] = info.source;
+  if (info.workshop_id != 0) {
+    item["workshop_id"] = info.workshop_id;
+  }
+  if (info.size_bytes != 0) {
+    item["size_bytes"] = info.size_bytes;
+  }
+  nlohmann::json settings;
+  settings["fps"] = info.settings.fps;
+  settings["volume"] = info.settings.volume;
+  settings["muted"] = info.settings.muted;
+  settings["playback_speed"] = info.settings.playback_speed;
+  settings["scaling"] = static_cast<int>(info.settings.scaling);
+  settings["no_audio_processing"] = info.settings.noAudioProcessing;
+  settings["disable_mouse"] = info.settings.disableMouse;
+  settings["no_automute"] = info.settings.noAutomute;
+  item["settings"] = settings;
+  if (!info.blurhash.empty()) {
+    item["blurhash"] = info.blurhash;
+  }
+  if (info.phash != 0) {
+    item["phash"] = info.phash;
+  }
+  if (info.width > 0 && info.height > 0) {
+    item["width"] = info.width;
+    item["height"] = info.height;
+  }
+  if (info.duration > 0.0) {
+    item["duration"] = info.duration;
+  }
+  if (info.frame_rate > 0.0) {
+    item["frame_rate"] = info.frame_rate;
+  }
+  if (!info.codec.empty()) {
+    item["codec"] = info.codec;
+  }
+  return item;
+}
+WallpaperInfo LibraryCodec::fromJson(const nlohmann::json &item) {
+  WallpaperInfo info;
+  info.id = item.value("id", "");
+  info.path = item.value("path", "");
+  info.title = item.value("title", "");
+  info.type = static_cast<WallpaperType>(item.value("type", 0));
+  info.source = item.value("source", std::string(""));
+  info.rating = item.value("rating", 0);
+  info.favorite = item.value("favorite", false);
+  info.play_count = item.value("play_count", 0);
+  info.added = item.value("added", 0LL);
+  info.last_used = item.value("last_used", 0LL);
+  info.workshop_id = item.value("workshop_id", uint64_t{0});
+  info.size_bytes = item.value("size_bytes", uint64_t{0});
+  if (item.contains("tags") && item["tags"].is_array()) {
+    for (const auto &tag : item["tags"]) {
+      if (tag.is_string())
+        info.tags.push_back(tag.get<std::string>());
+    }
+  }
+  if (item.contains("settings")) {
+    const auto &s = item["settings"];
+    info.settings.fps = s.value("fps", -1);
+    info.settings.volume = s.value("volume", -1);
+    info.settings.muted = s.value("muted", false);
+    info.settings.playback_speed = s.value("playback_speed", 1.0);
+    info.settings.scaling = static_cast<ScalingMode>(s.value("scaling", 0));
+    info.settings.noAudioProcessing = s.value("no_audio_processing", -1);
+    info.settings.disableMouse = s.value("disable_mouse", -1);
+    info.settings.noAutomute = s.value("no_automute", -1);
+  }
+  info.blurhash = item.value("blurhash", "");
+  info.phash = item.value("phash", uint64_t{0});
+  info.width = item.value("width", 0);
+  info.height = item.value("height", 0);
+  info.duration = item.value("duration", 0.0);
+  info.frame_rate = item.value("frame_rate", 0.0);
+  info.codec = item.value("codec", "");
+  return info;
+}
+} // namespace bwp::wallpaper
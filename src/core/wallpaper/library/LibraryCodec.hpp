@@ -0,0 +1,12 @@
+#pragma once
+#include "../WallpaperInfo.hpp"
+#include <nlohmann/json.hpp>
+namespace bwp::wallpaper {
+// Field-level (de)serialization of WallpaperInfo shared by the JSON
+// snapshot and the change journal so both stay in lockstep.
+class LibraryCodec {
+public:
+  static nlohmann::json toJson(const WallpaperInfo &info);
+  static WallpaperInfo fromJson(const nlohmann::json &item);
+};
+} // namespace bwp::wallpaper
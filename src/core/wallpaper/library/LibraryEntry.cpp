@@ -0,0 +1,126 @@
+#include "LibraryEntry.hpp"
+#include <algorithm>
+namespace bwp::wallpaper {
+const std::string *StringPool::intern(std::string_view value) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return &*m_strings.emplace(value).first;
+}
+size_t StringPool::size() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_strings.size();
+}
+LibraryEntry LibraryEntry::fromInfo(const WallpaperInfo &info,
+                                    StringPool &pool) {
+  LibraryEntry entry;
+  // Split before the second-to-last separator: "/a/b/c/d.jpg" is stored as
+  // root "/a/b/" and suffix "c/d.jpg".
+  std::string_view path = info.path;
+  size_t cut = path.find_last_of("/\\");
+  if (cut != std::string_view::npos && cut > 0) {
+    size_t parent = path.find_last_of("/\\", cut - 1);
+    if (parent != std::string_view::npos)
+      cut = parent;
+  }
+  size_t rootLength = cut == std::string_view::npos ? 0 : cut + 1;
+  std::string_view suffix = path.substr(rootLength);
+  entry.root = pool.intern(path.substr(0, rootLength));
+  entry.idLength = static_cast<uint32_t>(info.id.size());
+  entry.titleLength = static_cast<uint32_t>(info.title.size());
+  entry.suffixLength = static_cast<uint32_t>(suffix.size());
+  entry.blurhashLength = static_cast<uint32_t>(info.blurhash.size());
+  entry.text = std::make_unique<char[]>(info.id.size() + info.title.size() +
+                                        suffix.size() + info.blurhash.size());
+  char *out = entry.text.get();
+  for (std::string_view part : {std::string_view(info.id),
+                                std::string_view(info.title), suffix,
+                                std::string_view(info.blurhash)}) {
+    out = std::copy(part.begin(), part.end(), out);
+  }
+  entry.source = pool.intern(info.source);
+  entry.codec = pool.intern(info.codec);
+  entry.tags.reserve(info.tags.size());
+  for (const auto &tag : info.tags)
+    entry.tags.push_back(pool.intern(tag));
+  entry.workshopId = info.workshop_id;
+  entry.sizeBytes = info.size_bytes;
+  entry.phash = info.phash;
+  entry.added = info.added;
+  entry.lastUsed = info.last_used;
+  entry.playbackSpeed = info.settings.playback_speed;
+  entry.rating = info.rating;
+  entry.playCount = info.play_count;
+  entry.fps = info.settings.fps;
+  entry.volume = info.settings.volume;
+  entry.width = info.width;
+  entry.height = info.height;
+  entry.duration = info.duration;
+  entry.frameRate = info.frame_rate;
+  entry.type = static_cast<uint8_t>(info.type);
+  entry.scaling = static_cast<uint8_t>(info.settings.scaling);
+  entry.noAudioProcessing = static_cast<int8_t>(info.settings.noAudioProcessing);
+  entry.disableMouse = static_cast<int8_t>(info.settings.disableMouse);
+  entry.noAutomute = static_cast<int8_t>(info.settings.noAutomute);
+  entry.flags = (info.favorite ? kFavorite : 0) |
+                (info.settings.muted ? kMuted : 0) |
+                (info.isScanning ? kScanning : 0) |
+                (info.isAutoTagged ? kAutoTagged : 0);
+  return entry;
+}
+std::string WallpaperView::path() const {
+  std::string_view suffix = m_entry->suffix();
+  std::string path;
+  path.reserve(m_entry->root->size() + suffix.size());
+  path += *m_entry->root;
+  path += suffix;
+  return path;
+}
+std::string_view WallpaperView::filename() const {
+  std::string_view suffix = m_entry->suffix();
+  size_t slash = suffix.find_last_of("/\\");
+  return slash == std::string_view::npos ? suffix : suffix.substr(slash + 1);
+}
+bool WallpaperView::hasTag(std::string_view tag) const {
+  for (const auto *t : m_entry->tags) {
+    if (*t == tag)
+      return true;
+  }
+  return false;
+}
+WallpaperInfo WallpaperView::toInfo() const {
+  const LibraryEntry &e = *m_entry;
+  WallpaperInfo info;
+  info.id = e.id();
+  info.path = path();
+  info.title = e.title();
+  info.source = *e.source;
+  info.type = static_cast<WallpaperType>(e.type);
+  info.tags.reserve(e.tags.size());
+  for (const auto *tag : e.tags)
+    info.tags.push_back(*tag);
+  info.favorite = e.flags & LibraryEntry::kFavorite;
+  info.rating = e.rating;
+  info.play_count = e.playCount;
+  info.added = e.added;
+  info.last_used = e.lastUsed;
+  info.isScanning = e.flags & LibraryEntry::kScanning;
+  info.isAutoTagged = e.flags & LibraryEntry::kAutoTagged;
+  info.workshop_id = e.workshopId;
+  info.size_bytes = e.sizeBytes;
+  info.phash = e.phash;
+  info.width = e.width;
+  info.height = e.height;
+  info.duration = e.duration;
+  info.frame_rate = e.frameRate;
+  info.codec = *e.codec;
+  info.blurhash = e.blurhash();
+  info.settings.fps = e.fps;
+  info.settings.muted = e.flags & LibraryEntry::kMuted;
+  info.settings.volume = e.volume;
+  info.settings.playback_speed = e.playbackSpeed;
+  info.settings.scaling = static_cast<ScalingMode>(e.scaling);
+  info.settings.noAudioProcessing = e.noAudioProcessing;
+  info.settings.disableMouse = e.disableMouse;
+  info.settings.noAutomute = e.noAutomute;
+  return info;
+}
+} // namespace bwp::wallpaper
@@ -0,0 +1,119 @@
+#pragma once
+#include "../WallpaperInfo.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+namespace bwp::wallpaper {
+// Append-only intern table for low-cardinality strings (sources, tags,
+// directory roots). Returned pointers stay valid for the pool's lifetime and
+// may be dereferenced from any thread without locking.
+class StringPool {
+public:
+  const std::string *intern(std::string_view value);
+  size_t size() const;
+
+private:
+  mutable std::mutex m_mutex;
+  std::unordered_set<std::string> m_strings; // node-based: stable addresses
+};
+// In-library storage for one wallpaper. Repeated values are pool pointers
+// and the path is split into an interned directory root plus the last two
+// components, so workshop items share ".../431960/" and local files share
+// their folder. The per-entry strings (id, title, path suffix, blurhash) are
+// packed back to back into a single allocation.
+struct LibraryEntry {
+  enum Flags : uint8_t {
+    kFavorite = 1 << 0,
+    kMuted = 1 << 1,
+    kScanning = 1 << 2,
+    kAutoTagged = 1 << 3,
+  };
+  std::unique_ptr<char[]> text;
+  uint32_t idLength = 0;
+  uint32_t titleLength = 0;
+  uint32_t suffixLength = 0;
+  uint32_t blurhashLength = 0;
+  const std::string *root = nullptr;
+  const std::string *source = nullptr;
+  const std::string *codec = nullptr;
+  std::vector<const std::string *> tags;
+  uint64_t workshopId = 0;
+  uint64_t sizeBytes = 0;
+  uint64_t phash = 0;
+  int64_t added = 0;
+  int64_t lastUsed = 0;
+  double playbackSpeed = 1.0;
+  int32_t rating = 0;
+  int32_t playCount = 0;
+  int32_t fps = -1;
+  int32_t volume = -1;
+  int32_t width = 0;
+  int32_t height = 0;
+  double duration = 0.0;
+  double frameRate = 0.0;
+  uint8_t type = 0;
+  uint8_t scaling = 0;
+  int8_t noAudioProcessing = -1;
+  int8_t disableMouse = -1;
+  int8_t noAutomute = -1;
+  uint8_t flags = 0;
+  std::string_view id() const { return {text.get(), idLength}; }
+  std::string_view title() const {
+    return {text.get() + idLength, titleLength};
+  }
+  std::string_view suffix() const {
+    return {text.get() + idLength + titleLength, suffixLength};
+  }
+  std::string_view blurhash() const {
+    return {text.get() + idLength + titleLength + suffixLength,
+            blurhashLength};
+  }
+  static LibraryEntry fromInfo(const WallpaperInfo &info, StringPool &pool);
+};
+// Thin read-only accessor over a LibraryEntry. Cheap to copy; valid while
+// the snapshot (or store) it came from is alive. Empty views compare false.
+class WallpaperView {
+public:
+  WallpaperView() = default;
+  explicit WallpaperView(const LibraryEntry *entry) : m_entry(entry) {}
+  explicit operator bool() const { return m_entry != nullptr; }
+  std::string_view id() const { return m_entry->id(); }
+  std::string_view title() const { return m_entry->title(); }
+  const std::string &source() const { return *m_entry->source; }
+  std::string_view blurhash() const { return m_entry->blurhash(); }
+  std::string path() const;
+  // Final path component, without building the full path.
+  std::string_view filename() const;
+  WallpaperType type() const {
+    return static_cast<WallpaperType>(m_entry->type);
+  }
+  bool favorite() const { return m_entry->flags & LibraryEntry::kFavorite; }
+  int rating() const { return m_entry->rating; }
+  int playCount() const { return m_entry->playCount; }
+  long long added() const { return m_entry->added; }
+  long long lastUsed() const { return m_entry->lastUsed; }
+  uint64_t workshopId() const { return m_entry->workshopId; }
+  uint64_t sizeBytes() const { return m_entry->sizeBytes; }
+  uint64_t phash() const { return m_entry->phash; }
+  int width() const { return m_entry->width; }
+  int height() const { return m_entry->height; }
+  double duration() const { return m_entry->duration; }
+  double frameRate() const { return m_entry->frameRate; }
+  const std::string &codec() const { return *m_entry->codec; }
+  size_t tagCount() const { return m_entry->tags.size(); }
+  const std::string &tag(size_t index) const { return *m_entry->tags[index]; }
+  bool hasTag(std::string_view tag) const;
+  WallpaperInfo toInfo() const;
+  const LibraryEntry *entry() const { return m_entry; }
+  bool operator==(const WallpaperView &other) const {
+    return m_entry == other.m_entry;
+  }
+
+private:
+  const LibraryEntry *m_entry = nullptr;
+};
+} // namespace bwp::wallpaper
@@ -0,0 +1,179 @@
+#include "LibraryJournal.hpp"
+#include "../../utils/Logger.hpp"
+#include "LibraryCodec.hpp"
+#include <fstream>
+#include <nlohmann/json.hpp>
+namespace bwp::wallpaper {
+LibraryJournal::LibraryJournal(std::filesystem::path path)
+    : m_path(std::move(path)) {
+  m_rotatedPath = m_path;
+  m_rotatedPath += ".compacting";
+}
+LibraryJournal::~LibraryJournal() { close(); }
+std::string LibraryJournal::encodePut(const WallpaperInfo &info) {
+  nlohmann::json j;
+  j["op"] = "put";
+  j["wp"] = LibraryCodec::toJson(info);
+  return j.dump() + "\n";
+}
+std::string LibraryJournal::encodeRemove(const std::string &id) {
+  nlohmann::json j;
+  j["op"] = "del";
+  j["id"] = id;
+  return j.dump() + "\n";
+}
+bool LibraryJournal::openForAppend() {
+  if (m_file)
+    return true;
+  std::error_code ec;
+  std::filesystem::create_directories(m_path.parent_path(), ec);
+  m_file = std::fopen(m_path.string().c_str(), "ab");
+  if (!m_file) {
+    LOG_ERROR("Failed to open library journal: " + m_path.string());
+    return false;
+  }
+  return true;
+}
+bool LibraryJournal::append(const std::string &lines, size_t recordCount) {
+  if (lines.empty())
+    return true;
+  if (!openForAppend())
+    return false;
+  // A single fwrite + fflush per call keeps a batch contiguous on disk and
+  // hands it to the kernel, so a process crash can at worst tear the tail.
+  if (std::fwrite(lines.data(), 1, lines.size(), m_file) != lines.size() ||
+      std::fflush(m_file) != 0) {
+    LOG_ERROR("Failed to append to library journal: " + m_path.string());
+    return false;
+  }
+  m_pendingRecords += recordCount;
+  m_pendingBytes += lines.size();
+  return true;
+}
+size_t LibraryJournal::replayFile(const std::filesystem::path &file,
+                                  const ReplayCallback &callback) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in.is_open())
+    return 0;
+  size_t applied = 0;
+  size_t goodBytes = 0;
+  size_t readBytes = 0;
+  bool tornTail = false;
+  std::string line;
+  while (std::getline(in, line)) {
+    bool terminated = !in.eof();
+    readBytes += line.size() + (terminated ? 1 : 0);
+    if (!terminated) {
+      // Last write was interrupted before its newline made it to disk.
+      tornTail = true;
+      break;
+    }
+    if (line.empty()) {
+      goodBytes = readBytes;
+      continue;
+    }
+    try {
+      nlohmann::json j = nlohmann::json::parse(line);
+      Record record;
+      std::string op = j.value("op", "");
+      if (op == "put" && j.contains("wp")) {
+        record.op = Op::Put;
+        record.info = LibraryCodec::fromJson(j["wp"]);
+        record.id = record.info.id;
+      } else if (op == "del") {
+        record.op = Op::Remove;
+        record.id = j.value("id", "");
+      } else {
+        LOG_WARN("Skipping unknown library journal record in " +
+                 file.string());
+        goodBytes = readBytes;
+        continue;
+      }
+      if (!record.id.empty()) {
+        callback(std::move(record));
+        applied++;
+      }
+    } catch (const std::exception &e) {
+      LOG_WARN("Skipping corrupt library journal record: " +
+               std::string(e.what()));
+    }
+    goodBytes = readBytes;
+  }
+  in.close();
+  if (tornTail) {
+    LOG_WARN("Discarding torn tail of library journal " + file.string());
+    std::error_code ec;
+    std::filesystem::resize_file(file, goodBytes, ec);
+  }
+  return applied;
+}
+size_t LibraryJournal::replay(const ReplayCallback &callback) {
+  close();
+  size_t applied = 0;
+  std::error_code ec;
+  if (std::filesystem::exists(m_rotatedPath, ec)) {
+    applied += replayFile(m_rotatedPath, callback);
+  }
+  size_t active = 0;
+  if (std::filesystem::exists(m_path, ec)) {
+    active = replayFile(m_path, callback);
+    applied += active;
+  }
+  m_pendingRecords = applied;
+  m_pendingBytes = std::filesystem::exists(m_path, ec)
+                       ? std::filesystem::file_size(m_path, ec)
+                       : 0;
+  return applied;
+}
+bool LibraryJournal::rotate() {
+  close();
+  std::error_code ec;
+  if (!std::filesystem::exists(m_path, ec)) {
+    m_pendingRecords = 0;
+    m_pendingBytes = 0;
+    return true;
+  }
+  if (std::filesystem::exists(m_rotatedPath, ec)) {
+    // A previous compaction never finished; fold the active journal into
+    // the pending rotation instead of overwriting it.
+    std::ifstream in(m_path, std::ios::binary);
+    std::ofstream out(m_rotatedPath, std::ios::binary | std::ios::app);
+    out << in.rdbuf();
+    out.close();
+    in.close();
+    if (out.fail()) {
+      LOG_ERROR("Failed to merge library journal into pending rotation");
+      return false;
+    }
+    std::filesystem::remove(m_path, ec);
+  } else {
+    std::filesystem::rename(m_path, m_rotatedPath, ec);
+    if (ec) {
+      LOG_ERROR("Failed to rotate library journal: " + ec.message());
+      return false;
+    }
+  }
+  m_pendingRecords = 0;
+  m_pendingBytes = 0;
+  return true;
+}
+void LibraryJournal::discardRotated() {
+  std::error_code ec;
+  std::filesystem::remove(m_rotatedPath, ec);
+}
+bool LibraryJournal::emptyOnDisk() const {
+  std::error_code ec;
+  for (const auto &file : {m_path, m_rotatedPath}) {
+    auto size = std::filesystem::file_size(file, ec);
+    if (!ec && size > 0)
+      return false;
+  }
+  return true;
+}
+void LibraryJournal::close() {
+  if (m_file) {
+    std::fclose(m_file);
+    m_file = nullptr;
+  }
+}
+} // namespace bwp::wallpaper
@@ -0,0 +1,50 @@
+#pragma once
+#include "../WallpaperInfo.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <string>
+namespace bwp::wallpaper {
+// Append-only log of per-entry library mutations (one JSON object per line).
+// The active journal is rotated aside while a compaction writes the new
+// snapshot, so replaying "rotated, then active" on top of the last snapshot
+// always reconstructs the latest state. Records are idempotent (full puts
+// and removes), which makes replaying an already-compacted rotation harmless.
+class LibraryJournal {
+public:
+  enum class Op { Put, Remove };
+  struct Record {
+    Op op = Op::Put;
+    std::string id;
+    WallpaperInfo info;
+  };
+  using ReplayCallback = std::function<void(Record &&record)>;
+  explicit LibraryJournal(std::filesystem::path path);
+  ~LibraryJournal();
+  LibraryJournal(const LibraryJournal &) = delete;
+  LibraryJournal &operator=(const LibraryJournal &) = delete;
+  static std::string encodePut(const WallpaperInfo &info);
+  static std::string encodeRemove(const std::string &id);
+  // `lines` must be one or more newline-terminated encoded records.
+  bool append(const std::string &lines, size_t recordCount);
+  size_t replay(const ReplayCallback &callback);
+  bool rotate();
+  void discardRotated();
+  void close();
+  // True when neither the active nor a rotated journal holds any records.
+  bool emptyOnDisk() const;
+  size_t pendingRecords() const { return m_pendingRecords; }
+  size_t pendingBytes() const { return m_pendingBytes; }
+  const std::filesystem::path &path() const { return m_path; }
+
+private:
+  bool openForAppend();
+  size_t replayFile(const std::filesystem::path &file,
+                    const ReplayCallback &callback);
+  std::filesystem::path m_path;
+  std::filesystem::path m_rotatedPath;
+  FILE *m_file = nullptr;
+  size_t m_pendingRecords = 0;
+  size_t m_pendingBytes = 0;
+};
+} // namespace bwp::wallpaper
@@ -0,0 +1,332 @@
+#include "LibraryQuery.hpp"
+#include "../../utils/StringUtils.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+namespace bwp::wallpaper {
+namespace {
+std::vector<std::string> tokenize(std::string_view text, std::string *error) {
+  std::vector<std::string> tokens;
+  std::string current;
+  bool quoted = false;
+  bool inToken = false;
+  for (char c : text) {
+    if (c == '"') {
+      quoted = !quoted;
+      inToken = true;
+    } else if (!quoted && (c == ' ' || c == '\t' || c == '\n')) {
+      if (inToken)
+        tokens.push_back(std::move(current));
+      current.clear();
+      inToken = false;
+    } else {
+      current += c;
+      inToken = true;
+    }
+  }
+  if (quoted && error)
+    *error = "unterminated quote";
+  if (inToken)
+    tokens.push_back(std::move(current));
+  return tokens;
+}
+std::vector<std::string> splitAlternatives(const std::string &value) {
+  std::vector<std::string> parts;
+  size_t start = 0;
+  while (start <= value.size()) {
+    size_t bar = value.find('|', start);
+    if (bar == std::string::npos)
+      bar = value.size();
+    if (bar > start)
+      parts.push_back(value.substr(start, bar - start));
+    start = bar + 1;
+  }
+  return parts;
+}
+std::optional<WallpaperType> typeNamed(const std::string &name) {
+  if (name == "image" || name == "static")
+    return WallpaperType::StaticImage;
+  if (name == "gif" || name == "animated")
+    return WallpaperType::AnimatedImage;
+  if (name == "video")
+    return WallpaperType::Video;
+  if (name == "scene")
+    return WallpaperType::WEScene;
+  if (name == "wevideo")
+    return WallpaperType::WEVideo;
+  if (name == "web")
+    return WallpaperType::WEWeb;
+  return std::nullopt;
+}
+std::optional<int64_t> parseInteger(std::string_view text) {
+  int64_t value = 0;
+  auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (ec != std::errc() || end != text.data() + text.size())
+    return std::nullopt;
+  return value;
+}
+// "90", "15m", "12h", "7d", "2w" -> seconds; nullopt if not a duration.
+std::optional<int64_t> parseDuration(std::string_view text) {
+  if (text.size() < 2)
+    return std::nullopt;
+  int64_t unit = 0;
+  switch (text.back()) {
+  case 's': unit = 1; break;
+  case 'm': unit = 60; break;
+  case 'h': unit = 3600; break;
+  case 'd': unit = 86400; break;
+  case 'w': unit = 7 * 86400; break;
+  default: return std::nullopt;
+  }
+  auto count = parseInteger(text.substr(0, text.size() - 1));
+  if (!count || *count < 0)
+    return std::nullopt;
+  return *count * unit;
+}
+void applyBound(LibraryQuery::Range &range, std::string_view op,
+                int64_t value) {
+  using Limits = std::numeric_limits<int64_t>;
+  if (op == "=" || op == ":") {
+    range.min = std::max(range.min, value);
+    range.max = std::min(range.max, value);
+  } else if (op == ">") {
+    range.min = std::max(range.min, value == Limits::max() ? value : value + 1);
+  } else if (op == ">=") {
+    range.min = std::max(range.min, value);
+  } else if (op == "<") {
+    range.max = std::min(range.max, value == Limits::min() ? value : value - 1);
+  } else if (op == "<=") {
+    range.max = std::min(range.max, value);
+  }
+}
+std::string_view flipped(std::string_view op) {
+  if (op == "<")
+    return ">";
+  if (op == "<=")
+    return ">=";
+  if (op == ">")
+    return "<";
+  if (op == ">=")
+    return "<=";
+  return op;
+}
+bool containsLower(std::string_view haystack, const std::string &needle) {
+  return utils::StringUtils::toLower(std::string(haystack)).find(needle) !=
+         std::string::npos;
+}
+bool textMatches(const WallpaperView &view, const std::string &word) {
+  if (containsLower(view.title(), word) ||
+      containsLower(view.filename(), word))
+    return true;
+  for (size_t i = 0; i < view.tagCount(); ++i) {
+    if (containsLower(view.tag(i), word))
+      return true;
+  }
+  return false;
+}
+} // namespace
+std::optional<LibraryQuery> LibraryQuery::parse(std::string_view text,
+                                                std::string *error,
+                                                int64_t now) {
+  if (now == 0) {
+    now = std::chrono::duration_cast<std::chrono::seconds>(
+              std::chrono::system_clock::now().time_since_epoch())
+              .count();
+  }
+  std::string tokenError;
+  auto tokens = tokenize(text, &tokenError);
+  auto fail = [error](std::string message) -> std::optional<LibraryQuery> {
+    if (error)
+      *error = std::move(message);
+    return std::nullopt;
+  };
+  if (!tokenError.empty())
+    return fail(tokenError);
+  LibraryQuery q;
+  for (const auto &token : tokens) {
+    bool negated = token.size() > 1 && token[0] == '-';
+    std::string term = negated ? token.substr(1) : token;
+    // Comparison terms: field op value.
+    size_t opPos = term.find_first_of("<>=");
+    size_t colon = term.find(':');
+    if (opPos != std::string::npos &&
+        (colon == std::string::npos || opPos < colon)) {
+      std::string field = utils::StringUtils::toLower(term.substr(0, opPos));
+      size_t opLen = (opPos + 1 < term.size() && term[opPos + 1] == '=' &&
+                      term[opPos] != '=')
+                         ? 2
+                         : 1;
+      std::string_view op(term.data() + opPos, opLen);
+      std::string_view value(term.data() + opPos + opLen,
+                             term.size() - opPos - opLen);
+      if (negated)
+        return fail("comparisons cannot be negated: " + token);
+      Range *range = nullptr;
+      bool timestamp = false;
+      bool length = false;
+      if (field == "rating")
+        range = &q.rating;
+      else if (field == "plays")
+        range = &q.plays;
+      else if (field == "size")
+        range = &q.size;
+      else if (field == "added")
+        range = &q.added, timestamp = true;
+      else if (field == "used" || field == "last_used")
+        range = &q.lastUsed, timestamp = true;
+      else if (field == "width")
+        range = &q.width;
+      else if (field == "height")
+        range = &q.height;
+      else if (field == "duration" || field == "length")
+        range = &q.duration, length = true;
+      else if (field == "fps")
+        range = &q.frameRate;
+      else
+        return fail("unknown field: " + field);
+      if (timestamp) {
+        if (auto age = parseDuration(value)) {
+          // "added<7d" reads as "added less than 7 days ago".
+          applyBound(*range, flipped(op), now - *age);
+          continue;
+        }
+      }
+      if (length) {
+        if (auto seconds = parseDuration(value)) {
+          applyBound(*range, op, *seconds);
+          continue;
+        }
+      }
+      auto number = parseInteger(value);
+      if (!number)
+        return fail("expected a number in " + token);
+      applyBound(*range, op, *number);
+      continue;
+    }
+    if (colon != std::string::npos && colon > 0) {
+      std::string key = utils::StringUtils::toLower(term.substr(0, colon));
+      std::string value = term.substr(colon + 1);
+      if (key == "tag") {
+        auto tags = splitAlternatives(value);
+        if (tags.empty())
+          return fail("empty tag in " + token);
+        if (negated) {
+          q.tagsNone.insert(q.tagsNone.end(), tags.begin(), tags.end());
+        } else if (tags.size() == 1) {
+          q.tagsAll.push_back(tags[0]);
+        } else {
+          if (!q.tagsAny.empty())
+            return fail("only one tag:a|b group is supported");
+          q.tagsAny = tags;
+        }
+      } else if (key == "type") {
+        if (negated)
+          return fail("type cannot be negated: " + token);
+        for (const auto &name : splitAlternatives(value)) {
+          auto type = typeNamed(utils::StringUtils::toLower(name));
+          if (!type)
+            return fail("unknown type: " + name);
+          q.types.push_back(*type);
+        }
+      } else if (key == "source") {
+        if (negated)
+          return fail("source cannot be negated: " + token);
+        for (const auto &source : splitAlternatives(value))
+          q.sources.push_back(utils::StringUtils::toLower(source));
+      } else if (key == "codec") {
+        if (negated)
+          return fail("codec cannot be negated: " + token);
+        for (const auto &codec : splitAlternatives(value))
+          q.codecs.push_back(utils::StringUtils::toLower(codec));
+      } else if (key == "is") {
+        std::string flag = utils::StringUtils::toLower(value);
+        if (flag != "fav" && flag != "favorite" && flag != "favourite")
+          return fail("unknown flag: " + value);
+        q.favorite = !negated;
+      } else if (key == "sort") {
+        std::string name = utils::StringUtils::toLower(value);
+        std::optional<bool> direction;
+        if (auto dir = name.rfind(':'); dir != std::string::npos) {
+          std::string suffix = name.substr(dir + 1);
+          if (suffix != "asc" && suffix != "desc")
+            return fail("sort direction must be asc or desc: " + token);
+          direction = suffix == "desc";
+          name.resize(dir);
+        }
+        if (name == "name" || name == "title")
+          q.sort = SortKey::Name;
+        else if (name == "added")
+          q.sort = SortKey::Added;
+        else if (name == "used" || name == "last_used")
+          q.sort = SortKey::LastUsed;
+        else if (name == "rating")
+          q.sort = SortKey::Rating;
+        else if (name == "plays")
+          q.sort = SortKey::Plays;
+        else if (name == "size")
+          q.sort = SortKey::Size;
+        else
+          return fail("unknown sort key: " + name);
+        // Names read A-Z by default, everything else largest/newest first.
+        q.descending = direction.value_or(q.sort != SortKey::Name);
+      } else if (key == "limit") {
+        auto n = parseInteger(value);
+        if (!n || *n < 0)
+          return fail("limit must be a non-negative number");
+        q.limit = static_cast<size_t>(*n);
+      } else {
+        return fail("unknown filter: " + key);
+      }
+      continue;
+    }
+    std::string word = utils::StringUtils::toLower(term);
+    if (word.empty())
+      continue;
+    (negated ? q.excludedWords : q.words).push_back(std::move(word));
+  }
+  return q;
+}
+bool LibraryQuery::matches(const WallpaperView &view) const {
+  for (const auto &tag : tagsAll) {
+    if (!view.hasTag(tag))
+      return false;
+  }
+  for (const auto &tag : tagsNone) {
+    if (view.hasTag(tag))
+      return false;
+  }
+  if (!tagsAny.empty() &&
+      std::none_of(tagsAny.begin(), tagsAny.end(),
+                   [&view](const std::string &t) { return view.hasTag(t); }))
+    return false;
+  if (!types.empty() &&
+      std::find(types.begin(), types.end(), view.type()) == types.end())
+    return false;
+  if (!sources.empty() &&
+      std::find(sources.begin(), sources.end(),
+                utils::StringUtils::toLower(view.source())) == sources.end())
+    return false;
+  if (!codecs.empty() &&
+      std::find(codecs.begin(), codecs.end(), view.codec()) == codecs.end())
+    return false;
+  if (favorite && view.favorite() != *favorite)
+    return false;
+  if (!rating.contains(view.rating()) || !plays.contains(view.playCount()) ||
+      !added.contains(view.added()) || !lastUsed.contains(view.lastUsed()) ||
+      !size.contains(static_cast<int64_t>(view.sizeBytes())) ||
+      !width.contains(view.width()) || !height.contains(view.height()) ||
+      !duration.contains(std::llround(view.duration())) ||
+      !frameRate.contains(std::llround(view.frameRate())))
+    return false;
+  for (const auto &word : words) {
+    if (!textMatches(view, word))
+      return false;
+  }
+  for (const auto &word : excludedWords) {
+    if (textMatches(view, word))
+      return false;
+  }
+  return true;
+}
+} // namespace bwp::wallpaper
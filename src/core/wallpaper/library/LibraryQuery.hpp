@@ -0,0 +1,67 @@
+#pragma once
+#include "../WallpaperInfo.hpp"
+#include "LibraryEntry.hpp"
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+namespace bwp::wallpaper {
+// Parsed form of the library query language shared by the GUI, the CLI
+// (`bwp query`) and the D-Bus Query method. Terms are separated by spaces
+// and AND-ed; values may be double-quoted.
+//
+//   word  -word               text in title, filename or tags
+//   tag:dark  tag:a|b  -tag:x all / any-of / none
+//   type:video|image|gif|scene|web|wevideo   (repeat or '|' for any-of)
+//   source:workshop  is:fav  -is:fav
+//   rating>=3  plays>0  size<10000000         (ops: = : < <= > >=)
+//   added<7d  used<=12h                       durations compare age
+//   added>=1700000000                         plain numbers are unix time
+//   width>=3840  height<1080  fps>=60         media headers; 0 when unknown
+//   duration<30  duration>=2m                 length in (rounded) seconds
+//   codec:h264|vp9
+//   sort:name|added|used|rating|plays|size[:asc|:desc]  limit:50
+//
+// Indexed terms (tag, type, rating, favourite, text) only narrow the
+// candidates; matches() re-checks every term against the entry.
+struct LibraryQuery {
+  enum class SortKey { None, Name, Added, LastUsed, Rating, Plays, Size };
+  struct Range {
+    int64_t min = std::numeric_limits<int64_t>::min();
+    int64_t max = std::numeric_limits<int64_t>::max();
+    bool active() const {
+      return min != std::numeric_limits<int64_t>::min() ||
+             max != std::numeric_limits<int64_t>::max();
+    }
+    bool contains(int64_t v) const { return v >= min && v <= max; }
+  };
+  std::vector<std::string> words;
+  std::vector<std::string> excludedWords;
+  std::vector<std::string> tagsAll;
+  std::vector<std::string> tagsAny;
+  std::vector<std::string> tagsNone;
+  std::vector<WallpaperType> types;
+  std::vector<std::string> sources;
+  std::vector<std::string> codecs;
+  std::optional<bool> favorite;
+  Range rating;
+  Range plays;
+  Range size;
+  Range added;
+  Range lastUsed;
+  Range width;
+  Range height;
+  Range duration;
+  Range frameRate;
+  SortKey sort = SortKey::None;
+  bool descending = false;
+  size_t limit = 0; // 0: unlimited
+  // `now` anchors relative durations; 0 means the current time.
+  static std::optional<LibraryQuery> parse(std::string_view text,
+                                           std::string *error = nullptr,
+                                           int64_t now = 0);
+  bool matches(const WallpaperView &view) const;
+};
+} // namespace bwp::wallpaper
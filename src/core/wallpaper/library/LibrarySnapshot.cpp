@@ -0,0 +1,83 @@
+#include "LibrarySnapshot.hpp"
+namespace bwp::wallpaper {
+size_t LibrarySnapshot::shardOf(std::string_view id) {
+  // Take the high bits of a mixed hash so shard choice does not correlate
+  // with the bucket choice of the per-shard unordered_map.
+  uint64_t h = std::hash<std::string_view>{}(id) * 0x9E3779B97F4A7C15ULL;
+  return static_cast<size_t>(h >> 58);
+}
+WallpaperView LibrarySnapshot::find(std::string_view id) const {
+  const auto &shard = *m_shards[shardOf(id)];
+  auto it = shard.find(id);
+  return it == shard.end() ? WallpaperView() : WallpaperView(it->second.get());
+}
+LibrarySnapshot::Entry LibrarySnapshot::get(std::string_view id) const {
+  const auto &shard = *m_shards[shardOf(id)];
+  auto it = shard.find(id);
+  return it == shard.end() ? nullptr : it->second;
+}
+std::vector<WallpaperInfo> LibrarySnapshot::values() const {
+  std::vector<WallpaperInfo> result;
+  result.reserve(m_size);
+  forEach([&result](WallpaperView view) { result.push_back(view.toInfo()); });
+  return result;
+}
+LibraryStore::LibraryStore() {
+  for (auto &shard : m_shards)
+    shard = std::make_shared<LibrarySnapshot::Shard>();
+}
+LibrarySnapshot::Shard &LibraryStore::writableShard(size_t index) {
+  if (m_shared.test(index)) {
+    m_shards[index] = std::make_shared<LibrarySnapshot::Shard>(*m_shards[index]);
+    m_shared.reset(index);
+  }
+  return *m_shards[index];
+}
+WallpaperView LibraryStore::find(std::string_view id) const {
+  const auto &shard = *m_shards[LibrarySnapshot::shardOf(id)];
+  auto it = shard.find(id);
+  return it == shard.end() ? WallpaperView() : WallpaperView(it->second.get());
+}
+void LibraryStore::put(const WallpaperInfo &info) {
+  auto &shard = writableShard(LibrarySnapshot::shardOf(info.id));
+  auto entry = std::make_shared<const LibraryEntry>(
+      LibraryEntry::fromInfo(info, *m_pool));
+  // The key views the entry's id, so a replaced entry must take its key
+  // with it.
+  if (shard.erase(entry->id()) == 0)
+    m_size++;
+  std::string_view key = entry->id();
+  shard.emplace(key, std::move(entry));
+}
+bool LibraryStore::erase(std::string_view id) {
+  size_t index = LibrarySnapshot::shardOf(id);
+  if (!m_shards[index]->count(id))
+    return false;
+  writableShard(index).erase(id);
+  m_size--;
+  return true;
+}
+void LibraryStore::clear() {
+  for (auto &shard : m_shards)
+    shard = std::make_shared<LibrarySnapshot::Shard>();
+  m_shared.reset();
+  // Published snapshots keep the old pool alive; start a fresh one so tags
+  // and roots that no longer exist are not retained.
+  m_pool = std::make_shared<StringPool>();
+  m_size = 0;
+}
+void LibraryStore::reserve(size_t count) {
+  for (size_t i = 0; i < m_shards.size(); ++i)
+    writableShard(i).reserve(count / LibrarySnapshot::kShards + 1);
+}
+std::shared_ptr<const LibrarySnapshot> LibraryStore::publish() {
+  auto snapshot = std::make_shared<LibrarySnapshot>();
+  for (size_t i = 0; i < m_shards.size(); ++i)
+    snapshot->m_shards[i] = m_shards[i];
+  snapshot->m_pool = m_pool;
+  snapshot->m_size = m_size;
+  snapshot->m_version = ++m_version;
+  m_shared.set();
+  return snapshot;
+}
+} // namespace bwp::wallpaper
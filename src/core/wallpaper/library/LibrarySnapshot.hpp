@@ -0,0 +1,82 @@
+#pragma once
+#include "LibraryEntry.hpp"
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+namespace bwp::wallpaper {
+// Immutable, versioned view of the library. Readers obtain one with
+// WallpaperLibrary::snapshot() and may iterate it or hold references into it
+// for as long as they keep the shared_ptr; writers never touch a published
+// snapshot.
+//
+// Entries are split across kShards hash shards. Publishing after a write
+// copies only the shards that changed (and the entry pointers inside them),
+// so a single mutation costs O(n / kShards) rather than O(n).
+//
+// Entries are stored as compact LibraryEntry records (see LibraryEntry.hpp)
+// and handed out as WallpaperView; shard maps key on a view of the entry's
+// own id so the id is not stored twice.
+class LibrarySnapshot {
+public:
+  static constexpr size_t kShards = 64;
+  using Entry = std::shared_ptr<const LibraryEntry>;
+  using Shard = std::unordered_map<std::string_view, Entry>;
+  size_t size() const { return m_size; }
+  uint64_t version() const { return m_version; }
+  // The view stays valid while this snapshot is alive; empty if missing.
+  WallpaperView find(std::string_view id) const;
+  Entry get(std::string_view id) const;
+  template <typename Fn> void forEach(Fn &&fn) const {
+    for (const auto &shard : m_shards) {
+      for (const auto &[id, entry] : *shard)
+        fn(WallpaperView(entry.get()));
+    }
+  }
+  std::vector<WallpaperInfo> values() const;
+  static size_t shardOf(std::string_view id);
+
+private:
+  friend class LibraryStore;
+  std::shared_ptr<const StringPool> m_pool; // keeps interned strings alive
+  std::array<std::shared_ptr<const Shard>, kShards> m_shards;
+  size_t m_size = 0;
+  uint64_t m_version = 0;
+};
+// Writer-side storage behind WallpaperLibrary. Mutations copy a shard the
+// first time it is touched after a publish(); later mutations of the same
+// shard before the next publish() reuse that private copy.
+class LibraryStore {
+public:
+  LibraryStore();
+  size_t size() const { return m_size; }
+  WallpaperView find(std::string_view id) const;
+  bool contains(std::string_view id) const { return bool(find(id)); }
+  void put(const WallpaperInfo &info);
+  bool erase(std::string_view id);
+  void clear();
+  void reserve(size_t count);
+  template <typename Fn> void forEach(Fn &&fn) const {
+    for (const auto &shard : m_shards) {
+      for (const auto &[id, entry] : *shard)
+        fn(WallpaperView(entry.get()));
+    }
+  }
+  const StringPool &pool() const { return *m_pool; }
+  // Freezes the current state into a new snapshot.
+  std::shared_ptr<const LibrarySnapshot> publish();
+
+private:
+  LibrarySnapshot::Shard &writableShard(size_t index);
+  std::shared_ptr<StringPool> m_pool = std::make_shared<StringPool>();
+  std::array<std::shared_ptr<LibrarySnapshot::Shard>, LibrarySnapshot::kShards>
+      m_shards;
+  std::bitset<LibrarySnapshot::kShards> m_shared;
+  size_t m_size = 0;
+  uint64_t m_version = 0;
+};
+} // namespace bwp::wallpaper
@@ -0,0 +1,51 @@
+#include "PathValidator.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <thread>
+namespace bwp::wallpaper {
+namespace {
+void check(PathCheck &c) {
+  std::error_code ec;
+  bool exists = std::filesystem::exists(c.path, ec);
+  if (ec) {
+    // EIO, EACCES, a stale mount: not proof the file is gone.
+    c.state = PathCheck::State::Unknown;
+    c.canonical = c.path;
+    return;
+  }
+  if (!exists) {
+    c.state = PathCheck::State::Missing;
+    c.canonical = c.path;
+    return;
+  }
+  c.state = PathCheck::State::Present;
+  auto canonical = std::filesystem::canonical(c.path, ec);
+  c.canonical = ec ? c.path : canonical.string();
+}
+} // namespace
+bool PathValidator::run(std::vector<PathCheck> &checks, unsigned workers,
+                        const std::atomic<bool> *stop) {
+  if (workers == 0)
+    workers = std::clamp(std::thread::hardware_concurrency(), 1u, kMaxWorkers);
+  size_t batches = (checks.size() + kBatchSize - 1) / kBatchSize;
+  workers = static_cast<unsigned>(std::min<size_t>(workers, batches));
+  std::atomic<size_t> next{0};
+  auto work = [&] {
+    while (!stop || !stop->load(std::memory_order_relaxed)) {
+      size_t begin = next.fetch_add(kBatchSize, std::memory_order_relaxed);
+      if (begin >= checks.size())
+        return;
+      size_t end = std::min(begin + kBatchSize, checks.size());
+      for (size_t i = begin; i < end; ++i)
+        check(checks[i]);
+    }
+  };
+  std::vector<std::thread> pool;
+  for (unsigned i = 1; i < workers; ++i)
+    pool.emplace_back(work);
+  work();
+  for (auto &thread : pool)
+    thread.join();
+  return !stop || !stop->load();
+}
+} // namespace bwp::wallpaper
@@ -0,0 +1,27 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <vector>
+namespace bwp::wallpaper {
+// Parallel existence check and canonicalization for library paths. Each
+// worker claims fixed-size batches from a shared cursor, so one slow
+// directory (a sleeping disk, a network-mounted Steam library) only stalls
+// its own batch.
+struct PathCheck {
+  enum class State { Pending, Present, Missing, Unknown };
+  std::string id;
+  std::string path;
+  State state = State::Pending;
+  // Canonical form when Present, otherwise the original path.
+  std::string canonical;
+};
+class PathValidator {
+public:
+  static constexpr size_t kBatchSize = 64;
+  static constexpr unsigned kMaxWorkers = 8;
+  // Fills in state/canonical for every check. Returns false if `stop` was
+  // raised first; unvisited checks stay Pending.
+  static bool run(std::vector<PathCheck> &checks, unsigned workers = 0,
+                  const std::atomic<bool> *stop = nullptr);
+};
+} // namespace bwp::wallpaper
@@ -0,0 +1,143 @@
+#include "PerceptualIndex.hpp"
+#include "../../utils/PerceptualHash.hpp"
+#include <algorithm>
+#include <numeric>
+namespace bwp::wallpaper {
+void PerceptualIndex::set(Slot slot, uint64_t hash) {
+  if (slot < m_hashOf.size() && m_hashOf[slot] == hash)
+    return;
+  remove(slot);
+  if (hash == 0)
+    return;
+  if (slot >= m_hashOf.size())
+    m_hashOf.resize(slot + 1, 0);
+  m_hashOf[slot] = hash;
+  m_live++;
+  insert(slot, hash);
+}
+void PerceptualIndex::insert(Slot slot, uint64_t hash) {
+  auto found = m_nodeOf.find(hash);
+  if (found != m_nodeOf.end()) {
+    Node &node = m_nodes[found->second];
+    if (node.slots.empty())
+      m_emptyNodes--;
+    node.slots.push_back(slot);
+    return;
+  }
+  uint32_t index = static_cast<uint32_t>(m_nodes.size());
+  if (!m_nodes.empty()) {
+    uint32_t current = 0;
+    while (true) {
+      auto d = static_cast<uint8_t>(
+          utils::phash::distance(m_nodes[current].hash, hash));
+      auto &children = m_nodes[current].children;
+      auto child = std::find_if(children.begin(), children.end(),
+                                [d](const auto &c) { return c.first == d; });
+      if (child == children.end()) {
+        children.emplace_back(d, index);
+        break;
+      }
+      current = child->second;
+    }
+  }
+  Node node;
+  node.hash = hash;
+  node.slots.push_back(slot);
+  m_nodes.push_back(std::move(node));
+  m_nodeOf.emplace(hash, index);
+}
+void PerceptualIndex::remove(Slot slot) {
+  if (slot >= m_hashOf.size() || m_hashOf[slot] == 0)
+    return;
+  Node &node = m_nodes[m_nodeOf.at(m_hashOf[slot])];
+  node.slots.erase(std::find(node.slots.begin(), node.slots.end(), slot));
+  if (node.slots.empty())
+    m_emptyNodes++;
+  m_hashOf[slot] = 0;
+  m_live--;
+  if (m_emptyNodes > 64 && m_emptyNodes * 2 > m_nodes.size())
+    rebuild();
+}
+void PerceptualIndex::rebuild() {
+  m_nodes.clear();
+  m_nodeOf.clear();
+  m_emptyNodes = 0;
+  for (Slot slot = 0; slot < m_hashOf.size(); ++slot) {
+    if (m_hashOf[slot] != 0)
+      insert(slot, m_hashOf[slot]);
+  }
+}
+void PerceptualIndex::clear() {
+  m_nodes.clear();
+  m_nodeOf.clear();
+  m_hashOf.clear();
+  m_live = 0;
+  m_emptyNodes = 0;
+}
+template <typename Fn>
+void PerceptualIndex::visit(uint64_t hash, int radius, Fn &&fn) const {
+  if (m_nodes.empty())
+    return;
+  std::vector<uint32_t> stack{0};
+  while (!stack.empty()) {
+    const Node &node = m_nodes[stack.back()];
+    stack.pop_back();
+    int d = utils::phash::distance(node.hash, hash);
+    if (d <= radius && !node.slots.empty())
+      fn(node, d);
+    for (const auto &[edge, child] : node.children) {
+      if (edge >= d - radius && edge <= d + radius)
+        stack.push_back(child);
+    }
+  }
+}
+std::vector<std::pair<PerceptualIndex::Slot, int>>
+PerceptualIndex::within(uint64_t hash, int radius) const {
+  std::vector<std::pair<Slot, int>> result;
+  visit(hash, radius, [&result](const Node &node, int d) {
+    for (Slot slot : node.slots)
+      result.emplace_back(slot, d);
+  });
+  return result;
+}
+std::vector<std::vector<PerceptualIndex::Slot>>
+PerceptualIndex::clusters(int radius) const {
+  // Union-find over nodes: one radius query per distinct hash.
+  std::vector<uint32_t> parent(m_nodes.size());
+  std::iota(parent.begin(), parent.end(), 0u);
+  auto find = [&parent](uint32_t n) {
+    while (parent[n] != n)
+      n = parent[n] = parent[parent[n]];
+    return n;
+  };
+  for (uint32_t n = 0; n < m_nodes.size(); ++n) {
+    if (m_nodes[n].slots.empty())
+      continue;
+    visit(m_nodes[n].hash, radius, [&](const Node &other, int) {
+      uint32_t a = find(n);
+      uint32_t b = find(m_nodeOf.at(other.hash));
+      if (a != b)
+        parent[std::max(a, b)] = std::min(a, b);
+    });
+  }
+  std::unordered_map<uint32_t, std::vector<Slot>> groups;
+  for (uint32_t n = 0; n < m_nodes.size(); ++n) {
+    const auto &slots = m_nodes[n].slots;
+    if (!slots.empty()) {
+      auto &group = groups[find(n)];
+      group.insert(group.end(), slots.begin(), slots.end());
+    }
+  }
+  std::vector<std::vector<Slot>> result;
+  for (auto &[root, slots] : groups) {
+    if (slots.size() > 1) {
+      std::sort(slots.begin(), slots.end());
+      result.push_back(std::move(slots));
+    }
+  }
+  std::sort(result.begin(), result.end(), [](const auto &a, const auto &b) {
+    return a.size() != b.size() ? a.size() > b.size() : a.front() < b.front();
+  });
+  return result;
+}
+} // namespace bwp::wallpaper
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+namespace bwp::wallpaper {
+// BK-tree over 64-bit perceptual hashes under Hamming distance. A radius
+// query only descends into children whose edge distance lies within
+// [d - r, d + r] of the probe's distance to the node (triangle
+// inequality), so small radii touch a small fraction of the tree.
+//
+// Slots sharing a hash share a node. Removing a slot leaves its node in
+// place as a routing node; the tree is rebuilt once such empty nodes make
+// up half of it.
+class PerceptualIndex {
+public:
+  using Slot = uint32_t;
+  // hash 0 means "no hash" and just removes the slot.
+  void set(Slot slot, uint64_t hash);
+  void remove(Slot slot);
+  void clear();
+  size_t size() const { return m_live; }
+  // (slot, distance) pairs within `radius` bits of `hash`.
+  std::vector<std::pair<Slot, int>> within(uint64_t hash, int radius) const;
+  // Connected groups of two or more slots where each member is within
+  // `radius` of some other member (single linkage), largest first.
+  std::vector<std::vector<Slot>> clusters(int radius) const;
+
+private:
+  struct Node {
+    uint64_t hash = 0;
+    std::vector<Slot> slots;
+    std::vector<std::pair<uint8_t, uint32_t>> children; // distance, node
+  };
+  void insert(Slot slot, uint64_t hash);
+  void rebuild();
+  template <typename Fn> void visit(uint64_t hash, int radius, Fn &&fn) const;
+  std::vector<Node> m_nodes;
+  std::unordered_map<uint64_t, uint32_t> m_nodeOf;
+  std::vector<uint64_t> m_hashOf; // per slot, 0 when absent
+  size_t m_live = 0;
+  size_t m_emptyNodes = 0;
+};
+} // namespace bwp::wallpaper
@@ -0,0 +1,237 @@
+#include "ProjectMetadata.hpp"
+#include "../../utils/FileUtils.hpp"
+#include "../../utils/MappedFile.hpp"
+#include "ByteStream.hpp"
+#include <nlohmann/json.hpp>
+namespace bwp::wallpaper {
+namespace {
+constexpr char kMagic[4] = {'B', 'W', 'P', 'M'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kHasMetadata = 1;
+constexpr uint32_t kHasTitle = 2;
+constexpr uint32_t kHasTags = 4;
+constexpr unsigned kAllFields = 0xf;
+size_t skipSpace(std::string_view s, size_t i) {
+  while (i < s.size() &&
+         (s[i] == ' ' || s[i] == '\n' || s[i] == '\r' || s[i] == '\t'))
+    ++i;
+  return i;
+}
+// `i` is at the opening quote; returns the index past the closing one.
+size_t skipString(std::string_view s, size_t i) {
+  for (++i; i < s.size(); ++i) {
+    if (s[i] == '\\')
+      ++i;
+    else if (s[i] == '"')
+      return i + 1;
+  }
+  return std::string_view::npos;
+}
+// Returns the index past the value starting at `i` without decoding it.
+// Only structure is tracked; the wanted values are validated when decoded.
+size_t skipValue(std::string_view s, size_t i) {
+  if (i >= s.size())
+    return std::string_view::npos;
+  if (s[i] == '"')
+    return skipString(s, i);
+  if (s[i] != '{' && s[i] != '[') {
+    while (i < s.size() && s[i] != ',' && s[i] != '}' && s[i] != ']' &&
+           s[i] != ' ' && s[i] != '\n' && s[i] != '\r' && s[i] != '\t')
+      ++i;
+    return i;
+  }
+  int depth = 0;
+  while (i < s.size()) {
+    char c = s[i];
+    if (c == '"') {
+      i = skipString(s, i);
+      if (i == std::string_view::npos)
+        return i;
+      continue;
+    }
+    if (c == '{' || c == '[') {
+      ++depth;
+    } else if (c == '}' || c == ']') {
+      if (--depth == 0)
+        return i + 1;
+    }
+    ++i;
+  }
+  return std::string_view::npos;
+}
+} // namespace
+std::optional<ProjectMetadata> ProjectMetadata::extract(std::string_view json) {
+  ProjectMetadata out;
+  unsigned seen = 0;
+  size_t i = skipSpace(json, 0);
+  if (i >= json.size() || json[i] != '{')
+    return std::nullopt;
+  i = skipSpace(json, i + 1);
+  if (i < json.size() && json[i] == '}')
+    return out;
+  while (i < json.size() && json[i] == '"') {
+    size_t keyEnd = skipString(json, i);
+    if (keyEnd == std::string_view::npos)
+      return std::nullopt;
+    std::string_view key = json.substr(i + 1, keyEnd - i - 2);
+    i = skipSpace(json, keyEnd);
+    if (i >= json.size() || json[i] != ':')
+      return std::nullopt;
+    i = skipSpace(json, i + 1);
+    size_t valueEnd = skipValue(json, i);
+    if (valueEnd == std::string_view::npos)
+      return std::nullopt;
+    unsigned field = key == "title"  ? 1
+                     : key == "file" ? 2
+                     : key == "type" ? 4
+                     : key == "tags" ? 8
+                                     : 0;
+    if (field) {
+      // Only the wanted values go through the full parser, which also
+      // takes care of escapes.
+      auto value = nlohmann::json::parse(json.substr(i, valueEnd - i), nullptr,
+                                         false);
+      if (value.is_string()) {
+        auto text = value.get<std::string>();
+        if (field == 1) {
+          out.title = std::move(text);
+          out.hasTitle = true;
+        } else if (field == 2) {
+          out.file = std::move(text);
+        } else if (field == 4) {
+          out.type = std::move(text);
+        }
+      } else if (field == 8 && value.is_array()) {
+        out.hasTags = true;
+        out.tags.clear();
+        for (const auto &tag : value)
+          if (tag.is_string())
+            out.tags.push_back(tag.get<std::string>());
+      }
+      seen |= field;
+      if (seen == kAllFields)
+        return out;
+    }
+    i = skipSpace(json, valueEnd);
+    if (i < json.size() && json[i] == '}')
+      return out;
+    if (i >= json.size() || json[i] != ',')
+      return std::nullopt;
+    i = skipSpace(json, i + 1);
+  }
+  return std::nullopt;
+}
+std::optional<ProjectMetadata>
+ProjectMetadataCache::get(const std::filesystem::path &path) {
+  auto identity = FileIdentity::of(path);
+  if (!identity)
+    return std::nullopt;
+  const std::string key = path.string();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end() && it->second.identity == *identity) {
+      m_hits++;
+      return it->second.metadata;
+    }
+  }
+  std::optional<ProjectMetadata> metadata;
+  if (auto file = utils::MappedFile::open(path))
+    metadata = ProjectMetadata::extract(std::string_view(
+        reinterpret_cast<const char *>(file->data()), file->size()));
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_misses++;
+  m_entries[key] = {*identity, metadata};
+  m_dirty = true;
+  return metadata;
+}
+bool ProjectMetadataCache::load(const std::filesystem::path &path) {
+  auto file = utils::MappedFile::open(path);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries.clear();
+  m_dirty = false;
+  if (!file || file->size() < 16 ||
+      std::memcmp(file->data(), kMagic, 4) != 0)
+    return false;
+  ByteReader in{file->data() + 4, file->data() + file->size()};
+  if (in.u32() != kVersion)
+    return false;
+  uint64_t count = in.u64();
+  for (uint64_t i = 0; i < count && in.ok; ++i) {
+    std::string key = in.str();
+    Entry entry;
+    entry.identity.device = in.u64();
+    entry.identity.inode = in.u64();
+    entry.identity.mtimeNs = static_cast<int64_t>(in.u64());
+    entry.identity.size = in.u64();
+    uint32_t flags = in.u32();
+    if (flags & kHasMetadata) {
+      ProjectMetadata metadata;
+      metadata.title = in.str();
+      metadata.file = in.str();
+      metadata.type = in.str();
+      metadata.tags = in.strings();
+      metadata.hasTitle = flags & kHasTitle;
+      metadata.hasTags = flags & kHasTags;
+      entry.metadata = std::move(metadata);
+    }
+    m_entries.emplace(std::move(key), std::move(entry));
+  }
+  if (!in.ok)
+    m_entries.clear();
+  return in.ok;
+}
+bool ProjectMetadataCache::save(const std::filesystem::path &path) {
+  std::string out;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+      std::error_code ec;
+      if (std::filesystem::exists(it->first, ec))
+        ++it;
+      else
+        it = m_entries.erase(it);
+    }
+    out.append(kMagic, 4);
+    putU32(out, kVersion);
+    putU64(out, m_entries.size());
+    for (const auto &[key, entry] : m_entries) {
+      putString(out, key);
+      putU64(out, entry.identity.device);
+      putU64(out, entry.identity.inode);
+      putU64(out, static_cast<uint64_t>(entry.identity.mtimeNs));
+      putU64(out, entry.identity.size);
+      const auto &metadata = entry.metadata;
+      uint32_t flags = 0;
+      if (metadata)
+        flags = kHasMetadata | (metadata->hasTitle ? kHasTitle : 0) |
+                (metadata->hasTags ? kHasTags : 0);
+      putU32(out, flags);
+      if (metadata) {
+        putString(out, metadata->title);
+        putString(out, metadata->file);
+        putString(out, metadata->type);
+        putStrings(out, metadata->tags);
+      }
+    }
+    m_dirty = false;
+  }
+  return utils::FileUtils::writeFileAtomic(path, out);
+}
+size_t ProjectMetadataCache::size() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_entries.size();
+}
+bool ProjectMetadataCache::dirty() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_dirty;
+}
+size_t ProjectMetadataCache::hits() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_hits;
+}
+size_t ProjectMetadataCache::misses() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_misses;
+}
+} // namespace bwp::wallpaper
@@ -0,0 +1,50 @@
+#pragma once
+#include "HashCache.hpp"
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+namespace bwp::wallpaper {
+// The handful of Wallpaper Engine project.json fields the scanner uses.
+struct ProjectMetadata {
+  std::string title;
+  std::string file;
+  std::string type;
+  std::vector<std::string> tags;
+  bool hasTitle = false;
+  bool hasTags = false;
+  // Skims the top-level object, decoding only the wanted values, and stops
+  // once all of them were seen; the (often large) rest is never parsed.
+  // nullopt when the document is malformed before that point.
+  static std::optional<ProjectMetadata> extract(std::string_view json);
+  bool operator==(const ProjectMetadata &) const = default;
+};
+// Extracted project.json metadata by path, valid while the file's identity
+// (device, inode, mtime, size) is unchanged. Thread-safe.
+class ProjectMetadataCache {
+public:
+  // Parses `path` on a miss; unparsable files are cached as nullopt too.
+  std::optional<ProjectMetadata> get(const std::filesystem::path &path);
+  bool load(const std::filesystem::path &path);
+  // Drops entries whose file no longer exists, then writes the cache.
+  bool save(const std::filesystem::path &path);
+  size_t size() const;
+  bool dirty() const;
+  size_t hits() const;
+  size_t misses() const;
+
+private:
+  struct Entry {
+    FileIdentity identity;
+    std::optional<ProjectMetadata> metadata;
+  };
+  mutable std::mutex m_mutex;
+  std::unordered_map<std::string, Entry> m_entries;
+  bool m_dirty = false;
+  size_t m_hits = 0;
+  size_t m_misses = 0;
+};
+} // namespace bwp::wallpaper
@@ -0,0 +1,243 @@
+#include "RoaringBitmap.hpp"
+#include <algorithm>
+namespace bwp::wallpaper {
+std::vector<RoaringBitmap::Chunk>::iterator
+RoaringBitmap::findChunk(uint16_t key) {
+  return std::lower_bound(
+      m_chunks.begin(), m_chunks.end(), key,
+      [](const Chunk &chunk, uint16_t k) { return chunk.key < k; });
+}
+std::vector<RoaringBitmap::Chunk>::const_iterator
+RoaringBitmap::findChunk(uint16_t key) const {
+  return std::lower_bound(
+      m_chunks.begin(), m_chunks.end(), key,
+      [](const Chunk &chunk, uint16_t k) { return chunk.key < k; });
+}
+std::vector<uint64_t> RoaringBitmap::bitsOf(const Chunk &chunk) {
+  if (!chunk.bits.empty())
+    return chunk.bits;
+  std::vector<uint64_t> bits(kWords, 0);
+  for (uint16_t low : chunk.array)
+    bits[low >> 6] |= uint64_t{1} << (low & 63);
+  return bits;
+}
+bool RoaringBitmap::chunkContains(const Chunk &chunk, uint16_t low) {
+  if (!chunk.bits.empty())
+    return (chunk.bits[low >> 6] >> (low & 63)) & 1;
+  return std::binary_search(chunk.array.begin(), chunk.array.end(), low);
+}
+RoaringBitmap::Chunk RoaringBitmap::fromBits(uint16_t key,
+                                             std::vector<uint64_t> bits) {
+  Chunk chunk;
+  chunk.key = key;
+  for (uint64_t word : bits)
+    chunk.count += static_cast<uint32_t>(std::popcount(word));
+  if (chunk.count > kArrayMax) {
+    chunk.bits = std::move(bits);
+    return chunk;
+  }
+  chunk.array.reserve(chunk.count);
+  for (size_t w = 0; w < bits.size(); ++w) {
+    uint64_t word = bits[w];
+    while (word) {
+      chunk.array.push_back(
+          static_cast<uint16_t>(w * 64 + std::countr_zero(word)));
+      word &= word - 1;
+    }
+  }
+  return chunk;
+}
+void RoaringBitmap::add(uint32_t value) {
+  const uint16_t key = static_cast<uint16_t>(value >> 16);
+  const uint16_t low = static_cast<uint16_t>(value & 0xffff);
+  auto it = findChunk(key);
+  if (it == m_chunks.end() || it->key != key) {
+    Chunk chunk;
+    chunk.key = key;
+    it = m_chunks.insert(it, std::move(chunk));
+  }
+  if (!it->bits.empty()) {
+    uint64_t &word = it->bits[low >> 6];
+    const uint64_t mask = uint64_t{1} << (low & 63);
+    if (!(word & mask)) {
+      word |= mask;
+      it->count++;
+    }
+    return;
+  }
+  auto pos = std::lower_bound(it->array.begin(), it->array.end(), low);
+  if (pos != it->array.end() && *pos == low)
+    return;
+  it->array.insert(pos, low);
+  it->count++;
+  if (it->count > kArrayMax) {
+    it->bits = bitsOf(*it);
+    it->array.clear();
+    it->array.shrink_to_fit();
+  }
+}
+void RoaringBitmap::remove(uint32_t value) {
+  const uint16_t key = static_cast<uint16_t>(value >> 16);
+  const uint16_t low = static_cast<uint16_t>(value & 0xffff);
+  auto it = findChunk(key);
+  if (it == m_chunks.end() || it->key != key)
+    return;
+  if (!it->bits.empty()) {
+    uint64_t &word = it->bits[low >> 6];
+    const uint64_t mask = uint64_t{1} << (low & 63);
+    if (!(word & mask))
+      return;
+    word &= ~mask;
+    it->count--;
+    if (it->count <= kArrayMax)
+      *it = fromBits(key, std::move(it->bits));
+  } else {
+    auto pos = std::lower_bound(it->array.begin(), it->array.end(), low);
+    if (pos == it->array.end() || *pos != low)
+      return;
+    it->array.erase(pos);
+    it->count--;
+  }
+  if (it->count == 0)
+    m_chunks.erase(it);
+}
+bool RoaringBitmap::contains(uint32_t value) const {
+  const uint16_t key = static_cast<uint16_t>(value >> 16);
+  auto it = findChunk(key);
+  return it != m_chunks.end() && it->key == key &&
+         chunkContains(*it, static_cast<uint16_t>(value & 0xffff));
+}
+size_t RoaringBitmap::cardinality() const {
+  size_t total = 0;
+  for (const auto &chunk : m_chunks)
+    total += chunk.count;
+  return total;
+}
+RoaringBitmap RoaringBitmap::operator&(const RoaringBitmap &other) const {
+  RoaringBitmap result;
+  auto a = m_chunks.begin();
+  auto b = other.m_chunks.begin();
+  while (a != m_chunks.end() && b != other.m_chunks.end()) {
+    if (a->key < b->key) {
+      ++a;
+      continue;
+    }
+    if (b->key < a->key) {
+      ++b;
+      continue;
+    }
+    Chunk chunk;
+    if (!a->bits.empty() && !b->bits.empty()) {
+      std::vector<uint64_t> bits(kWords);
+      for (size_t w = 0; w < kWords; ++w)
+        bits[w] = a->bits[w] & b->bits[w];
+      chunk = fromBits(a->key, std::move(bits));
+    } else {
+      // At least one side is an array; probe the other with its members.
+      const Chunk &small = a->bits.empty() ? *a : *b;
+      const Chunk &large = a->bits.empty() ? *b : *a;
+      chunk.key = a->key;
+      for (uint16_t low : small.array) {
+        if (chunkContains(large, low))
+          chunk.array.push_back(low);
+      }
+      chunk.count = static_cast<uint32_t>(chunk.array.size());
+    }
+    if (chunk.count > 0)
+      result.m_chunks.push_back(std::move(chunk));
+    ++a;
+    ++b;
+  }
+  return result;
+}
+RoaringBitmap RoaringBitmap::operator|(const RoaringBitmap &other) const {
+  RoaringBitmap result;
+  auto a = m_chunks.begin();
+  auto b = other.m_chunks.begin();
+  while (a != m_chunks.end() || b != other.m_chunks.end()) {
+    if (b == other.m_chunks.end() ||
+        (a != m_chunks.end() && a->key < b->key)) {
+      result.m_chunks.push_back(*a++);
+      continue;
+    }
+    if (a == m_chunks.end() || b->key < a->key) {
+      result.m_chunks.push_back(*b++);
+      continue;
+    }
+    if (a->bits.empty() && b->bits.empty() &&
+        a->count + b->count <= kArrayMax) {
+      Chunk chunk;
+      chunk.key = a->key;
+      std::set_union(a->array.begin(), a->array.end(), b->array.begin(),
+                     b->array.end(), std::back_inserter(chunk.array));
+      chunk.count = static_cast<uint32_t>(chunk.array.size());
+      result.m_chunks.push_back(std::move(chunk));
+    } else {
+      std::vector<uint64_t> bits = bitsOf(*a);
+      if (!b->bits.empty()) {
+        for (size_t w = 0; w < kWords; ++w)
+          bits[w] |= b->bits[w];
+      } else {
+        for (uint16_t low : b->array)
+          bits[low >> 6] |= uint64_t{1} << (low & 63);
+      }
+      result.m_chunks.push_back(fromBits(a->key, std::move(bits)));
+    }
+    ++a;
+    ++b;
+  }
+  return result;
+}
+RoaringBitmap RoaringBitmap::operator-(const RoaringBitmap &other) const {
+  RoaringBitmap result;
+  auto b = other.m_chunks.begin();
+  for (const auto &chunk : m_chunks) {
+    while (b != other.m_chunks.end() && b->key < chunk.key)
+      ++b;
+    if (b == other.m_chunks.end() || b->key != chunk.key) {
+      result.m_chunks.push_back(chunk);
+      continue;
+    }
+    Chunk diff;
+    if (chunk.bits.empty()) {
+      diff.key = chunk.key;
+      for (uint16_t low : chunk.array) {
+        if (!chunkContains(*b, low))
+          diff.array.push_back(low);
+      }
+      diff.count = static_cast<uint32_t>(diff.array.size());
+    } else {
+      std::vector<uint64_t> bits = chunk.bits;
+      if (!b->bits.empty()) {
+        for (size_t w = 0; w < kWords; ++w)
+          bits[w] &= ~b->bits[w];
+      } else {
+        for (uint16_t low : b->array)
+          bits[low >> 6] &= ~(uint64_t{1} << (low & 63));
+      }
+      diff = fromBits(chunk.key, std::move(bits));
+    }
+    if (diff.count > 0)
+      result.m_chunks.push_back(std::move(diff));
+  }
+  return result;
+}
+bool RoaringBitmap::operator==(const RoaringBitmap &other) const {
+  if (m_chunks.size() != other.m_chunks.size())
+    return false;
+  for (size_t i = 0; i < m_chunks.size(); ++i) {
+    const Chunk &a = m_chunks[i];
+    const Chunk &b = other.m_chunks[i];
+    if (a.key != b.key || a.count != b.count || a.array != b.array ||
+        a.bits != b.bits)
+      return false;
+  }
+  return true;
+}
+std::vector<uint32_t> RoaringBitmap::toVector() const {
+  std::vector<uint32_t> values;
+  values.reserve(cardinality());
+  forEach([&values](uint32_t v) { values.push_back(v); });
+  return values;
+}
+} // namespace bwp::wallpaper
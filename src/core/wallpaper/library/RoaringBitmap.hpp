@@ -0,0 +1,64 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+namespace bwp::wallpaper {
+// Compressed set of 32-bit integers in the style of Roaring bitmaps.
+//
+// Values are split into 65536-wide chunks by their high 16 bits. A chunk
+// holding at most kArrayMax values is a sorted uint16 array; denser chunks
+// switch to a fixed 8 KiB bitset. Dense slot ids therefore cost about two
+// bytes per member while set operations run chunk-by-chunk on whichever
+// representation is cheaper.
+class RoaringBitmap {
+public:
+  static constexpr uint32_t kArrayMax = 4096;
+  void add(uint32_t value);
+  void remove(uint32_t value);
+  bool contains(uint32_t value) const;
+  size_t cardinality() const;
+  bool empty() const { return m_chunks.empty(); }
+  void clear() { m_chunks.clear(); }
+  RoaringBitmap operator&(const RoaringBitmap &other) const;
+  RoaringBitmap operator|(const RoaringBitmap &other) const;
+  // Set difference: members of this bitmap that are not in `other`.
+  RoaringBitmap operator-(const RoaringBitmap &other) const;
+  bool operator==(const RoaringBitmap &other) const;
+  // Visits members in ascending order.
+  template <typename Fn> void forEach(Fn &&fn) const {
+    for (const auto &chunk : m_chunks) {
+      const uint32_t high = uint32_t{chunk.key} << 16;
+      if (chunk.bits.empty()) {
+        for (uint16_t low : chunk.array)
+          fn(high | low);
+        continue;
+      }
+      for (size_t w = 0; w < chunk.bits.size(); ++w) {
+        uint64_t word = chunk.bits[w];
+        while (word) {
+          fn(high |
+             static_cast<uint32_t>(w * 64 + std::countr_zero(word)));
+          word &= word - 1;
+        }
+      }
+    }
+  }
+  std::vector<uint32_t> toVector() const;
+
+private:
+  static constexpr size_t kWords = 65536 / 64;
+  struct Chunk {
+    uint16_t key = 0;
+    uint32_t count = 0;
+    std::vector<uint16_t> array; // used while count <= kArrayMax
+    std::vector<uint64_t> bits;  // kWords words otherwise
+  };
+  static std::vector<uint64_t> bitsOf(const Chunk &chunk);
+  static bool chunkContains(const Chunk &chunk, uint16_t low);
+  static Chunk fromBits(uint16_t key, std::vector<uint64_t> bits);
+  std::vector<Chunk>::iterator findChunk(uint16_t key);
+  std::vector<Chunk>::const_iterator findChunk(uint16_t key) const;
+  std::vector<Chunk> m_chunks; // sorted by key
+};
+} // namespace bwp::wallpaper
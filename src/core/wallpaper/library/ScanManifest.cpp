@@ -0,0 +1,124 @@
+#include "ScanManifest.hpp"
+#include "ByteStream.hpp"
+#include "../../utils/FileUtils.hpp"
+#include "../../utils/MappedFile.hpp"
+#include <chrono>
+#include <cstring>
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+namespace bwp::wallpaper {
+namespace {
+constexpr char kMagic[4] = {'B', 'W', 'P', 'S'};
+// v2: media probing; dropping v1 manifests revisits every directory once so
+// known wallpapers get their headers read. v3: no per-directory entry count.
+constexpr uint32_t kVersion = 3;
+void putStamp(std::string &out, const DirStamp &stamp) {
+  putU64(out, stamp.device);
+  putU64(out, stamp.inode);
+  putU64(out, static_cast<uint64_t>(stamp.mtimeNs));
+}
+DirStamp readStamp(ByteReader &in) {
+  DirStamp s;
+  s.device = in.u64();
+  s.inode = in.u64();
+  s.mtimeNs = static_cast<int64_t>(in.u64());
+  return s;
+}
+} // namespace
+std::optional<DirStamp> DirStamp::of(const std::filesystem::path &path) {
+  DirStamp stamp;
+#ifndef _WIN32
+  struct stat st {};
+  if (::stat(path.c_str(), &st) != 0)
+    return std::nullopt;
+  stamp.device = static_cast<uint64_t>(st.st_dev);
+  stamp.inode = static_cast<uint64_t>(st.st_ino);
+  stamp.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+                  st.st_mtim.tv_nsec;
+#else
+  std::error_code ec;
+  auto mtime = std::filesystem::last_write_time(path, ec);
+  if (ec)
+    return std::nullopt;
+  stamp.mtimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      mtime.time_since_epoch())
+                      .count();
+#endif
+  return stamp;
+}
+bool ScanManifest::load(const std::filesystem::path &path) {
+  clear();
+  auto file = utils::MappedFile::open(path);
+  if (!file || file->size() < 8 || std::memcmp(file->data(), kMagic, 4) != 0)
+    return false;
+  ByteReader in{file->data() + 4, file->data() + file->size()};
+  if (in.u32() != kVersion)
+    return false;
+  uint64_t dirs = in.u64();
+  for (uint64_t i = 0; i < dirs && in.ok; ++i) {
+    std::string key = in.str();
+    Directory dir;
+    dir.stamp = readStamp(in);
+    dir.subdirs = in.strings();
+    dir.files = in.strings();
+    m_dirs.emplace(std::move(key), std::move(dir));
+  }
+  uint64_t items = in.u64();
+  for (uint64_t i = 0; i < items && in.ok; ++i) {
+    std::string key = in.str();
+    Item item;
+    item.stamp = readStamp(in);
+    item.projectMtimeNs = static_cast<int64_t>(in.u64());
+    item.found = in.u32() != 0;
+    m_items.emplace(std::move(key), item);
+  }
+  if (!in.ok)
+    clear();
+  return in.ok;
+}
+bool ScanManifest::save(const std::filesystem::path &path) const {
+  std::string out;
+  out.append(kMagic, 4);
+  putU32(out, kVersion);
+  putU64(out, m_dirs.size());
+  for (const auto &[key, dir] : m_dirs) {
+    putString(out, key);
+    putStamp(out, dir.stamp);
+    putStrings(out, dir.subdirs);
+    putStrings(out, dir.files);
+  }
+  putU64(out, m_items.size());
+  for (const auto &[key, item] : m_items) {
+    putString(out, key);
+    putStamp(out, item.stamp);
+    putU64(out, static_cast<uint64_t>(item.projectMtimeNs));
+    putU32(out, item.found ? 1 : 0);
+  }
+  return utils::FileUtils::writeFileAtomic(path, out);
+}
+const ScanManifest::Directory *
+ScanManifest::directory(const std::string &path) const {
+  auto it = m_dirs.find(path);
+  return it == m_dirs.end() ? nullptr : &it->second;
+}
+const ScanManifest::Item *ScanManifest::item(const std::string &path) const {
+  auto it = m_items.find(path);
+  return it == m_items.end() ? nullptr : &it->second;
+}
+void ScanManifest::setDirectory(const std::string &path, Directory dir) {
+  m_dirs[path] = std::move(dir);
+}
+void ScanManifest::setItem(const std::string &path, Item item) {
+  m_items[path] = item;
+}
+void ScanManifest::merge(ScanManifest &&other) {
+  m_dirs.merge(other.m_dirs);
+  m_items.merge(other.m_items);
+  other.clear();
+}
+void ScanManifest::clear() {
+  m_dirs.clear();
+  m_items.clear();
+}
+} // namespace bwp::wallpaper
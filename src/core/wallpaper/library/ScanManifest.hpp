@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+namespace bwp::wallpaper {
+// Adding, removing or renaming an entry bumps a directory's mtime, and a
+// replaced directory gets a new inode, so an unchanged stamp means the
+// listing recorded with it is still current.
+struct DirStamp {
+  uint64_t device = 0;
+  uint64_t inode = 0;
+  int64_t mtimeNs = 0;
+  static std::optional<DirStamp> of(const std::filesystem::path &path);
+  bool operator==(const DirStamp &) const = default;
+};
+// What the previous scan saw, so a rescan can trust unchanged directories
+// instead of listing them and unchanged workshop items instead of parsing
+// their project.json. Not thread-safe; scanners build one per worker and
+// merge().
+class ScanManifest {
+public:
+  struct Directory {
+    DirStamp stamp;
+    std::vector<std::string> subdirs; // names, not followed symlinks
+    std::vector<std::string> files;   // names of wallpaper candidates
+  };
+  struct Item {
+    DirStamp stamp;
+    int64_t projectMtimeNs = 0; // 0 when there is no project.json
+    bool found = false;         // the probe produced a wallpaper
+  };
+  // Stamps this close to the scan start may still be followed by a change
+  // within the same timestamp tick, so they are not recorded.
+  static constexpr int64_t kSettleNs = 2'000'000'000;
+  static bool settled(int64_t mtimeNs, int64_t scanStartNs) {
+    return mtimeNs + kSettleNs <= scanStartNs;
+  }
+  bool load(const std::filesystem::path &path);
+  bool save(const std::filesystem::path &path) const;
+  const Directory *directory(const std::string &path) const;
+  const Item *item(const std::string &path) const;
+  void setDirectory(const std::string &path, Directory dir);
+  void setItem(const std::string &path, Item item);
+  void merge(ScanManifest &&other);
+  void clear();
+  size_t directories() const { return m_dirs.size(); }
+  size_t items() const { return m_items.size(); }
+
+private:
+  std::unordered_map<std::string, Directory> m_dirs;
+  std::unordered_map<std::string, Item> m_items;
+};
+} // namespace bwp::wallpaper
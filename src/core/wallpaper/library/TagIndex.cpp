@@ -0,0 +1,99 @@
+#include "TagIndex.hpp"
+#include <algorithm>
+namespace bwp::wallpaper {
+uint32_t TagIndex::intern(const std::string &tag) {
+  auto it = m_tagIds.find(tag);
+  if (it != m_tagIds.end())
+    return it->second;
+  uint32_t id = static_cast<uint32_t>(m_tagNames.size());
+  m_tagIds.emplace(tag, id);
+  m_tagNames.push_back(tag);
+  m_postings.emplace_back();
+  return id;
+}
+void TagIndex::set(Slot slot, const std::vector<std::string> &tags) {
+  remove(slot);
+  if (slot >= m_slotTags.size())
+    m_slotTags.resize(slot + 1);
+  auto &slotTags = m_slotTags[slot];
+  for (const auto &tag : tags) {
+    uint32_t id = intern(tag);
+    if (std::find(slotTags.begin(), slotTags.end(), id) != slotTags.end())
+      continue;
+    slotTags.push_back(id);
+    m_postings[id].add(slot);
+  }
+  m_live.add(slot);
+}
+void TagIndex::remove(Slot slot) {
+  if (!m_live.contains(slot))
+    return;
+  for (uint32_t id : m_slotTags[slot]) {
+    m_postings[id].remove(slot);
+  }
+  m_slotTags[slot].clear();
+  m_live.remove(slot);
+}
+void TagIndex::clear() {
+  m_tagIds.clear();
+  m_tagNames.clear();
+  m_postings.clear();
+  m_slotTags.clear();
+  m_live.clear();
+}
+const RoaringBitmap *TagIndex::postings(const std::string &tag) const {
+  auto it = m_tagIds.find(tag);
+  if (it == m_tagIds.end() || m_postings[it->second].empty())
+    return nullptr;
+  return &m_postings[it->second];
+}
+size_t TagIndex::count(const std::string &tag) const {
+  const RoaringBitmap *bitmap = postings(tag);
+  return bitmap ? bitmap->cardinality() : 0;
+}
+std::vector<std::pair<std::string, size_t>> TagIndex::counts() const {
+  std::vector<std::pair<std::string, size_t>> result;
+  for (size_t id = 0; id < m_tagNames.size(); ++id) {
+    if (!m_postings[id].empty())
+      result.emplace_back(m_tagNames[id], m_postings[id].cardinality());
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+RoaringBitmap TagIndex::query(const std::vector<std::string> &all,
+                              const std::vector<std::string> &any,
+                              const std::vector<std::string> &none) const {
+  static const RoaringBitmap kEmpty;
+  auto lookup = [this](const std::string &tag) -> const RoaringBitmap & {
+    const RoaringBitmap *bitmap = postings(tag);
+    return bitmap ? *bitmap : kEmpty;
+  };
+  RoaringBitmap result;
+  if (!all.empty()) {
+    // Start from the rarest tag so every intersection stays small.
+    std::vector<const RoaringBitmap *> lists;
+    for (const auto &tag : all)
+      lists.push_back(&lookup(tag));
+    std::sort(lists.begin(), lists.end(), [](const auto *a, const auto *b) {
+      return a->cardinality() < b->cardinality();
+    });
+    result = *lists.front();
+    for (size_t i = 1; i < lists.size() && !result.empty(); ++i)
+      result = result & *lists[i];
+  }
+  if (!any.empty()) {
+    RoaringBitmap either;
+    for (const auto &tag : any)
+      either = either | lookup(tag);
+    result = all.empty() ? std::move(either) : result & either;
+  }
+  if (all.empty() && any.empty())
+    result = m_live;
+  for (const auto &tag : none) {
+    if (result.empty())
+      break;
+    result = result - lookup(tag);
+  }
+  return result;
+}
+} // namespace bwp::wallpaper
@@ -0,0 +1,39 @@
+#pragma once
+#include "RoaringBitmap.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+namespace bwp::wallpaper {
+// Tag -> slot posting lists. Tag strings are interned to dense ids once;
+// each id owns a RoaringBitmap of the library slots carrying that tag, so
+// counts are O(1) and boolean tag queries cost O(result) rather than
+// O(library).
+class TagIndex {
+public:
+  using Slot = uint32_t;
+  void set(Slot slot, const std::vector<std::string> &tags);
+  void remove(Slot slot);
+  void clear();
+  // Posting list for `tag`, or nullptr when no live slot carries it.
+  const RoaringBitmap *postings(const std::string &tag) const;
+  size_t count(const std::string &tag) const;
+  const RoaringBitmap &live() const { return m_live; }
+  // Tags in use with their slot counts, sorted by tag.
+  std::vector<std::pair<std::string, size_t>> counts() const;
+  // Slots matching every tag in `all`, at least one of `any` (when
+  // non-empty) and none of `none`; with no positive terms, all live slots.
+  RoaringBitmap query(const std::vector<std::string> &all,
+                      const std::vector<std::string> &any,
+                      const std::vector<std::string> &none) const;
+
+private:
+  uint32_t intern(const std::string &tag);
+  std::unordered_map<std::string, uint32_t> m_tagIds;
+  std::vector<std::string> m_tagNames;
+  std::vector<RoaringBitmap> m_postings;
+  std::vector<std::vector<uint32_t>> m_slotTags;
+  RoaringBitmap m_live;
+};
+} // namespace bwp::wallpaper
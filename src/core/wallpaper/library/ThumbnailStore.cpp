@@ -0,0 +1,544 @@
+#include "ThumbnailStore.hpp"
+#include "ByteStream.hpp"
+#include "../../utils/FileUtils.hpp"
+#include "../../utils/Logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <random>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+namespace bwp::wallpaper {
+#ifndef _WIN32
+namespace {
+constexpr char kPackMagic[4] = {'B', 'W', 'T', 'P'};
+constexpr char kIndexMagic[4] = {'B', 'W', 'T', 'I'};
+constexpr char kRecordMagic[4] = {'B', 'W', 'T', 'R'};
+constexpr uint64_t kPackHeaderSize = 16; // magic, version, generation
+constexpr uint64_t kRecordHeaderSize = 40;
+// Below this much garbage a rewrite is not worth the I/O.
+constexpr uint64_t kMinCompactionBytes = 16u << 20;
+constexpr size_t kRewriteChunk = 1u << 20;
+uint64_t recordSize(size_t keySize, uint32_t length) {
+  return kRecordHeaderSize + keySize + length;
+}
+// Tells packs apart so an index is never applied to a pack it was not
+// written for (after a compaction or clear by another process).
+uint64_t newGeneration() {
+  std::random_device rd;
+  uint64_t random = (static_cast<uint64_t>(rd()) << 32) ^ rd();
+  return random ^ static_cast<uint64_t>(
+                      std::chrono::steady_clock::now().time_since_epoch().count());
+}
+std::string encodeHeader(uint64_t generation) {
+  std::string out(kPackMagic, 4);
+  putU32(out, ThumbnailStore::kVersion);
+  putU64(out, generation);
+  return out;
+}
+void appendRecord(std::string &out, const std::string &key,
+                  const ThumbnailStore::Entry &entry, const uint8_t *data) {
+  out.append(kRecordMagic, 4);
+  putU32(out, static_cast<uint32_t>(key.size()));
+  putU32(out, entry.length);
+  putU32(out, entry.width);
+  putU32(out, entry.height);
+  putU32(out, static_cast<uint32_t>(entry.format));
+  putU64(out, static_cast<uint64_t>(entry.sourceMtime));
+  putU64(out, entry.sourceSize);
+  out += key;
+  if (entry.length > 0)
+    out.append(reinterpret_cast<const char *>(data), entry.length);
+}
+bool writeAt(int fd, const std::string &bytes, uint64_t offset) {
+  size_t done = 0;
+  while (done < bytes.size()) {
+    ssize_t n = ::pwrite(fd, bytes.data() + done, bytes.size() - done,
+                         static_cast<off_t>(offset + done));
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    done += static_cast<size_t>(n);
+  }
+  return true;
+}
+bool readGeneration(int fd, uint64_t &generation) {
+  char header[kPackHeaderSize];
+  if (::pread(fd, header, sizeof(header), 0) !=
+          static_cast<ssize_t>(sizeof(header)) ||
+      std::memcmp(header, kPackMagic, 4) != 0)
+    return false;
+  uint32_t version = 0;
+  std::memcpy(&version, header + 4, 4);
+  std::memcpy(&generation, header + 8, 8);
+  return version == ThumbnailStore::kVersion;
+}
+int openPackFile(const std::filesystem::path &path, int flags = 0) {
+  return ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | flags, 0644);
+}
+} // namespace
+
+// Exclusive flock on the pack; every process sharing the cache takes it
+// before appending or replacing the pack.
+class ThumbnailStore::PackLock {
+public:
+  explicit PackLock(int fd) { rebind(fd); }
+  ~PackLock() {
+    if (m_fd >= 0)
+      ::flock(m_fd, LOCK_UN);
+  }
+  PackLock(const PackLock &) = delete;
+  PackLock &operator=(const PackLock &) = delete;
+  // Moves the lock to `fd`. The old lock is dropped explicitly: a mapping
+  // of the old descriptor would otherwise keep it held after close().
+  void rebind(int fd) {
+    if (m_fd >= 0 && m_fd != fd)
+      ::flock(m_fd, LOCK_UN);
+    m_fd = fd;
+    while (m_fd >= 0 && ::flock(m_fd, LOCK_EX) != 0 && errno == EINTR) {
+    }
+  }
+
+private:
+  int m_fd = -1;
+};
+
+ThumbnailStore::SourceStamp
+ThumbnailStore::SourceStamp::of(const std::filesystem::path &path) {
+  SourceStamp stamp;
+  struct stat st {};
+  if (::stat(path.c_str(), &st) == 0) {
+    stamp.mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+                  st.st_mtim.tv_nsec;
+    stamp.size = static_cast<uint64_t>(st.st_size);
+  }
+  return stamp;
+}
+ThumbnailStore::ThumbnailStore(std::filesystem::path dir)
+    : m_packPath(dir / "thumbnails.pack"),
+      m_indexPath(dir / "thumbnails.idx") {}
+ThumbnailStore::~ThumbnailStore() {
+  flush();
+  if (m_fd >= 0)
+    ::close(m_fd);
+}
+bool ThumbnailStore::open() {
+  std::lock_guard<std::mutex> writer(m_writeMutex);
+  std::error_code ec;
+  std::filesystem::create_directories(m_packPath.parent_path(), ec);
+  int fd = openPackFile(m_packPath);
+  if (fd < 0) {
+    LOG_ERROR("Failed to open thumbnail pack: " + m_packPath.string());
+    return false;
+  }
+  PackLock lock(fd);
+  std::lock_guard<std::mutex> state(m_mutex);
+  if (m_fd >= 0)
+    ::close(m_fd);
+  m_fd = fd;
+  return loadPack();
+}
+bool ThumbnailStore::loadPack() {
+  uint64_t generation = 0;
+  if (!readGeneration(m_fd, generation)) {
+    struct stat st {};
+    if (::fstat(m_fd, &st) == 0 && st.st_size > 0)
+      LOG_WARN("Discarding unreadable thumbnail pack: " + m_packPath.string());
+    generation = newGeneration();
+    if (::ftruncate(m_fd, 0) != 0 ||
+        !writeAt(m_fd, encodeHeader(generation), 0)) {
+      LOG_ERROR("Failed to initialize thumbnail pack: " + m_packPath.string());
+      return false;
+    }
+  }
+  m_generation = generation;
+  m_index.clear();
+  m_packSize = kPackHeaderSize;
+  m_deadBytes = 0;
+  m_savedSize = 0;
+  if (!remap())
+    return false;
+  if (!loadIndex(m_map->size()) && m_map->size() > kPackHeaderSize)
+    LOG_INFO("Rebuilding thumbnail index from " + m_packPath.string());
+  scanTail(m_map->size());
+  return true;
+}
+bool ThumbnailStore::loadIndex(uint64_t packSize) {
+  auto file = utils::MappedFile::open(m_indexPath);
+  if (!file || file->size() < 8 ||
+      std::memcmp(file->data(), kIndexMagic, 4) != 0)
+    return false;
+  ByteReader in{file->data() + 4, file->data() + file->size()};
+  if (in.u32() != kVersion || in.u64() != m_generation)
+    return false;
+  uint64_t covered = in.u64();
+  uint64_t count = in.u64();
+  if (!in.ok || covered < kPackHeaderSize || covered > packSize)
+    return false;
+  std::unordered_map<std::string, Entry> index;
+  index.reserve(std::min<uint64_t>(count, file->size() / 32));
+  uint64_t live = 0;
+  for (uint64_t i = 0; i < count && in.ok; ++i) {
+    std::string key = in.str();
+    Entry entry;
+    entry.offset = in.u64();
+    entry.length = in.u32();
+    entry.width = in.u32();
+    entry.height = in.u32();
+    entry.format = static_cast<Format>(in.u32());
+    entry.sourceMtime = static_cast<int64_t>(in.u64());
+    entry.sourceSize = in.u64();
+    if (entry.offset < kPackHeaderSize + kRecordHeaderSize ||
+        entry.offset + entry.length > covered)
+      in.ok = false;
+    live += recordSize(key.size(), entry.length);
+    index.emplace(std::move(key), entry);
+  }
+  if (!in.ok || live > covered - kPackHeaderSize)
+    return false;
+  m_index = std::move(index);
+  m_packSize = covered;
+  m_savedSize = covered;
+  m_deadBytes = covered - kPackHeaderSize - live;
+  return true;
+}
+void ThumbnailStore::scanTail(uint64_t end) {
+  const uint8_t *base = m_map->data();
+  uint64_t pos = m_packSize;
+  while (pos < end) {
+    if (end - pos < kRecordHeaderSize ||
+        std::memcmp(base + pos, kRecordMagic, 4) != 0)
+      break;
+    ByteReader in{base + pos + 4, base + end};
+    uint32_t keySize = in.u32();
+    Entry entry;
+    entry.length = in.u32();
+    entry.width = in.u32();
+    entry.height = in.u32();
+    entry.format = static_cast<Format>(in.u32());
+    entry.sourceMtime = static_cast<int64_t>(in.u64());
+    entry.sourceSize = in.u64();
+    uint64_t size = recordSize(keySize, entry.length);
+    if (end - pos < size)
+      break;
+    std::string key(reinterpret_cast<const char *>(base + pos) +
+                        kRecordHeaderSize,
+                    keySize);
+    entry.offset = pos + kRecordHeaderSize + keySize;
+    account(key, entry);
+    pos += size;
+  }
+  m_packSize = pos;
+  if (pos < end) {
+    // Only reached with the pack locked, so nobody is mid-append: the tail
+    // is what a crashed writer left behind.
+    LOG_WARN("Discarding torn tail of thumbnail pack " + m_packPath.string());
+    if (::ftruncate(m_fd, static_cast<off_t>(pos)) == 0)
+      remap();
+  }
+}
+void ThumbnailStore::account(const std::string &key, const Entry &entry) {
+  auto it = m_index.find(key);
+  if (it != m_index.end())
+    m_deadBytes += recordSize(key.size(), it->second.length);
+  if (entry.format == Format::Removed) {
+    m_deadBytes += recordSize(key.size(), 0);
+    if (it != m_index.end())
+      m_index.erase(it);
+  } else if (it != m_index.end()) {
+    it->second = entry;
+  } else {
+    m_index.emplace(key, entry);
+  }
+}
+bool ThumbnailStore::remap() {
+  auto file = utils::MappedFile::map(m_fd);
+  if (!file) {
+    LOG_ERROR("Failed to map thumbnail pack: " + m_packPath.string());
+    return false;
+  }
+  m_map = std::move(file);
+  return true;
+}
+bool ThumbnailStore::catchUp(PackLock &lock) {
+  struct stat ours {};
+  struct stat onDisk {};
+  bool replaced = ::fstat(m_fd, &ours) != 0 ||
+                  ::stat(m_packPath.c_str(), &onDisk) != 0 ||
+                  ours.st_ino != onDisk.st_ino || ours.st_dev != onDisk.st_dev;
+  if (replaced) {
+    // Another process compacted or cleared the store.
+    int fd = openPackFile(m_packPath);
+    if (fd < 0)
+      return false;
+    lock.rebind(fd);
+    ::close(m_fd);
+    m_fd = fd;
+    return loadPack();
+  }
+  uint64_t generation = 0;
+  if (!readGeneration(m_fd, generation) || generation != m_generation ||
+      static_cast<uint64_t>(ours.st_size) < m_packSize)
+    return loadPack();
+  if (static_cast<uint64_t>(ours.st_size) > m_packSize) {
+    if (!remap())
+      return false;
+    scanTail(static_cast<uint64_t>(ours.st_size));
+  }
+  return true;
+}
+bool ThumbnailStore::contains(const std::string &key) const {
+  std::lock_guard<std::mutex> state(m_mutex);
+  return m_index.count(key) > 0;
+}
+std::optional<ThumbnailStore::Blob>
+ThumbnailStore::find(const std::string &key) {
+  std::lock_guard<std::mutex> state(m_mutex);
+  auto it = m_index.find(key);
+  if (it == m_index.end())
+    return std::nullopt;
+  const Entry &entry = it->second;
+  if (!m_map || entry.offset + entry.length > m_map->size()) {
+    if (!remap() || entry.offset + entry.length > m_map->size())
+      return std::nullopt;
+  }
+  return Blob{entry, m_map->data() + entry.offset, m_map};
+}
+bool ThumbnailStore::put(const std::string &key, Entry meta,
+                         const uint8_t *data, size_t size) {
+  if (meta.format == Format::Removed || size > UINT32_MAX)
+    return false;
+  std::lock_guard<std::mutex> writer(m_writeMutex);
+  if (m_fd < 0)
+    return false;
+  PackLock lock(m_fd);
+  std::lock_guard<std::mutex> state(m_mutex);
+  if (!catchUp(lock))
+    return false;
+  meta.length = static_cast<uint32_t>(size);
+  std::string record;
+  record.reserve(recordSize(key.size(), meta.length));
+  appendRecord(record, key, meta, data);
+  if (!writeAt(m_fd, record, m_packSize)) {
+    LOG_WARN("Failed to append to thumbnail pack: " + m_packPath.string());
+    return false;
+  }
+  meta.offset = m_packSize + kRecordHeaderSize + key.size();
+  m_packSize += record.size();
+  account(key, meta);
+  return true;
+}
+bool ThumbnailStore::erase(const std::string &key) {
+  std::lock_guard<std::mutex> writer(m_writeMutex);
+  if (m_fd < 0)
+    return false;
+  PackLock lock(m_fd);
+  std::lock_guard<std::mutex> state(m_mutex);
+  if (!catchUp(lock) || m_index.count(key) == 0)
+    return false;
+  Entry removed;
+  removed.format = Format::Removed;
+  std::string record;
+  appendRecord(record, key, removed, nullptr);
+  if (!writeAt(m_fd, record, m_packSize))
+    return false;
+  m_packSize += record.size();
+  account(key, removed);
+  return true;
+}
+void ThumbnailStore::clear() {
+  std::lock_guard<std::mutex> writer(m_writeMutex);
+  if (m_fd < 0)
+    return;
+  PackLock lock(m_fd);
+  rewrite(lock, {}, nullptr);
+}
+ThumbnailStore::Stats ThumbnailStore::stats() const {
+  std::lock_guard<std::mutex> state(m_mutex);
+  Stats stats;
+  stats.entries = m_index.size();
+  stats.packBytes = m_packSize;
+  stats.liveBytes = m_packSize - kPackHeaderSize - m_deadBytes;
+  return stats;
+}
+bool ThumbnailStore::wantsCompaction() const {
+  std::lock_guard<std::mutex> state(m_mutex);
+  return m_deadBytes >= kMinCompactionBytes && m_deadBytes * 2 >= m_packSize;
+}
+bool ThumbnailStore::compact(uint64_t budgetBytes) {
+  std::lock_guard<std::mutex> writer(m_writeMutex);
+  if (m_fd < 0)
+    return false;
+  PackLock lock(m_fd);
+  Snapshot live;
+  std::shared_ptr<const utils::MappedFile> map;
+  {
+    std::lock_guard<std::mutex> state(m_mutex);
+    if (!catchUp(lock))
+      return false;
+    live.assign(m_index.begin(), m_index.end());
+    map = m_map;
+  }
+  // Pack order is write order; keep the newest records that fit.
+  std::sort(live.begin(), live.end(), [](const auto &a, const auto &b) {
+    return a.second.offset < b.second.offset;
+  });
+  if (budgetBytes > 0) {
+    uint64_t kept = 0;
+    size_t first = live.size();
+    while (first > 0) {
+      const auto &[key, entry] = live[first - 1];
+      uint64_t size = recordSize(key.size(), entry.length);
+      if (kept + size > budgetBytes)
+        break;
+      kept += size;
+      --first;
+    }
+    live.erase(live.begin(), live.begin() + static_cast<ptrdiff_t>(first));
+  }
+  return rewrite(lock, live, map);
+}
+bool ThumbnailStore::rewrite(
+    PackLock &lock, const Snapshot &live,
+    const std::shared_ptr<const utils::MappedFile> &map) {
+  const uint64_t before = stats().packBytes;
+  std::filesystem::path tmpPath = m_packPath;
+  tmpPath += ".compacting";
+  int fd = openPackFile(tmpPath, O_TRUNC);
+  if (fd < 0) {
+    LOG_WARN("Failed to create " + tmpPath.string());
+    return false;
+  }
+  const uint64_t generation = newGeneration();
+  std::unordered_map<std::string, Entry> index;
+  index.reserve(live.size());
+  std::string buffer = encodeHeader(generation);
+  uint64_t written = 0;
+  bool ok = true;
+  for (const auto &[key, entry] : live) {
+    Entry moved = entry;
+    moved.offset = written + buffer.size() + kRecordHeaderSize + key.size();
+    appendRecord(buffer, key, moved, map->data() + entry.offset);
+    index.emplace(key, moved);
+    if (buffer.size() >= kRewriteChunk) {
+      ok = writeAt(fd, buffer, written);
+      written += buffer.size();
+      buffer.clear();
+      if (!ok)
+        break;
+    }
+  }
+  ok = ok && writeAt(fd, buffer, written);
+  written += buffer.size();
+  ok = ok && ::fsync(fd) == 0;
+  // Lock the new pack before it becomes visible, so other processes wait
+  // for its index instead of rescanning it.
+  std::error_code ec;
+  if (ok) {
+    while (::flock(fd, LOCK_EX) != 0 && errno == EINTR) {
+    }
+    std::filesystem::rename(tmpPath, m_packPath, ec);
+    ok = !ec;
+  }
+  if (!ok) {
+    LOG_WARN("Failed to rewrite thumbnail pack: " + m_packPath.string());
+    ::close(fd);
+    std::filesystem::remove(tmpPath, ec);
+    return false;
+  }
+  lock.rebind(fd);
+  std::string encoded;
+  {
+    std::lock_guard<std::mutex> state(m_mutex);
+    ::close(m_fd);
+    m_fd = fd;
+    m_generation = generation;
+    m_index = std::move(index);
+    m_packSize = written;
+    m_deadBytes = 0;
+    m_savedSize = 0;
+    remap();
+    encoded = encodeIndex();
+  }
+  if (utils::FileUtils::writeFileAtomic(m_indexPath, encoded)) {
+    std::lock_guard<std::mutex> state(m_mutex);
+    m_savedSize = written;
+  }
+  LOG_INFO("Compacted thumbnail pack from " + std::to_string(before >> 10) +
+           " KiB to " + std::to_string(written >> 10) + " KiB");
+  return true;
+}
+std::string ThumbnailStore::encodeIndex() const {
+  std::string out(kIndexMagic, 4);
+  putU32(out, kVersion);
+  putU64(out, m_generation);
+  putU64(out, m_packSize);
+  putU64(out, m_index.size());
+  for (const auto &[key, entry] : m_index) {
+    putString(out, key);
+    putU64(out, entry.offset);
+    putU32(out, entry.length);
+    putU32(out, entry.width);
+    putU32(out, entry.height);
+    putU32(out, static_cast<uint32_t>(entry.format));
+    putU64(out, static_cast<uint64_t>(entry.sourceMtime));
+    putU64(out, entry.sourceSize);
+  }
+  return out;
+}
+bool ThumbnailStore::flush() {
+  std::lock_guard<std::mutex> writer(m_writeMutex);
+  if (m_fd < 0)
+    return false;
+  PackLock lock(m_fd);
+  std::string encoded;
+  uint64_t covered = 0;
+  {
+    std::lock_guard<std::mutex> state(m_mutex);
+    if (!catchUp(lock))
+      return false;
+    if (m_packSize == m_savedSize)
+      return true;
+    encoded = encodeIndex();
+    covered = m_packSize;
+  }
+  if (!utils::FileUtils::writeFileAtomic(m_indexPath, encoded))
+    return false;
+  std::lock_guard<std::mutex> state(m_mutex);
+  m_savedSize = covered;
+  return true;
+}
+#else
+// The pack is built on pwrite and flock; without them there is no store and
+// every lookup misses.
+ThumbnailStore::SourceStamp
+ThumbnailStore::SourceStamp::of(const std::filesystem::path &) {
+  return {};
+}
+ThumbnailStore::ThumbnailStore(std::filesystem::path dir)
+    : m_packPath(dir / "thumbnails.pack"),
+      m_indexPath(dir / "thumbnails.idx") {}
+ThumbnailStore::~ThumbnailStore() = default;
+bool ThumbnailStore::open() { return false; }
+bool ThumbnailStore::contains(const std::string &) const { return false; }
+std::optional<ThumbnailStore::Blob> ThumbnailStore::find(const std::string &) {
+  return std::nullopt;
+}
+bool ThumbnailStore::put(const std::string &, Entry, const uint8_t *, size_t) {
+  return false;
+}
+bool ThumbnailStore::erase(const std::string &) { return false; }
+void ThumbnailStore::clear() {}
+ThumbnailStore::Stats ThumbnailStore::stats() const { return {}; }
+bool ThumbnailStore::wantsCompaction() const { return false; }
+bool ThumbnailStore::compact(uint64_t) { return false; }
+bool ThumbnailStore::flush() { return false; }
+#endif
+} // namespace bwp::wallpaper
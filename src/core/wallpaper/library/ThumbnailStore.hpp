@@ -0,0 +1,114 @@
+#pragma once
+#include "../../utils/MappedFile.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+namespace bwp::wallpaper {
+// Packed thumbnail store ("thumbnails.pack" + "thumbnails.idx").
+//
+// Every thumbnail is appended to one pack file as a self-describing record
+// (header | key | payload); the index maps keys to (offset, length, dims,
+// source mtime and size). The pack is mmap'd once, so a hit is a hash lookup and a
+// pointer into the mapping; the mapping is only refreshed when a lookup
+// lands past its end.
+//
+// Replacing or erasing a thumbnail leaves dead bytes behind until compact()
+// rewrites the live records into a new pack. The index is saved by flush()
+// and after compaction; records appended since are recovered by walking the
+// tail of the pack on open. Appends take an flock on the pack, so the GUI
+// and the daemon can share one store: each catches up on the other's
+// records (or a compaction it ran) before writing.
+class ThumbnailStore {
+public:
+  static constexpr uint32_t kVersion = 2;
+  enum class Format : uint32_t { Removed = 0, Png = 1, Qoi = 2 };
+  // What a thumbnail is checked against on lookup: a file replaced in place
+  // changes mtime or size, and its old thumbnail is then stale. Zero for a
+  // file that cannot be stat'ed.
+  struct SourceStamp {
+    int64_t mtime = 0; // nanoseconds
+    uint64_t size = 0;
+    static SourceStamp of(const std::filesystem::path &path);
+    bool operator==(const SourceStamp &) const = default;
+  };
+  struct Entry {
+    uint64_t offset = 0; // payload start within the pack
+    uint32_t length = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    Format format = Format::Png;
+    // The source file as it was when the thumbnail was made.
+    int64_t sourceMtime = 0;
+    uint64_t sourceSize = 0;
+    SourceStamp source() const { return {sourceMtime, sourceSize}; }
+    // True if the thumbnail was made from `path` as it is now.
+    bool isCurrent(const std::filesystem::path &path) const {
+      return source() == SourceStamp::of(path);
+    }
+  };
+  // Points into a mapping it keeps alive, so it stays valid across
+  // compactions and remaps.
+  struct Blob {
+    Entry entry;
+    const uint8_t *data = nullptr;
+    std::shared_ptr<const utils::MappedFile> file;
+  };
+  struct Stats {
+    size_t entries = 0;
+    uint64_t liveBytes = 0;
+    uint64_t packBytes = 0;
+  };
+  explicit ThumbnailStore(std::filesystem::path dir);
+  ~ThumbnailStore();
+  ThumbnailStore(const ThumbnailStore &) = delete;
+  ThumbnailStore &operator=(const ThumbnailStore &) = delete;
+  bool open();
+  bool contains(const std::string &key) const;
+  std::optional<Blob> find(const std::string &key);
+  // `meta.offset` and `meta.length` are filled in by the store.
+  bool put(const std::string &key, Entry meta, const uint8_t *data,
+           size_t size);
+  bool erase(const std::string &key);
+  void clear();
+  Stats stats() const;
+  // True once dead records make up half of a pack worth rewriting.
+  bool wantsCompaction() const;
+  // Rewrites the live records into a fresh pack. With a budget, the oldest
+  // records that do not fit are dropped. Blocks writers, not readers.
+  bool compact(uint64_t budgetBytes = 0);
+  bool flush();
+  const std::filesystem::path &packPath() const { return m_packPath; }
+
+private:
+  class PackLock;
+  using Snapshot = std::vector<std::pair<std::string, Entry>>;
+  bool loadPack();
+  bool loadIndex(uint64_t packSize);
+  void scanTail(uint64_t end);
+  bool catchUp(PackLock &lock);
+  bool rewrite(PackLock &lock, const Snapshot &live,
+               const std::shared_ptr<const utils::MappedFile> &map);
+  bool remap();
+  std::string encodeIndex() const;
+  void account(const std::string &key, const Entry &entry);
+  std::filesystem::path m_packPath;
+  std::filesystem::path m_indexPath;
+  // Writers (put, erase, compaction) serialize here before taking the pack
+  // lock; m_mutex only guards the in-memory state and is held briefly.
+  std::mutex m_writeMutex;
+  mutable std::mutex m_mutex;
+  int m_fd = -1;
+  uint64_t m_generation = 0;
+  uint64_t m_packSize = 0; // bytes of the pack already indexed
+  uint64_t m_deadBytes = 0;
+  uint64_t m_savedSize = 0; // pack bytes covered by the index on disk
+  std::unordered_map<std::string, Entry> m_index;
+  std::shared_ptr<const utils::MappedFile> m_map;
+};
+} // namespace bwp::wallpaper
@@ -0,0 +1,125 @@
+#include "TrigramIndex.hpp"
+#include <algorithm>
+namespace bwp::wallpaper {
+namespace {
+char lowerAscii(char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+std::string lowered(std::string_view s) {
+  std::string out(s);
+  std::transform(out.begin(), out.end(), out.begin(), lowerAscii);
+  return out;
+}
+} // namespace
+std::vector<uint32_t> TrigramIndex::trigramsOf(std::string_view text) {
+  std::vector<uint32_t> grams;
+  if (text.size() < 3)
+    return grams;
+  grams.reserve(text.size() - 2);
+  for (size_t i = 0; i + 3 <= text.size(); ++i) {
+    unsigned char a = text[i], b = text[i + 1], c = text[i + 2];
+    if (a == '\n' || b == '\n' || c == '\n')
+      continue;
+    grams.push_back((uint32_t{a} << 16) | (uint32_t{b} << 8) | c);
+  }
+  std::sort(grams.begin(), grams.end());
+  grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+  return grams;
+}
+void TrigramIndex::set(DocId doc, const std::vector<std::string_view> &fields) {
+  remove(doc);
+  std::string text;
+  for (const auto &field : fields) {
+    if (!text.empty())
+      text += '\n';
+    text += lowered(field);
+  }
+  for (uint32_t gram : trigramsOf(text)) {
+    auto &posting = m_postings[gram];
+    // Fresh documents usually take the highest id, making this an append.
+    if (posting.empty() || posting.back() < doc) {
+      posting.push_back(doc);
+    } else {
+      posting.insert(std::lower_bound(posting.begin(), posting.end(), doc),
+                     doc);
+    }
+  }
+  if (doc >= m_texts.size()) {
+    m_texts.resize(doc + 1);
+    m_present.resize(doc + 1, false);
+  }
+  m_texts[doc] = std::move(text);
+  m_present[doc] = true;
+  m_count++;
+}
+void TrigramIndex::remove(DocId doc) {
+  if (doc >= m_present.size() || !m_present[doc])
+    return;
+  for (uint32_t gram : trigramsOf(m_texts[doc])) {
+    auto it = m_postings.find(gram);
+    if (it == m_postings.end())
+      continue;
+    auto &posting = it->second;
+    auto pos = std::lower_bound(posting.begin(), posting.end(), doc);
+    if (pos != posting.end() && *pos == doc)
+      posting.erase(pos);
+    if (posting.empty())
+      m_postings.erase(it);
+  }
+  m_texts[doc].clear();
+  m_texts[doc].shrink_to_fit();
+  m_present[doc] = false;
+  m_count--;
+}
+void TrigramIndex::clear() {
+  m_texts.clear();
+  m_present.clear();
+  m_postings.clear();
+  m_count = 0;
+}
+std::vector<TrigramIndex::DocId>
+TrigramIndex::search(std::string_view query) const {
+  std::string q = lowered(query);
+  std::vector<DocId> result;
+  // Fields are newline-separated; no single field can contain one.
+  if (q.find('\n') != std::string::npos)
+    return result;
+  if (q.size() < 3) {
+    for (DocId doc = 0; doc < m_texts.size(); ++doc) {
+      if (m_present[doc] && m_texts[doc].find(q) != std::string::npos)
+        result.push_back(doc);
+    }
+    return result;
+  }
+  std::vector<const std::vector<DocId> *> lists;
+  for (uint32_t gram : trigramsOf(q)) {
+    auto it = m_postings.find(gram);
+    if (it == m_postings.end())
+      return result;
+    lists.push_back(&it->second);
+  }
+  if (lists.empty())
+    return result;
+  // A single trigram is its own proof: postings never span fields.
+  if (q.size() == 3)
+    return *lists.front();
+  std::sort(lists.begin(), lists.end(),
+            [](const auto *a, const auto *b) { return a->size() < b->size(); });
+  std::vector<DocId> candidates = *lists.front();
+  std::vector<DocId> scratch;
+  for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+    scratch.clear();
+    std::set_intersection(candidates.begin(), candidates.end(),
+                          lists[i]->begin(), lists[i]->end(),
+                          std::back_inserter(scratch));
+    candidates.swap(scratch);
+  }
+  // Sharing every trigram does not imply containing the query.
+  result.reserve(candidates.size());
+  for (DocId doc : candidates) {
+    if (m_texts[doc].find(q) != std::string::npos)
+      result.push_back(doc);
+  }
+  return result;
+}
+} // namespace bwp::wallpaper
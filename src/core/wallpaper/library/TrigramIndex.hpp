@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+namespace bwp::wallpaper {
+// Case-insensitive substring index over small per-document texts.
+//
+// Each document is a set of fields (title, filename, tags) stored lowercased
+// and joined with '\n', so no trigram spans two fields. Posting lists are
+// sorted document ids; a query of three or more bytes intersects the
+// postings of its trigrams (smallest first) and verifies the survivors, so
+// the cost follows the rarest trigram rather than the library size.
+// Shorter queries fall back to scanning the stored texts.
+class TrigramIndex {
+public:
+  using DocId = uint32_t;
+  void set(DocId doc, const std::vector<std::string_view> &fields);
+  void remove(DocId doc);
+  void clear();
+  // Matching documents in ascending id order. An empty query matches all.
+  std::vector<DocId> search(std::string_view query) const;
+  size_t size() const { return m_count; }
+
+private:
+  static std::vector<uint32_t> trigramsOf(std::string_view text);
+  std::vector<std::string> m_texts;
+  std::vector<bool> m_present;
+  std::unordered_map<uint32_t, std::vector<DocId>> m_postings;
+  size_t m_count = 0;
+};
+} // namespace bwp::wallpaper
@@ -3,10 +3,14 @@
 #include "../core/monitor/MonitorManager.hpp"
 #include "../core/slideshow/SlideshowManager.hpp"
 #include "../core/utils/Constants.hpp"
+#include "../core/utils/ContentHash.hpp"
 #include "../core/utils/Logger.hpp"
+#include "../core/wallpaper/ThumbnailCache.hpp"
 #include "../core/wallpaper/WallpaperLibrary.hpp"
 #include "../core/wallpaper/WallpaperManager.hpp"
+#include "../core/wallpaper/library/LibraryCodec.hpp"
 
+#include <clocale>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
@@ -60,6 +64,8 @@ private:
   }
   static void onStartup(GtkApplication *, gpointer user_data) {
     auto *self = static_cast<DaemonApp *>(user_data);
+    // After GTK applied the user's locale; libmpv needs a C LC_NUMERIC.
+    std::setlocale(LC_NUMERIC, "C");
     if (!setupServices(self)) {
       LOG_ERROR("Service setup failed, requesting shutdown.");
       g_application_quit(G_APPLICATION(self->m_app));
@@ -188,6 +194,75 @@ private:
       }
       return arr.dump();
     });
+    self->m_ipcService->setQueryHandler([](const std::string &expr) -> std::string {
+      LOG_INFO("IPC Command: Query " + expr);
+      auto &lib = bwp::wallpaper::WallpaperLibrary::getInstance();
+      lib.initialize();
+      std::string error;
+      auto results = lib.query(expr, &error);
+      nlohmann::json j;
+      if (!error.empty()) {
+        j["error"] = error;
+        return j.dump();
+      }
+      nlohmann::json arr = nlohmann::json::array();
+      for (const auto &info : results) {
+        arr.push_back(bwp::wallpaper::LibraryCodec::toJson(info));
+      }
+      j["wallpapers"] = arr;
+      return j.dump();
+    });
+    self->m_ipcService->setFindDuplicatesHandler([]() -> std::string {
+      LOG_INFO("IPC Command: FindDuplicates");
+      auto &lib = bwp::wallpaper::WallpaperLibrary::getInstance();
+      lib.initialize();
+      nlohmann::json groups = nlohmann::json::array();
+      for (const auto &group : lib.findDuplicates()) {
+        nlohmann::json g;
+        g["size"] = group.size;
+        g["hash"] = bwp::utils::ContentHash::toHex(group.hash);
+        nlohmann::json members = nlohmann::json::array();
+        for (const auto &id : group.ids) {
+          auto info = lib.getWallpaper(id);
+          members.push_back({{"id", id}, {"path", info ? info->path : ""}});
+        }
+        g["wallpapers"] = members;
+        groups.push_back(g);
+      }
+      nlohmann::json j;
+      j["groups"] = groups;
+      return j.dump();
+    });
+    self->m_ipcService->setFindNearDuplicatesHandler([](int radius) -> std::string {
+      LOG_INFO("IPC Command: FindNearDuplicates " + std::to_string(radius));
+      auto &lib = bwp::wallpaper::WallpaperLibrary::getInstance();
+      lib.initialize();
+      // The GUI's scanner hashes new entries in the background; whatever
+      // it has not reached yet is hashed here, in one journal batch.
+      auto &thumbs = bwp::wallpaper::ThumbnailCache::getInstance();
+      lib.beginBulk();
+      lib.snapshot()->forEach([&](bwp::wallpaper::WallpaperView view) {
+        if (view.phash() != 0)
+          return;
+        uint64_t phash = thumbs.computePerceptualHash(
+            view.path(), bwp::wallpaper::ThumbnailCache::Size::Small);
+        if (phash != 0)
+          lib.updatePerceptualHash(std::string(view.id()), phash);
+      });
+      lib.commit();
+      nlohmann::json clusters = nlohmann::json::array();
+      for (const auto &ids : lib.findNearDuplicates(radius)) {
+        nlohmann::json members = nlohmann::json::array();
+        for (const auto &id : ids) {
+          auto info = lib.getWallpaper(id);
+          members.push_back({{"id", id}, {"path", info ? info->path : ""}});
+        }
+        clusters.push_back({{"wallpapers", members}});
+      }
+      nlohmann::json j;
+      j["groups"] = clusters;
+      return j.dump();
+    });
     if (!self->m_ipcService->initialize()) {
       LOG_ERROR("Failed to initialize IPC Service.");
       return false;
@@ -3,9 +3,11 @@
 #include "../core/monitor/MonitorManager.hpp"
 #include "../core/steam/SteamService.hpp"
 #include "../core/utils/Logger.hpp"
+#include "../core/wallpaper/LibraryWatcher.hpp"
 #include "../core/wallpaper/WallpaperManager.hpp"
 #include "MainWindow.hpp"
 #include "dialogs/FluidSetupWizard.hpp"
+#include <clocale>
 #include <iostream>
 #include <wayland-client.h>
 namespace bwp::gui {
@@ -32,6 +34,7 @@ Application::~Application() {
   // Ensure config is saved before shutdown (handles pending debounced saves)
   bwp::config::ConfigManager::getInstance().save();
   bwp::wallpaper::WallpaperManager::getInstance().shutdown();
+  bwp::wallpaper::LibraryWatcher::getInstance().stop();
   if (s_cssMonitor) {
     g_object_unref(s_cssMonitor);
     s_cssMonitor = nullptr;
@@ -145,12 +148,18 @@ void Application::onActivate(GApplication *app, gpointer) {
 }
 void Application::onStartup(GApplication *, gpointer) {
   bwp::utils::Logger::log(bwp::utils::LogLevel::INFO, "Application startup");
+  // GTK has just applied the user's locale. libmpv (video wallpapers and
+  // thumbnail frame grabs) refuses a non-C LC_NUMERIC, and threads must not
+  // switch it, so it is set once here.
+  std::setlocale(LC_NUMERIC, "C");
   if (!bwp::monitor::MonitorManager::getInstance().initialize()) {
     bwp::utils::Logger::log(bwp::utils::LogLevel::ERR,
                             "Failed to initialize MonitorManager");
   }
   // Load saved Steam API key from config into memory
   bwp::steam::SteamService::getInstance().initialize();
+  // Pick up wallpapers added to library folders while the app is open
+  bwp::wallpaper::LibraryWatcher::getInstance().start();
   loadStylesheet();
   setupCssHotReload();
   ensureBackgroundServices();
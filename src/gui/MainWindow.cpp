@@ -181,12 +181,11 @@ MainWindow::MainWindow(AdwApplication *app) {
         LOG_ERROR("Slideshow: failed to connect to daemon via IPC");
       }
     }
-    auto all = lib.getAllWallpapers();
     int favCount = 0;
-    for (const auto &w : all) {
-      if (w.favorite)
+    lib.snapshot()->forEach([&favCount](const auto &w) {
+      if (w.favorite())
         favCount++;
-    }
+    });
     if (m_sidebar)
       m_sidebar->updateBadge("favorites", favCount);
   });
@@ -340,12 +339,12 @@ void MainWindow::setupUi() {
   m_folderView = std::make_unique<FolderView>();
   adw_view_stack_add_named(ADW_VIEW_STACK(m_contentStack),
                            m_folderView->getWidget(), "folder");
-  auto all = bwp::wallpaper::WallpaperLibrary::getInstance().getAllWallpapers();
   int favCount = 0;
-  for (const auto &w : all) {
-    if (w.favorite)
-      favCount++;
-  }
+  bwp::wallpaper::WallpaperLibrary::getInstance().snapshot()->forEach(
+      [&favCount](const auto &w) {
+        if (w.favorite())
+          favCount++;
+      });
   m_sidebar->updateBadge("favorites", favCount);
 }
 void MainWindow::ensureWorkshopView() {
@@ -0,0 +1,17 @@
+#pragma once
+#include <functional>
+#include <glib.h>
+namespace bwp::gui {
+// Runs `task` once on the default main context at idle priority. Safe to
+// call from any thread.
+inline void runOnMainLoop(std::function<void()> task) {
+  g_idle_add(
+      +[](gpointer data) -> gboolean {
+        auto *fn = static_cast<std::function<void()> *>(data);
+        (*fn)();
+        delete fn;
+        return G_SOURCE_REMOVE;
+      },
+      new std::function<void()>(std::move(task)));
+}
+}  
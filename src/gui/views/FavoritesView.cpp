@@ -1,5 +1,6 @@
 #include "FavoritesView.hpp"
 #include "../../core/wallpaper/WallpaperLibrary.hpp"
+#include "../utils/MainLoop.hpp"
 namespace bwp::gui {
 FavoritesView::FavoritesView() {
   setupUi();
@@ -10,40 +11,50 @@ FavoritesView::FavoritesView() {
         return G_SOURCE_REMOVE;
       },
       this);
+  m_changeQueue = std::make_unique<bwp::wallpaper::ChangeSetQueue>(
+      runOnMainLoop,
+      [this](const bwp::wallpaper::LibraryChangeSet &changes) {
+        applyChanges(changes);
+      });
   auto &lib = bwp::wallpaper::WallpaperLibrary::getInstance();
-  m_changeCallbackId = lib.addChangeCallbackWithId(
-      [this](const bwp::wallpaper::WallpaperInfo &changedInfo) {
-        auto *info = new bwp::wallpaper::WallpaperInfo(changedInfo);
-        g_idle_add(
-            +[](gpointer data) -> gboolean {
-              auto *pair =
-                  static_cast<std::pair<FavoritesView *,
-                                        bwp::wallpaper::WallpaperInfo *> *>(
-                      data);
-              auto *self = pair->first;
-              auto *changed = pair->second;
-              if (self->m_grid) {
-                if (changed->favorite) {
-                  self->m_grid->updateWallpaperInStore(*changed);
-                  self->m_grid->addWallpaper(*changed);
-                  self->m_grid->notifyDataChanged();
-                } else {
-                  self->loadFavorites();
-                }
-              }
-              delete changed;
-              delete pair;
-              return G_SOURCE_REMOVE;
-            },
-            new std::pair<FavoritesView *, bwp::wallpaper::WallpaperInfo *>(
-                this, info));
+  m_changeSetCallbackId = lib.addChangeSetCallback(
+      [this](const bwp::wallpaper::LibraryChangeSet &changes) {
+        m_changeQueue->push(changes);
       });
 }
 FavoritesView::~FavoritesView() {
-  if (m_changeCallbackId != 0) {
-    bwp::wallpaper::WallpaperLibrary::getInstance().removeChangeCallback(m_changeCallbackId);
+  if (m_changeSetCallbackId != 0) {
+    bwp::wallpaper::WallpaperLibrary::getInstance().removeChangeSetCallback(
+        m_changeSetCallbackId);
   }
 }
+void FavoritesView::applyChanges(
+    const bwp::wallpaper::LibraryChangeSet &changes) {
+  if (!m_grid)
+    return;
+  auto snapshot = bwp::wallpaper::WallpaperLibrary::getInstance().snapshot();
+  std::vector<std::string> removed = changes.removed;
+  std::vector<bwp::wallpaper::WallpaperInfo> added;
+  auto consider = [&](const std::string &id) {
+    auto view = snapshot->find(id);
+    if (!view || !view.favorite()) {
+      removed.push_back(id);
+      return;
+    }
+    auto info = view.toInfo();
+    if (!m_grid->updateWallpaperInStore(info))
+      added.push_back(std::move(info));
+  };
+  for (const auto &id : changes.added)
+    consider(id);
+  for (const auto &id : changes.updated)
+    consider(id);
+  m_grid->removeWallpapers(removed);
+  m_grid->addWallpapers(added);
+  m_grid->notifyDataChanged();
+  gtk_stack_set_visible_child_name(GTK_STACK(m_stack),
+                                   m_grid->count() == 0 ? "empty" : "grid");
+}
 void FavoritesView::setupUi() {
   m_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
   GtkWidget *header = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 12);
@@ -99,16 +110,14 @@ void FavoritesView::loadFavorites() {
   if (!m_grid)
     return;
   m_grid->clear();
-  auto &lib = bwp::wallpaper::WallpaperLibrary::getInstance();
-  auto wallpapers = lib.getAllWallpapers();
-  int favoriteCount = 0;
-  for (const auto &info : wallpapers) {
-    if (info.favorite) {
-      m_grid->addWallpaper(info);
-      favoriteCount++;
-    }
-  }
-  if (favoriteCount == 0) {
+  std::vector<bwp::wallpaper::WallpaperInfo> favorites;
+  bwp::wallpaper::WallpaperLibrary::getInstance().snapshot()->forEach(
+      [&favorites](const auto &view) {
+        if (view.favorite())
+          favorites.push_back(view.toInfo());
+      });
+  m_grid->addWallpapers(favorites);
+  if (favorites.empty()) {
     gtk_stack_set_visible_child_name(GTK_STACK(m_stack), "empty");
   } else {
     gtk_stack_set_visible_child_name(GTK_STACK(m_stack), "grid");
@@ -1,5 +1,6 @@
 #pragma once
 #include "../widgets/WallpaperGrid.hpp"
+#include "../../core/wallpaper/library/LibraryChangeSet.hpp"
 #include <adwaita.h>
 #include <functional>
 #include <gtk/gtk.h>
@@ -14,12 +15,14 @@ public:
 private:
   void setupUi();
   void loadFavorites();
+  void applyChanges(const bwp::wallpaper::LibraryChangeSet &changes);
   GtkWidget *m_box;
   GtkWidget *m_stack;
   GtkWidget *m_emptyState;
   GtkWidget *m_goToLibraryButton = nullptr;
   std::unique_ptr<WallpaperGrid> m_grid;
   std::function<void()> m_goToLibraryCallback;
-  int m_changeCallbackId = 0;
+  std::unique_ptr<bwp::wallpaper::ChangeSetQueue> m_changeQueue;
+  int m_changeSetCallbackId = 0;
 };
 }  
@@ -4,6 +4,7 @@
 #include "../../core/utils/Logger.hpp"
 #include "../../core/wallpaper/LibraryScanner.hpp"
 #include "../../core/wallpaper/WallpaperLibrary.hpp"
+#include "../utils/MainLoop.hpp"
 #include <filesystem>
 namespace bwp::gui {
 static constexpr int PREVIEW_PANEL_WIDTH = 300;
@@ -18,6 +19,14 @@ LibraryView::LibraryView() {
       this);
 }
 LibraryView::~LibraryView() {
+  auto &scanner = bwp::wallpaper::LibraryScanner::getInstance();
+  scanner.setCallback(nullptr);
+  scanner.setProgressCallback(nullptr);
+  scanner.setCompletionCallback(nullptr);
+  if (m_changeSetCallbackId != 0) {
+    bwp::wallpaper::WallpaperLibrary::getInstance().removeChangeSetCallback(
+        m_changeSetCallbackId);
+  }
 }
 void LibraryView::setupUi() {
   m_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
@@ -159,6 +168,24 @@ void LibraryView::setupUi() {
                    this);
   gtk_box_append(GTK_BOX(headerBox), addBtn);
   gtk_box_append(GTK_BOX(m_box), headerBox);
+  GtkWidget *scanBox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 4);
+  gtk_widget_set_margin_start(scanBox, 8);
+  gtk_widget_set_margin_end(scanBox, 8);
+  gtk_widget_set_margin_bottom(scanBox, 4);
+  m_scanLabel = gtk_label_new(nullptr);
+  gtk_label_set_xalign(GTK_LABEL(m_scanLabel), 0.0f);
+  gtk_label_set_ellipsize(GTK_LABEL(m_scanLabel), PANGO_ELLIPSIZE_MIDDLE);
+  gtk_widget_add_css_class(m_scanLabel, "dim-label");
+  gtk_widget_add_css_class(m_scanLabel, "caption");
+  gtk_box_append(GTK_BOX(scanBox), m_scanLabel);
+  m_scanProgress = gtk_progress_bar_new();
+  gtk_box_append(GTK_BOX(scanBox), m_scanProgress);
+  m_scanRevealer = gtk_revealer_new();
+  gtk_revealer_set_transition_type(GTK_REVEALER(m_scanRevealer),
+                                   GTK_REVEALER_TRANSITION_TYPE_SLIDE_DOWN);
+  gtk_revealer_set_child(GTK_REVEALER(m_scanRevealer), scanBox);
+  gtk_revealer_set_reveal_child(GTK_REVEALER(m_scanRevealer), FALSE);
+  gtk_box_append(GTK_BOX(m_box), m_scanRevealer);
   GtkWidget *paned = gtk_paned_new(GTK_ORIENTATION_HORIZONTAL);
   gtk_widget_set_vexpand(paned, TRUE);
   gtk_widget_set_hexpand(paned, TRUE);
@@ -195,39 +222,99 @@ void LibraryView::setupUi() {
       }
     }
   });
+  // Transactions from the scanner and other threads fold into one diff that
+  // is applied on the next main-loop iteration.
+  m_changeQueue = std::make_unique<bwp::wallpaper::ChangeSetQueue>(
+      runOnMainLoop,
+      [this](const bwp::wallpaper::LibraryChangeSet &changes) {
+        applyChanges(changes);
+      });
   auto &lib = bwp::wallpaper::WallpaperLibrary::getInstance();
-  lib.setChangeCallback(
-      [this](const bwp::wallpaper::WallpaperInfo &changedInfo) {
-        auto *info = new bwp::wallpaper::WallpaperInfo(changedInfo);
-        g_idle_add(
-            +[](gpointer data) -> gboolean {
-              auto *pair =
-                  static_cast<std::pair<LibraryView *,
-                                        bwp::wallpaper::WallpaperInfo *> *>(
-                      data);
-              if (pair->first->m_grid) {
-                // Try update first; if not found, add as new wallpaper
-                if (!pair->first->m_grid->updateWallpaperInStore(*pair->second)) {
-                  pair->first->m_grid->addWallpaper(*pair->second);
-                }
-              }
-              delete pair->second;
-              delete pair;
-              return G_SOURCE_REMOVE;
-            },
-            new std::pair<LibraryView *, bwp::wallpaper::WallpaperInfo *>(this,
-                                                                          info));
+  m_changeSetCallbackId = lib.addChangeSetCallback(
+      [this](const bwp::wallpaper::LibraryChangeSet &changes) {
+        m_changeQueue->push(changes);
       });
 }
+void LibraryView::applyChanges(const bwp::wallpaper::LibraryChangeSet &changes) {
+  if (!m_grid)
+    return;
+  auto snapshot = bwp::wallpaper::WallpaperLibrary::getInstance().snapshot();
+  m_grid->removeWallpapers(changes.removed);
+  std::vector<bwp::wallpaper::WallpaperInfo> added;
+  for (const auto &id : changes.added) {
+    if (auto view = snapshot->find(id))
+      added.push_back(view.toInfo());
+  }
+  for (const auto &id : changes.updated) {
+    auto view = snapshot->find(id);
+    if (!view)
+      continue;
+    auto info = view.toInfo();
+    if (!m_grid->updateWallpaperInStore(info))
+      added.push_back(std::move(info));
+  }
+  m_grid->addWallpapers(added);
+}
+void LibraryView::updateTagList() {
+  auto tags = bwp::wallpaper::WallpaperLibrary::getInstance().getAllTags();
+  GtkStringList *newList = gtk_string_list_new(nullptr);
+  gtk_string_list_append(newList, "All Tags");
+  for (const auto &tag : tags) {
+    gtk_string_list_append(newList, tag.c_str());
+  }
+  gtk_drop_down_set_model(GTK_DROP_DOWN(m_filterCombo), G_LIST_MODEL(newList));
+  m_tagList = newList;
+}
+void LibraryView::showScanStatus() {
+  if (gtk_revealer_get_reveal_child(GTK_REVEALER(m_scanRevealer)))
+    return;
+  gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(m_scanProgress), 0.0);
+  gtk_revealer_set_reveal_child(GTK_REVEALER(m_scanRevealer), TRUE);
+}
+void LibraryView::onScanFound(size_t count) { m_scanFound += count; }
+void LibraryView::onScanProgress(const bwp::wallpaper::ScanProgress &progress) {
+  if (progress.isComplete)
+    return;
+  showScanStatus();
+  float percent = progress.getPercentage();
+  if (percent < 0.0f) {
+    gtk_progress_bar_pulse(GTK_PROGRESS_BAR(m_scanProgress));
+  } else {
+    gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(m_scanProgress),
+                                  percent / 100.0);
+  }
+  // Paths the main loop fell behind on were still found.
+  std::string text = "Scanning... " +
+                     std::to_string(m_scanFound + progress.foundDropped) +
+                     " found";
+  if (progress.filesPerSecond >= 1.0) {
+    text += ", " +
+            std::to_string(static_cast<int>(progress.filesPerSecond + 0.5)) +
+            " files/s";
+  }
+  if (progress.etaSeconds > 0) {
+    text += ", about ";
+    text += progress.etaSeconds < 60
+                ? std::to_string(progress.etaSeconds) + " s"
+                : std::to_string((progress.etaSeconds + 30) / 60) + " min";
+    text += " left";
+  }
+  gtk_label_set_text(GTK_LABEL(m_scanLabel), text.c_str());
+}
+void LibraryView::onScanComplete() {
+  gtk_revealer_set_reveal_child(GTK_REVEALER(m_scanRevealer), FALSE);
+  if (m_scanFound > 0)
+    LOG_INFO("Library scan delivered " + std::to_string(m_scanFound) +
+             " wallpapers");
+  m_scanFound = 0;
+  updateTagList();
+}
 void LibraryView::loadWallpapers() {
   auto &lib = bwp::wallpaper::WallpaperLibrary::getInstance();
   lib.initialize();
   if (m_grid) {
     m_grid->clear();
-    auto wallpapers = lib.getAllWallpapers();
-    for (const auto &info : wallpapers) {
-      m_grid->addWallpaper(info);
-    }
+    m_grid->addWallpapers(lib.getAllWallpapers());
     m_grid->setSortOrder(WallpaperGrid::SortOrder::NameAsc);
     g_idle_add(+[](gpointer data) -> gboolean {
         auto* grid = static_cast<WallpaperGrid*>(data);
@@ -238,15 +325,7 @@ void LibraryView::loadWallpapers() {
         return FALSE;
     }, m_grid.get());
   }
-  auto tags = lib.getAllTags();
-  GtkStringList *newList = gtk_string_list_new(nullptr);
-  gtk_string_list_append(newList, "All Tags");
-  for (const auto &tag : tags) {
-    gtk_string_list_append(newList, tag.c_str());
-  }
-  gtk_drop_down_set_model(GTK_DROP_DOWN(m_filterCombo), G_LIST_MODEL(newList));
-  m_tagList =
-      newList;  
+  updateTagList();
   auto paths =
       bwp::config::ConfigManager::getInstance().get<std::vector<std::string>>(
           "library.paths");
@@ -278,23 +357,20 @@ void LibraryView::loadWallpapers() {
                "manually.");
     }
   }
+  // Also reports scans started from Settings or the setup wizard. All three
+  // run on the main loop from the scanner's single tick.
   auto &scanner = bwp::wallpaper::LibraryScanner::getInstance();
-  scanner.setCallback(nullptr);
+  scanner.setCallback([this](const std::vector<std::string> &found) {
+    onScanFound(found.size());
+  });
+  scanner.setProgressCallback(
+      [this](const bwp::wallpaper::ScanProgress &progress) {
+        onScanProgress(progress);
+      });
+  scanner.setCompletionCallback([this](int) { onScanComplete(); });
   if (!paths.empty()) {
     scanner.scan(paths);
   }
-  g_timeout_add(
-      2000,
-      [](gpointer data) -> gboolean {
-        auto *self = static_cast<LibraryView *>(data);
-        auto &scanner = bwp::wallpaper::LibraryScanner::getInstance();
-        self->refresh();
-        if (scanner.isScanning()) {
-          return G_SOURCE_CONTINUE;
-        }
-        return G_SOURCE_REMOVE;
-      },
-      this);
 }
 void LibraryView::refresh() {
   if (!m_grid)
@@ -304,14 +380,7 @@ void LibraryView::refresh() {
   for (const auto &info : wallpapers) {
     m_grid->addWallpaper(info);
   }
-  auto tags = lib.getAllTags();
-  GtkStringList *newList = gtk_string_list_new(nullptr);
-  gtk_string_list_append(newList, "All Tags");
-  for (const auto &tag : tags) {
-    gtk_string_list_append(newList, tag.c_str());
-  }
-  gtk_drop_down_set_model(GTK_DROP_DOWN(m_filterCombo), G_LIST_MODEL(newList));
-  m_tagList = newList;
+  updateTagList();
 }
 void LibraryView::onAddWallpaper() {
   GtkRoot *root = gtk_widget_get_root(m_box);
@@ -2,6 +2,8 @@
 #include "../widgets/PreviewPanel.hpp"
 #include "../widgets/SearchBar.hpp"
 #include "../widgets/WallpaperGrid.hpp"
+#include "../../core/wallpaper/LibraryScanner.hpp"
+#include "../../core/wallpaper/library/LibraryChangeSet.hpp"
 #include <adwaita.h>
 #include <gtk/gtk.h>
 namespace bwp::gui {
@@ -16,6 +18,13 @@ private:
   void loadWallpapers();
   void onAddWallpaper();
   void onSourceFilterChanged(const std::string &source);
+  void applyChanges(const bwp::wallpaper::LibraryChangeSet &changes);
+  void updateTagList();
+  // Scanner callbacks; entries themselves arrive through the change queue.
+  void showScanStatus();
+  void onScanFound(size_t count);
+  void onScanProgress(const bwp::wallpaper::ScanProgress &progress);
+  void onScanComplete();
   GtkWidget *m_box;
   GtkWidget *m_toolbarView;  
   std::unique_ptr<SearchBar> m_searchBar;
@@ -24,5 +33,11 @@ private:
   GtkWidget *m_previewRevealer = nullptr;
   GtkWidget *m_filterCombo = nullptr;
   GtkStringList *m_tagList = nullptr;
+  GtkWidget *m_scanRevealer = nullptr;
+  GtkWidget *m_scanProgress = nullptr;
+  GtkWidget *m_scanLabel = nullptr;
+  size_t m_scanFound = 0;  // paths delivered during the current scan
+  std::unique_ptr<bwp::wallpaper::ChangeSetQueue> m_changeQueue;
+  int m_changeSetCallbackId = 0;
 };
 }  
@@ -349,12 +349,11 @@ void WorkshopView::updateBrowseGrid(
 void WorkshopView::refreshDownloadedIds() {
   m_downloadedIds.clear();
   auto &lib = bwp::wallpaper::WallpaperLibrary::getInstance();
-  auto allWallpapers = lib.getAllWallpapers();
-  for (const auto &wp : allWallpapers) {
-    if (wp.workshop_id > 0) {
-      m_downloadedIds.insert(std::to_string(wp.workshop_id));
+  lib.snapshot()->forEach([this](const auto &wp) {
+    if (wp.workshopId() > 0) {
+      m_downloadedIds.insert(std::to_string(wp.workshopId()));
     }
-  }
+  });
 }
 
 bool WorkshopView::isWorkshopItemDownloaded(
@@ -11,6 +11,7 @@
 #include "../dialogs/ErrorDialog.hpp"
 #include <algorithm>
 #include <cctype>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <filesystem>
@@ -335,11 +336,29 @@ void PreviewPanel::setWallpaper(const bwp::wallpaper::WallpaperInfo &info) {
   } catch (const std::exception &e) {
     LOG_DEBUG("Failed to get file size for preview: " + std::string(e.what()));
   }
-  if (info.type == bwp::wallpaper::WallpaperType::StaticImage) {
-    int w, h;
-    if (gdk_pixbuf_get_file_info(info.path.c_str(), &w, &h)) {
-      details += "\nRes: " + std::to_string(w) + "x" + std::to_string(h);
-    }
+  // Media details come from the scan-time header probe; only images scanned
+  // before it existed still need their header read here.
+  int w = info.width, h = info.height;
+  if (w <= 0 && info.type == bwp::wallpaper::WallpaperType::StaticImage &&
+      !gdk_pixbuf_get_file_info(info.path.c_str(), &w, &h)) {
+    w = h = 0;
+  }
+  if (w > 0 && h > 0) {
+    details += "\nRes: " + std::to_string(w) + "x" + std::to_string(h);
+  }
+  if (info.duration > 0) {
+    long secs = std::lround(info.duration);
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%ld:%02ld", secs / 60, secs % 60);
+    details += "\nLength: " + std::string(buf);
+  }
+  if (info.frame_rate > 0) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.3g fps", info.frame_rate);
+    details += "\nFrame rate: " + std::string(buf);
+  }
+  if (!info.codec.empty()) {
+    details += "\nCodec: " + info.codec;
   }
   if (info.workshop_id != 0) {
     details += "\nID: " + std::to_string(info.workshop_id);
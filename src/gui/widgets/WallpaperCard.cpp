@@ -121,10 +121,7 @@ WallpaperCard::WallpaperCard(const bwp::wallpaper::WallpaperInfo &info)
 }
 WallpaperCard::~WallpaperCard() {
   *m_aliveToken = false;
-  if (m_thumbnailSourceId > 0) {
-    g_source_remove(m_thumbnailSourceId);
-    m_thumbnailSourceId = 0;
-  }
+  cancelThumbnailLoad();
 }
 void WallpaperCard::setFavorite(bool favorite) {
   const char *icon = favorite ? "starred-symbolic" : "non-starred-symbolic";
@@ -191,10 +188,7 @@ void WallpaperCard::setInfo(const bwp::wallpaper::WallpaperInfo &info) {
 }
 void WallpaperCard::updateThumbnail(const std::string &path) {
   showSkeleton();
-  if (m_thumbnailSourceId > 0) {
-    g_source_remove(m_thumbnailSourceId);
-    m_thumbnailSourceId = 0;
-  }
+  cancelThumbnailLoad();
   struct RequestData {
     WallpaperCard *card;
     std::string path;
@@ -208,7 +202,7 @@ void WallpaperCard::updateThumbnail(const std::string &path) {
         auto &cache = bwp::wallpaper::ThumbnailCache::getInstance();
         auto *cardPtr = d->card;
         auto aliveToken = cardPtr->m_aliveToken;
-        cache.getAsync(
+        cardPtr->m_thumbnailRequest = cache.getAsync(
             d->path, bwp::wallpaper::ThumbnailCache::Size::Medium,
             [cardPtr, aliveToken, path = d->path](GdkPixbuf *pixbuf) {
               if (!*aliveToken)
@@ -221,6 +215,7 @@ void WallpaperCard::updateThumbnail(const std::string &path) {
                   g_object_unref(texture);
                 }
                 cardPtr->hideSkeleton();
+                // Perceptual hashes come from the scanner's hash thread.
                 if (cardPtr->m_info.blurhash.empty()) {
                   auto wallpaperId = cardPtr->m_info.id;
                   auto wallpaperPath = cardPtr->m_info.path;
@@ -252,6 +247,9 @@ void WallpaperCard::cancelThumbnailLoad() {
     g_source_remove(m_thumbnailSourceId);
     m_thumbnailSourceId = 0;
   }
+  // A card scrolled out of view no longer holds a decode slot.
+  m_thumbnailRequest.cancel();
+  m_thumbnailRequest = {};
 }
 void WallpaperCard::releaseResources() {
   cancelThumbnailLoad();
@@ -1,4 +1,5 @@
 #pragma once
+#include "../../core/wallpaper/ThumbnailCache.hpp"
 #include "../../core/wallpaper/WallpaperInfo.hpp"
 #include <gtk/gtk.h>
 #include <memory>
@@ -33,5 +34,6 @@ private:
   std::shared_ptr<bool> m_aliveToken;
   bool m_isLoading = true;
   guint m_thumbnailSourceId = 0;  
+  bwp::wallpaper::ThumbnailCache::Request m_thumbnailRequest;
 };
 }  
@@ -77,6 +77,8 @@ WallpaperGrid::WallpaperGrid() {
       });
 }
 WallpaperGrid::~WallpaperGrid() {
+  for (auto &request : m_prefetch)
+    request.cancel();
   if (m_configListenerId > 0) {
     bwp::config::ConfigManager::getInstance().removeListener(m_configListenerId);
   }
@@ -89,51 +91,76 @@ WallpaperGrid::~WallpaperGrid() {
 void WallpaperGrid::clear() {
   g_list_store_remove_all(m_store);
   m_existingPaths.clear();
+  m_objectsById.clear();
 }
 void WallpaperGrid::addWallpaper(const bwp::wallpaper::WallpaperInfo &info) {
-  if (m_existingPaths.count(info.path) > 0) {
-    return;  
+  addWallpapers({info});
+}
+void WallpaperGrid::addWallpapers(
+    const std::vector<bwp::wallpaper::WallpaperInfo> &infos) {
+  std::vector<gpointer> objects;
+  objects.reserve(infos.size());
+  for (const auto &info : infos) {
+    if (m_existingPaths.count(info.path) > 0 || m_objectsById.count(info.id)) {
+      continue;
+    }
+    m_existingPaths.insert(info.path);
+    BwpWallpaperObject *obj = bwp_wallpaper_object_new(info);
+    m_objectsById[info.id] = obj;
+    objects.push_back(obj);
   }
-  m_existingPaths.insert(info.path);
-  BwpWallpaperObject *obj = bwp_wallpaper_object_new(info);
-  g_list_store_append(m_store, obj);
-  g_object_unref(obj);
+  if (objects.empty())
+    return;
+  g_list_store_splice(m_store, g_list_model_get_n_items(G_LIST_MODEL(m_store)),
+                      0, objects.data(), static_cast<guint>(objects.size()));
+  for (gpointer obj : objects)
+    g_object_unref(obj);
 }
 void WallpaperGrid::removeWallpaperById(const std::string &id) {
+  removeWallpapers({id});
+}
+void WallpaperGrid::removeWallpapers(const std::vector<std::string> &ids) {
+  std::unordered_set<gpointer> doomed;
+  for (const auto &id : ids) {
+    auto it = m_objectsById.find(id);
+    if (it == m_objectsById.end())
+      continue;
+    m_existingPaths.erase(it->second->info.path);
+    m_boundCards.erase(id);
+    doomed.insert(it->second);
+    m_objectsById.erase(it);
+  }
+  if (doomed.empty())
+    return;
+  if (doomed.size() == 1) {
+    guint position = 0;
+    if (g_list_store_find(m_store, *doomed.begin(), &position))
+      g_list_store_remove(m_store, position);
+    return;
+  }
+  // One pass from the back, removing each run of adjacent items with a
+  // single splice so untouched rows keep their widgets and selection.
   guint n = g_list_model_get_n_items(G_LIST_MODEL(m_store));
-  for (guint i = 0; i < n; ++i) {
-    BwpWallpaperObject *obj =
-        BWP_WALLPAPER_OBJECT(g_list_model_get_item(G_LIST_MODEL(m_store), i));
-    if (obj) {
-      const auto *stored = bwp_wallpaper_object_get_info(obj);
-      if (stored && stored->id == id) {
-        m_existingPaths.erase(stored->path);
-        m_boundCards.erase(id);
-        g_object_unref(obj);
-        g_list_store_remove(m_store, i);
-        return;
-      }
-      g_object_unref(obj);
+  guint runEnd = n;
+  for (guint i = n; i-- > 0;) {
+    gpointer obj = g_list_model_get_item(G_LIST_MODEL(m_store), i);
+    bool remove = doomed.count(obj) > 0;
+    g_object_unref(obj);
+    if (!remove) {
+      if (runEnd > i + 1)
+        g_list_store_splice(m_store, i + 1, runEnd - i - 1, nullptr, 0);
+      runEnd = i;
     }
   }
+  if (runEnd > 0)
+    g_list_store_splice(m_store, 0, runEnd, nullptr, 0);
 }
 bool WallpaperGrid::updateWallpaperInStore(
     const bwp::wallpaper::WallpaperInfo &info) {
-  guint n = g_list_model_get_n_items(G_LIST_MODEL(m_store));
-  bool found = false;
-  for (guint i = 0; i < n; ++i) {
-    BwpWallpaperObject *obj =
-        BWP_WALLPAPER_OBJECT(g_list_model_get_item(G_LIST_MODEL(m_store), i));
-    if (obj) {
-      const auto *stored = bwp_wallpaper_object_get_info(obj);
-      if (stored && stored->id == info.id) {
-        bwp_wallpaper_object_update_info(obj, info);
-        g_object_unref(obj);
-        found = true;
-        break;
-      }
-      g_object_unref(obj);
-    }
+  auto object = m_objectsById.find(info.id);
+  bool found = object != m_objectsById.end();
+  if (found) {
+    bwp_wallpaper_object_update_info(object->second, info);
   }
   auto it = m_boundCards.find(info.id);
   if (it != m_boundCards.end() && it->second) {
@@ -155,6 +182,11 @@ struct FilterState {
   bool favoritesOnly;
   std::string tag;
   std::string source;
+  // Ids carrying `tag`, resolved once from the library's tag bitmaps.
+  std::unordered_set<std::string> taggedIds;
+  // Set when the search text parsed as a library query expression.
+  bool structured = false;
+  std::unordered_set<std::string> queryIds;
 };
 void WallpaperGrid::filter(const std::string &query) {
   m_filterQuery = query;
@@ -174,7 +206,23 @@ void WallpaperGrid::setFilterSource(const std::string &source) {
 }
 void WallpaperGrid::updateFilter() {
   FilterState *state = new FilterState{m_filterQuery, m_filterFavorites,
-                                       m_filterTag, m_filterSource};
+                                       m_filterTag, m_filterSource, {}};
+  if (!m_filterTag.empty()) {
+    bwp::wallpaper::TagQuery query;
+    query.all.push_back(m_filterTag);
+    bwp::wallpaper::WallpaperLibrary::getInstance().forEachTagged(
+        query, [state](const std::string &id) { state->taggedIds.insert(id); });
+  }
+  if (m_filterQuery.find_first_of(":<>=") != std::string::npos) {
+    std::string error;
+    auto hits = bwp::wallpaper::WallpaperLibrary::getInstance().query(
+        m_filterQuery, &error);
+    if (error.empty()) {
+      state->structured = true;
+      for (const auto &info : hits)
+        state->queryIds.insert(info.id);
+    }
+  }
   auto matchFunc = [](gpointer item, gpointer user_data) -> gboolean {
     FilterState *s = static_cast<FilterState *>(user_data);
     BwpWallpaperObject *obj = BWP_WALLPAPER_OBJECT(item);
@@ -216,18 +264,12 @@ void WallpaperGrid::updateFilter() {
     }
     if (s->favoritesOnly && !info->favorite)
       return FALSE;
-    if (!s->tag.empty()) {
-      bool tagFound = false;
-      for (const auto &t : info->tags) {
-        if (t == s->tag) {
-          tagFound = true;
-          break;
-        }
-      }
-      if (!tagFound)
+    if (!s->tag.empty() && !s->taggedIds.count(info->id))
+      return FALSE;
+    if (s->structured) {
+      if (!s->queryIds.count(info->id))
         return FALSE;
-    }
-    if (!s->query.empty()) {
+    } else if (!s->query.empty()) {
       std::string q = bwp::utils::StringUtils::toLower(s->query);
       std::string name = bwp::utils::StringUtils::toLower(
           std::filesystem::path(info->path).stem().string());
@@ -704,11 +746,38 @@ void WallpaperGrid::onBind(GtkSignalListItemFactory *  ,
     if (self) {
       self->m_boundCards[info->id] = card;
       card->setHighlight(self->m_filterQuery);
+      self->prefetchAfter(gtk_list_item_get_position(item));
     }
   } else {
     LOG_WARN("onBind: card or info is null");
   }
 }
+void WallpaperGrid::prefetchAfter(guint position) {
+  auto &cache = bwp::wallpaper::ThumbnailCache::getInstance();
+  GListModel *model = G_LIST_MODEL(m_selectionModel);
+  guint end = std::min(g_list_model_get_n_items(model),
+                       position + 1 + kPrefetchAhead);
+  for (guint i = position + 1; i < end; ++i) {
+    auto *obj = static_cast<BwpWallpaperObject *>(g_list_model_get_item(model, i));
+    if (!obj)
+      continue;
+    const bwp::wallpaper::WallpaperInfo *info =
+        bwp_wallpaper_object_get_info(obj);
+    if (info) {
+      auto request = cache.getAsync(info->path,
+                                    bwp::wallpaper::ThumbnailCache::Size::Medium,
+                                    nullptr,
+                                    bwp::wallpaper::ThumbnailCache::Priority::Prefetch);
+      if (request)
+        m_prefetch.push_back(std::move(request));
+    }
+    g_object_unref(obj);
+  }
+  while (m_prefetch.size() > kMaxPrefetch) {
+    m_prefetch.front().cancel();
+    m_prefetch.pop_front();
+  }
+}
 void WallpaperGrid::onUnbind(GtkSignalListItemFactory *  ,
                              GtkListItem *item, gpointer user_data) {
   GtkWidget *widget = gtk_list_item_get_child(item);
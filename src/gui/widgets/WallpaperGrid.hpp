@@ -1,10 +1,14 @@
 #pragma once
+#include "../../core/wallpaper/ThumbnailCache.hpp"
 #include "../../core/wallpaper/WallpaperInfo.hpp"
+#include "../models/WallpaperObject.hpp"
+#include <deque>
 #include <functional>
 #include <gtk/gtk.h>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 namespace bwp::gui {
 class WallpaperCard;
 class WallpaperGrid {
@@ -21,8 +25,12 @@ public:
   GtkWidget *getWidget() const { return m_scrolledWindow; }
   void clear();
   void addWallpaper(const bwp::wallpaper::WallpaperInfo &info);
+  // Batch variants emit a single items-changed on the model.
+  void addWallpapers(const std::vector<bwp::wallpaper::WallpaperInfo> &infos);
   void removeWallpaperById(const std::string &id);
+  void removeWallpapers(const std::vector<std::string> &ids);
   bool updateWallpaperInStore(const bwp::wallpaper::WallpaperInfo &info);
+  size_t count() const { return m_objectsById.size(); }
   void notifyDataChanged();
   void filter(const std::string &query);
   void setFilterFavoritesOnly(bool onlyFavorites);
@@ -54,8 +62,16 @@ private:
   std::string m_filterSource = "all";
   SortOrder m_currentSort = SortOrder::NameAsc;
   std::unordered_set<std::string> m_existingPaths;
+  // Items in m_store by wallpaper id; the store owns the references.
+  std::unordered_map<std::string, BwpWallpaperObject *> m_objectsById;
   std::unordered_map<std::string, WallpaperCard*> m_boundCards;
   int m_configListenerId = 0;
+  // Low-priority thumbnail loads for the items just past each bound card;
+  // the oldest are cancelled once the user has scrolled beyond them.
+  static constexpr guint kPrefetchAhead = 8;
+  static constexpr size_t kMaxPrefetch = 48;
+  std::deque<bwp::wallpaper::ThumbnailCache::Request> m_prefetch;
+  void prefetchAfter(guint position);
   void updateFilter();
   static void onSetup(GtkSignalListItemFactory *factory, GtkListItem *item,
                       gpointer user_data);
@@ -0,0 +1,110 @@
+// Heap footprint of the library store: the previous layout (a shared
+// WallpaperInfo per entry) against the interned LibraryEntry layout.
+//
+//   ./library_memory_bench [count]
+#include "core/wallpaper/library/LibrarySnapshot.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using bwp::wallpaper::LibraryStore;
+using bwp::wallpaper::WallpaperInfo;
+using bwp::wallpaper::WallpaperType;
+
+namespace {
+
+// Live heap bytes, tracked through a size header in front of every block.
+size_t g_liveBytes = 0;
+constexpr size_t kHeader = alignof(std::max_align_t);
+
+std::vector<WallpaperInfo> makeEntries(size_t count) {
+  static const char *kTags[] = {"anime",  "nature", "dark",   "minimal",
+                                "city",   "space",  "abstract", "retro",
+                                "neon",   "ocean",  "forest", "cyberpunk"};
+  std::vector<WallpaperInfo> entries;
+  entries.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    WallpaperInfo info;
+    info.id = std::to_string(2000000000 + i);
+    if (i % 10 < 7) {
+      info.path = "/home/user/.local/share/Steam/steamapps/workshop/content/"
+                  "431960/" +
+                  info.id + "/scene.pkg";
+      info.source = "workshop";
+      info.type = WallpaperType::WEScene;
+      info.workshop_id = 2000000000 + i;
+    } else {
+      info.path = "/home/user/Pictures/Wallpapers/folder_" +
+                  std::to_string(i % 20) + "/image_" + std::to_string(i) +
+                  ".jpg";
+      info.source = "local";
+      info.type = WallpaperType::StaticImage;
+    }
+    info.title = "Wallpaper " + std::to_string(i) + " - Evening Skyline";
+    for (size_t t = 0; t < 3; ++t)
+      info.tags.push_back(kTags[(i + t * 5) % 12]);
+    if (i % 2 == 0)
+      info.blurhash = "LEHV6nWB2yk8pyo0adR*.7kCMdnj";
+    info.added = 1700000000 + static_cast<long long>(i);
+    entries.push_back(std::move(info));
+  }
+  return entries;
+}
+
+} // namespace
+
+void *operator new(size_t size) {
+  auto *block = static_cast<char *>(std::malloc(size + kHeader));
+  if (!block)
+    throw std::bad_alloc();
+  *reinterpret_cast<size_t *>(block) = size;
+  g_liveBytes += size;
+  return block + kHeader;
+}
+void operator delete(void *ptr) noexcept {
+  if (!ptr)
+    return;
+  char *block = static_cast<char *>(ptr) - kHeader;
+  g_liveBytes -= *reinterpret_cast<size_t *>(block);
+  std::free(block);
+}
+void operator delete(void *ptr, size_t) noexcept { operator delete(ptr); }
+
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+  auto entries = makeEntries(count);
+
+  size_t base = g_liveBytes;
+  size_t legacyBytes = 0;
+  {
+    std::unordered_map<std::string, std::shared_ptr<const WallpaperInfo>>
+        legacy;
+    legacy.reserve(count);
+    for (const auto &info : entries)
+      legacy.emplace(info.id, std::make_shared<const WallpaperInfo>(info));
+    legacyBytes = g_liveBytes - base;
+  }
+
+  base = g_liveBytes;
+  size_t compactBytes = 0;
+  {
+    LibraryStore store;
+    store.reserve(count);
+    for (const auto &info : entries)
+      store.put(info);
+    auto snapshot = store.publish();
+    compactBytes = g_liveBytes - base;
+  }
+
+  std::printf("entries:              %zu\n", count);
+  std::printf("WallpaperInfo layout: %8.1f bytes/entry\n",
+              static_cast<double>(legacyBytes) / count);
+  std::printf("LibraryEntry layout:  %8.1f bytes/entry\n",
+              static_cast<double>(compactBytes) / count);
+  return 0;
+}
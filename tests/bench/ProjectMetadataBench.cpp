@@ -0,0 +1,139 @@
+// project.json field extraction: a full nlohmann DOM parse (what the scanner
+// used to do) against the streaming ProjectMetadata extractor.
+//
+//   ./project_metadata_bench [workshop-content-dir] [rounds]
+//
+// Without a directory it uses the Wallpaper Engine workshop folder under
+// $HOME, or synthetic manifests with a typical properties block.
+#include "core/wallpaper/library/ProjectMetadata.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using bwp::wallpaper::ProjectMetadata;
+
+namespace {
+
+std::vector<std::string> loadManifests(const std::filesystem::path &root) {
+  std::vector<std::string> docs;
+  std::error_code ec;
+  for (std::filesystem::directory_iterator it(root, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    std::ifstream in(it->path() / "project.json");
+    if (!in)
+      continue;
+    std::ostringstream buf;
+    buf << in.rdbuf();
+    docs.push_back(buf.str());
+  }
+  return docs;
+}
+
+std::vector<std::string> syntheticManifests(size_t count) {
+  std::vector<std::string> docs;
+  for (size_t i = 0; i < count; ++i) {
+    nlohmann::json properties = nlohmann::json::object();
+    for (int p = 0; p < 40; ++p) {
+      properties["prop_" + std::to_string(p)] = {
+          {"order", p},
+          {"text", "ui_property_" + std::to_string(p)},
+          {"type", p % 3 == 0 ? "slider" : "color"},
+          {"value", "0.12 0.34 0.56"},
+          {"min", 0},
+          {"max", 100}};
+    }
+    nlohmann::json doc = {
+        {"contentrating", "Everyone"},
+        {"description", std::string(400, 'd')},
+        {"file", "scene.json"},
+        {"general", {{"properties", properties}}},
+        {"preview", "preview.jpg"},
+        {"tags", {"Anime", "Landscape"}},
+        {"title", "Wallpaper " + std::to_string(i)},
+        {"type", "scene"},
+        {"version", 3},
+        {"workshopid", std::to_string(2000000000 + i)}};
+    docs.push_back(doc.dump());
+  }
+  return docs;
+}
+
+ProjectMetadata parseDom(const std::string &doc) {
+  ProjectMetadata out;
+  try {
+    nlohmann::json j = nlohmann::json::parse(doc);
+    out.title = j.value("title", "");
+    out.file = j.value("file", "");
+    out.type = j.value("type", "");
+    if (j.contains("tags") && j["tags"].is_array())
+      out.tags = j["tags"].get<std::vector<std::string>>();
+  } catch (const std::exception &) {
+  }
+  return out;
+}
+
+template <typename Fn> double seconds(Fn &&fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::filesystem::path root;
+  if (argc > 1) {
+    root = argv[1];
+  } else if (const char *home = std::getenv("HOME")) {
+    root = std::string(home) +
+           "/.local/share/Steam/steamapps/workshop/content/431960";
+  }
+  int rounds = argc > 2 ? std::atoi(argv[2]) : 5;
+  auto docs = loadManifests(root);
+  const char *source = "workshop";
+  if (docs.empty()) {
+    docs = syntheticManifests(2000);
+    source = "synthetic";
+  }
+  size_t bytes = 0;
+  for (const auto &doc : docs)
+    bytes += doc.size();
+  std::printf("%zu %s manifests, %.1f KiB average\n", docs.size(), source,
+              bytes / 1024.0 / docs.size());
+
+  size_t mismatches = 0;
+  for (const auto &doc : docs) {
+    auto fast = ProjectMetadata::extract(doc);
+    auto dom = parseDom(doc);
+    if (!fast || fast->title != dom.title || fast->file != dom.file ||
+        fast->type != dom.type || fast->tags != dom.tags)
+      mismatches++;
+  }
+
+  size_t sink = 0;
+  double dom = seconds([&] {
+    for (int r = 0; r < rounds; ++r)
+      for (const auto &doc : docs)
+        sink += parseDom(doc).title.size();
+  });
+  double sax = seconds([&] {
+    for (int r = 0; r < rounds; ++r)
+      for (const auto &doc : docs)
+        if (auto m = ProjectMetadata::extract(doc))
+          sink += m->title.size();
+  });
+  double perDoc = 1e6 / (static_cast<double>(docs.size()) * rounds);
+  std::printf("DOM parse:  %8.2f us/file\n", dom * perDoc);
+  std::printf("extractor:  %8.2f us/file  (%.1fx)\n", sax * perDoc,
+              dom / sax);
+  std::printf("mismatches: %zu  (checksum %zu)\n", mismatches, sink);
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+// Thumbnail disk-cache codecs: PNG through GdkPixbufLoader (what the cache
+// used to store) against QOI decoded straight into a pixbuf-owned buffer.
+//
+//   ./thumbnail_codec_bench [image-dir] [size] [rounds]
+//
+// Images in the directory are scaled to `size` (default 256) first, like
+// ThumbnailCache does; without a directory it uses synthetic photo-like
+// thumbnails (smooth gradients plus sensor noise).
+#include "core/utils/QoiCodec.hpp"
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace qoi = bwp::utils::qoi;
+
+namespace {
+
+std::vector<GdkPixbuf *> loadThumbnails(const std::filesystem::path &root,
+                                        int size) {
+  std::vector<GdkPixbuf *> out;
+  std::error_code ec;
+  for (std::filesystem::directory_iterator it(root, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_file_at_scale(
+        it->path().c_str(), size, size, TRUE, nullptr);
+    if (pixbuf)
+      out.push_back(pixbuf);
+  }
+  return out;
+}
+
+std::vector<GdkPixbuf *> syntheticThumbnails(size_t count, int size) {
+  std::vector<GdkPixbuf *> out;
+  uint32_t seed = 1;
+  for (size_t i = 0; i < count; ++i) {
+    bool alpha = i % 4 == 0;
+    GdkPixbuf *pixbuf =
+        gdk_pixbuf_new(GDK_COLORSPACE_RGB, alpha, 8, size, size * 9 / 16);
+    int channels = gdk_pixbuf_get_n_channels(pixbuf);
+    int stride = gdk_pixbuf_get_rowstride(pixbuf);
+    guchar *pixels = gdk_pixbuf_get_pixels(pixbuf);
+    for (int y = 0; y < gdk_pixbuf_get_height(pixbuf); ++y) {
+      for (int x = 0; x < size; ++x) {
+        seed = seed * 1103515245u + 12345u;
+        int noise = static_cast<int>((seed >> 16) % 7) - 3;
+        guchar *p = pixels + y * stride + x * channels;
+        p[0] = static_cast<guchar>(std::clamp(x + noise, 0, 255));
+        int green = (x + y + static_cast<int>(i)) / 2 + noise;
+        p[1] = static_cast<guchar>(std::clamp(green, 0, 255));
+        p[2] = static_cast<guchar>(std::clamp(200 - y + noise, 0, 255));
+        if (alpha)
+          p[3] = 255;
+      }
+    }
+    out.push_back(pixbuf);
+  }
+  return out;
+}
+
+GdkPixbuf *decodePng(const std::string &data) {
+  GdkPixbufLoader *loader = gdk_pixbuf_loader_new_with_type("png", nullptr);
+  gdk_pixbuf_loader_write(loader,
+                          reinterpret_cast<const guchar *>(data.data()),
+                          data.size(), nullptr);
+  gdk_pixbuf_loader_close(loader, nullptr);
+  GdkPixbuf *pixbuf = gdk_pixbuf_loader_get_pixbuf(loader);
+  if (pixbuf)
+    g_object_ref(pixbuf);
+  g_object_unref(loader);
+  return pixbuf;
+}
+
+GdkPixbuf *decodeQoi(const std::string &data) {
+  const auto *bytes = reinterpret_cast<const uint8_t *>(data.data());
+  auto header = qoi::readHeader(bytes, data.size());
+  if (!header)
+    return nullptr;
+  size_t stride = static_cast<size_t>(header->width) * header->channels;
+  auto *pixels = static_cast<guchar *>(g_malloc(stride * header->height));
+  if (!qoi::decode(bytes, data.size(), pixels, stride)) {
+    g_free(pixels);
+    return nullptr;
+  }
+  return gdk_pixbuf_new_from_data(
+      pixels, GDK_COLORSPACE_RGB, header->channels == 4, 8,
+      static_cast<int>(header->width), static_cast<int>(header->height),
+      static_cast<int>(stride), [](guchar *p, gpointer) { g_free(p); },
+      nullptr);
+}
+
+bool samePixels(GdkPixbuf *a, GdkPixbuf *b) {
+  int w = gdk_pixbuf_get_width(a);
+  int h = gdk_pixbuf_get_height(a);
+  int n = gdk_pixbuf_get_n_channels(a);
+  if (!b || w != gdk_pixbuf_get_width(b) || h != gdk_pixbuf_get_height(b) ||
+      n != gdk_pixbuf_get_n_channels(b))
+    return false;
+  for (int y = 0; y < h; ++y) {
+    if (std::memcmp(gdk_pixbuf_get_pixels(a) + y * gdk_pixbuf_get_rowstride(a),
+                    gdk_pixbuf_get_pixels(b) + y * gdk_pixbuf_get_rowstride(b),
+                    static_cast<size_t>(w) * n) != 0)
+      return false;
+  }
+  return true;
+}
+
+template <typename Fn> double seconds(Fn &&fn) {
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int size = argc > 2 ? std::atoi(argv[2]) : 256;
+  int rounds = argc > 3 ? std::atoi(argv[3]) : 5;
+  auto thumbnails = argc > 1 ? loadThumbnails(argv[1], size)
+                             : std::vector<GdkPixbuf *>{};
+  const char *source = "image";
+  if (thumbnails.empty()) {
+    thumbnails = syntheticThumbnails(300, size);
+    source = "synthetic";
+  }
+
+  std::vector<std::string> png, qoiData;
+  size_t pngBytes = 0, qoiBytes = 0;
+  double pngEncode = 0, qoiEncode = 0;
+  for (GdkPixbuf *pixbuf : thumbnails) {
+    pngEncode += seconds([&] {
+      gchar *buffer = nullptr;
+      gsize length = 0;
+      gdk_pixbuf_save_to_buffer(pixbuf, &buffer, &length, "png", nullptr,
+                                nullptr);
+      png.emplace_back(buffer, length);
+      g_free(buffer);
+    });
+    qoiEncode += seconds([&] {
+      qoiData.push_back(qoi::encode(
+          gdk_pixbuf_get_pixels(pixbuf), gdk_pixbuf_get_width(pixbuf),
+          gdk_pixbuf_get_height(pixbuf), gdk_pixbuf_get_rowstride(pixbuf),
+          gdk_pixbuf_get_n_channels(pixbuf)));
+    });
+    pngBytes += png.back().size();
+    qoiBytes += qoiData.back().size();
+  }
+
+  size_t mismatches = 0;
+  for (size_t i = 0; i < thumbnails.size(); ++i) {
+    GdkPixbuf *decoded = decodeQoi(qoiData[i]);
+    if (!samePixels(thumbnails[i], decoded))
+      mismatches++;
+    if (decoded)
+      g_object_unref(decoded);
+  }
+
+  auto decodeAll = [&](const std::vector<std::string> &blobs,
+                       GdkPixbuf *(*decode)(const std::string &)) {
+    return seconds([&] {
+      for (int r = 0; r < rounds; ++r)
+        for (const auto &blob : blobs)
+          if (GdkPixbuf *pixbuf = decode(blob))
+            g_object_unref(pixbuf);
+    });
+  };
+  double pngDecode = decodeAll(png, decodePng);
+  double qoiDecode = decodeAll(qoiData, decodeQoi);
+
+  const double count = static_cast<double>(thumbnails.size());
+  const double perDecode = 1e6 / (count * rounds);
+  std::printf("%zu %s thumbnails at %d px\n", thumbnails.size(), source, size);
+  std::printf("PNG: %8.1f us decode  %8.1f us encode  %6.1f KiB avg\n",
+              pngDecode * perDecode, pngEncode * 1e6 / count,
+              pngBytes / 1024.0 / count);
+  std::printf("QOI: %8.1f us decode  %8.1f us encode  %6.1f KiB avg  "
+              "(%.1fx faster decode)\n",
+              qoiDecode * perDecode, qoiEncode * 1e6 / count,
+              qoiBytes / 1024.0 / count, pngDecode / qoiDecode);
+  std::printf("mismatches: %zu\n", mismatches);
+  for (GdkPixbuf *pixbuf : thumbnails)
+    g_object_unref(pixbuf);
+  return mismatches == 0 ? 0 : 1;
+}
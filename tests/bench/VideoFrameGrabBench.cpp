@@ -0,0 +1,125 @@
+// Video thumbnails through VideoFrameGrabber (headless libmpv, software
+// render at thumbnail size).
+//
+//   ./video_frame_grab_bench <video-or-dir>... [--size N] [--threads N]
+//                            [--rounds N]
+//
+// Reports wall time and process CPU time (mpv's decoder threads included)
+// per grab. The first round pays for starting the mpv instances; later
+// rounds reuse them, as the thumbnail workers do.
+#include "core/wallpaper/VideoFrameGrabber.hpp"
+#include <sys/resource.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using bwp::wallpaper::VideoFrameGrabber;
+
+namespace {
+
+bool isVideo(const std::filesystem::path &path) {
+  std::string ext = path.extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  return ext == ".mp4" || ext == ".webm" || ext == ".mkv" || ext == ".avi";
+}
+
+double cpuSeconds() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+         (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+struct Round {
+  double wall;
+  double cpu;
+  size_t failed;
+};
+
+Round runRound(VideoFrameGrabber &grabber,
+               const std::vector<std::string> &videos, int size,
+               unsigned threads) {
+  std::atomic<size_t> next{0};
+  std::atomic<size_t> failed{0};
+  const double cpuStart = cpuSeconds();
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; ++t) {
+    workers.emplace_back([&] {
+      for (size_t i; (i = next++) < videos.size();) {
+        if (!grabber.grab(videos[i], size))
+          failed++;
+      }
+    });
+  }
+  for (auto &worker : workers)
+    worker.join();
+  return {std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                        start)
+              .count(),
+          cpuSeconds() - cpuStart, failed.load()};
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::setlocale(LC_NUMERIC, "C");
+  int size = 256;
+  unsigned threads = 2;
+  int rounds = 3;
+  std::vector<std::string> videos;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      size = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+    } else if (std::strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+      rounds = std::max(1, std::atoi(argv[++i]));
+    } else if (std::filesystem::is_directory(argv[i])) {
+      std::error_code ec;
+      for (std::filesystem::recursive_directory_iterator it(argv[i], ec), end;
+           !ec && it != end; it.increment(ec)) {
+        if (it->is_regular_file() && isVideo(it->path()))
+          videos.push_back(it->path().string());
+      }
+    } else {
+      videos.emplace_back(argv[i]);
+    }
+  }
+  if (videos.empty()) {
+    std::fprintf(stderr,
+                 "usage: %s <video-or-dir>... [--size N] [--threads N] "
+                 "[--rounds N]\n",
+                 argv[0]);
+    return 2;
+  }
+
+  VideoFrameGrabber grabber(threads);
+  std::printf("%zu videos at %d px, %u threads\n", videos.size(), size,
+              threads);
+  const double count = static_cast<double>(videos.size());
+  for (int r = 0; r < rounds; ++r) {
+    Round round = runRound(grabber, videos, size, threads);
+    std::printf("round %d%s: %8.1f ms wall/video  %8.1f ms cpu/video  "
+                "%zu failed\n",
+                r + 1, r == 0 ? " (cold)" : "       ",
+                round.wall * 1e3 * threads / count, round.cpu * 1e3 / count,
+                round.failed);
+  }
+  auto stats = grabber.getStats();
+  std::printf("grabs: %llu  failures: %llu  extra seeks: %llu  "
+              "mpv instances: %zu  avg grab: %.1f ms\n",
+              static_cast<unsigned long long>(stats.grabs),
+              static_cast<unsigned long long>(stats.failures),
+              static_cast<unsigned long long>(stats.extraSeeks), stats.handles,
+              stats.avgGrabMs);
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "core/wallpaper/library/BinaryLibraryFile.hpp"
+#include <filesystem>
+#include <fstream>
+
+using bwp::wallpaper::BinaryLibraryFile;
+using bwp::wallpaper::LibraryEntry;
+using bwp::wallpaper::StringPool;
+using bwp::wallpaper::WallpaperView;
+using bwp::wallpaper::WallpaperInfo;
+using bwp::wallpaper::WallpaperType;
+
+namespace {
+
+std::filesystem::path freshBinaryPath(const std::string &name) {
+  auto dir = std::filesystem::temp_directory_path() / "bwp_binary_tests";
+  std::filesystem::create_directories(dir);
+  auto path = dir / (name + ".bin");
+  std::filesystem::remove(path);
+  return path;
+}
+
+// Written from interned entries, as WallpaperLibrary does.
+bool writeInfos(const std::filesystem::path &path,
+                const std::vector<WallpaperInfo> &infos,
+                const BinaryLibraryFile::Stamp &stamp) {
+  StringPool pool;
+  std::vector<LibraryEntry> entries;
+  entries.reserve(infos.size());
+  for (const auto &info : infos)
+    entries.push_back(LibraryEntry::fromInfo(info, pool));
+  std::vector<WallpaperView> views;
+  for (const auto &entry : entries)
+    views.emplace_back(&entry);
+  return BinaryLibraryFile::write(path, views, stamp);
+}
+
+} // namespace
+
+// ──────────────────────────────────────────────────────────
+//  BinaryLibraryFile — round trip and indexed lookups
+// ──────────────────────────────────────────────────────────
+
+TEST(BinaryLibraryFile, RoundTripsEntriesAndIdIndex) {
+  auto path = freshBinaryPath("roundtrip");
+  std::vector<WallpaperInfo> entries;
+  for (int i = 0; i < 100; ++i) {
+    WallpaperInfo info;
+    info.id = "bin_" + std::to_string(i);
+    info.path = "/tmp/bin_" + std::to_string(i) + ".mp4";
+    info.title = "Binary " + std::to_string(i);
+    info.type = WallpaperType::Video;
+    info.tags = {"shared", "tag_" + std::to_string(i % 3)};
+    info.rating = i % 5;
+    info.workshop_id = 1000 + i;
+    info.settings.playback_speed = 1.5;
+    info.settings.noAutomute = 1;
+    entries.push_back(info);
+  }
+  BinaryLibraryFile::Stamp stamp{1234, 5678};
+  ASSERT_TRUE(writeInfos(path, entries, stamp));
+
+  auto file = BinaryLibraryFile::open(path);
+  ASSERT_NE(file, nullptr);
+  EXPECT_EQ(file->size(), 100u);
+  EXPECT_TRUE(file->stamp() == stamp);
+
+  auto found = file->find("bin_42");
+  ASSERT_TRUE(found.has_value());
+  EXPECT_EQ(found->path, "/tmp/bin_42.mp4");
+  EXPECT_EQ(found->title, "Binary 42");
+  EXPECT_EQ(found->type, WallpaperType::Video);
+  EXPECT_EQ(found->tags, (std::vector<std::string>{"shared", "tag_0"}));
+  EXPECT_EQ(found->rating, 2);
+  EXPECT_EQ(found->workshop_id, 1042u);
+  EXPECT_DOUBLE_EQ(found->settings.playback_speed, 1.5);
+  EXPECT_EQ(found->settings.noAutomute, 1);
+
+  EXPECT_EQ(file->find("bin_7")->path, "/tmp/bin_7.mp4");
+  EXPECT_FALSE(file->find("missing").has_value());
+}
+
+TEST(BinaryLibraryFile, RejectsTruncatedFile) {
+  auto path = freshBinaryPath("truncated");
+  WallpaperInfo info;
+  info.id = "only";
+  info.path = "/tmp/only.jpg";
+  ASSERT_TRUE(writeInfos(path, {info}, {}));
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+  EXPECT_EQ(BinaryLibraryFile::open(path), nullptr);
+}
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include "core/utils/CoalescingJobPool.hpp"
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using Pool = bwp::utils::CoalescingJobPool<std::string>;
+
+namespace {
+
+// Holds the single worker of a pool until released, so the queue can be
+// arranged deterministically behind it.
+struct Gate {
+  std::promise<void> release;
+  std::shared_future<void> opened = release.get_future().share();
+  std::promise<void> entered;
+  Pool::Ticket block(Pool &pool) {
+    auto ticket = pool.submit(
+        "gate", Pool::Priority::High,
+        [this]() {
+          entered.set_value();
+          opened.wait();
+          return std::string("gate");
+        },
+        nullptr);
+    entered.get_future().wait();
+    return ticket;
+  }
+};
+
+} // namespace
+
+// ──────────────────────────────────────────────────────────
+//  CoalescingJobPool — ordering, coalescing, cancellation
+// ──────────────────────────────────────────────────────────
+
+TEST(CoalescingJobPool, RunsHighPriorityFirstAndCoalescesKeys) {
+  Pool pool(1);
+  Gate gate;
+  gate.block(pool);
+
+  std::mutex mutex;
+  std::vector<std::string> order;
+  std::atomic<int> runs{0};
+  std::promise<void> finished;
+  std::atomic<int> callbacks{0};
+  auto work = [&](std::string key) {
+    return [&, key]() {
+      runs++;
+      std::lock_guard<std::mutex> lock(mutex);
+      order.push_back(key);
+      return key;
+    };
+  };
+  auto done = [&](const std::string &) {
+    if (++callbacks == 4)
+      finished.set_value();
+  };
+  pool.submit("low-a", Pool::Priority::Low, work("low-a"), done);
+  pool.submit("low-b", Pool::Priority::Low, work("low-b"), done);
+  pool.submit("high", Pool::Priority::High, work("high"), done);
+  // Joins low-b and promotes it ahead of low-a.
+  pool.submit("low-b", Pool::Priority::High, work("low-b"), done);
+  EXPECT_EQ(pool.metrics().queued, 3u);
+  EXPECT_EQ(pool.metrics().coalesced, 1u);
+
+  gate.release.set_value();
+  finished.get_future().wait();
+  EXPECT_EQ(runs, 3);
+  EXPECT_EQ(order, (std::vector<std::string>{"high", "low-b", "low-a"}));
+}
+
+TEST(CoalescingJobPool, CancellingTheLastWaiterDropsAQueuedJob) {
+  Pool pool(1);
+  Gate gate;
+  gate.block(pool);
+
+  std::atomic<int> runs{0};
+  std::atomic<int> delivered{0};
+  auto work = [&]() {
+    runs++;
+    return std::string("x");
+  };
+  auto dropped = pool.submit("dropped", Pool::Priority::Low, work,
+                             [&](const std::string &) { delivered++; });
+  auto first = pool.submit("shared", Pool::Priority::Low, work,
+                           [&](const std::string &) { delivered++; });
+  std::promise<void> finished;
+  auto second = pool.submit("shared", Pool::Priority::Low, work,
+                            [&](const std::string &) {
+                              delivered++;
+                              finished.set_value();
+                            });
+  dropped.cancel();
+  dropped.cancel();
+  first.cancel();
+  EXPECT_FALSE(dropped);
+  EXPECT_EQ(pool.metrics().queued, 1u);
+  EXPECT_EQ(pool.metrics().cancelled, 1u);
+
+  gate.release.set_value();
+  finished.get_future().wait();
+  EXPECT_EQ(runs, 1);
+  EXPECT_EQ(delivered, 1);
+  auto metrics = pool.metrics();
+  EXPECT_EQ(metrics.completed, 2u);
+  EXPECT_GT(metrics.maxRunMs, 0.0);
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include "core/utils/ContentHash.hpp"
+#include "core/wallpaper/library/DuplicateFinder.hpp"
+#include <filesystem>
+#include <fstream>
+
+using bwp::utils::Xxh64;
+using bwp::wallpaper::DuplicateFinder;
+using bwp::wallpaper::HashCache;
+
+namespace {
+
+void writeBytes(const std::filesystem::path &path, size_t size, char fill,
+                char last) {
+  std::string data(size, fill);
+  data.back() = last;
+  std::ofstream(path, std::ios::binary) << data;
+}
+
+} // namespace
+
+// ──────────────────────────────────────────────────────────
+//  Xxh64 — reference vectors
+// ──────────────────────────────────────────────────────────
+
+TEST(ContentHash, MatchesXxh64ReferenceAndStreams) {
+  EXPECT_EQ(Xxh64::of("", 0), 0xEF46DB3751D8E999ULL);
+  EXPECT_EQ(Xxh64::of("abc", 3), 0x44BC2CF5AD770999ULL);
+  const std::string text = "Nobody inspects the spammish repetition";
+  EXPECT_EQ(Xxh64::of(text.data(), text.size()), 0xFBCEA83C8A378BF1ULL);
+  Xxh64 streamed;
+  for (char c : text)
+    streamed.update(&c, 1);
+  EXPECT_EQ(streamed.digest(), 0xFBCEA83C8A378BF1ULL);
+}
+
+// ──────────────────────────────────────────────────────────
+//  DuplicateFinder — size / partial / full cascade
+// ──────────────────────────────────────────────────────────
+
+TEST(DuplicateFinder, GroupsIdenticalContentsAndCachesHashes) {
+  auto dir = std::filesystem::temp_directory_path() / "bwp_duplicates";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir / "a");
+  std::filesystem::create_directories(dir / "b");
+  // Large enough that the ends and the middle are hashed separately.
+  const size_t big = 3 * bwp::utils::ContentHash::kPartialBytes;
+  writeBytes(dir / "a" / "video.mp4", big, 'v', '1');
+  writeBytes(dir / "b" / "video.mp4", big, 'v', '1');
+  writeBytes(dir / "b" / "other.mp4", big, 'v', '2'); // same size, new tail
+  writeBytes(dir / "a" / "small.jpg", 100, 's', 's');
+  std::filesystem::create_hard_link(dir / "a" / "small.jpg",
+                                    dir / "b" / "linked.jpg");
+  writeBytes(dir / "b" / "unique.jpg", 50, 'u', 'u');
+
+  std::vector<DuplicateFinder::Input> inputs = {
+      {"v1", (dir / "a" / "video.mp4").string()},
+      {"v2", (dir / "b" / "video.mp4").string()},
+      {"other", (dir / "b" / "other.mp4").string()},
+      {"small", (dir / "a" / "small.jpg").string()},
+      {"linked", (dir / "b" / "linked.jpg").string()},
+      {"unique", (dir / "b" / "unique.jpg").string()},
+      {"missing", (dir / "gone.jpg").string()},
+  };
+  HashCache cache;
+  auto groups = DuplicateFinder::run(inputs, cache, 3);
+  ASSERT_EQ(groups.size(), 2u);
+  EXPECT_EQ(groups[0].ids, (std::vector<std::string>{"v1", "v2"}));
+  EXPECT_EQ(groups[0].size, big);
+  EXPECT_EQ(groups[1].ids, (std::vector<std::string>{"small", "linked"}));
+  EXPECT_EQ(*bwp::utils::ContentHash::file(dir / "a" / "video.mp4"),
+            groups[0].hash);
+
+  // Only same-size files were hashed; a reload serves them from disk.
+  EXPECT_EQ(cache.size(), 4u);
+  auto cachePath = dir / "hashes.bin";
+  ASSERT_TRUE(cache.save(cachePath));
+  HashCache reloaded;
+  ASSERT_TRUE(reloaded.load(cachePath));
+  EXPECT_EQ(reloaded.size(), 4u);
+  auto again = DuplicateFinder::run(inputs, reloaded, 1);
+  ASSERT_EQ(again.size(), 2u);
+  EXPECT_EQ(again[0].hash, groups[0].hash);
+  EXPECT_FALSE(reloaded.dirty());
+}
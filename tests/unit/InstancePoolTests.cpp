@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include "core/utils/InstancePool.hpp"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+
+using Pool = bwp::utils::InstancePool<int>;
+
+namespace {
+
+// Numbers the instances it creates, starting at 1; fails once `failAt` is
+// reached.
+struct Factory {
+  std::atomic<int> created{0};
+  int failAt = 0;
+  Pool::Factory make() {
+    return [this]() -> std::unique_ptr<int> {
+      int n = ++created;
+      if (n == failAt)
+        return nullptr;
+      return std::make_unique<int>(n);
+    };
+  }
+};
+
+bool blocked(std::future<std::unique_ptr<int>> &pending) {
+  return pending.wait_for(std::chrono::milliseconds(50)) ==
+         std::future_status::timeout;
+}
+
+} // namespace
+
+// ──────────────────────────────────────────────────────────
+//  InstancePool — creation limit, reuse, dropped instances
+// ──────────────────────────────────────────────────────────
+
+TEST(InstancePool, ReusesReturnedInstancesAndWaitsAtTheLimit) {
+  Factory factory;
+  Pool pool(2, factory.make());
+  auto a = pool.acquire();
+  auto b = pool.acquire();
+  ASSERT_TRUE(a && b);
+  EXPECT_EQ(pool.live(), 2u);
+
+  auto pending = std::async(std::launch::async, [&] { return pool.acquire(); });
+  EXPECT_TRUE(blocked(pending));
+  int *first = a.get();
+  pool.release(std::move(a), true);
+  auto c = pending.get();
+  EXPECT_EQ(c.get(), first);
+  EXPECT_EQ(factory.created, 2);
+
+  pool.release(std::move(b), true);
+  pool.release(std::move(c), true);
+  EXPECT_EQ(pool.live(), 2u);
+  EXPECT_EQ(pool.idle(), 2u);
+}
+
+TEST(InstancePool, UnreusableInstanceFreesItsSlot) {
+  // What a grab that timed out hands back.
+  Factory factory;
+  Pool pool(1, factory.make());
+  auto a = pool.acquire();
+  ASSERT_TRUE(a);
+  auto pending = std::async(std::launch::async, [&] { return pool.acquire(); });
+  EXPECT_TRUE(blocked(pending));
+
+  pool.release(std::move(a), false);
+  auto b = pending.get();
+  ASSERT_TRUE(b);
+  EXPECT_EQ(*b, 2);
+  EXPECT_EQ(pool.live(), 1u);
+  EXPECT_EQ(pool.idle(), 0u);
+
+  pool.release(std::move(b), false);
+  EXPECT_EQ(pool.live(), 0u);
+  pool.release(nullptr, true);
+  EXPECT_EQ(pool.idle(), 0u);
+}
+
+TEST(InstancePool, StopsCreatingAfterTheFactoryFails) {
+  Factory factory;
+  factory.failAt = 2;
+  Pool pool(2, factory.make());
+  auto a = pool.acquire();
+  ASSERT_TRUE(a);
+  EXPECT_EQ(pool.acquire(), nullptr);
+  EXPECT_TRUE(pool.unavailable());
+  EXPECT_EQ(pool.live(), 1u);
+
+  // Not even an idle instance is handed out any more.
+  pool.release(std::move(a), true);
+  EXPECT_EQ(pool.acquire(), nullptr);
+  EXPECT_EQ(factory.created, 2);
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include "core/wallpaper/library/LibraryChangeSet.hpp"
+
+using bwp::wallpaper::ChangeSetAccumulator;
+using bwp::wallpaper::ChangeSetQueue;
+using bwp::wallpaper::LibraryChangeSet;
+
+// ──────────────────────────────────────────────────────────
+//  ChangeSetAccumulator — net diff per id
+// ──────────────────────────────────────────────────────────
+
+TEST(LibraryChangeSet, AccumulatorFoldsEventsPerId) {
+  ChangeSetAccumulator acc;
+  acc.added("a");
+  acc.updated("a");   // still an add
+  acc.added("b");
+  acc.removed("b");   // cancels out
+  acc.removed("c");
+  acc.added("c");     // consumer had it: update
+  acc.updated("d");
+  acc.removed("d");   // update then remove: remove
+  EXPECT_FALSE(acc.empty());
+
+  LibraryChangeSet changes = acc.take();
+  EXPECT_EQ(changes.added, (std::vector<std::string>{"a"}));
+  EXPECT_EQ(changes.updated, (std::vector<std::string>{"c"}));
+  EXPECT_EQ(changes.removed, (std::vector<std::string>{"d"}));
+  EXPECT_TRUE(acc.empty());
+}
+
+// ──────────────────────────────────────────────────────────
+//  ChangeSetQueue — one delivery per scheduled run
+// ──────────────────────────────────────────────────────────
+
+TEST(LibraryChangeSet, QueueCoalescesUntilScheduledRun) {
+  std::vector<std::function<void()>> scheduled;
+  std::vector<LibraryChangeSet> delivered;
+  auto queue = std::make_unique<ChangeSetQueue>(
+      [&](std::function<void()> task) { scheduled.push_back(std::move(task)); },
+      [&](const LibraryChangeSet &changes) { delivered.push_back(changes); });
+
+  for (int i = 0; i < 1000; ++i) {
+    LibraryChangeSet changes;
+    changes.added.push_back("wp_" + std::to_string(i % 10));
+    queue->push(changes);
+  }
+  ASSERT_EQ(scheduled.size(), 1u);
+  EXPECT_TRUE(delivered.empty());
+  scheduled[0]();
+  ASSERT_EQ(delivered.size(), 1u);
+  EXPECT_EQ(delivered[0].added.size(), 10u);
+
+  // A run scheduled before the queue died must not touch the sink.
+  LibraryChangeSet late;
+  late.removed.push_back("wp_0");
+  queue->push(late);
+  ASSERT_EQ(scheduled.size(), 2u);
+  queue.reset();
+  scheduled[1]();
+  EXPECT_EQ(delivered.size(), 1u);
+}
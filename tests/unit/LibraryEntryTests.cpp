@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include "core/wallpaper/library/LibraryEntry.hpp"
+
+using bwp::wallpaper::LibraryEntry;
+using bwp::wallpaper::StringPool;
+using bwp::wallpaper::WallpaperInfo;
+using bwp::wallpaper::WallpaperType;
+using bwp::wallpaper::WallpaperView;
+
+// ──────────────────────────────────────────────────────────
+//  LibraryEntry — compact layout round trip
+// ──────────────────────────────────────────────────────────
+
+TEST(LibraryEntry, RoundTripsThroughView) {
+  StringPool pool;
+  WallpaperInfo info;
+  info.id = "entry_1";
+  info.path = "/home/u/.steam/workshop/content/431960/123/scene.pkg";
+  info.title = "Entry";
+  info.source = "workshop";
+  info.type = WallpaperType::WEScene;
+  info.tags = {"anime", "dark"};
+  info.favorite = true;
+  info.rating = 4;
+  info.workshop_id = 123;
+  info.settings.muted = true;
+  info.settings.volume = 40;
+  info.settings.noAutomute = 1;
+
+  LibraryEntry entry = LibraryEntry::fromInfo(info, pool);
+  EXPECT_EQ(*entry.root, "/home/u/.steam/workshop/content/431960/");
+  EXPECT_EQ(entry.suffix(), "123/scene.pkg");
+
+  WallpaperView view(&entry);
+  EXPECT_EQ(view.path(), info.path);
+  EXPECT_EQ(view.filename(), "scene.pkg");
+  EXPECT_TRUE(view.hasTag("dark"));
+  EXPECT_FALSE(view.hasTag("light"));
+
+  WallpaperInfo back = view.toInfo();
+  EXPECT_EQ(back.path, info.path);
+  EXPECT_EQ(back.source, "workshop");
+  EXPECT_EQ(back.type, WallpaperType::WEScene);
+  EXPECT_EQ(back.tags, info.tags);
+  EXPECT_TRUE(back.favorite);
+  EXPECT_EQ(back.rating, 4);
+  EXPECT_EQ(back.workshop_id, 123u);
+  EXPECT_TRUE(back.settings.muted);
+  EXPECT_EQ(back.settings.volume, 40);
+  EXPECT_EQ(back.settings.noAutomute, 1);
+}
+
+TEST(LibraryEntry, SharesInternedStrings) {
+  StringPool pool;
+  WallpaperInfo a;
+  a.path = "/walls/nature/forest.jpg";
+  a.source = "local";
+  a.tags = {"green"};
+  WallpaperInfo b = a;
+  b.path = "/walls/nature/lake.jpg";
+
+  LibraryEntry ea = LibraryEntry::fromInfo(a, pool);
+  LibraryEntry eb = LibraryEntry::fromInfo(b, pool);
+  EXPECT_EQ(ea.root, eb.root);
+  EXPECT_EQ(ea.source, eb.source);
+  EXPECT_EQ(ea.tags[0], eb.tags[0]);
+
+  WallpaperInfo shallow;
+  shallow.path = "x.jpg";
+  LibraryEntry es = LibraryEntry::fromInfo(shallow, pool);
+  EXPECT_EQ(WallpaperView(&es).path(), "x.jpg");
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include "core/wallpaper/library/LibraryJournal.hpp"
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+using bwp::wallpaper::LibraryJournal;
+using bwp::wallpaper::WallpaperInfo;
+
+namespace {
+
+std::filesystem::path freshJournalPath(const std::string &name) {
+  auto dir = std::filesystem::temp_directory_path() / "bwp_journal_tests";
+  std::filesystem::create_directories(dir);
+  auto path = dir / (name + ".journal");
+  std::filesystem::remove(path);
+  std::filesystem::remove(path.string() + ".compacting");
+  return path;
+}
+
+std::map<std::string, WallpaperInfo> replayAll(LibraryJournal &journal) {
+  std::map<std::string, WallpaperInfo> state;
+  journal.replay([&](LibraryJournal::Record &&record) {
+    if (record.op == LibraryJournal::Op::Put)
+      state[record.id] = record.info;
+    else
+      state.erase(record.id);
+  });
+  return state;
+}
+
+WallpaperInfo makeInfo(const std::string &id, const std::string &title) {
+  WallpaperInfo info;
+  info.id = id;
+  info.path = "/tmp/" + id + ".jpg";
+  info.title = title;
+  info.tags = {"a", "b"};
+  return info;
+}
+
+} // namespace
+
+// ──────────────────────────────────────────────────────────
+//  LibraryJournal — append / replay
+// ──────────────────────────────────────────────────────────
+
+TEST(LibraryJournal, ReplayAppliesPutsAndRemovesInOrder) {
+  auto path = freshJournalPath("order");
+  {
+    LibraryJournal journal(path);
+    journal.append(LibraryJournal::encodePut(makeInfo("one", "First")), 1);
+    journal.append(LibraryJournal::encodePut(makeInfo("two", "Second")), 1);
+    journal.append(LibraryJournal::encodePut(makeInfo("one", "Renamed")) +
+                       LibraryJournal::encodeRemove("two"),
+                   2);
+    EXPECT_EQ(journal.pendingRecords(), 4u);
+  }
+  LibraryJournal journal(path);
+  auto state = replayAll(journal);
+  ASSERT_EQ(state.size(), 1u);
+  EXPECT_EQ(state["one"].title, "Renamed");
+  EXPECT_EQ(state["one"].tags.size(), 2u);
+}
+
+TEST(LibraryJournal, TornTailIsDiscarded) {
+  auto path = freshJournalPath("torn");
+  {
+    LibraryJournal journal(path);
+    journal.append(LibraryJournal::encodePut(makeInfo("kept", "Kept")), 1);
+  }
+  {
+    std::ofstream out(path, std::ios::app | std::ios::binary);
+    out << "{\"op\":\"put\",\"wp\":{\"id\":\"lost\"";
+  }
+  LibraryJournal journal(path);
+  auto state = replayAll(journal);
+  EXPECT_EQ(state.size(), 1u);
+  EXPECT_TRUE(state.count("kept"));
+
+  // The torn bytes are truncated so later appends start on a clean line.
+  journal.append(LibraryJournal::encodePut(makeInfo("after", "After")), 1);
+  journal.close();
+  LibraryJournal reopened(path);
+  state = replayAll(reopened);
+  EXPECT_EQ(state.size(), 2u);
+  EXPECT_TRUE(state.count("after"));
+}
+
+TEST(LibraryJournal, RotatedJournalIsReplayedUntilDiscarded) {
+  auto path = freshJournalPath("rotate");
+  LibraryJournal journal(path);
+  journal.append(LibraryJournal::encodePut(makeInfo("old", "Old")), 1);
+  ASSERT_TRUE(journal.rotate());
+  EXPECT_EQ(journal.pendingRecords(), 0u);
+  journal.append(LibraryJournal::encodePut(makeInfo("new", "New")), 1);
+
+  // Simulates a crash before the snapshot was written.
+  auto state = replayAll(journal);
+  EXPECT_EQ(state.size(), 2u);
+
+  ASSERT_TRUE(journal.rotate());
+  journal.discardRotated();
+  state = replayAll(journal);
+  EXPECT_TRUE(state.empty());
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include "core/wallpaper/WallpaperLibrary.hpp"
+#include "core/wallpaper/library/LibraryQuery.hpp"
+
+using bwp::wallpaper::LibraryQuery;
+using bwp::wallpaper::WallpaperInfo;
+using bwp::wallpaper::WallpaperLibrary;
+using bwp::wallpaper::WallpaperType;
+
+// ──────────────────────────────────────────────────────────
+//  LibraryQuery — parser
+// ──────────────────────────────────────────────────────────
+
+TEST(LibraryQuery, ParsesFiltersSortAndLimit) {
+  const int64_t now = 1'700'000'000;
+  std::string error;
+  auto q = LibraryQuery::parse(
+      "type:video tag:dark rating>=3 -tag:nsfw \"blue sky\" added<7d "
+      "sort:used limit:50",
+      &error, now);
+  ASSERT_TRUE(q.has_value()) << error;
+  EXPECT_EQ(q->types, std::vector<WallpaperType>{WallpaperType::Video});
+  EXPECT_EQ(q->tagsAll, std::vector<std::string>{"dark"});
+  EXPECT_EQ(q->tagsNone, std::vector<std::string>{"nsfw"});
+  EXPECT_EQ(q->words, std::vector<std::string>{"blue sky"});
+  EXPECT_EQ(q->rating.min, 3);
+  EXPECT_EQ(q->added.min, now - 7 * 86400 + 1);
+  EXPECT_EQ(q->sort, LibraryQuery::SortKey::LastUsed);
+  EXPECT_TRUE(q->descending);
+  EXPECT_EQ(q->limit, 50u);
+
+  auto byName = LibraryQuery::parse("sort:name tag:a|b is:fav");
+  ASSERT_TRUE(byName.has_value());
+  EXPECT_FALSE(byName->descending);
+  EXPECT_EQ(byName->tagsAny, (std::vector<std::string>{"a", "b"}));
+  EXPECT_EQ(byName->favorite, true);
+
+  auto media = LibraryQuery::parse("duration<2m fps>=60 codec:H264|vp9");
+  ASSERT_TRUE(media.has_value());
+  EXPECT_EQ(media->duration.max, 119);
+  EXPECT_EQ(media->frameRate.min, 60);
+  EXPECT_EQ(media->codecs, (std::vector<std::string>{"h264", "vp9"}));
+
+  EXPECT_FALSE(LibraryQuery::parse("colour:red", &error).has_value());
+  EXPECT_EQ(error, "unknown filter: colour");
+  EXPECT_FALSE(LibraryQuery::parse("rating>=high").has_value());
+  EXPECT_FALSE(LibraryQuery::parse("\"open").has_value());
+}
+
+// ──────────────────────────────────────────────────────────
+//  WallpaperLibrary — query
+// ──────────────────────────────────────────────────────────
+
+TEST(LibraryQuery, LibraryQueryFiltersAndOrders) {
+  auto &lib = WallpaperLibrary::getInstance();
+  for (int i = 0; i < 6; ++i) {
+    WallpaperInfo wp;
+    wp.id = "test_query_" + std::to_string(i);
+    wp.path = "/tmp/test_query_" + std::to_string(i) + ".mp4";
+    wp.title = "Query Sample " + std::to_string(i);
+    wp.type = i % 2 == 0 ? WallpaperType::Video : WallpaperType::StaticImage;
+    wp.tags = {"queryTag"};
+    if (i == 4)
+      wp.tags.push_back("queryHidden");
+    wp.rating = i;
+    wp.last_used = 1000 + i;
+    wp.width = i >= 3 ? 3840 : 1920;
+    wp.height = i >= 3 ? 2160 : 1080;
+    wp.duration = 10.0 * i;
+    wp.codec = i % 2 == 0 ? "vp9" : "h264";
+    lib.addWallpaper(wp);
+  }
+
+  auto ids = [](const std::vector<WallpaperInfo> &list) {
+    std::vector<std::string> out;
+    for (const auto &w : list)
+      out.push_back(w.id);
+    return out;
+  };
+  EXPECT_EQ(ids(lib.query("tag:queryTag type:video -tag:queryHidden "
+                          "sort:used")),
+            (std::vector<std::string>{"test_query_2", "test_query_0"}));
+  EXPECT_EQ(ids(lib.query("tag:queryTag rating>=2 sort:rating limit:2")),
+            (std::vector<std::string>{"test_query_5", "test_query_4"}));
+  EXPECT_EQ(ids(lib.query("\"sample 3\" tag:queryTag")),
+            std::vector<std::string>{"test_query_3"});
+  EXPECT_EQ(ids(lib.query("tag:queryTag width>=3840 codec:vp9")),
+            std::vector<std::string>{"test_query_4"});
+  EXPECT_EQ(ids(lib.query("tag:queryTag duration<=20 sort:rating:asc")),
+            (std::vector<std::string>{"test_query_0", "test_query_1",
+                                      "test_query_2"}));
+  std::string error;
+  EXPECT_TRUE(lib.query("sort:nowhere", &error).empty());
+  EXPECT_FALSE(error.empty());
+
+  for (int i = 0; i < 6; ++i) {
+    lib.removeWallpaper("test_query_" + std::to_string(i));
+  }
+}
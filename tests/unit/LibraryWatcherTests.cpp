@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+#include "core/config/ConfigManager.hpp"
+#include "core/config/SettingsSchema.hpp"
+#include "core/wallpaper/LibraryWatcher.hpp"
+#include "core/wallpaper/WallpaperLibrary.hpp"
+#include <glib.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using bwp::config::ConfigManager;
+using bwp::wallpaper::LibraryWatcher;
+using bwp::wallpaper::WallpaperLibrary;
+namespace keys = bwp::config::keys;
+
+namespace {
+
+std::string be32(uint32_t v) {
+  return {char(v >> 24), char(v >> 16), char(v >> 8), char(v)};
+}
+
+// Enough of a PNG for the header probe; `padding` changes the file size.
+std::string png(uint32_t width, uint32_t height, size_t padding = 0) {
+  return "\x89PNG\r\n\x1a\n" + be32(13) + "IHDR" + be32(width) +
+         be32(height) + std::string(5, '\0') + be32(0) +
+         std::string(padding, '\0');
+}
+
+std::filesystem::path freshDir(const std::string &name) {
+  auto dir = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  return dir;
+}
+
+void write(const std::filesystem::path &path, const std::string &bytes) {
+  std::ofstream(path, std::ios::binary) << bytes;
+}
+
+// Runs the default main context, where the watcher reads inotify and
+// debounces, until `done` holds.
+template <typename Predicate> bool pumpUntil(Predicate done) {
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (!done()) {
+    if (std::chrono::steady_clock::now() > deadline)
+      return false;
+    while (g_main_context_iteration(nullptr, FALSE)) {
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return true;
+}
+
+bool known(const std::filesystem::path &path) {
+  return WallpaperLibrary::getInstance().getWallpaper(path.string())
+      .has_value();
+}
+
+// Points library.paths at one temp root for the life of a test, with HOME
+// moved aside so no Steam workshop folders are watched alongside it.
+class WatchedRoot {
+public:
+  explicit WatchedRoot(const std::string &name)
+      : root(freshDir(name)),
+        m_home(freshDir(name + "_home")),
+        m_savedPaths(
+            ConfigManager::getInstance().get<std::vector<std::string>>(
+                keys::LIBRARY_PATHS, {})) {
+    const char *home = std::getenv("HOME");
+    m_savedHome = home ? home : "";
+    setenv("HOME", m_home.c_str(), 1);
+    ConfigManager::getInstance().set(keys::LIBRARY_PATHS,
+                                     std::vector<std::string>{root.string()});
+  }
+  ~WatchedRoot() {
+    LibraryWatcher::getInstance().stop();
+    ConfigManager::getInstance().set(keys::LIBRARY_PATHS, m_savedPaths);
+    setenv("HOME", m_savedHome.c_str(), 1);
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+    std::filesystem::remove_all(m_home, ec);
+  }
+  const std::filesystem::path root;
+
+private:
+  std::filesystem::path m_home;
+  std::vector<std::string> m_savedPaths;
+  std::string m_savedHome;
+};
+
+} // namespace
+
+// ──────────────────────────────────────────────────────────
+//  LibraryWatcher — live inotify events on a temp library
+// ──────────────────────────────────────────────────────────
+
+TEST(LibraryWatcher, IngestsCreatedModifiedRenamedAndDeletedFiles) {
+  WatchedRoot library("bwp_watcher_files");
+  auto &watcher = LibraryWatcher::getInstance();
+  ASSERT_TRUE(watcher.start());
+  ASSERT_TRUE(pumpUntil([&] { return watcher.watchCount() == 1; }));
+
+  auto a = library.root / "a.png";
+  write(a, png(640, 480));
+  ASSERT_TRUE(pumpUntil([&] { return known(a); }));
+  EXPECT_EQ(WallpaperLibrary::getInstance().getWallpaper(a.string())->width,
+            640);
+
+  write(a, png(1920, 1080, 64));
+  ASSERT_TRUE(pumpUntil([&] {
+    auto info = WallpaperLibrary::getInstance().getWallpaper(a.string());
+    return info && info->width == 1920;
+  }));
+
+  auto b = library.root / "b.png";
+  std::filesystem::rename(a, b);
+  ASSERT_TRUE(pumpUntil([&] { return known(b) && !known(a); }));
+
+  std::filesystem::remove(b);
+  ASSERT_TRUE(pumpUntil([&] { return !known(b); }));
+}
+
+TEST(LibraryWatcher, FollowsDirectoriesMovedInRenamedAndMovedOut) {
+  WatchedRoot library("bwp_watcher_dirs");
+  auto outside = freshDir("bwp_watcher_outside");
+  auto &watcher = LibraryWatcher::getInstance();
+  ASSERT_TRUE(watcher.start());
+  ASSERT_TRUE(pumpUntil([&] { return watcher.watchCount() == 1; }));
+
+  std::filesystem::create_directories(outside / "set" / "nested");
+  write(outside / "set" / "c.png", png(800, 600));
+  write(outside / "set" / "nested" / "d.png", png(800, 600));
+  std::filesystem::rename(outside / "set", library.root / "set");
+  ASSERT_TRUE(pumpUntil([&] {
+    return known(library.root / "set" / "c.png") &&
+           known(library.root / "set" / "nested" / "d.png");
+  }));
+  EXPECT_TRUE(pumpUntil([&] { return watcher.watchCount() == 3; }));
+
+  // Renamed within the library: entries follow, and the old path is not
+  // mistaken for a watched one when it is created again.
+  std::filesystem::rename(library.root / "set", library.root / "renamed");
+  ASSERT_TRUE(pumpUntil([&] {
+    return known(library.root / "renamed" / "nested" / "d.png") &&
+           !known(library.root / "set" / "nested" / "d.png");
+  }));
+  write(library.root / "renamed" / "nested" / "e.png", png(800, 600));
+  ASSERT_TRUE(pumpUntil(
+      [&] { return known(library.root / "renamed" / "nested" / "e.png"); }));
+  std::filesystem::create_directories(library.root / "set");
+  ASSERT_TRUE(pumpUntil([&] { return watcher.watchCount() == 4; }));
+  write(library.root / "set" / "f.png", png(800, 600));
+  ASSERT_TRUE(pumpUntil([&] { return known(library.root / "set" / "f.png"); }));
+
+  // Moved out: its entries and watches go.
+  std::filesystem::rename(library.root / "renamed", outside / "renamed");
+  ASSERT_TRUE(pumpUntil([&] {
+    return !known(library.root / "renamed" / "c.png") &&
+           !known(library.root / "renamed" / "nested" / "e.png");
+  }));
+  EXPECT_TRUE(pumpUntil([&] { return watcher.watchCount() == 2; }));
+
+  std::error_code ec;
+  std::filesystem::remove_all(outside, ec);
+  WallpaperLibrary::getInstance().removeWallpaper(
+      (library.root / "set" / "f.png").string());
+}
+
+TEST(LibraryWatcher, FolderMovedInArrivesAsOneChangeSet) {
+  WatchedRoot library("bwp_watcher_bulk");
+  auto outside = freshDir("bwp_watcher_bulk_outside");
+  auto &watcher = LibraryWatcher::getInstance();
+  auto &lib = WallpaperLibrary::getInstance();
+  ASSERT_TRUE(watcher.start());
+  ASSERT_TRUE(pumpUntil([&] { return watcher.watchCount() == 1; }));
+
+  std::filesystem::create_directories(outside / "pack");
+  for (int i = 0; i < 20; ++i)
+    write(outside / "pack" / ("w" + std::to_string(i) + ".png"),
+          png(800, 600));
+  // Dispatched on the watcher's worker thread.
+  std::atomic<int> changeSets{0};
+  std::atomic<size_t> added{0};
+  int cbId = lib.addChangeSetCallback(
+      [&](const bwp::wallpaper::LibraryChangeSet &changes) {
+        changeSets++;
+        added += changes.added.size();
+      });
+  std::filesystem::rename(outside / "pack", library.root / "pack");
+  ASSERT_TRUE(pumpUntil([&] { return added == 20; }));
+  lib.removeChangeSetCallback(cbId);
+  EXPECT_EQ(changeSets, 1);
+
+  lib.beginBulk();
+  for (int i = 0; i < 20; ++i)
+    lib.removeWallpaper(
+        (library.root / "pack" / ("w" + std::to_string(i) + ".png")).string());
+  lib.commit();
+  std::error_code ec;
+  std::filesystem::remove_all(outside, ec);
+}
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include "core/utils/MediaProbe.hpp"
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using bwp::utils::MediaProbe;
+
+namespace {
+
+std::string be16(uint16_t v) { return {char(v >> 8), char(v)}; }
+std::string be32(uint32_t v) {
+  return {char(v >> 24), char(v >> 16), char(v >> 8), char(v)};
+}
+std::string le16(uint16_t v) { return {char(v), char(v >> 8)}; }
+std::string zeros(size_t n) { return std::string(n, '\0'); }
+std::string box(const std::string &type, const std::string &payload) {
+  return be32(uint32_t(8 + payload.size())) + type + payload;
+}
+// EBML element with a one-byte size (payloads here stay under 127 bytes).
+std::string ebml(const std::string &id, const std::string &payload) {
+  return id + char(0x80 | payload.size()) + payload;
+}
+
+std::filesystem::path freshDir(const std::string &name) {
+  auto dir = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  return dir;
+}
+
+std::filesystem::path write(const std::filesystem::path &dir,
+                            const std::string &name,
+                            const std::string &bytes) {
+  auto path = dir / name;
+  std::ofstream(path, std::ios::binary) << bytes;
+  return path;
+}
+
+} // namespace
+
+// ──────────────────────────────────────────────────────────
+//  MediaProbe — still images
+// ──────────────────────────────────────────────────────────
+
+TEST(MediaProbe, ReadsImageHeaders) {
+  auto dir = freshDir("bwp_media_probe");
+  std::string png = "\x89PNG\r\n\x1a\n" + be32(13) + "IHDR" + be32(3840) +
+                    be32(2160) + zeros(5) + be32(0) + be32(8) + "acTL" +
+                    zeros(8) + be32(0);
+  auto info = MediaProbe::probe(write(dir, "a.png", png));
+  ASSERT_TRUE(info);
+  EXPECT_EQ(info->width, 3840);
+  EXPECT_EQ(info->height, 2160);
+  EXPECT_EQ(info->codec, "apng");
+
+  // An EXIF segment ahead of the frame header is skipped by length.
+  std::string jpeg = "\xFF\xD8\xFF\xE1" + be16(2 + 100) + zeros(100) +
+                     "\xFF\xC2" + be16(17) + char(8) + be16(1080) +
+                     be16(1920) + zeros(10);
+  info = MediaProbe::probe(write(dir, "b.jpg", jpeg));
+  ASSERT_TRUE(info);
+  EXPECT_EQ(info->width, 1920);
+  EXPECT_EQ(info->height, 1080);
+  EXPECT_EQ(info->codec, "jpeg");
+
+  info = MediaProbe::probe(
+      write(dir, "c.gif", "GIF89a" + le16(640) + le16(480) + zeros(3)));
+  ASSERT_TRUE(info);
+  EXPECT_EQ(info->width, 640);
+  EXPECT_EQ(info->height, 480);
+
+  std::string vp8x = "RIFF" + zeros(4) + "WEBPVP8X" + zeros(4) + zeros(4) +
+                     std::string("\xFF\x0E\x00\x6F\x08\x00", 6);
+  info = MediaProbe::probe(write(dir, "d.webp", vp8x));
+  ASSERT_TRUE(info);
+  EXPECT_EQ(info->width, 3840);
+  EXPECT_EQ(info->height, 2160);
+
+  EXPECT_FALSE(MediaProbe::probe(write(dir, "e.png", "not an image at all")));
+  EXPECT_FALSE(MediaProbe::probe(dir / "missing.png"));
+}
+
+// ──────────────────────────────────────────────────────────
+//  MediaProbe — video containers
+// ──────────────────────────────────────────────────────────
+
+TEST(MediaProbe, ReadsMp4MoovAfterMdat) {
+  auto dir = freshDir("bwp_media_probe");
+  std::string mvhd = box("mvhd", zeros(12) + be32(1000) + be32(12500) +
+                                     zeros(80));
+  std::string tkhd = box("tkhd", zeros(76) + be32(1280u << 16) +
+                                     be32(720u << 16));
+  std::string mdhd = box("mdhd", zeros(12) + be32(30000) + be32(375000) +
+                                     zeros(4));
+  std::string hdlr = box("hdlr", zeros(8) + "vide" + zeros(13));
+  std::string avc1 = box("avc1", zeros(24) + be16(1920) + be16(1080) +
+                                     zeros(50));
+  std::string stsd = box("stsd", zeros(4) + be32(1) + avc1);
+  // 375 frames of 1000 ticks at 30000 ticks/s: 30 fps.
+  std::string stts = box("stts", zeros(4) + be32(1) + be32(375) + be32(1000));
+  std::string stbl = box("stbl", stsd + stts);
+  std::string trak =
+      box("trak", tkhd + box("mdia", mdhd + hdlr +
+                                         box("minf", stbl)));
+  std::string mp4 = box("ftyp", "isom" + zeros(4)) +
+                    box("mdat", zeros(64 * 1024)) + box("moov", mvhd + trak);
+  auto info = MediaProbe::probe(write(dir, "clip.mp4", mp4));
+  ASSERT_TRUE(info);
+  EXPECT_EQ(info->width, 1920);
+  EXPECT_EQ(info->height, 1080);
+  EXPECT_DOUBLE_EQ(info->duration, 12.5);
+  EXPECT_DOUBLE_EQ(info->frameRate, 30.0);
+  EXPECT_EQ(info->codec, "h264");
+}
+
+TEST(MediaProbe, ReadsMatroskaInfoAndTracks) {
+  auto dir = freshDir("bwp_media_probe");
+  std::string header = ebml("\x1A\x45\xDF\xA3", ebml("\x42\x82", "webm"));
+  // 8-byte float 4000.0 with the default 1 ms timecode scale.
+  std::string duration = ebml("\x44\x89", std::string("\x40\xAF\x40\x00"
+                                                       "\x00\x00\x00\x00",
+                                                       8));
+  std::string info = ebml("\x15\x49\xA9\x66",
+                          ebml("\x2A\xD7\xB1", be32(1000000)) + duration);
+  std::string video = ebml("\xE0", ebml("\xB0", be16(2560)) +
+                                       ebml("\xBA", be16(1440)));
+  std::string track = ebml(
+      "\xAE", ebml("\x83", "\x01") + ebml("\x86", "V_VP9") +
+                  ebml("\x23\xE3\x83", be32(16666667)) + video);
+  std::string tracks = ebml("\x16\x54\xAE\x6B", track);
+  std::string cluster = "\x1F\x43\xB6\x75\x01\xFF\xFF\xFF\xFF\xFF\xFF\xFF";
+  std::string segment = "\x18\x53\x80\x67\x01\xFF\xFF\xFF\xFF\xFF\xFF\xFF" +
+                        info + tracks + cluster + zeros(256);
+  auto probed = MediaProbe::probe(write(dir, "clip.webm", header + segment));
+  ASSERT_TRUE(probed);
+  EXPECT_EQ(probed->width, 2560);
+  EXPECT_EQ(probed->height, 1440);
+  EXPECT_DOUBLE_EQ(probed->duration, 4.0);
+  EXPECT_NEAR(probed->frameRate, 60.0, 0.01);
+  EXPECT_EQ(probed->codec, "vp9");
+}
@@ -0,0 +1,47 @@
+#include <gtest/gtest.h>
+#include "core/wallpaper/library/PathValidator.hpp"
+#include <filesystem>
+#include <fstream>
+
+using bwp::wallpaper::PathCheck;
+using bwp::wallpaper::PathValidator;
+
+// ──────────────────────────────────────────────────────────
+//  PathValidator — parallel existence and canonical paths
+// ──────────────────────────────────────────────────────────
+
+TEST(PathValidator, ClassifiesAndCanonicalizes) {
+  auto dir = std::filesystem::temp_directory_path() / "bwp_path_validator";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir / "sub");
+  std::ofstream(dir / "sub" / "a.jpg") << "x";
+
+  std::vector<PathCheck> checks;
+  for (int i = 0; i < 300; ++i) {
+    PathCheck check;
+    check.id = std::to_string(i);
+    check.path = i % 2 == 0 ? (dir / "sub" / ".." / "sub" / "a.jpg").string()
+                            : (dir / ("missing_" + check.id)).string();
+    checks.push_back(check);
+  }
+  ASSERT_TRUE(PathValidator::run(checks, 4));
+
+  auto canonical = std::filesystem::canonical(dir / "sub" / "a.jpg").string();
+  for (size_t i = 0; i < checks.size(); ++i) {
+    if (i % 2 == 0) {
+      EXPECT_EQ(checks[i].state, PathCheck::State::Present);
+      EXPECT_EQ(checks[i].canonical, canonical);
+    } else {
+      EXPECT_EQ(checks[i].state, PathCheck::State::Missing);
+      EXPECT_EQ(checks[i].canonical, checks[i].path);
+    }
+  }
+  std::filesystem::remove_all(dir);
+}
+
+TEST(PathValidator, StopsWhenRequested) {
+  std::vector<PathCheck> checks(10);
+  std::atomic<bool> stop{true};
+  EXPECT_FALSE(PathValidator::run(checks, 2, &stop));
+  EXPECT_EQ(checks[0].state, PathCheck::State::Pending);
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include "core/utils/PerceptualHash.hpp"
+#include "core/wallpaper/WallpaperLibrary.hpp"
+#include "core/wallpaper/library/PerceptualIndex.hpp"
+#include <algorithm>
+#include <random>
+
+using bwp::wallpaper::PerceptualIndex;
+namespace phash = bwp::utils::phash;
+
+namespace {
+
+// RGB image with a diagonal gradient and a bright block, scaled to size.
+std::vector<uint8_t> makeImage(int width, int height, int shift) {
+  std::vector<uint8_t> rgb(static_cast<size_t>(width) * height * 3);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      int fx = x * 100 / width, fy = y * 100 / height;
+      int v = (fx * 2 + fy) % 200 + shift;
+      if (fx > 60 && fy < 30)
+        v = 250;
+      uint8_t *p = &rgb[(static_cast<size_t>(y) * width + x) * 3];
+      p[0] = p[1] = p[2] = static_cast<uint8_t>(std::clamp(v, 0, 255));
+    }
+  }
+  return rgb;
+}
+
+} // namespace
+
+// ──────────────────────────────────────────────────────────
+//  dHash — resized copies stay close
+// ──────────────────────────────────────────────────────────
+
+TEST(PerceptualHash, ResizedCopiesAreNear) {
+  auto big = makeImage(256, 144, 0);
+  auto small = makeImage(96, 54, 5); // smaller and slightly brighter
+  auto flipped = big;
+  std::reverse(flipped.begin(), flipped.end());
+  uint64_t a = phash::dhash(big.data(), 256, 144, 256 * 3, 3);
+  uint64_t b = phash::dhash(small.data(), 96, 54, 96 * 3, 3);
+  uint64_t c = phash::dhash(flipped.data(), 256, 144, 256 * 3, 3);
+  EXPECT_LE(phash::distance(a, b), 6);
+  EXPECT_GT(phash::distance(a, c), 16);
+  std::vector<uint8_t> flat(16 * 16 * 3, 128);
+  EXPECT_EQ(phash::dhash(flat.data(), 16, 16, 48, 3), 1u);
+}
+
+// ──────────────────────────────────────────────────────────
+//  PerceptualIndex — BK-tree radius queries and clusters
+// ──────────────────────────────────────────────────────────
+
+TEST(PerceptualIndex, RadiusQueriesMatchBruteForce) {
+  std::mt19937_64 rng(7);
+  PerceptualIndex index;
+  std::vector<uint64_t> hashes(2000);
+  for (uint32_t slot = 0; slot < hashes.size(); ++slot) {
+    hashes[slot] = rng() | 1;
+    index.set(slot, hashes[slot]);
+  }
+  // Remove most slots to exercise routing nodes and the rebuild.
+  for (uint32_t slot = 0; slot < 1500; ++slot) {
+    index.remove(slot);
+    hashes[slot] = 0;
+  }
+  EXPECT_EQ(index.size(), 500u);
+  for (int probe = 0; probe < 50; ++probe) {
+    uint64_t q = hashes[1500 + probe] ^ (uint64_t{1} << probe);
+    auto found = index.within(q, 20);
+    std::vector<uint32_t> got, expected;
+    for (auto [slot, d] : found) {
+      EXPECT_EQ(d, phash::distance(hashes[slot], q));
+      got.push_back(slot);
+    }
+    for (uint32_t slot = 1500; slot < hashes.size(); ++slot) {
+      if (phash::distance(hashes[slot], q) <= 20)
+        expected.push_back(slot);
+    }
+    std::sort(got.begin(), got.end());
+    EXPECT_EQ(got, expected);
+  }
+}
+
+TEST(PerceptualIndex, ClustersAreSingleLinkage) {
+  PerceptualIndex index;
+  index.set(1, 0xF0F0);
+  index.set(2, 0xF0F1);     // 1 bit from slot 1
+  index.set(3, 0xF0F3);     // 1 bit from slot 2, 2 from slot 1
+  index.set(4, 0xF0F0);     // same hash as slot 1
+  index.set(5, 0x0F0F0000); // far away
+  auto clusters = index.clusters(1);
+  ASSERT_EQ(clusters.size(), 1u);
+  EXPECT_EQ(clusters[0], (std::vector<uint32_t>{1, 2, 3, 4}));
+  index.set(2, 0);
+  EXPECT_EQ(index.clusters(1)[0], (std::vector<uint32_t>{1, 4}));
+}
+
+TEST(PerceptualIndex, LibraryFindsNearDuplicates) {
+  auto &lib = bwp::wallpaper::WallpaperLibrary::getInstance();
+  for (int i = 0; i < 3; ++i) {
+    bwp::wallpaper::WallpaperInfo wp;
+    wp.id = "test_near_" + std::to_string(i);
+    wp.path = "/tmp/test_near_" + std::to_string(i) + ".jpg";
+    lib.addWallpaper(wp);
+  }
+  lib.updatePerceptualHash("test_near_0", 0x123456789ABCDEF0ULL);
+  lib.updatePerceptualHash("test_near_1", 0x123456789ABCDEF3ULL);
+  lib.updatePerceptualHash("test_near_2", ~0x123456789ABCDEF0ULL);
+  EXPECT_EQ(lib.getWallpaper("test_near_1")->phash, 0x123456789ABCDEF3ULL);
+
+  bool found = false;
+  for (const auto &ids : lib.findNearDuplicates(2)) {
+    if (std::find(ids.begin(), ids.end(), "test_near_0") != ids.end()) {
+      EXPECT_EQ(ids, (std::vector<std::string>{"test_near_0", "test_near_1"}));
+      found = true;
+    }
+  }
+  EXPECT_TRUE(found);
+  for (int i = 0; i < 3; ++i)
+    lib.removeWallpaper("test_near_" + std::to_string(i));
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include "core/wallpaper/library/ProjectMetadata.hpp"
+#include <filesystem>
+#include <fstream>
+
+using bwp::wallpaper::ProjectMetadata;
+using bwp::wallpaper::ProjectMetadataCache;
+
+// ──────────────────────────────────────────────────────────
+//  ProjectMetadata — top-level field extraction
+// ──────────────────────────────────────────────────────────
+
+TEST(ProjectMetadata, ExtractsTopLevelFieldsOnly) {
+  auto metadata = ProjectMetadata::extract(R"({
+    "contentrating": "Everyone",
+    "file": "scene.json",
+    "general": {
+      "properties": {
+        "title": {"text": "nested", "type": "text"},
+        "tags": ["nested"],
+        "schemecolor": {"value": "0.1 0.2 0.3", "order": 0}
+      }
+    },
+    "tags": ["Anime", "Landscape"],
+    "title": "Sunset \"Cove\" é",
+    "type": "Scene",
+    "version": 3,
+    "workshopid": "123"
+  })");
+  ASSERT_TRUE(metadata);
+  EXPECT_EQ(metadata->file, "scene.json");
+  EXPECT_EQ(metadata->title, "Sunset \"Cove\" \xc3\xa9");
+  EXPECT_TRUE(metadata->hasTitle);
+  EXPECT_EQ(metadata->type, "Scene");
+  EXPECT_EQ(metadata->tags, (std::vector<std::string>{"Anime", "Landscape"}));
+
+  // The parse stops after the last wanted key, so trailing garbage after
+  // it does not matter, while garbage before it does.
+  auto early =
+      ProjectMetadata::extract(R"({"title":"a","file":"b","type":"video",)"
+                               R"("tags":[],"general":{ broken)");
+  ASSERT_TRUE(early);
+  EXPECT_EQ(early->type, "video");
+  EXPECT_TRUE(early->hasTags);
+  EXPECT_FALSE(ProjectMetadata::extract(R"({"general":{ broken, "title":"a"})"));
+
+  auto partial = ProjectMetadata::extract(R"({"file":"v.mp4"})");
+  ASSERT_TRUE(partial);
+  EXPECT_FALSE(partial->hasTitle);
+  EXPECT_FALSE(partial->hasTags);
+}
+
+TEST(ProjectMetadata, CacheRevalidatesAndPersists) {
+  auto dir = std::filesystem::temp_directory_path() / "bwp_project_meta";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  auto project = dir / "project.json";
+  std::ofstream(project) << R"({"title":"One","type":"video"})";
+
+  ProjectMetadataCache cache;
+  EXPECT_EQ(cache.get(project)->title, "One");
+  EXPECT_EQ(cache.get(project)->title, "One");
+  EXPECT_EQ(cache.misses(), 1u);
+  EXPECT_EQ(cache.hits(), 1u);
+
+  std::ofstream(project) << R"({"title":"Two!","type":"video"})";
+  EXPECT_EQ(cache.get(project)->title, "Two!");
+  EXPECT_EQ(cache.misses(), 2u);
+  EXPECT_FALSE(cache.get(dir / "missing.json"));
+
+  auto file = dir / "cache.bin";
+  ASSERT_TRUE(cache.save(file));
+  ProjectMetadataCache loaded;
+  ASSERT_TRUE(loaded.load(file));
+  EXPECT_EQ(loaded.size(), 1u);
+  EXPECT_EQ(loaded.get(project)->title, "Two!");
+  EXPECT_EQ(loaded.hits(), 1u);
+  std::filesystem::remove_all(dir);
+}
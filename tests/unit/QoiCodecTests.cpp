@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include "core/utils/QoiCodec.hpp"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace qoi = bwp::utils::qoi;
+
+namespace {
+
+// Gradients, flat runs, alpha steps and noise, so every chunk type shows up.
+std::vector<uint8_t> makeImage(int width, int height, int channels,
+                               int rowstride) {
+  std::vector<uint8_t> pixels(static_cast<size_t>(rowstride) * height, 0xee);
+  uint32_t seed = 12345;
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      uint8_t *p = pixels.data() + y * rowstride + x * channels;
+      seed = seed * 1103515245u + 12345u;
+      if (y < height / 4) {
+        p[0] = p[1] = p[2] = 40;
+      } else if (y < height / 2) {
+        p[0] = static_cast<uint8_t>(x);
+        p[1] = static_cast<uint8_t>(x + y);
+        p[2] = static_cast<uint8_t>(y * 3);
+      } else {
+        p[0] = static_cast<uint8_t>(seed >> 8);
+        p[1] = static_cast<uint8_t>(seed >> 16);
+        p[2] = static_cast<uint8_t>(seed >> 24);
+      }
+      if (channels == 4)
+        p[3] = static_cast<uint8_t>(x < width / 2 ? 255 : x * 2);
+    }
+  }
+  return pixels;
+}
+
+} // namespace
+
+// ──────────────────────────────────────────────────────────
+//  QoiCodec — lossless round trip
+// ──────────────────────────────────────────────────────────
+
+TEST(QoiCodec, RoundTripsRgbAndRgba) {
+  for (int channels : {3, 4}) {
+    const int width = 97, height = 64;
+    const int stride = width * channels + 5; // padded rows
+    auto source = makeImage(width, height, channels, stride);
+    std::string encoded =
+        qoi::encode(source.data(), width, height, stride, channels);
+    ASSERT_FALSE(encoded.empty());
+    const auto *data = reinterpret_cast<const uint8_t *>(encoded.data());
+    auto header = qoi::readHeader(data, encoded.size());
+    ASSERT_TRUE(header);
+    EXPECT_EQ(header->width, 97u);
+    EXPECT_EQ(header->height, 64u);
+    EXPECT_EQ(header->channels, channels);
+
+    const size_t tight = static_cast<size_t>(width) * channels;
+    std::vector<uint8_t> decoded(tight * height);
+    ASSERT_TRUE(qoi::decode(data, encoded.size(), decoded.data(), tight));
+    for (int y = 0; y < height; ++y)
+      ASSERT_EQ(0, std::memcmp(decoded.data() + y * tight,
+                               source.data() + y * stride, tight))
+          << "row " << y << ", " << channels << " channels";
+  }
+}
+
+TEST(QoiCodec, RejectsTruncatedAndBogusInput) {
+  auto source = makeImage(16, 16, 3, 48);
+  std::string encoded = qoi::encode(source.data(), 16, 16, 48, 3);
+  std::vector<uint8_t> out(16 * 16 * 3);
+  const auto *data = reinterpret_cast<const uint8_t *>(encoded.data());
+  EXPECT_FALSE(qoi::decode(data, encoded.size() / 2, out.data(), 48));
+  EXPECT_FALSE(qoi::readHeader(data, 10));
+  std::string bogus = encoded;
+  bogus[12] = 2; // channels
+  EXPECT_FALSE(qoi::readHeader(
+      reinterpret_cast<const uint8_t *>(bogus.data()), bogus.size()));
+  EXPECT_TRUE(qoi::encode(source.data(), 16, 16, 48, 2).empty());
+}
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include "core/wallpaper/library/ScanManifest.hpp"
+#include <filesystem>
+#include <fstream>
+
+using bwp::wallpaper::DirStamp;
+using bwp::wallpaper::ScanManifest;
+
+// ──────────────────────────────────────────────────────────
+//  ScanManifest — persistence and directory stamps
+// ──────────────────────────────────────────────────────────
+
+TEST(ScanManifest, RoundTripsAndRejectsTruncatedFiles) {
+  auto dir = std::filesystem::temp_directory_path() / "bwp_scan_manifest";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir / "sub");
+  auto stamp = DirStamp::of(dir);
+  ASSERT_TRUE(stamp);
+
+  ScanManifest manifest;
+  ScanManifest::Directory entry;
+  entry.stamp = *stamp;
+  entry.subdirs = {"sub"};
+  entry.files = {"a.png", "b.mp4"};
+  manifest.setDirectory(dir.string(), entry);
+  ScanManifest part;
+  part.setItem("/workshop/123", {*stamp, 42, true});
+  manifest.merge(std::move(part));
+  auto file = dir / "manifest.bin";
+  ASSERT_TRUE(manifest.save(file));
+
+  ScanManifest loaded;
+  ASSERT_TRUE(loaded.load(file));
+  const auto *d = loaded.directory(dir.string());
+  ASSERT_NE(d, nullptr);
+  EXPECT_TRUE(d->stamp == *stamp);
+  EXPECT_EQ(d->subdirs, entry.subdirs);
+  EXPECT_EQ(d->files, entry.files);
+  const auto *item = loaded.item("/workshop/123");
+  ASSERT_NE(item, nullptr);
+  EXPECT_EQ(item->projectMtimeNs, 42);
+  EXPECT_TRUE(item->found);
+  EXPECT_EQ(loaded.item("/workshop/124"), nullptr);
+
+  // Adding an entry changes the stamp, so the recorded listing is stale.
+  std::ofstream(dir / "new.png") << "x";
+  std::filesystem::last_write_time(
+      dir, std::filesystem::last_write_time(dir) + std::chrono::seconds(5));
+  EXPECT_FALSE(*DirStamp::of(dir) == *stamp);
+
+  auto size = std::filesystem::file_size(file);
+  std::filesystem::resize_file(file, size - 3);
+  EXPECT_FALSE(loaded.load(file));
+  EXPECT_EQ(loaded.directories(), 0u);
+  EXPECT_EQ(loaded.items(), 0u);
+  std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include "core/utils/ShardedLruCache.hpp"
+#include <memory>
+#include <string>
+
+using Cache = bwp::utils::ShardedLruCache<std::string>;
+
+// ──────────────────────────────────────────────────────────
+//  ShardedLruCache — byte budget, recency, stats
+// ──────────────────────────────────────────────────────────
+
+TEST(ShardedLruCache, EvictsLeastRecentlyUsedWithinByteBudget) {
+  Cache cache(300, 1);
+  cache.put("a", "A", 100);
+  cache.put("b", "B", 100);
+  cache.put("c", "C", 100);
+  // Touching "a" leaves "b" as the oldest entry.
+  EXPECT_EQ(cache.get("a"), "A");
+  cache.put("d", "D", 100);
+  EXPECT_FALSE(cache.get("b"));
+  EXPECT_TRUE(cache.get("a"));
+  EXPECT_TRUE(cache.get("c"));
+  EXPECT_TRUE(cache.get("d"));
+
+  // Replacing an entry re-costs it; a large value pushes out several.
+  cache.put("d", "DD", 250);
+  auto stats = cache.stats();
+  EXPECT_EQ(stats.entries, 1u);
+  EXPECT_EQ(stats.bytes, 250u);
+  EXPECT_EQ(stats.evictions, 3u);
+
+  cache.put("huge", "H", 301);
+  EXPECT_FALSE(cache.get("huge"));
+  EXPECT_TRUE(cache.get("d"));
+}
+
+TEST(ShardedLruCache, EraseShrinkAndStats) {
+  Cache cache(1000, 4);
+  for (int i = 0; i < 8; ++i)
+    cache.put("dir/" + std::to_string(i), "v", 10);
+  cache.put("other", "v", 10);
+  EXPECT_EQ(cache.eraseIf([](const std::string &k) {
+              return k.rfind("dir/", 0) == 0;
+            }),
+            8u);
+  EXPECT_TRUE(cache.erase("other"));
+  EXPECT_FALSE(cache.erase("other"));
+  EXPECT_EQ(cache.stats().entries, 0u);
+  EXPECT_EQ(cache.stats().bytes, 0u);
+
+  for (int i = 0; i < 40; ++i)
+    cache.put(std::to_string(i), "v", 20);
+  cache.setBudget(0);
+  auto stats = cache.stats();
+  EXPECT_EQ(stats.entries, 0u);
+  EXPECT_EQ(stats.budgetBytes, 0u);
+
+  cache.setBudget(1000);
+  cache.put("k", "v", 1);
+  cache.get("k");
+  cache.get("missing");
+  stats = cache.stats();
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.misses, 1u);
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include "core/wallpaper/SharedThumbnailCache.hpp"
+#include <sys/stat.h>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using bwp::wallpaper::SharedThumbnailCache;
+
+namespace {
+
+std::filesystem::path freshDir(const std::string &name) {
+  auto dir = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  return dir;
+}
+
+std::filesystem::path writeSource(const std::filesystem::path &dir,
+                                  const std::string &name) {
+  auto path = dir / name;
+  std::ofstream(path, std::ios::binary) << "not decoded by the cache";
+  return path;
+}
+
+GdkPixbuf *solid(int width, int height) {
+  GdkPixbuf *pixbuf = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, width,
+                                     height);
+  gdk_pixbuf_fill(pixbuf, 0x3366ccff);
+  return pixbuf;
+}
+
+std::string uriOf(const std::filesystem::path &path) {
+  gchar *uri = g_filename_to_uri(path.c_str(), nullptr, nullptr);
+  std::string result = uri;
+  g_free(uri);
+  return result;
+}
+
+std::string nameOf(const std::string &uri) {
+  gchar *md5 = g_compute_checksum_for_string(G_CHECKSUM_MD5, uri.c_str(), -1);
+  std::string name = std::string(md5) + ".png";
+  g_free(md5);
+  return name;
+}
+
+std::string option(GdkPixbuf *pixbuf, const char *key) {
+  const char *value = gdk_pixbuf_get_option(pixbuf, key);
+  return value ? value : "<missing>";
+}
+
+} // namespace
+
+// ──────────────────────────────────────────────────────────
+//  SharedThumbnailCache — freedesktop.org thumbnail spec
+// ──────────────────────────────────────────────────────────
+
+TEST(SharedThumbnailCache, DefaultRootFollowsXdgCacheHome) {
+  auto dir = freshDir("bwp_shared_thumb_xdg");
+  const char *previous = std::getenv("XDG_CACHE_HOME");
+  std::string saved = previous ? previous : "";
+  setenv("XDG_CACHE_HOME", dir.c_str(), 1);
+  EXPECT_EQ(SharedThumbnailCache::defaultRoot(), dir / "thumbnails");
+  if (previous)
+    setenv("XDG_CACHE_HOME", saved.c_str(), 1);
+  else
+    unsetenv("XDG_CACHE_HOME");
+}
+
+TEST(SharedThumbnailCache, SavesSpecNamesAndTagsAndLoadsThemBack) {
+  auto dir = freshDir("bwp_shared_thumb_roundtrip");
+  auto source = writeSource(dir, "wall.jpg");
+  SharedThumbnailCache cache(dir / "thumbnails");
+
+  GdkPixbuf *thumb = solid(256, 144);
+  ASSERT_TRUE(cache.save(source, 256, thumb));
+  g_object_unref(thumb);
+
+  const std::string uri = uriOf(source);
+  auto file = dir / "thumbnails" / "large" / nameOf(uri);
+  ASSERT_TRUE(std::filesystem::exists(file));
+  struct stat st {};
+  ASSERT_EQ(::stat(source.c_str(), &st), 0);
+  GdkPixbuf *written = gdk_pixbuf_new_from_file(file.c_str(), nullptr);
+  ASSERT_NE(written, nullptr);
+  EXPECT_EQ(option(written, "tEXt::Thumb::URI"), uri);
+  EXPECT_EQ(option(written, "tEXt::Thumb::MTime"),
+            std::to_string(st.st_mtime));
+  EXPECT_EQ(option(written, "tEXt::Thumb::Size"), std::to_string(st.st_size));
+  g_object_unref(written);
+
+  GdkPixbuf *loaded = cache.load(source, 256);
+  ASSERT_NE(loaded, nullptr);
+  EXPECT_EQ(gdk_pixbuf_get_width(loaded), 256);
+  EXPECT_EQ(gdk_pixbuf_get_height(loaded), 144);
+  g_object_unref(loaded);
+}
+
+TEST(SharedThumbnailCache, IgnoresThumbnailOfAnOlderMtime) {
+  auto dir = freshDir("bwp_shared_thumb_mtime");
+  auto source = writeSource(dir, "wall.png");
+  SharedThumbnailCache cache(dir / "thumbnails");
+
+  GdkPixbuf *thumb = solid(128, 128);
+  ASSERT_TRUE(cache.save(source, 128, thumb));
+  g_object_unref(thumb);
+
+  auto mtime = std::filesystem::last_write_time(source);
+  std::filesystem::last_write_time(source, mtime + std::chrono::seconds(5));
+  EXPECT_EQ(cache.load(source, 128), nullptr);
+}
+
+TEST(SharedThumbnailCache, ScalesDownFromALargerFlavor) {
+  auto dir = freshDir("bwp_shared_thumb_scale");
+  auto source = writeSource(dir, "wall.webp");
+  SharedThumbnailCache cache(dir / "thumbnails");
+
+  GdkPixbuf *thumb = solid(512, 288);
+  ASSERT_TRUE(cache.save(source, 512, thumb));
+  g_object_unref(thumb);
+  EXPECT_FALSE(std::filesystem::exists(dir / "thumbnails" / "normal"));
+
+  GdkPixbuf *loaded = cache.load(source, 128);
+  ASSERT_NE(loaded, nullptr);
+  EXPECT_EQ(gdk_pixbuf_get_width(loaded), 128);
+  EXPECT_EQ(gdk_pixbuf_get_height(loaded), 72);
+  g_object_unref(loaded);
+  // A smaller flavor is never scaled up.
+  EXPECT_EQ(cache.load(source, 1024), nullptr);
+}
+
+TEST(SharedThumbnailCache, RefusesSourcesInsideTheCache) {
+  auto dir = freshDir("bwp_shared_thumb_inside");
+  auto root = dir / "thumbnails";
+  std::filesystem::create_directories(root / "normal");
+  auto source = writeSource(root / "normal", "other.png");
+  SharedThumbnailCache cache(root);
+
+  GdkPixbuf *thumb = solid(128, 128);
+  EXPECT_FALSE(cache.save(source, 128, thumb));
+  // Not a spec flavor either.
+  EXPECT_FALSE(cache.save(writeSource(dir, "wall.png"), 200, thumb));
+  g_object_unref(thumb);
+  EXPECT_EQ(std::distance(std::filesystem::directory_iterator(root / "normal"),
+                          std::filesystem::directory_iterator()),
+            1);
+}
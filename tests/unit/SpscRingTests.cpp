@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include "core/utils/SpscRing.hpp"
+#include <string>
+#include <thread>
+#include <vector>
+
+using bwp::utils::SpscRing;
+
+// ──────────────────────────────────────────────────────────
+//  SpscRing — bounded single-producer queue
+// ──────────────────────────────────────────────────────────
+
+TEST(SpscRing, RejectsPushWhenFullAndDrainsInOrder) {
+  SpscRing<std::string, 4> ring;
+  EXPECT_TRUE(ring.empty());
+  for (int i = 0; i < 4; ++i)
+    EXPECT_TRUE(ring.push(std::to_string(i)));
+  EXPECT_FALSE(ring.push("overflow"));
+
+  std::vector<std::string> out;
+  EXPECT_EQ(ring.drain([&](std::string &&s) { out.push_back(std::move(s)); },
+                       3),
+            3u);
+  EXPECT_EQ(out, (std::vector<std::string>{"0", "1", "2"}));
+  EXPECT_TRUE(ring.push("4"));
+  ring.drain([&](std::string &&s) { out.push_back(std::move(s)); });
+  EXPECT_EQ(out.back(), "4");
+  EXPECT_EQ(out.size(), 5u);
+  EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRing, DeliversEverythingAcrossThreads) {
+  SpscRing<int, 64> ring;
+  constexpr int kCount = 200000;
+  std::thread producer([&] {
+    for (int i = 0; i < kCount;) {
+      if (ring.push(int(i)))
+        ++i;
+      else
+        std::this_thread::yield();
+    }
+  });
+  int expected = 0;
+  bool ordered = true;
+  while (expected < kCount) {
+    size_t drained = ring.drain([&](int &&v) {
+      ordered = ordered && v == expected;
+      ++expected;
+    });
+    if (drained == 0)
+      std::this_thread::yield();
+  }
+  producer.join();
+  EXPECT_TRUE(ordered);
+  EXPECT_TRUE(ring.empty());
+}
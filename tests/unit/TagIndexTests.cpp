@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include "core/wallpaper/library/TagIndex.hpp"
+
+using bwp::wallpaper::RoaringBitmap;
+using bwp::wallpaper::TagIndex;
+
+// ──────────────────────────────────────────────────────────
+//  RoaringBitmap — array/bitset chunks
+// ──────────────────────────────────────────────────────────
+
+TEST(RoaringBitmap, SetOperationsAcrossRepresentations) {
+  RoaringBitmap dense, sparse;
+  // 6000 members in chunk 0 forces a bitset; chunk 1 stays an array.
+  for (uint32_t i = 0; i < 12000; i += 2)
+    dense.add(i);
+  dense.add(70000);
+  for (uint32_t i = 0; i < 12000; i += 3)
+    sparse.add(i);
+  sparse.add(70000);
+  sparse.add(70001);
+
+  EXPECT_EQ(dense.cardinality(), 6001u);
+  EXPECT_TRUE(dense.contains(70000));
+  EXPECT_FALSE(dense.contains(3));
+
+  RoaringBitmap both = dense & sparse;
+  EXPECT_EQ(both.cardinality(), 2001u); // multiples of 6, plus 70000
+  EXPECT_TRUE(both.contains(11994));
+
+  RoaringBitmap either = dense | sparse;
+  EXPECT_EQ(either.cardinality(), 6001u + 4000u - 2000u + 1u);
+
+  RoaringBitmap onlyDense = dense - sparse;
+  EXPECT_EQ(onlyDense.cardinality(), 4000u);
+  EXPECT_FALSE(onlyDense.contains(70000));
+
+  // Shrinking below the array threshold converts back losslessly.
+  for (uint32_t i = 0; i < 12000; i += 2) {
+    if (i % 6 != 0)
+      dense.remove(i);
+  }
+  EXPECT_TRUE(dense == both);
+  EXPECT_EQ(both.toVector().back(), 70000u);
+}
+
+// ──────────────────────────────────────────────────────────
+//  TagIndex — counts and boolean queries
+// ──────────────────────────────────────────────────────────
+
+TEST(TagIndex, CountsAndBooleanQueries) {
+  TagIndex index;
+  index.set(0, {"nature", "ocean"});
+  index.set(1, {"nature", "forest"});
+  index.set(2, {"city", "night"});
+  index.set(3, {"ocean", "night", "ocean"});
+
+  EXPECT_EQ(index.count("nature"), 2u);
+  EXPECT_EQ(index.count("ocean"), 2u);
+  EXPECT_EQ(index.count("missing"), 0u);
+
+  EXPECT_EQ(index.query({"nature", "ocean"}, {}, {}).toVector(),
+            (std::vector<uint32_t>{0}));
+  EXPECT_EQ(index.query({}, {"forest", "city"}, {}).toVector(),
+            (std::vector<uint32_t>{1, 2}));
+  EXPECT_EQ(index.query({"night"}, {}, {"city"}).toVector(),
+            (std::vector<uint32_t>{3}));
+  EXPECT_EQ(index.query({}, {}, {"nature"}).toVector(),
+            (std::vector<uint32_t>{2, 3}));
+  EXPECT_TRUE(index.query({"nature", "missing"}, {}, {}).empty());
+
+  index.set(0, {"city"});
+  index.remove(2);
+  EXPECT_EQ(index.count("city"), 1u);
+  EXPECT_EQ(index.count("nature"), 1u);
+  auto counts = index.counts();
+  ASSERT_EQ(counts.size(), 5u);
+  EXPECT_EQ(counts.front(), (std::pair<std::string, size_t>{"city", 1}));
+}
@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include "core/utils/ThumbnailDecoder.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <vector>
+#ifdef BWP_HAVE_LIBJPEG
+#include <jpeglib.h>
+#endif
+#ifdef BWP_HAVE_LIBPNG
+#include <png.h>
+#endif
+
+using bwp::utils::DecodedImage;
+using bwp::utils::RowDownscaler;
+using bwp::utils::ThumbnailDecoder;
+
+namespace {
+
+// Left half red, right half blue.
+std::vector<uint8_t> splitImage(int width, int height) {
+  std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 3);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      uint8_t *p = &pixels[(static_cast<size_t>(y) * width + x) * 3];
+      p[0] = x < width / 2 ? 230 : 10;
+      p[2] = x < width / 2 ? 10 : 230;
+    }
+  }
+  return pixels;
+}
+
+const uint8_t *pixel(const DecodedImage &image, int x, int y) {
+  return &image.pixels[(static_cast<size_t>(y) * image.width + x) *
+                       image.channels];
+}
+
+void expectSplit(const DecodedImage &image) {
+  const int y = image.height / 2;
+  EXPECT_NEAR(pixel(image, 2, y)[0], 230, 8);
+  EXPECT_NEAR(pixel(image, 2, y)[2], 10, 8);
+  EXPECT_NEAR(pixel(image, image.width - 3, y)[0], 10, 8);
+  EXPECT_NEAR(pixel(image, image.width - 3, y)[2], 230, 8);
+}
+
+std::filesystem::path tempFile(const char *name) {
+  return std::filesystem::temp_directory_path() / name;
+}
+
+} // namespace
+
+// ──────────────────────────────────────────────────────────
+//  RowDownscaler — streaming box filter
+// ──────────────────────────────────────────────────────────
+
+TEST(RowDownscaler, AveragesBinsAndWeightsByAlpha) {
+  RowDownscaler rgb(4, 2, 2, 1, 3);
+  const uint8_t top[] = {0, 0, 0, 100, 100, 100, 10, 20, 30, 10, 20, 30};
+  const uint8_t bottom[] = {50, 50, 50, 50, 50, 50, 30, 40, 50, 30, 40, 50};
+  rgb.push(top);
+  EXPECT_FALSE(rgb.complete());
+  rgb.push(bottom);
+  ASSERT_TRUE(rgb.complete());
+  DecodedImage out = rgb.take();
+  ASSERT_EQ(out.width, 2);
+  ASSERT_EQ(out.height, 1);
+  EXPECT_EQ(out.pixels, (std::vector<uint8_t>{50, 50, 50, 20, 30, 40}));
+
+  // A transparent pixel's colour must not darken its opaque neighbour.
+  RowDownscaler rgba(2, 1, 1, 1, 4);
+  const uint8_t row[] = {0, 0, 0, 0, 200, 100, 50, 255};
+  rgba.push(row);
+  EXPECT_EQ(rgba.take().pixels, (std::vector<uint8_t>{200, 100, 50, 128}));
+}
+
+TEST(RowDownscaler, HandlesUnevenRatios) {
+  RowDownscaler scaler(7, 5, 3, 2, 3);
+  std::vector<uint8_t> row(7 * 3, 90);
+  for (int y = 0; y < 5; ++y)
+    scaler.push(row.data());
+  DecodedImage out = scaler.take();
+  EXPECT_EQ(out.width, 3);
+  EXPECT_EQ(out.height, 2);
+  EXPECT_EQ(out.pixels, std::vector<uint8_t>(3 * 2 * 3, 90));
+  EXPECT_EQ(ThumbnailDecoder::fit(1920, 1080, 256), std::make_pair(256, 144));
+  EXPECT_EQ(ThumbnailDecoder::fit(1080, 1920, 256), std::make_pair(144, 256));
+}
+
+// ──────────────────────────────────────────────────────────
+//  ThumbnailDecoder — decode-at-scale
+// ──────────────────────────────────────────────────────────
+
+#ifdef BWP_HAVE_LIBPNG
+namespace {
+void writePng(const std::filesystem::path &path, int width, int height,
+              bool interlaced) {
+  auto pixels = splitImage(width, height);
+  FILE *file = std::fopen(path.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  png_structp png =
+      png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+  png_infop info = png_create_info_struct(png);
+  png_init_io(png, file);
+  png_set_IHDR(png, info, width, height, 8, PNG_COLOR_TYPE_RGB,
+               interlaced ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE,
+               PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+  std::vector<png_bytep> rows(height);
+  for (int y = 0; y < height; ++y)
+    rows[y] = &pixels[static_cast<size_t>(y) * width * 3];
+  png_set_rows(png, info, rows.data());
+  png_write_png(png, info, PNG_TRANSFORM_IDENTITY, nullptr);
+  png_destroy_write_struct(&png, &info);
+  std::fclose(file);
+}
+} // namespace
+
+TEST(ThumbnailDecoder, StreamsPngAndReadsTheFirstAdam7Pass) {
+  auto path = tempFile("bwp_thumbnail_decoder.png");
+  for (bool interlaced : {false, true}) {
+    writePng(path, 1200, 600, interlaced);
+    auto image = ThumbnailDecoder::decode(path, 128);
+    ASSERT_TRUE(image) << "interlaced=" << interlaced;
+    EXPECT_EQ(image->width, 128);
+    EXPECT_EQ(image->height, 64);
+    EXPECT_EQ(image->channels, 3);
+    expectSplit(*image);
+  }
+  // Nothing to gain over the regular loader.
+  writePng(path, 100, 50, false);
+  EXPECT_FALSE(ThumbnailDecoder::decode(path, 128));
+  std::filesystem::remove(path);
+}
+#endif
+
+#ifdef BWP_HAVE_LIBJPEG
+namespace {
+void writeJpeg(const std::filesystem::path &path, int width, int height,
+               bool progressive) {
+  auto pixels = splitImage(width, height);
+  FILE *file = std::fopen(path.c_str(), "wb");
+  ASSERT_NE(file, nullptr);
+  jpeg_compress_struct cinfo{};
+  jpeg_error_mgr error;
+  cinfo.err = jpeg_std_error(&error);
+  jpeg_create_compress(&cinfo);
+  jpeg_stdio_dest(&cinfo, file);
+  cinfo.image_width = width;
+  cinfo.image_height = height;
+  cinfo.input_components = 3;
+  cinfo.in_color_space = JCS_RGB;
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, 90, TRUE);
+  if (progressive)
+    jpeg_simple_progression(&cinfo);
+  jpeg_start_compress(&cinfo, TRUE);
+  while (cinfo.next_scanline < cinfo.image_height) {
+    JSAMPROW row =
+        &pixels[static_cast<size_t>(cinfo.next_scanline) * width * 3];
+    jpeg_write_scanlines(&cinfo, &row, 1);
+  }
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+  std::fclose(file);
+}
+} // namespace
+
+TEST(ThumbnailDecoder, ScalesJpegInTheDct) {
+  auto path = tempFile("bwp_thumbnail_decoder.jpg");
+  for (bool progressive : {false, true}) {
+    writeJpeg(path, 1600, 900, progressive);
+    auto image = ThumbnailDecoder::decode(path, 128);
+    ASSERT_TRUE(image) << "progressive=" << progressive;
+    EXPECT_EQ(image->width, 128);
+    EXPECT_EQ(image->height, 72);
+    expectSplit(*image);
+  }
+  // Truncated data still decodes (grey-filled) rather than failing hard.
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+  EXPECT_TRUE(ThumbnailDecoder::decode(path, 128));
+  std::filesystem::remove(path);
+}
+#endif
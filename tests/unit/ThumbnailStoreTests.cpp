@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include "core/wallpaper/library/ThumbnailStore.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using bwp::wallpaper::ThumbnailStore;
+
+namespace {
+
+std::filesystem::path freshDir(const std::string &name) {
+  auto dir = std::filesystem::temp_directory_path() / name;
+  std::filesystem::remove_all(dir);
+  return dir;
+}
+
+bool put(ThumbnailStore &store, const std::string &key,
+         const std::string &bytes, int64_t mtime = 0) {
+  ThumbnailStore::Entry meta;
+  meta.width = 4;
+  meta.height = 2;
+  meta.sourceMtime = mtime;
+  meta.sourceSize = static_cast<uint64_t>(mtime) * 10;
+  return store.put(key, meta, reinterpret_cast<const uint8_t *>(bytes.data()),
+                   bytes.size());
+}
+
+std::string read(ThumbnailStore &store, const std::string &key) {
+  auto blob = store.find(key);
+  if (!blob)
+    return "<missing>";
+  return std::string(reinterpret_cast<const char *>(blob->data),
+                     blob->entry.length);
+}
+
+} // namespace
+
+// ──────────────────────────────────────────────────────────
+//  ThumbnailStore — pack persistence, recovery, compaction
+// ──────────────────────────────────────────────────────────
+
+TEST(ThumbnailStore, PersistsIndexAndRecoversTheTail) {
+  auto dir = freshDir("bwp_thumbnail_store");
+  {
+    ThumbnailStore store(dir);
+    ASSERT_TRUE(store.open());
+    EXPECT_TRUE(put(store, "a_256", "alpha"));
+    EXPECT_TRUE(put(store, "b_256", "bravo"));
+    EXPECT_TRUE(put(store, "a_256", "alpha-2", 42));
+    EXPECT_TRUE(store.erase("b_256"));
+    EXPECT_FALSE(store.erase("b_256"));
+    EXPECT_EQ(read(store, "a_256"), "alpha-2");
+    EXPECT_FALSE(store.contains("b_256"));
+    ASSERT_TRUE(store.flush());
+    std::filesystem::copy_file(dir / "thumbnails.idx", dir / "saved.idx");
+    // Appended after the index was saved; recovered by walking the pack.
+    EXPECT_TRUE(put(store, "c_128", "charlie"));
+    auto stats = store.stats();
+    EXPECT_EQ(stats.entries, 2u);
+    EXPECT_LT(stats.liveBytes, stats.packBytes);
+  }
+  std::filesystem::rename(dir / "saved.idx", dir / "thumbnails.idx");
+  {
+    std::ofstream torn(dir / "thumbnails.pack",
+                       std::ios::binary | std::ios::app);
+    torn << "BWTR\x05";
+  }
+  auto packSize = std::filesystem::file_size(dir / "thumbnails.pack");
+
+  ThumbnailStore reopened(dir);
+  ASSERT_TRUE(reopened.open());
+  EXPECT_EQ(std::filesystem::file_size(dir / "thumbnails.pack"), packSize - 5);
+  EXPECT_EQ(read(reopened, "a_256"), "alpha-2");
+  EXPECT_EQ(read(reopened, "c_128"), "charlie");
+  EXPECT_FALSE(reopened.contains("b_256"));
+  auto blob = reopened.find("a_256");
+  ASSERT_TRUE(blob);
+  EXPECT_EQ(blob->entry.width, 4u);
+  EXPECT_EQ(blob->entry.height, 2u);
+  EXPECT_EQ(blob->entry.sourceMtime, 42);
+  EXPECT_EQ(blob->entry.sourceSize, 420u);
+}
+
+TEST(ThumbnailStore, CompactionKeepsNewestAndIsSeenByOtherHandles) {
+  auto dir = freshDir("bwp_thumbnail_store_compact");
+  ThumbnailStore a(dir);
+  ThumbnailStore b(dir);
+  ASSERT_TRUE(a.open());
+  ASSERT_TRUE(b.open());
+  for (int i = 0; i < 10; ++i)
+    ASSERT_TRUE(put(a, "k" + std::to_string(i), std::string(100, 'a' + i)));
+  // b catches up on a's records before it appends.
+  ASSERT_TRUE(put(b, "from-b", "b"));
+  EXPECT_TRUE(b.contains("k9"));
+
+  auto before = b.find("k0");
+  ASSERT_TRUE(before);
+  // Room for roughly the newest three 100-byte records.
+  ASSERT_TRUE(b.compact(3 * 140));
+  EXPECT_FALSE(b.contains("k0"));
+  EXPECT_TRUE(b.contains("from-b"));
+  EXPECT_EQ(read(b, "k9"), std::string(100, 'j'));
+  // Lookups made before the rewrite keep the old pack mapped.
+  EXPECT_EQ(std::string(reinterpret_cast<const char *>(before->data), 3),
+            "aaa");
+
+  // a notices the replaced pack on its next write.
+  ASSERT_TRUE(put(a, "after", "x"));
+  EXPECT_FALSE(a.contains("k0"));
+  EXPECT_EQ(read(a, "from-b"), "b");
+  EXPECT_EQ(read(b, "after"), "<missing>");
+
+  a.clear();
+  EXPECT_EQ(a.stats().entries, 0u);
+  ASSERT_TRUE(put(b, "fresh", "y"));
+  EXPECT_FALSE(b.contains("k9"));
+  EXPECT_EQ(read(b, "fresh"), "y");
+}
+
+TEST(ThumbnailStore, RecordOfAChangedSourceIsNotCurrent) {
+  auto dir = freshDir("bwp_thumb_store_stamp");
+  std::filesystem::create_directories(dir);
+  auto source = dir / "wall.jpg";
+  std::ofstream(source, std::ios::binary) << "original";
+
+  ThumbnailStore store(dir / "cache");
+  ASSERT_TRUE(store.open());
+  const auto stamp = ThumbnailStore::SourceStamp::of(source);
+  EXPECT_EQ(stamp.size, 8u);
+  ThumbnailStore::Entry meta;
+  meta.sourceMtime = stamp.mtime;
+  meta.sourceSize = stamp.size;
+  const std::string bytes = "thumb";
+  ASSERT_TRUE(store.put("wall", meta,
+                        reinterpret_cast<const uint8_t *>(bytes.data()),
+                        bytes.size()));
+  EXPECT_TRUE(store.find("wall")->entry.isCurrent(source));
+
+  // Same size, later mtime.
+  auto mtime = std::filesystem::last_write_time(source);
+  std::filesystem::last_write_time(source, mtime + std::chrono::seconds(5));
+  EXPECT_FALSE(store.find("wall")->entry.isCurrent(source));
+
+  // Original mtime, different size.
+  std::ofstream(source, std::ios::binary) << "rewritten";
+  std::filesystem::last_write_time(source, mtime);
+  EXPECT_FALSE(store.find("wall")->entry.isCurrent(source));
+
+  std::filesystem::remove(source);
+  EXPECT_FALSE(store.find("wall")->entry.isCurrent(source));
+}
@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+#include "core/wallpaper/library/TrigramIndex.hpp"
+
+using bwp::wallpaper::TrigramIndex;
+
+// ──────────────────────────────────────────────────────────
+//  TrigramIndex — substring queries
+// ──────────────────────────────────────────────────────────
+
+TEST(TrigramIndex, MatchesSubstringsCaseInsensitively) {
+  TrigramIndex index;
+  index.set(0, {"Ocean Sunset", "ocean_sunset.mp4", "nature"});
+  index.set(1, {"City Night", "city.jpg", "urban", "night"});
+  index.set(2, {"Forest", "forest.png", "Nature"});
+
+  EXPECT_EQ(index.search("SUNSET"), (std::vector<uint32_t>{0}));
+  EXPECT_EQ(index.search("natu"), (std::vector<uint32_t>{0, 2}));
+  EXPECT_EQ(index.search("ty.j"), (std::vector<uint32_t>{1}));
+  // All trigrams of "cean.mp" exist in doc 0, but not contiguously.
+  EXPECT_TRUE(index.search("cean.mp").empty());
+  // Matches never span two fields.
+  EXPECT_TRUE(index.search("night\ncity").empty());
+  EXPECT_TRUE(index.search("sunsetocean").empty());
+  EXPECT_EQ(index.search("").size(), 3u);
+}
+
+TEST(TrigramIndex, ShortQueriesAndUpdates) {
+  TrigramIndex index;
+  index.set(0, {"Alpha"});
+  index.set(1, {"Beta"});
+  EXPECT_EQ(index.search("a"), (std::vector<uint32_t>{0, 1}));
+  EXPECT_EQ(index.search("ph"), (std::vector<uint32_t>{0}));
+
+  index.set(1, {"Gamma"});
+  EXPECT_TRUE(index.search("beta").empty());
+  EXPECT_EQ(index.search("amm"), (std::vector<uint32_t>{1}));
+
+  index.remove(0);
+  EXPECT_TRUE(index.search("alp").empty());
+  EXPECT_EQ(index.size(), 1u);
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include "core/wallpaper/VideoFrameGrabber.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using bwp::wallpaper::VideoFrameGrabber;
+
+namespace {
+
+// RGB0 rows with `pad` junk bytes after each, so the stride is honoured.
+struct Frame {
+  int width;
+  int height;
+  size_t stride;
+  std::vector<uint8_t> pixels;
+  Frame(int w, int h, size_t pad = 12)
+      : width(w), height(h), stride(static_cast<size_t>(w) * 4 + pad),
+        pixels(stride * h, 0xff) {}
+  void set(int x, int y, uint8_t r, uint8_t g, uint8_t b) {
+    uint8_t *p = pixels.data() + y * stride + x * 4;
+    p[0] = r;
+    p[1] = g;
+    p[2] = b;
+    p[3] = 0;
+  }
+  VideoFrameGrabber::FrameLook look() const {
+    return VideoFrameGrabber::look(pixels.data(), width, height, stride);
+  }
+};
+
+Frame fill(uint8_t value) {
+  Frame frame(16, 8);
+  for (int y = 0; y < frame.height; ++y)
+    for (int x = 0; x < frame.width; ++x)
+      frame.set(x, y, value, value, value);
+  return frame;
+}
+
+// An uncompressed YUV4MPEG2 clip of a horizontal grey ramp, which libmpv
+// plays without any codec.
+std::filesystem::path writeClip(const std::string &name, int width,
+                                int height, int frames) {
+  auto dir = std::filesystem::temp_directory_path() / "bwp_frame_grabber";
+  std::filesystem::create_directories(dir);
+  auto path = dir / name;
+  std::ofstream out(path, std::ios::binary);
+  out << "YUV4MPEG2 W" << width << " H" << height
+      << " F10:1 Ip A1:1 C420jpeg\n";
+  std::string luma(static_cast<size_t>(width) * height, '\0');
+  for (int y = 0; y < height; ++y)
+    for (int x = 0; x < width; ++x)
+      luma[y * width + x] = static_cast<char>(x * 255 / (width - 1));
+  const std::string chroma(static_cast<size_t>(width / 2) * (height / 2),
+                           static_cast<char>(128));
+  for (int i = 0; i < frames; ++i)
+    out << "FRAME\n" << luma << chroma << chroma;
+  return path;
+}
+
+} // namespace
+
+// ──────────────────────────────────────────────────────────
+//  VideoFrameGrabber — blank-frame heuristic
+// ──────────────────────────────────────────────────────────
+
+TEST(VideoFrameGrabber, BlackAndFlatFramesAreBlank) {
+  auto black = fill(0).look();
+  EXPECT_EQ(black.meanLuma, 0.0);
+  EXPECT_TRUE(black.blank());
+
+  // Bright enough, but one colour: a title card.
+  auto grey = fill(160).look();
+  EXPECT_NEAR(grey.meanLuma, 160.0, 1.0);
+  EXPECT_NEAR(grey.contrast, 0.0, 1e-9);
+  EXPECT_TRUE(grey.blank());
+
+  // Detail in a frame that is still mostly black: the tail of a fade.
+  Frame dim = fill(4);
+  dim.set(0, 0, 255, 255, 255);
+  EXPECT_LT(dim.look().meanLuma, 24.0);
+  EXPECT_TRUE(dim.look().blank());
+}
+
+TEST(VideoFrameGrabber, FrameWithDetailIsNotBlank) {
+  Frame ramp(16, 8);
+  for (int y = 0; y < ramp.height; ++y)
+    for (int x = 0; x < ramp.width; ++x)
+      ramp.set(x, y, static_cast<uint8_t>(x * 16), static_cast<uint8_t>(x * 16),
+               static_cast<uint8_t>(x * 16));
+  auto look = ramp.look();
+  EXPECT_NEAR(look.meanLuma, 120.0, 1.0);
+  EXPECT_GT(look.contrast, 6.0);
+  EXPECT_FALSE(look.blank());
+}
+
+TEST(VideoFrameGrabber, LumaWeighsGreenMost) {
+  Frame green(2, 1), blue(2, 1);
+  green.set(0, 0, 0, 200, 0);
+  green.set(1, 0, 0, 200, 0);
+  blue.set(0, 0, 0, 0, 200);
+  blue.set(1, 0, 0, 0, 200);
+  EXPECT_NEAR(green.look().meanLuma, 125.0, 1.0);
+  EXPECT_NEAR(blue.look().meanLuma, 25.0, 1.0);
+}
+
+// ──────────────────────────────────────────────────────────
+//  VideoFrameGrabber — libmpv
+// ──────────────────────────────────────────────────────────
+
+TEST(VideoFrameGrabber, GrabsAFittedFrameAndReusesItsInstance) {
+  auto clip = writeClip("ramp.y4m", 64, 36, 20);
+  VideoFrameGrabber grabber(2);
+
+  for (int round = 0; round < 2; ++round) {
+    auto image = grabber.grab(clip.string(), 32);
+    ASSERT_TRUE(image.has_value()) << "round " << round;
+    EXPECT_EQ(image->width, 32);
+    EXPECT_EQ(image->height, 18);
+    ASSERT_EQ(image->channels, 3);
+    ASSERT_EQ(image->pixels.size(), 32u * 18u * 3u);
+    // The ramp survives: dark on the left, light on the right.
+    const uint8_t *row = image->pixels.data() + 9 * 32 * 3;
+    EXPECT_LT(row[0], 64);
+    EXPECT_GT(row[31 * 3], 192);
+  }
+  auto stats = grabber.getStats();
+  EXPECT_EQ(stats.grabs, 2u);
+  EXPECT_EQ(stats.failures, 0u);
+  EXPECT_EQ(stats.extraSeeks, 0u);
+  EXPECT_EQ(stats.handles, 1u);
+}
+
+TEST(VideoFrameGrabber, FailsOnAFileThatIsNotAVideo) {
+  auto path = std::filesystem::temp_directory_path() / "bwp_frame_grabber" /
+              "zeros.mp4";
+  std::filesystem::create_directories(path.parent_path());
+  std::ofstream(path, std::ios::binary) << std::string(4096, '\0');
+  VideoFrameGrabber grabber(1);
+  EXPECT_FALSE(grabber.grab(path.string(), 64).has_value());
+  auto stats = grabber.getStats();
+  EXPECT_EQ(stats.failures, 1u);
+  // A file mpv rejects does not cost the instance.
+  EXPECT_EQ(stats.handles, 1u);
+}
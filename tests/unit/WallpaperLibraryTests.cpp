@@ -138,7 +138,7 @@ TEST(WallpaperLibrary, SearchByTitle) {
 
   lib.addWallpaper(wp);
 
-  // search() matches against filename and tags (not title)
+  // search() matches against title, filename and tags
   auto results = lib.search("UniqueSearchable");
   bool found = false;
   for (const auto &r : results) {
@@ -212,6 +212,157 @@ TEST(WallpaperLibrary, GetAllTagsIncludesAddedTags) {
   lib.removeWallpaper("test_tags_xyz");
 }
 
+TEST(WallpaperLibrary, QueryTagsUsesPostingLists) {
+  auto &lib = WallpaperLibrary::getInstance();
+
+  for (int i = 0; i < 4; ++i) {
+    WallpaperInfo wp;
+    wp.id = "test_tagq_" + std::to_string(i);
+    wp.path = "/tmp/test_tagq_" + std::to_string(i) + ".jpg";
+    wp.tags = {"tagqAll"};
+    if (i % 2 == 0)
+      wp.tags.push_back("tagqEven");
+    lib.addWallpaper(wp);
+  }
+  EXPECT_EQ(lib.countWithTag("tagqAll"), 4u);
+  bwp::wallpaper::TagQuery query;
+  query.all = {"tagqAll"};
+  query.none = {"tagqEven"};
+  auto ids = lib.queryTags(query);
+  std::sort(ids.begin(), ids.end());
+  EXPECT_EQ(ids, (std::vector<std::string>{"test_tagq_1", "test_tagq_3"}));
+
+  for (int i = 0; i < 4; ++i) {
+    lib.removeWallpaper("test_tagq_" + std::to_string(i));
+  }
+  EXPECT_EQ(lib.countWithTag("tagqAll"), 0u);
+}
+
+// ──────────────────────────────────────────────────────────
+//  WallpaperLibrary — bulk import
+// ──────────────────────────────────────────────────────────
+
+TEST(WallpaperLibrary, AddWallpapersDedupesAndNotifiesOnce) {
+  auto &lib = WallpaperLibrary::getInstance();
+
+  int notifications = 0;
+  size_t addedIds = 0;
+  int cbId = lib.addChangeSetCallback(
+      [&](const bwp::wallpaper::LibraryChangeSet &changes) {
+        notifications++;
+        addedIds += changes.added.size();
+      });
+
+  std::vector<WallpaperInfo> batch;
+  for (int i = 0; i < 3; ++i) {
+    WallpaperInfo wp;
+    wp.id = "test_bulk_" + std::to_string(i);
+    wp.path = "/tmp/test_bulk_" + std::to_string(i) + ".jpg";
+    batch.push_back(wp);
+  }
+  // Same path under a different id must be ignored.
+  WallpaperInfo dup = batch[0];
+  dup.id = "test_bulk_dup";
+  batch.push_back(dup);
+
+  EXPECT_EQ(lib.addWallpapers(batch), 3u);
+  EXPECT_EQ(notifications, 1);
+  EXPECT_EQ(addedIds, 3u);
+  EXPECT_FALSE(lib.getWallpaper("test_bulk_dup").has_value());
+  EXPECT_EQ(lib.getWallpaper("test_bulk_1")->title, "test_bulk_1");
+
+  lib.removeChangeSetCallback(cbId);
+  lib.beginBulk();
+  for (int i = 0; i < 3; ++i) {
+    lib.removeWallpaper("test_bulk_" + std::to_string(i));
+  }
+  lib.commit();
+  EXPECT_FALSE(lib.getWallpaper("test_bulk_2").has_value());
+}
+
+TEST(WallpaperLibrary, MergedAddOutsideBulkNotifiesAnUpdate) {
+  auto &lib = WallpaperLibrary::getInstance();
+  WallpaperInfo wp;
+  wp.id = "test_merge_notify";
+  wp.path = "/tmp/test_merge_notify.jpg";
+  lib.addWallpaper(wp);
+
+  std::vector<std::string> updated;
+  int cbId = lib.addChangeSetCallback(
+      [&](const bwp::wallpaper::LibraryChangeSet &changes) {
+        updated.insert(updated.end(), changes.updated.begin(),
+                       changes.updated.end());
+      });
+  wp.width = 1920;
+  wp.height = 1080;
+  lib.addWallpaper(wp);
+  // Re-adding it unchanged is not an update.
+  lib.addWallpaper(wp);
+  lib.removeChangeSetCallback(cbId);
+
+  EXPECT_EQ(updated, std::vector<std::string>{"test_merge_notify"});
+  lib.removeWallpaper("test_merge_notify");
+}
+
+// ──────────────────────────────────────────────────────────
+//  WallpaperLibrary — snapshots
+// ──────────────────────────────────────────────────────────
+
+TEST(WallpaperLibrary, SnapshotIsImmutableAcrossWrites) {
+  auto &lib = WallpaperLibrary::getInstance();
+
+  WallpaperInfo wp;
+  wp.id = "test_snapshot";
+  wp.path = "/tmp/test_snapshot.jpg";
+  wp.title = "Before";
+  lib.addWallpaper(wp);
+
+  auto before = lib.snapshot();
+  auto held = before->find("test_snapshot");
+  ASSERT_TRUE(held);
+
+  wp.title = "After";
+  lib.updateWallpaper(wp);
+  lib.removeWallpaper("test_snapshot");
+
+  EXPECT_EQ(held.title(), "Before");
+  EXPECT_TRUE(before->find("test_snapshot") == held);
+  auto after = lib.snapshot();
+  EXPECT_GT(after->version(), before->version());
+  EXPECT_FALSE(after->find("test_snapshot"));
+  EXPECT_EQ(after->size() + 1, before->size());
+}
+
+TEST(WallpaperLibrary, RewrittenFileDropsItsHashes) {
+  auto &lib = WallpaperLibrary::getInstance();
+
+  WallpaperInfo wp;
+  wp.id = "/tmp/test_rewritten.jpg";
+  wp.path = wp.id;
+  wp.size_bytes = 100;
+  wp.phash = 0x1234;
+  wp.blurhash = "LEHV6nWB2yk8";
+  lib.addWallpaper(wp);
+
+  // The same size is a rescan of the same file.
+  WallpaperInfo rescan;
+  rescan.id = wp.id;
+  rescan.path = wp.path;
+  rescan.size_bytes = 100;
+  lib.addWallpaper(rescan);
+  EXPECT_EQ(lib.getWallpaper(wp.id)->phash, 0x1234u);
+
+  rescan.size_bytes = 200;
+  lib.addWallpaper(rescan);
+  auto retrieved = lib.getWallpaper(wp.id);
+  ASSERT_TRUE(retrieved.has_value());
+  EXPECT_EQ(retrieved->size_bytes, 200u);
+  EXPECT_EQ(retrieved->phash, 0u);
+  EXPECT_TRUE(retrieved->blurhash.empty());
+
+  lib.removeWallpaper(wp.id);
+}
+
 // Cleanup the test_wp_001 added in earlier test
 TEST(WallpaperLibrary, Cleanup) {
   auto &lib = WallpaperLibrary::getInstance();
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include "core/utils/WorkStealingPool.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+using bwp::utils::WorkStealingPool;
+
+// ──────────────────────────────────────────────────────────
+//  WorkStealingPool — dynamic task trees
+// ──────────────────────────────────────────────────────────
+
+TEST(WorkStealingPool, RunsSpawnedTaskTree) {
+  // Each task n < 2^12 spawns 2n and 2n+1: a complete binary tree from a
+  // single seed.
+  WorkStealingPool<int> pool(4);
+  std::atomic<int> visited{0};
+  pool.run({1}, [&](int &n, unsigned worker) {
+    visited++;
+    if (n < (1 << 12)) {
+      pool.push(worker, 2 * n);
+      pool.push(worker, 2 * n + 1);
+    }
+  });
+  EXPECT_EQ(visited.load(), (1 << 13) - 1);
+
+  // The pool is reusable once run() returns.
+  visited = 0;
+  pool.run({1, 2, 3}, [&](int &, unsigned) { visited++; });
+  EXPECT_EQ(visited.load(), 3);
+}
+
+TEST(WorkStealingPool, SleepingWorkersStealFromABusyOne) {
+  // The seed pushes its children and then blocks its worker until they are
+  // done, so they only run if the other workers wake up and steal them.
+  WorkStealingPool<int> pool(3);
+  std::atomic<int> done{0};
+  std::mutex mutex;
+  std::set<unsigned> thieves;
+  unsigned seedWorker = 0;
+  pool.run({0}, [&](int &n, unsigned worker) {
+    if (n == 0) {
+      seedWorker = worker;
+      for (int i = 1; i <= 8; ++i)
+        pool.push(worker, i);
+      auto deadline =
+          std::chrono::steady_clock::now() + std::chrono::seconds(5);
+      while (done < 8 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      thieves.insert(worker);
+    }
+    done++;
+  });
+  EXPECT_EQ(done.load(), 8);
+  EXPECT_GE(thieves.size(), 1u);
+  EXPECT_EQ(thieves.count(seedWorker), 0u);
+}
+
+TEST(WorkStealingPool, StopDropsRemainingTasks) {
+  WorkStealingPool<int> pool(2);
+  std::atomic<bool> stop{false};
+  std::atomic<int> visited{0};
+  pool.run(
+      {0},
+      [&](int &n, unsigned worker) {
+        if (++visited == 100)
+          stop = true;
+        pool.push(worker, n + 1);
+      },
+      &stop);
+  EXPECT_GE(visited.load(), 100);
+  EXPECT_LT(visited.load(), 1000);
+}